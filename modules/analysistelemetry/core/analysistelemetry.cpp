@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "analysistelemetry.hpp"
+
+#include "salalib/genlib/comm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+namespace {
+    int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+} // namespace
+
+double AnalysisTelemetry::Snapshot::getRecordsPerSecond() const {
+    if (elapsedSeconds <= 0.0) {
+        return 0.0;
+    }
+    // records counted by threads are the ones done in this run, while the
+    // overall count may include work carried over from a previous one
+    uint64_t records = threadRecords.empty()
+                           ? currentRecord
+                           : std::accumulate(threadRecords.begin(), threadRecords.end(),
+                                             uint64_t(0));
+    return static_cast<double>(records) / elapsedSeconds;
+}
+
+double AnalysisTelemetry::Snapshot::getThreadImbalance() const {
+    if (threadRecords.empty()) {
+        return 1.0;
+    }
+    uint64_t total = std::accumulate(threadRecords.begin(), threadRecords.end(), uint64_t(0));
+    if (total == 0) {
+        return 1.0;
+    }
+    uint64_t busiest = *std::max_element(threadRecords.begin(), threadRecords.end());
+    return static_cast<double>(busiest) * static_cast<double>(threadRecords.size()) /
+           static_cast<double>(total);
+}
+
+AnalysisTelemetry *AnalysisTelemetry::of(Communicator *comm) {
+    if (auto provider = dynamic_cast<Provider *>(comm)) {
+        return &provider->getTelemetry();
+    }
+    return nullptr;
+}
+
+void AnalysisTelemetry::start() {
+    setNumRecords(0);
+    m_phase.store("", std::memory_order_relaxed);
+    m_numSteps.store(0, std::memory_order_relaxed);
+    m_currentStep.store(0, std::memory_order_relaxed);
+    m_startTime.store(now(), std::memory_order_relaxed);
+}
+
+void AnalysisTelemetry::setNumRecords(uint64_t numRecords) {
+    size_t slotsUsed = m_slotsUsed.load(std::memory_order_relaxed);
+    for (size_t slot = 0; slot < slotsUsed; slot++) {
+        m_threads[slot].records.store(0, std::memory_order_relaxed);
+    }
+    m_postedRecord.store(0, std::memory_order_relaxed);
+    m_numRecords.store(numRecords, std::memory_order_relaxed);
+}
+
+void AnalysisTelemetry::markSlotUsed(size_t slot) {
+    size_t slotsUsed = m_slotsUsed.load(std::memory_order_relaxed);
+    while (slotsUsed <= slot &&
+           !m_slotsUsed.compare_exchange_weak(slotsUsed, slot + 1, std::memory_order_relaxed)) {
+    }
+}
+
+AnalysisTelemetry::Snapshot AnalysisTelemetry::snapshot() const {
+    Snapshot snapshot;
+    snapshot.phase = m_phase.load(std::memory_order_relaxed);
+    int64_t startTime = m_startTime.load(std::memory_order_relaxed);
+    if (startTime != 0) {
+        snapshot.elapsedSeconds = static_cast<double>(now() - startTime) * 1e-9;
+    }
+    snapshot.numSteps = m_numSteps.load(std::memory_order_relaxed);
+    snapshot.currentStep = m_currentStep.load(std::memory_order_relaxed);
+    snapshot.numRecords = m_numRecords.load(std::memory_order_relaxed);
+
+    size_t slotsUsed = m_slotsUsed.load(std::memory_order_relaxed);
+    uint64_t threadTotal = 0;
+    for (size_t slot = 0; slot < slotsUsed; slot++) {
+        uint64_t records = m_threads[slot].records.load(std::memory_order_relaxed);
+        // threads that did nothing, for instance beyond a reduced budget, do
+        // not count towards the imbalance
+        if (records == 0) {
+            continue;
+        }
+        snapshot.threadRecords.push_back(records);
+        threadTotal += records;
+    }
+    // analyses either count per thread or post an overall count
+    snapshot.currentRecord =
+        std::max(threadTotal, m_postedRecord.load(std::memory_order_relaxed));
+    return snapshot;
+}
@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Communicator;
+
+/**
+ * @brief Progress of a running analysis, updated without locks
+ *
+ * Worker threads count the records they complete in their own cache line,
+ * so that reporting does not contend. Any thread can take a snapshot at any
+ * time; the snapshot is not atomic as a whole, but each value in it is.
+ */
+class AnalysisTelemetry {
+  public:
+    // threads beyond this share slots, which only blurs the per-thread view
+    static constexpr size_t MAX_THREADS = 256;
+
+    struct Snapshot {
+        std::string phase;
+        double elapsedSeconds = 0.0;
+        uint64_t numSteps = 0;
+        uint64_t currentStep = 0;
+        uint64_t numRecords = 0;
+        uint64_t currentRecord = 0;
+        // records completed by each thread, for the threads that reported any
+        std::vector<uint64_t> threadRecords;
+
+        // throughput since the start of this run
+        double getRecordsPerSecond() const;
+        // the busiest thread relative to the average, 1 when perfectly even
+        double getThreadImbalance() const;
+    };
+
+    // implemented by communicators that carry telemetry
+    class Provider {
+      public:
+        virtual AnalysisTelemetry &getTelemetry() = 0;
+        virtual ~Provider() {}
+    };
+
+  private:
+    struct alignas(64) ThreadSlot {
+        std::atomic<uint64_t> records{0};
+    };
+
+    std::array<ThreadSlot, MAX_THREADS> m_threads;
+    // one past the highest slot that has reported, the slots below it may
+    // not all have been used
+    std::atomic<size_t> m_slotsUsed{0};
+    std::atomic<const char *> m_phase{""};
+    std::atomic<int64_t> m_startTime{0};
+    std::atomic<uint64_t> m_numSteps{0};
+    std::atomic<uint64_t> m_currentStep{0};
+    std::atomic<uint64_t> m_numRecords{0};
+    std::atomic<uint64_t> m_postedRecord{0};
+
+  public:
+    // the telemetry of the communicator, if it carries any
+    static AnalysisTelemetry *of(Communicator *comm);
+
+    // clears the counters and starts the clock
+    void start();
+
+    // the phase must outlive the analysis, string literals are expected
+    void setPhase(const char *phase) { m_phase.store(phase, std::memory_order_relaxed); }
+    void setNumSteps(uint64_t numSteps) { m_numSteps.store(numSteps, std::memory_order_relaxed); }
+    void setCurrentStep(uint64_t step) { m_currentStep.store(step, std::memory_order_relaxed); }
+    // a new record count also restarts the per-thread counters
+    void setNumRecords(uint64_t numRecords);
+    // for analyses that only report an overall count
+    void setCurrentRecord(uint64_t record) {
+        m_postedRecord.store(record, std::memory_order_relaxed);
+    }
+    void addRecords(size_t thread, uint64_t count = 1) {
+        size_t slot = thread % MAX_THREADS;
+        m_threads[slot].records.fetch_add(count, std::memory_order_relaxed);
+        if (slot >= m_slotsUsed.load(std::memory_order_relaxed)) {
+            markSlotUsed(slot);
+        }
+    }
+
+    Snapshot snapshot() const;
+
+  private:
+    void markSlotUsed(size_t slot);
+};
@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+
+#include "salalib/genlib/comm.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <thread>
+
+namespace {
+    class TelemetryCommunicator : public Communicator, public AnalysisTelemetry::Provider {
+        AnalysisTelemetry m_telemetry;
+
+      public:
+        void CommPostMessage(size_t, size_t) const override {}
+        AnalysisTelemetry &getTelemetry() override { return m_telemetry; }
+    };
+
+    class PlainCommunicator : public Communicator {
+      public:
+        void CommPostMessage(size_t, size_t) const override {}
+    };
+} // namespace
+
+TEST_CASE("Telemetry is found through the communicator", "") {
+    TelemetryCommunicator withTelemetry;
+    PlainCommunicator withoutTelemetry;
+    REQUIRE(AnalysisTelemetry::of(&withTelemetry) == &withTelemetry.getTelemetry());
+    REQUIRE(AnalysisTelemetry::of(&withoutTelemetry) == nullptr);
+    REQUIRE(AnalysisTelemetry::of(nullptr) == nullptr);
+}
+
+TEST_CASE("Telemetry counts records per thread", "") {
+    AnalysisTelemetry telemetry;
+    telemetry.start();
+    telemetry.setPhase("traversing");
+    telemetry.setNumRecords(4000);
+
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < 4; thread++) {
+        threads.emplace_back([&telemetry, thread]() {
+            for (int i = 0; i < 1000; i++) {
+                telemetry.addRecords(thread);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto snapshot = telemetry.snapshot();
+    REQUIRE(snapshot.phase == "traversing");
+    REQUIRE(snapshot.numRecords == 4000);
+    REQUIRE(snapshot.currentRecord == 4000);
+    REQUIRE(snapshot.threadRecords.size() == 4);
+    REQUIRE(snapshot.threadRecords[2] == 1000);
+    REQUIRE(snapshot.getThreadImbalance() == Catch::Approx(1.0));
+    REQUIRE(snapshot.elapsedSeconds >= 0.0);
+}
+
+TEST_CASE("Telemetry imbalance and overall counts", "") {
+    AnalysisTelemetry telemetry;
+    telemetry.start();
+    telemetry.addRecords(0, 30);
+    telemetry.addRecords(1, 10);
+    auto snapshot = telemetry.snapshot();
+    // the busiest thread did 30 against an average of 20
+    REQUIRE(snapshot.getThreadImbalance() == Catch::Approx(1.5));
+
+    // only the threads that reported work count
+    telemetry.addRecords(5, 20);
+    snapshot = telemetry.snapshot();
+    REQUIRE(snapshot.threadRecords.size() == 3);
+    REQUIRE(snapshot.getThreadImbalance() == Catch::Approx(1.5));
+
+    // an overall count higher than the per-thread total wins
+    telemetry.setCurrentRecord(100);
+    REQUIRE(telemetry.snapshot().currentRecord == 100);
+
+    // a new record count starts over
+    telemetry.setNumRecords(10);
+    snapshot = telemetry.snapshot();
+    REQUIRE(snapshot.currentRecord == 0);
+    REQUIRE(snapshot.numRecords == 10);
+}
@@ -0,0 +1,506 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "axialparallelintegration.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/integrationmeasures.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+namespace {
+    // a search by depth, lines in the order they were reached
+    struct Search {
+        std::vector<int> depth;
+        std::vector<uint32_t> order;
+        // index in the order after the last line at each depth
+        std::vector<size_t> levelEnd;
+        std::vector<double> sigma;
+        std::vector<double> delta;
+        std::vector<double> weightedDelta;
+        std::vector<int64_t> choice;
+        std::vector<int64_t> weightedChoice;
+        std::vector<int64_t> choiceSquares;
+    };
+} // namespace
+
+AxialParallelIntegration::Graph::Graph(const std::vector<std::vector<uint32_t>> &adjacency) {
+    m_offsets.reserve(adjacency.size() + 1);
+    m_offsets.push_back(0);
+    for (uint32_t node = 0; node < adjacency.size(); node++) {
+        for (uint32_t target : adjacency[node]) {
+            if (target != node) {
+                m_targets.push_back(target);
+            }
+        }
+        m_offsets.push_back(m_targets.size());
+    }
+}
+
+AxialParallelIntegration::Graph AxialParallelIntegration::Graph::fromMap(ShapeGraph &map) {
+    auto &connectors = map.getConnections();
+    std::vector<std::vector<uint32_t>> adjacency(connectors.size());
+    for (size_t node = 0; node < connectors.size(); node++) {
+        for (size_t connected : connectors[node].connections) {
+            adjacency[node].push_back(static_cast<uint32_t>(connected));
+        }
+    }
+    return Graph(adjacency);
+}
+
+AxialParallelIntegration::AxialParallelIntegration(ShapeGraph &map,
+                                                   const std::set<double> &radiusSet,
+                                                   int weightedMeasureCol, bool choice,
+                                                   bool fulloutput, bool local)
+    : m_map(map), m_weightedMeasureCol(weightedMeasureCol), m_choice(choice),
+      m_fulloutput(fulloutput), m_local(local) {
+    for (double radius : radiusSet) {
+        m_radii.push_back(static_cast<int>(radius));
+    }
+}
+
+std::vector<AxialParallelIntegration::Measures>
+AxialParallelIntegration::analyseGraph(const Graph &graph, const std::vector<int> &radii,
+                                       bool choice, const std::vector<double> &weights,
+                                       Communicator *comm, const std::vector<uint32_t> *sample) {
+    size_t nodeCount = graph.nodeCount();
+    size_t radiusCount = radii.size();
+    bool weighted = !weights.empty();
+    std::vector<Measures> measures(nodeCount * radiusCount);
+    if (nodeCount == 0 || radiusCount == 0) {
+        return measures;
+    }
+    int maxRadius = std::numeric_limits<int>::max();
+    if (std::find(radii.begin(), radii.end(), -1) == radii.end()) {
+        maxRadius = *std::max_element(radii.begin(), radii.end());
+    }
+
+    double totalWeight = static_cast<double>(nodeCount);
+    if (weighted) {
+        totalWeight = 0.0;
+        for (double weight : weights) {
+            totalWeight += std::abs(weight);
+        }
+    }
+    double lines = static_cast<double>(nodeCount);
+    double choiceScale = fixedPointScale(lines * lines);
+    double weightedChoiceScale = fixedPointScale(totalWeight * totalWeight);
+    // the squares from each origin add up to at most the cube of the lines
+    bool squared = choice && sample != nullptr;
+    double choiceSquaresScale = fixedPointScale(lines * lines * lines);
+    size_t originCount = sample ? sample->size() : nodeCount;
+
+    std::vector<Search> searches(static_cast<size_t>(getMaxThreads()));
+    for (auto &search : searches) {
+        search.depth.resize(nodeCount, -1);
+        search.sigma.resize(nodeCount, 0.0);
+        if (choice) {
+            search.delta.resize(nodeCount, 0.0);
+            search.choice.resize(nodeCount * radiusCount, 0);
+            if (weighted) {
+                search.weightedDelta.resize(nodeCount, 0.0);
+                search.weightedChoice.resize(nodeCount * radiusCount, 0);
+            }
+            if (squared) {
+                search.choiceSquares.resize(nodeCount * radiusCount, 0);
+            }
+        }
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, originCount);
+    }
+    std::atomic<size_t> originsDone(0);
+    std::atomic<bool> cancelled(false);
+
+    parallelFor(originCount, 16, [&](size_t originIdx, int thread) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Search &search = searches[static_cast<size_t>(thread)];
+        uint32_t origin = sample ? (*sample)[originIdx]
+                                 : static_cast<uint32_t>(originIdx);
+
+        search.order.assign(1, origin);
+        search.levelEnd.clear();
+        search.depth[origin] = 0;
+        search.sigma[origin] = 1.0;
+        for (size_t levelStart = 0; levelStart < search.order.size();) {
+            size_t levelEnd = search.order.size();
+            search.levelEnd.push_back(levelEnd);
+            int depth = static_cast<int>(search.levelEnd.size());
+            if (depth > maxRadius) {
+                break;
+            }
+            for (size_t idx = levelStart; idx < levelEnd; idx++) {
+                uint32_t node = search.order[idx];
+                for (uint32_t connected : graph.neighbours(node)) {
+                    if (search.depth[connected] == -1) {
+                        search.depth[connected] = depth;
+                        search.order.push_back(connected);
+                    }
+                    if (search.depth[connected] == depth) {
+                        search.sigma[connected] += search.sigma[node];
+                    }
+                }
+            }
+            levelStart = levelEnd;
+        }
+        size_t deepest = search.levelEnd.size() - 1;
+
+        for (size_t r = 0; r < radiusCount; r++) {
+            size_t lastDepth = radii[r] == -1 ? deepest
+                                              : std::min(deepest, static_cast<size_t>(radii[r]));
+            size_t reached = search.levelEnd[lastDepth];
+            Measures &measure = measures[origin * radiusCount + r];
+
+            double totalNodes = static_cast<double>(reached);
+            double totalDepth = 0.0, harmonicSum = 0.0;
+            for (size_t depth = 1; depth <= lastDepth; depth++) {
+                double count =
+                    static_cast<double>(search.levelEnd[depth] - search.levelEnd[depth - 1]);
+                totalDepth += static_cast<double>(depth) * count;
+                harmonicSum += count / static_cast<double>(depth);
+            }
+            measure.nodeCount = static_cast<float>(totalNodes);
+            if (weighted) {
+                double weightReached = 0.0, weightedDepth = 0.0;
+                for (size_t idx = 0; idx < reached; idx++) {
+                    uint32_t node = search.order[idx];
+                    weightReached += weights[node];
+                    weightedDepth += weights[node] * search.depth[node];
+                }
+                measure.totalWeight = static_cast<float>(weightReached);
+                double othersWeight = weightReached - weights[origin];
+                if (othersWeight > 0.0) {
+                    measure.weightedMeanDepth = static_cast<float>(weightedDepth / othersWeight);
+                }
+            }
+            if (reached > 1) {
+                double meanDepth = totalDepth / (totalNodes - 1.0);
+                measure.meanDepth = static_cast<float>(meanDepth);
+                measure.harmonicMeanDepth = static_cast<float>((totalNodes - 1.0) / harmonicSum);
+
+                double entropy = 0.0, relEntropy = 0.0, factorial = 1.0;
+                for (size_t depth = 1; depth <= lastDepth; depth++) {
+                    double prob =
+                        static_cast<double>(search.levelEnd[depth] - search.levelEnd[depth - 1]) /
+                        (totalNodes - 1.0);
+                    entropy -= prob * log2(prob);
+                    // Formula from Turner 2001, "Depthmap"
+                    factorial *= static_cast<double>(depth + 1);
+                    double q = (pow(meanDepth, static_cast<double>(depth)) / factorial) *
+                               exp(-meanDepth);
+                    relEntropy += prob * log2(prob / q);
+                }
+                measure.entropy = static_cast<float>(entropy);
+                measure.relEntropy = static_cast<float>(relEntropy);
+                measure.intensity = static_cast<float>(totalNodes * entropy / totalDepth);
+
+                auto integration =
+                    IntegrationMeasures::fromDepth(totalNodes, meanDepth, totalDepth);
+                measure.integHH = static_cast<float>(integration.integHH);
+                measure.integPV = static_cast<float>(integration.integPV);
+                measure.integTK = static_cast<float>(integration.integTK);
+            }
+
+            if (!choice) {
+                continue;
+            }
+            // dependencies of the lines on the shortest paths from the
+            // origin to those within the radius, deepest first
+            for (size_t idx = 0; idx < reached; idx++) {
+                search.delta[search.order[idx]] = 0.0;
+                if (weighted) {
+                    search.weightedDelta[search.order[idx]] = 0.0;
+                }
+            }
+            for (size_t idx = reached - 1; idx > 0; idx--) {
+                uint32_t node = search.order[idx];
+                for (uint32_t connected : graph.neighbours(node)) {
+                    if (search.depth[connected] != search.depth[node] - 1) {
+                        continue;
+                    }
+                    double share = search.sigma[connected] / search.sigma[node];
+                    search.delta[connected] += share * (1.0 + search.delta[node]);
+                    if (weighted) {
+                        search.weightedDelta[connected] +=
+                            share * (weights[node] + search.weightedDelta[node]);
+                    }
+                }
+                search.choice[node * radiusCount + r] +=
+                    std::llround(search.delta[node] * choiceScale);
+                if (squared) {
+                    search.choiceSquares[node * radiusCount + r] += std::llround(
+                        search.delta[node] * search.delta[node] * choiceSquaresScale);
+                }
+                if (weighted) {
+                    search.weightedChoice[node * radiusCount + r] += std::llround(
+                        weights[origin] * search.weightedDelta[node] * weightedChoiceScale);
+                }
+            }
+        }
+
+        for (uint32_t node : search.order) {
+            search.depth[node] = -1;
+            search.sigma[node] = 0.0;
+        }
+
+        if (telemetry) {
+            telemetry->addRecords(static_cast<size_t>(thread));
+        }
+        size_t done = originsDone.fetch_add(1) + 1;
+        if (comm && thread == 0) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+            if (comm->IsCancelled()) {
+                cancelled = true;
+            }
+        }
+    });
+
+    if (cancelled) {
+        throw Communicator::CancelledException();
+    }
+    if (!choice) {
+        return measures;
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("adding up choice");
+    }
+#pragma omp parallel for num_threads(getThreadBudget()) schedule(static)
+    for (int nodeIdx = 0; nodeIdx < static_cast<int>(nodeCount); nodeIdx++) {
+        size_t node = static_cast<size_t>(nodeIdx);
+        for (size_t r = 0; r < radiusCount; r++) {
+            size_t idx = node * radiusCount + r;
+            int64_t total = 0, weightedTotal = 0, squaresTotal = 0;
+            for (const auto &search : searches) {
+                total += search.choice[idx];
+                if (weighted) {
+                    weightedTotal += search.weightedChoice[idx];
+                }
+                if (squared) {
+                    squaresTotal += search.choiceSquares[idx];
+                }
+            }
+            Measures &measure = measures[idx];
+            if (squared) {
+                measure.choiceSquares = static_cast<double>(squaresTotal) / choiceSquaresScale;
+            }
+            double lineChoice = static_cast<double>(total) / choiceScale;
+            measure.choice = lineChoice;
+            double totalNodes = measure.nodeCount;
+            if (totalNodes > 2) {
+                measure.choiceNorm =
+                    static_cast<float>(lineChoice / ((totalNodes - 1.0) * (totalNodes - 2.0)));
+            }
+            if (weighted) {
+                double lineWeightedChoice =
+                    static_cast<double>(weightedTotal) / weightedChoiceScale;
+                measure.weightedChoice = static_cast<float>(lineWeightedChoice);
+                double othersWeight = measure.totalWeight - weights[node];
+                if (othersWeight > 0.0) {
+                    measure.weightedChoiceNorm =
+                        static_cast<float>(lineWeightedChoice / (othersWeight * othersWeight));
+                }
+            }
+        }
+    }
+    return measures;
+}
+
+std::vector<AxialParallelIntegration::LocalMeasures>
+AxialParallelIntegration::analyseLocal(const Graph &graph) {
+    size_t nodeCount = graph.nodeCount();
+    std::vector<LocalMeasures> measures(nodeCount);
+    // lines within two steps, marked with the line they are counted for
+    std::vector<std::vector<uint32_t>> marks(static_cast<size_t>(getMaxThreads()));
+    for (auto &mark : marks) {
+        mark.resize(nodeCount, std::numeric_limits<uint32_t>::max());
+    }
+
+    parallelFor(nodeCount, 64, [&](size_t nodeIdx, int thread) {
+        uint32_t node = static_cast<uint32_t>(nodeIdx);
+        if (graph.degree(node) == 0) {
+            return;
+        }
+        auto &mark = marks[static_cast<size_t>(thread)];
+        mark[node] = node;
+        double control = 0.0;
+        size_t withinTwo = 0;
+        for (uint32_t connected : graph.neighbours(node)) {
+            control += 1.0 / static_cast<double>(graph.degree(connected));
+            for (uint32_t second : graph.neighbours(connected)) {
+                if (mark[second] != node) {
+                    mark[second] = node;
+                    withinTwo++;
+                }
+            }
+            if (mark[connected] != node) {
+                mark[connected] = node;
+                withinTwo++;
+            }
+        }
+        measures[node].control = static_cast<float>(control);
+        measures[node].controllability =
+            static_cast<float>(static_cast<double>(graph.degree(node)) /
+                               static_cast<double>(withinTwo));
+    });
+    return measures;
+}
+
+AnalysisResult AxialParallelIntegration::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    Graph graph = Graph::fromMap(m_map);
+    std::vector<int> refs;
+    for (auto &shape : m_map.getAllShapes()) {
+        refs.push_back(shape.first);
+    }
+
+    AttributeTable &table = m_map.getAttributeTable();
+    std::vector<double> weights;
+    std::string weightColumn;
+    if (m_weightedMeasureCol != -1) {
+        size_t weightCol = static_cast<size_t>(m_weightedMeasureCol);
+        weightColumn = table.getColumnName(weightCol);
+        for (int ref : refs) {
+            weights.push_back(table.getRow(AttributeKey(ref)).getValue(weightCol));
+        }
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("searching from lines");
+    }
+    bool exactChoice = m_choice && !m_sampleChoice;
+    auto measures = analyseGraph(graph, m_radii, exactChoice, weights, comm);
+
+    ChoiceSampler::Estimate sampled;
+    if (m_choice && m_sampleChoice) {
+        if (telemetry) {
+            telemetry->setPhase("sampling choice");
+        }
+        std::vector<uint32_t> origins(graph.nodeCount());
+        std::iota(origins.begin(), origins.end(), 0);
+        sampled = ChoiceSampler::estimate(
+            origins, m_choiceSampling, [&](const std::vector<uint32_t> &sample) {
+                auto fromSample = analyseGraph(graph, m_radii, true, {}, comm, &sample);
+                ChoiceSampler::Totals totals;
+                for (const Measures &measure : fromSample) {
+                    totals.choice.push_back(measure.choice);
+                    totals.choiceSquares.push_back(measure.choiceSquares);
+                }
+                return totals;
+            });
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    AnalysisResult result;
+    auto writeColumn = [&](const std::string &column, size_t r,
+                           const std::function<float(const Measures &)> &value) {
+        size_t col = table.insertOrResetColumn(column);
+        for (size_t node = 0; node < refs.size(); node++) {
+            table.getRow(AttributeKey(refs[node]))
+                .setValue(col, value(measures[node * m_radii.size() + r]));
+        }
+        result.addAttribute(column);
+    };
+    auto writeSampled = [&](const std::string &column, size_t r,
+                            const std::vector<double> &values) {
+        size_t col = table.insertOrResetColumn(column);
+        for (size_t node = 0; node < refs.size(); node++) {
+            table.getRow(AttributeKey(refs[node]))
+                .setValue(col, static_cast<float>(values[node * m_radii.size() + r]));
+        }
+        result.addAttribute(column);
+    };
+    for (size_t r = 0; r < m_radii.size(); r++) {
+        int radius = m_radii[r];
+        if (!sampled.choice.empty()) {
+            writeSampled(getColumnWithRadius(Column::CHOICE_SAMPLED, radius), r, sampled.choice);
+            writeSampled(getColumnWithRadius(Column::CHOICE_SAMPLED_ERROR, radius), r,
+                         sampled.error);
+        }
+        if (exactChoice) {
+            writeColumn(getColumnWithRadius(Column::CHOICE, radius), r,
+                        [](const Measures &measure) { return static_cast<float>(measure.choice); });
+            writeColumn(getColumnWithRadius(Column::CHOICE_NORM, radius), r,
+                        [](const Measures &measure) { return measure.choiceNorm; });
+            if (!weights.empty()) {
+                writeColumn(
+                    getColumnWithRadius(getWeightedColumn(Column::CHOICE, weightColumn, false),
+                                        radius),
+                    r, [](const Measures &measure) { return measure.weightedChoice; });
+                writeColumn(
+                    getColumnWithRadius(getWeightedColumn(Column::CHOICE, weightColumn, true),
+                                        radius),
+                    r, [](const Measures &measure) { return measure.weightedChoiceNorm; });
+            }
+        }
+        if (m_fulloutput) {
+            writeColumn(getColumnWithRadius(Column::ENTROPY, radius), r,
+                        [](const Measures &measure) { return measure.entropy; });
+        }
+        writeColumn(getColumnWithRadius(Column::INTEGRATION_HH, radius), r,
+                    [](const Measures &measure) { return measure.integHH; });
+        if (m_fulloutput) {
+            writeColumn(getColumnWithRadius(Column::INTEGRATION_PV, radius), r,
+                        [](const Measures &measure) { return measure.integPV; });
+            writeColumn(getColumnWithRadius(Column::INTEGRATION_TK, radius), r,
+                        [](const Measures &measure) { return measure.integTK; });
+            writeColumn(getColumnWithRadius(Column::INTENSITY, radius), r,
+                        [](const Measures &measure) { return measure.intensity; });
+            writeColumn(getColumnWithRadius(Column::HARMONIC_MEAN_DEPTH, radius), r,
+                        [](const Measures &measure) { return measure.harmonicMeanDepth; });
+        }
+        writeColumn(getColumnWithRadius(Column::MEAN_DEPTH, radius), r,
+                    [](const Measures &measure) { return measure.meanDepth; });
+        writeColumn(getColumnWithRadius(Column::NODE_COUNT, radius), r,
+                    [](const Measures &measure) { return measure.nodeCount; });
+        if (m_fulloutput) {
+            writeColumn(getColumnWithRadius(Column::REL_ENTROPY, radius), r,
+                        [](const Measures &measure) { return measure.relEntropy; });
+        }
+        if (!weights.empty()) {
+            writeColumn(getColumnWithRadius(
+                            getWeightedColumn(Column::MEAN_DEPTH, weightColumn, false), radius),
+                        r, [](const Measures &measure) { return measure.weightedMeanDepth; });
+            writeColumn(getColumnWithRadius("Total " + weightColumn, radius), r,
+                        [](const Measures &measure) { return measure.totalWeight; });
+        }
+    }
+
+    if (m_local) {
+        if (telemetry) {
+            telemetry->setPhase("local measures");
+        }
+        auto local = analyseLocal(graph);
+        size_t controlCol = table.insertOrResetColumn(Column::CONTROL);
+        size_t controllabilityCol = table.insertOrResetColumn(Column::CONTROLLABILITY);
+        for (size_t node = 0; node < refs.size(); node++) {
+            AttributeRow &row = table.getRow(AttributeKey(refs[node]));
+            row.setValue(controlCol, local[node].control);
+            row.setValue(controllabilityCol, local[node].controllability);
+        }
+        result.addAttribute(Column::CONTROL);
+        result.addAttribute(Column::CONTROLLABILITY);
+    }
+
+    result.completed = true;
+    return result;
+}
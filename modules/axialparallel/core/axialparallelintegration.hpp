@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "modules/choicesampling/core/choicesampler.hpp"
+#include "modules/parallelcommon/core/columnwithradius.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+class ShapeGraph;
+
+/**
+ * @brief Axial integration and choice, searching from many lines at once
+ *
+ * Every thread runs breadth-first searches from its own origin lines with
+ * its own depth buffers, once to the largest radius, and reads the smaller
+ * radii off the same search. Choice is accumulated from every search over
+ * all the shortest paths, in fixed point so that adding up the totals of
+ * the threads gives the same result whichever thread searched from which
+ * line. Produces the columns of the axial analysis of salalib.
+ */
+class AxialParallelIntegration : public IAnalysis {
+  public:
+    // connections of each line, both ways
+    class Graph {
+        std::vector<size_t> m_offsets;
+        std::vector<uint32_t> m_targets;
+
+      public:
+        struct Range {
+            const uint32_t *first;
+            const uint32_t *last;
+            const uint32_t *begin() const { return first; }
+            const uint32_t *end() const { return last; }
+        };
+
+        explicit Graph(const std::vector<std::vector<uint32_t>> &adjacency);
+        static Graph fromMap(ShapeGraph &map);
+
+        size_t nodeCount() const { return m_offsets.size() - 1; }
+        size_t degree(uint32_t node) const { return m_offsets[node + 1] - m_offsets[node]; }
+        Range neighbours(uint32_t node) const {
+            return {m_targets.data() + m_offsets[node], m_targets.data() + m_offsets[node + 1]};
+        }
+    };
+
+    // what a line has in reach of one radius, -1 where it is not defined
+    struct Measures {
+        float nodeCount = -1.0f;
+        float meanDepth = -1.0f;
+        float integHH = -1.0f;
+        float integPV = -1.0f;
+        float integTK = -1.0f;
+        float entropy = -1.0f;
+        float relEntropy = -1.0f;
+        float intensity = -1.0f;
+        float harmonicMeanDepth = -1.0f;
+        // in double, as the sampling adds them up again
+        double choice = -1.0;
+        float choiceNorm = -1.0f;
+        float weightedMeanDepth = -1.0f;
+        float totalWeight = -1.0f;
+        float weightedChoice = -1.0f;
+        float weightedChoiceNorm = -1.0f;
+        // of the choice from each origin, for estimating choice from a sample
+        double choiceSquares = -1.0;
+    };
+
+    struct LocalMeasures {
+        float control = -1.0f;
+        float controllability = -1.0f;
+    };
+
+    struct Column {
+        inline static const std::string                          //
+            CHOICE = "Choice",                                   //
+            CHOICE_NORM = "Choice [Norm]",                       //
+            CHOICE_SAMPLED = "Choice [Sampled]",                 //
+            CHOICE_SAMPLED_ERROR = "Choice 95% Error [Sampled]", //
+            ENTROPY = "Entropy",                                 //
+            INTEGRATION_HH = "Integration [HH]",                 //
+            INTEGRATION_PV = "Integration [P-value]",            //
+            INTEGRATION_TK = "Integration [Tekl]",               //
+            INTENSITY = "Intensity",                             //
+            HARMONIC_MEAN_DEPTH = "Harmonic Mean Depth",         //
+            MEAN_DEPTH = "Mean Depth",                           //
+            NODE_COUNT = "Node Count",                           //
+            REL_ENTROPY = "Relativised Entropy",                 //
+            CONTROL = "Control",                                 //
+            CONTROLLABILITY = "Controllability";                 //
+    };
+    static std::string getWeightedColumn(const std::string &column,
+                                         const std::string &weightColumn, bool normalised) {
+        return column + " [" + weightColumn + " Wgt]" + (normalised ? "[Norm]" : "");
+    }
+
+  private:
+    ShapeGraph &m_map;
+    std::vector<int> m_radii;
+    int m_weightedMeasureCol;
+    bool m_choice;
+    bool m_fulloutput;
+    bool m_local;
+    bool m_sampleChoice = false;
+    ChoiceSampler::Settings m_choiceSampling;
+
+  public:
+    // radii of -1 are the whole graph, and a weighted measure column of -1
+    // leaves out the weighted measures
+    AxialParallelIntegration(ShapeGraph &map, const std::set<double> &radiusSet,
+                             int weightedMeasureCol, bool choice, bool fulloutput, bool local);
+    std::string getAnalysisName() const override { return "Parallel Axial Analysis"; }
+    // estimates choice from a sample of the lines instead
+    void setChoiceSampling(ChoiceSampler::Settings choiceSampling) {
+        m_sampleChoice = true;
+        m_choiceSampling = choiceSampling;
+    }
+    AnalysisResult run(Communicator *comm) override;
+
+    // the measures of every line at every radius, radius by radius for each
+    // line. Weights are left empty for no weighted measures. Given a sample,
+    // only the lines in it are searched from, and the squares of choice are
+    // added up as well
+    static std::vector<Measures> analyseGraph(const Graph &graph, const std::vector<int> &radii,
+                                              bool choice, const std::vector<double> &weights,
+                                              Communicator *comm,
+                                              const std::vector<uint32_t> *sample = nullptr);
+    static std::vector<LocalMeasures> analyseLocal(const Graph &graph);
+};
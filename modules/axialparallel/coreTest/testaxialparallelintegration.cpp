@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/axialparallel/core/axialparallelintegration.hpp"
+#include "modules/parallelcommon/coreTest/salalibparity.hpp"
+
+#include "salalib/axialmodules/axialintegration.hpp"
+#include "salalib/axialmodules/axiallocal.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <numeric>
+#include <queue>
+#include <random>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+    std::vector<std::vector<uint32_t>> makeRandomLines(size_t lineCount, size_t connectionCount,
+                                                       unsigned int seed) {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(lineCount - 1));
+        std::vector<std::vector<uint32_t>> adjacency(lineCount);
+        for (size_t connection = 0; connection < connectionCount; connection++) {
+            uint32_t from = pick(generator), to = pick(generator);
+            if (from != to) {
+                adjacency[from].push_back(to);
+                adjacency[to].push_back(from);
+            }
+        }
+        return adjacency;
+    }
+
+    // depth and number of shortest paths to every line from one line
+    void searchFrom(const AxialParallelIntegration::Graph &graph, uint32_t origin,
+                    std::vector<int> &depth, std::vector<double> &paths) {
+        depth.assign(graph.nodeCount(), -1);
+        paths.assign(graph.nodeCount(), 0.0);
+        std::queue<uint32_t> queue;
+        depth[origin] = 0;
+        paths[origin] = 1.0;
+        queue.push(origin);
+        while (!queue.empty()) {
+            uint32_t node = queue.front();
+            queue.pop();
+            for (uint32_t connected : graph.neighbours(node)) {
+                if (depth[connected] == -1) {
+                    depth[connected] = depth[node] + 1;
+                    queue.push(connected);
+                }
+                if (depth[connected] == depth[node] + 1) {
+                    paths[connected] += paths[node];
+                }
+            }
+        }
+    }
+} // namespace
+
+TEST_CASE("Parallel axial analysis matches searching every pair of lines", "") {
+    AxialParallelIntegration::Graph graph(makeRandomLines(120, 200, 7));
+    std::vector<int> radii = {2, 3, -1};
+    std::vector<double> weights(graph.nodeCount());
+    for (size_t line = 0; line < weights.size(); line++) {
+        weights[line] = static_cast<double>(line % 5 + 1);
+    }
+    auto measures = AxialParallelIntegration::analyseGraph(graph, radii, true, weights, nullptr);
+
+    size_t lineCount = graph.nodeCount();
+    std::vector<std::vector<int>> depth(lineCount);
+    std::vector<std::vector<double>> paths(lineCount);
+    for (uint32_t line = 0; line < lineCount; line++) {
+        searchFrom(graph, line, depth[line], paths[line]);
+    }
+
+    for (size_t r = 0; r < radii.size(); r++) {
+        int radius = radii[r] == -1 ? std::numeric_limits<int>::max() : radii[r];
+        for (uint32_t line = 0; line < lineCount; line++) {
+            int nodeCount = 0, totalDepth = 0;
+            double weightReached = 0.0;
+            for (uint32_t other = 0; other < lineCount; other++) {
+                int otherDepth = depth[line][other];
+                if (otherDepth != -1 && otherDepth <= radius) {
+                    nodeCount++;
+                    totalDepth += otherDepth;
+                    weightReached += weights[other];
+                }
+            }
+            double choice = 0.0, weightedChoice = 0.0;
+            for (uint32_t from = 0; from < lineCount; from++) {
+                for (uint32_t to = 0; to < lineCount; to++) {
+                    int fromDepth = depth[from][line], toDepth = depth[line][to];
+                    int pathDepth = depth[from][to];
+                    if (from == line || to == line || from == to || pathDepth == -1 ||
+                        pathDepth > radius || fromDepth == -1 || toDepth == -1 ||
+                        fromDepth + toDepth != pathDepth) {
+                        continue;
+                    }
+                    double share = paths[from][line] * paths[line][to] / paths[from][to];
+                    choice += share;
+                    weightedChoice += share * weights[from] * weights[to];
+                }
+            }
+
+            const auto &measure = measures[line * radii.size() + r];
+            REQUIRE(measure.nodeCount == static_cast<float>(nodeCount));
+            REQUIRE(measure.totalWeight == Catch::Approx(weightReached));
+            if (nodeCount > 1) {
+                REQUIRE(measure.meanDepth ==
+                        Catch::Approx(double(totalDepth) / double(nodeCount - 1)));
+            } else {
+                REQUIRE(measure.meanDepth == -1.0f);
+            }
+            REQUIRE(measure.choice == Catch::Approx(choice).margin(1e-4));
+            REQUIRE(measure.weightedChoice == Catch::Approx(weightedChoice).margin(1e-3));
+        }
+    }
+}
+
+TEST_CASE("Parallel axial choice does not depend on the number of threads", "") {
+    AxialParallelIntegration::Graph graph(makeRandomLines(400, 900, 3));
+    std::vector<int> radii = {3, -1};
+    std::vector<double> weights(graph.nodeCount(), 0.1);
+
+    auto measures = AxialParallelIntegration::analyseGraph(graph, radii, true, weights, nullptr);
+#ifdef _OPENMP
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(threads > 1 ? 1 : 4);
+#endif
+    auto again = AxialParallelIntegration::analyseGraph(graph, radii, true, weights, nullptr);
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+
+    for (size_t idx = 0; idx < measures.size(); idx++) {
+        REQUIRE(measures[idx].choice == again[idx].choice);
+        REQUIRE(measures[idx].weightedChoice == again[idx].weightedChoice);
+    }
+}
+
+TEST_CASE("Parallel axial choice from a sample of lines", "") {
+    AxialParallelIntegration::Graph graph(makeRandomLines(200, 400, 5));
+    std::vector<int> radii = {-1, 3};
+    auto exact = AxialParallelIntegration::analyseGraph(graph, radii, true, {}, nullptr);
+
+    // from one line, the squares are those of its choice
+    std::vector<uint32_t> single = {4};
+    auto fromOne = AxialParallelIntegration::analyseGraph(graph, radii, true, {}, nullptr, &single);
+    for (const auto &measure : fromOne) {
+        REQUIRE(measure.choiceSquares ==
+                Catch::Approx(double(measure.choice) * measure.choice).margin(1e-3));
+    }
+
+    auto searcher = [&](const std::vector<uint32_t> &sample) {
+        auto fromSample =
+            AxialParallelIntegration::analyseGraph(graph, radii, true, {}, nullptr, &sample);
+        ChoiceSampler::Totals totals;
+        for (const auto &measure : fromSample) {
+            totals.choice.push_back(measure.choice);
+            totals.choiceSquares.push_back(measure.choiceSquares);
+        }
+        return totals;
+    };
+    std::vector<uint32_t> origins(graph.nodeCount());
+    std::iota(origins.begin(), origins.end(), 0);
+    ChoiceSampler::Settings settings;
+    settings.sampling = ChoiceSampler::Sampling::UNIFORM;
+    settings.sampleShare = 1.0;
+    auto everyLine = ChoiceSampler::estimate(origins, settings, searcher);
+    for (size_t idx = 0; idx < exact.size(); idx++) {
+        REQUIRE(everyLine.choice[idx] == Catch::Approx(exact[idx].choice).margin(1e-3));
+    }
+
+    settings.sampleShare = 0.25;
+    auto quarter = ChoiceSampler::estimate(origins, settings, searcher);
+    REQUIRE(quarter.sampleCount == 50);
+    size_t covered = 0;
+    for (size_t idx = 0; idx < exact.size(); idx++) {
+        if (std::abs(quarter.choice[idx] - exact[idx].choice) <= quarter.error[idx] + 1e-3) {
+            covered++;
+        }
+    }
+    // most within the 95% error, though a few lines that get much of their
+    // choice from a few others are less sure than the error makes out
+    REQUIRE(covered > exact.size() * 3 / 4);
+}
+
+TEST_CASE("Axial control and controllability", "") {
+    // a line crossing three others, one of which crosses a fifth
+    AxialParallelIntegration::Graph graph({{1, 2, 3}, {0}, {0, 4}, {0}, {2}, {}});
+    auto local = AxialParallelIntegration::analyseLocal(graph);
+
+    REQUIRE(local[0].control == Catch::Approx(1.0 + 0.5 + 1.0));
+    REQUIRE(local[0].controllability == Catch::Approx(3.0 / 4.0));
+    REQUIRE(local[1].control == Catch::Approx(1.0 / 3.0));
+    REQUIRE(local[1].controllability == Catch::Approx(1.0 / 3.0));
+    REQUIRE(local[5].control == -1.0f);
+    REQUIRE(local[5].controllability == -1.0f);
+}
+
+TEST_CASE("Parallel axial analysis matches salalib's axial analysis", "") {
+    auto data = salalibparity::readTestData("barnsbury_axial.graph");
+    REQUIRE(!data.shapeGraphs.empty());
+    ShapeGraph &map = *data.shapeGraphs.front();
+    salalibparity::QuietCommunicator comm;
+    std::set<double> radiusSet = {-1.0, 3.0};
+
+    AxialIntegration(map, radiusSet, -1, true, true).run(&comm);
+    AxialLocal(map).run(&comm);
+    std::vector<std::string> columns = {AxialParallelIntegration::Column::CONTROL,
+                                        AxialParallelIntegration::Column::CONTROLLABILITY};
+    for (double radius : radiusSet) {
+        for (auto &column : {AxialParallelIntegration::Column::CHOICE,
+                             AxialParallelIntegration::Column::CHOICE_NORM,
+                             AxialParallelIntegration::Column::ENTROPY,
+                             AxialParallelIntegration::Column::INTEGRATION_HH,
+                             AxialParallelIntegration::Column::INTEGRATION_PV,
+                             AxialParallelIntegration::Column::INTEGRATION_TK,
+                             AxialParallelIntegration::Column::INTENSITY,
+                             AxialParallelIntegration::Column::HARMONIC_MEAN_DEPTH,
+                             AxialParallelIntegration::Column::MEAN_DEPTH,
+                             AxialParallelIntegration::Column::NODE_COUNT,
+                             AxialParallelIntegration::Column::REL_ENTROPY}) {
+            columns.push_back(getColumnWithRadius(column, static_cast<int>(radius)));
+        }
+    }
+    auto expected = salalibparity::getColumns(map.getAttributeTable(), columns);
+
+    AxialParallelIntegration(map, radiusSet, -1, true, true, true).run(&comm);
+    salalibparity::requireSameColumns(map.getAttributeTable(), columns, expected);
+}
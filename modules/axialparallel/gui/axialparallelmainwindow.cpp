@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "axialparallelmainwindow.hpp"
+
+#include "modules/axialparallel/core/axialparallelintegration.hpp"
+
+#include "qtgui/dialogs/AxialAnalysisOptionsDlg.hpp"
+#include "qtgui/mainwindowhelpers.hpp"
+
+#include <QInputDialog>
+#include <QMenuBar>
+#include <QMessageBox>
+
+namespace {
+    // how to sample the lines that choice is estimated from, false if cancelled
+    bool getChoiceSampling(QWidget *parent, ChoiceSampler::Settings &settings) {
+        bool ok = false;
+        QStringList samplings = {QObject::tr("Adaptive"), QObject::tr("Uniform")};
+        QString sampling = QInputDialog::getItem(
+            parent, QObject::tr("Choice sampling"),
+            QObject::tr("Adaptive sampling searches from as many lines as it takes for the "
+                        "highest choice to be within the target error.\nUniform sampling "
+                        "searches from a fixed share of them"),
+            samplings, 0, false, &ok);
+        if (!ok)
+            return false;
+        if (sampling == samplings[0]) {
+            settings.sampling = ChoiceSampler::Sampling::ADAPTIVE;
+            double targetError = QInputDialog::getDouble(
+                parent, QObject::tr("Target error"),
+                QObject::tr("Error of the estimated choice to aim for, in percent"), 10.0, 0.1,
+                50.0, 1, &ok);
+            if (!ok)
+                return false;
+            settings.targetError = targetError / 100.0;
+            settings.sampleShare = 1.0;
+        } else {
+            settings.sampling = ChoiceSampler::Sampling::UNIFORM;
+            double share = QInputDialog::getDouble(
+                parent, QObject::tr("Sample size"),
+                QObject::tr("Share of the lines to search from, in percent"), 10.0, 0.1, 100.0,
+                1, &ok);
+            if (!ok)
+                return false;
+            settings.sampleShare = share / 100.0;
+        }
+        return true;
+    }
+} // namespace
+
+bool AxialParallelMainWindow::createMenus(MainWindow *mainWindow) {
+    QMenu *toolsMenu = MainWindowHelpers::getOrAddRootMenu(mainWindow, tr("&Tools"));
+    QMenu *axialMenu = MainWindowHelpers::getOrAddMenu(toolsMenu, tr("A&xial / Convex / Pesh"));
+
+    QAction *axialParallelAct = new QAction(tr("Run Parallel Graph Analysis..."), mainWindow);
+    axialParallelAct->setStatusTip(
+        tr("Axial analysis of the displayed map, searching from many lines at once"));
+    connect(axialParallelAct, &QAction::triggered, this,
+            [this, mainWindow] { OnAxialParallel(mainWindow, false); });
+    axialMenu->addAction(axialParallelAct);
+    QAction *axialSampledAct =
+        new QAction(tr("Run Parallel Graph Analysis (Sampled Choice)..."), mainWindow);
+    axialSampledAct->setStatusTip(
+        tr("Axial analysis of the displayed map, with choice estimated from a sample of lines"));
+    connect(axialSampledAct, &QAction::triggered, this,
+            [this, mainWindow] { OnAxialParallel(mainWindow, true); });
+    axialMenu->addAction(axialSampledAct);
+
+    return true;
+}
+
+void AxialParallelMainWindow::OnAxialParallel(MainWindow *mainWindow, bool sampleChoice) {
+    QGraphDoc *graphDoc = mainWindow->activeMapDoc();
+    if (graphDoc == nullptr)
+        return;
+
+    if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::AXIALMAP) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please make sure the displayed map is an axial map"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    // the dialog leaves its choices in the options of the main window
+    CAxialAnalysisOptionsDlg dlg(graphDoc->m_meta_graph);
+    if (dlg.exec() != QDialog::Accepted)
+        return;
+    const auto &options = mainWindow->m_options;
+    ChoiceSampler::Settings choiceSampling;
+    if (sampleChoice && options.choice && !getChoiceSampling(mainWindow, choiceSampling))
+        return;
+
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    auto &map = graphDoc->m_meta_graph->getDisplayedShapeGraph();
+    auto analysis = std::make_unique<AxialParallelIntegration>(
+        map.getInternalMap(), options.radiusSet, options.weightedMeasureCol, options.choice,
+        options.fulloutput, options.local);
+    if (sampleChoice) {
+        analysis->setChoiceSampling(choiceSampling);
+    }
+    comm->setAnalysis(std::move(analysis));
+    int radius = static_cast<int>(*options.radiusSet.rbegin());
+    if (options.radiusSet.count(-1) != 0) {
+        radius = -1;
+    }
+    comm->setPostAnalysisFunc([&map, radius](std::unique_ptr<IAnalysis> &, AnalysisResult &) {
+        map.overrideDisplayedAttribute(-2);
+        map.setDisplayedAttribute(getColumnWithRadius(
+            AxialParallelIntegration::Column::INTEGRATION_HH, radius));
+    });
+
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
+
+    graphDoc->submitJob(comm.release(), tr("Performing parallel axial line analysis..."),
+                        graphDoc->getDisplayedLayer());
+}
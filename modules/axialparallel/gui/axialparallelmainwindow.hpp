@@ -0,0 +1,16 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "qtgui/imainwindowmodule.hpp"
+
+class AxialParallelMainWindow : public IMainWindowModule {
+  private slots:
+    void OnAxialParallel(MainWindow *mainWindow, bool sampleChoice);
+
+  public:
+    AxialParallelMainWindow() : IMainWindowModule() {}
+    bool createMenus(MainWindow *mainWindow);
+};
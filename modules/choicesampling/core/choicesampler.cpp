@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "choicesampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+    // 95% confidence
+    constexpr double Z_VALUE = 1.96;
+    constexpr size_t PILOT_SAMPLES = 64;
+    // the values aimed at are the highest this share of those with any
+    // choice, and the sample is sized for all but the most uneven of them
+    constexpr double TOP_SHARE = 0.1;
+    constexpr double COVERED_SHARE = 0.9;
+} // namespace
+
+ChoiceSampler::Estimate ChoiceSampler::estimate(const std::vector<uint32_t> &origins,
+                                                const Settings &settings,
+                                                const Searcher &searcher) {
+    Estimate estimate;
+    size_t originCount = origins.size();
+    if (originCount == 0) {
+        return estimate;
+    }
+    double share = std::clamp(settings.sampleShare, 0.0, 1.0);
+    size_t largestSample = std::clamp(
+        static_cast<size_t>(std::ceil(share * static_cast<double>(originCount))), size_t(1),
+        originCount);
+
+    // every prefix of a shuffled order is a random sample
+    std::vector<uint32_t> order = origins;
+    std::mt19937 generator(settings.seed);
+    std::shuffle(order.begin(), order.end(), generator);
+
+    Totals totals;
+    size_t sampled = 0;
+    auto sampleTo = [&](size_t sampleCount) {
+        std::vector<uint32_t> sample(order.begin() + static_cast<std::ptrdiff_t>(sampled),
+                                     order.begin() + static_cast<std::ptrdiff_t>(sampleCount));
+        Totals added = searcher(sample);
+        if (totals.choice.empty()) {
+            totals = std::move(added);
+        } else {
+            for (size_t idx = 0; idx < totals.choice.size(); idx++) {
+                totals.choice[idx] += added.choice[idx];
+                totals.choiceSquares[idx] += added.choiceSquares[idx];
+            }
+        }
+        sampled = sampleCount;
+    };
+    // the choice from the average origin and how much that varies
+    auto mean = [&](size_t idx) { return totals.choice[idx] / static_cast<double>(sampled); };
+    auto variance = [&](size_t idx) {
+        double count = static_cast<double>(sampled);
+        double average = mean(idx);
+        return std::max(0.0, (totals.choiceSquares[idx] - count * average * average) /
+                                 (count - 1.0));
+    };
+
+    if (settings.sampling == Sampling::UNIFORM) {
+        sampleTo(largestSample);
+    } else {
+        sampleTo(std::min(largestSample, PILOT_SAMPLES));
+
+        std::vector<size_t> ranked;
+        for (size_t idx = 0; idx < totals.choice.size(); idx++) {
+            if (totals.choice[idx] > 0.0) {
+                ranked.push_back(idx);
+            }
+        }
+        size_t topCount = static_cast<size_t>(std::ceil(TOP_SHARE * double(ranked.size())));
+        std::nth_element(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(topCount),
+                         ranked.end(), [&](size_t a, size_t b) {
+                             return totals.choice[a] > totals.choice[b] ||
+                                    (totals.choice[a] == totals.choice[b] && a < b);
+                         });
+        ranked.resize(topCount);
+
+        // the sample size that brings the relative error of a value within
+        // the target, from how much its choice varied in the pilot
+        std::vector<double> needed;
+        if (sampled > 1) {
+            for (size_t idx : ranked) {
+                double relativeSpread = std::sqrt(variance(idx)) / mean(idx);
+                needed.push_back(std::pow(Z_VALUE * relativeSpread / settings.targetError, 2.0));
+            }
+        }
+        if (!needed.empty()) {
+            auto covered = needed.begin() + static_cast<std::ptrdiff_t>(
+                                                COVERED_SHARE * double(needed.size() - 1));
+            std::nth_element(needed.begin(), covered, needed.end());
+            // fewer are needed when the sample is a large part of the origins
+            double required = *covered / (1.0 + *covered / double(originCount));
+            size_t sampleCount = std::clamp(static_cast<size_t>(std::ceil(required)), sampled,
+                                            largestSample);
+            if (sampleCount > sampled) {
+                sampleTo(sampleCount);
+            }
+        }
+    }
+
+    estimate.sampleCount = sampled;
+    double count = static_cast<double>(sampled);
+    double scale = static_cast<double>(originCount) / count;
+    // none is left to estimate once every origin is in the sample
+    double correction = (double(originCount) - count) / std::max(1.0, double(originCount) - 1.0);
+    estimate.choice.resize(totals.choice.size());
+    estimate.error.assign(totals.choice.size(), -1.0);
+    for (size_t idx = 0; idx < totals.choice.size(); idx++) {
+        estimate.choice[idx] = totals.choice[idx] * scale;
+        if (sampled == originCount) {
+            estimate.error[idx] = 0.0;
+        } else if (sampled > 1) {
+            estimate.error[idx] = Z_VALUE * static_cast<double>(originCount) *
+                                  std::sqrt(variance(idx) / count * correction);
+        }
+    }
+    return estimate;
+}
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Choice estimated from searching only from a sample of the origins
+ *
+ * The choice of a node is the sum of what it gets from every origin, so
+ * the sum over a random sample of the origins, scaled up by how many there
+ * are in all, is an unbiased estimate of it. How much the choice from each
+ * origin varies gives the error of that estimate. Uniform sampling searches
+ * from a fixed share of the origins. Adaptive sampling searches from a
+ * pilot sample first and then from as many as it takes for the highest
+ * choice, which decides how the nodes rank, to be within the target error.
+ */
+class ChoiceSampler {
+  public:
+    enum class Sampling { UNIFORM, ADAPTIVE };
+
+    struct Settings {
+        Sampling sampling = Sampling::ADAPTIVE;
+        // the share of the origins searched from when uniform, and the most
+        // that adaptive sampling may search from
+        double sampleShare = 0.1;
+        // relative error at 95% confidence, aimed at by adaptive sampling
+        double targetError = 0.1;
+        unsigned int seed = 0;
+    };
+
+    // choice from some of the origins, and the squares of the choice from
+    // each of them, by value
+    struct Totals {
+        std::vector<double> choice;
+        std::vector<double> choiceSquares;
+    };
+    // searches from the given origins, which are never searched from twice
+    using Searcher = std::function<Totals(const std::vector<uint32_t> &origins)>;
+
+    struct Estimate {
+        size_t sampleCount = 0;
+        std::vector<double> choice;
+        // half the width of the 95% confidence interval of the choice, -1
+        // where a single origin was searched from
+        std::vector<double> error;
+    };
+
+    static Estimate estimate(const std::vector<uint32_t> &origins, const Settings &settings,
+                             const Searcher &searcher);
+};
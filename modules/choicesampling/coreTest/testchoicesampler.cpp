@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/choicesampling/core/choicesampler.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <numeric>
+
+namespace {
+    // the choice each of the origins gives to each of three values
+    std::vector<std::vector<double>> makeChoice(size_t originCount) {
+        std::vector<std::vector<double>> choice(originCount);
+        for (size_t origin = 0; origin < originCount; origin++) {
+            double spread = static_cast<double>(origin % 7);
+            choice[origin] = {10.0, 5.0 + spread, spread * spread};
+        }
+        return choice;
+    }
+
+    ChoiceSampler::Searcher makeSearcher(const std::vector<std::vector<double>> &choice,
+                                         std::vector<uint32_t> &searched) {
+        return [&choice, &searched](const std::vector<uint32_t> &origins) {
+            ChoiceSampler::Totals totals;
+            totals.choice.assign(3, 0.0);
+            totals.choiceSquares.assign(3, 0.0);
+            for (uint32_t origin : origins) {
+                searched.push_back(origin);
+                for (size_t idx = 0; idx < 3; idx++) {
+                    totals.choice[idx] += choice[origin][idx];
+                    totals.choiceSquares[idx] += choice[origin][idx] * choice[origin][idx];
+                }
+            }
+            return totals;
+        };
+    }
+} // namespace
+
+TEST_CASE("Choice sampled from every origin is exact", "") {
+    auto choice = makeChoice(50);
+    std::vector<uint32_t> origins(50), searched;
+    std::iota(origins.begin(), origins.end(), 0);
+
+    ChoiceSampler::Settings settings;
+    settings.sampling = ChoiceSampler::Sampling::UNIFORM;
+    settings.sampleShare = 1.0;
+    auto estimate = ChoiceSampler::estimate(origins, settings, makeSearcher(choice, searched));
+
+    REQUIRE(estimate.sampleCount == 50);
+    REQUIRE(searched.size() == 50);
+    for (size_t idx = 0; idx < 3; idx++) {
+        double exact = 0.0;
+        for (const auto &fromOrigin : choice) {
+            exact += fromOrigin[idx];
+        }
+        REQUIRE(estimate.choice[idx] == Catch::Approx(exact));
+        REQUIRE(estimate.error[idx] == 0.0);
+    }
+}
+
+TEST_CASE("Uniformly sampled choice is scaled up to all the origins", "") {
+    auto choice = makeChoice(1000);
+    std::vector<uint32_t> origins(1000), searched;
+    std::iota(origins.begin(), origins.end(), 0);
+
+    ChoiceSampler::Settings settings;
+    settings.sampling = ChoiceSampler::Sampling::UNIFORM;
+    settings.sampleShare = 0.2;
+    settings.seed = 3;
+    auto estimate = ChoiceSampler::estimate(origins, settings, makeSearcher(choice, searched));
+
+    REQUIRE(estimate.sampleCount == 200);
+    std::sort(searched.begin(), searched.end());
+    REQUIRE(std::adjacent_find(searched.begin(), searched.end()) == searched.end());
+    // the same from every origin, so nothing to be unsure of
+    REQUIRE(estimate.choice[0] == Catch::Approx(10000.0));
+    REQUIRE(estimate.error[0] == Catch::Approx(0.0).margin(1e-6));
+    double exact = 0.0;
+    for (const auto &fromOrigin : choice) {
+        exact += fromOrigin[1];
+    }
+    REQUIRE(estimate.error[1] > 0.0);
+    REQUIRE(std::abs(estimate.choice[1] - exact) < estimate.error[1] * 2.0);
+
+    std::vector<uint32_t> again;
+    auto repeated = ChoiceSampler::estimate(origins, settings, makeSearcher(choice, again));
+    REQUIRE(repeated.choice == estimate.choice);
+}
+
+TEST_CASE("Adaptive sampling searches from more origins for uneven choice", "") {
+    auto choice = makeChoice(5000);
+    std::vector<uint32_t> origins(5000), searched;
+    std::iota(origins.begin(), origins.end(), 0);
+
+    ChoiceSampler::Settings settings;
+    settings.sampling = ChoiceSampler::Sampling::ADAPTIVE;
+    settings.sampleShare = 1.0;
+    settings.targetError = 0.05;
+    auto estimate = ChoiceSampler::estimate(origins, settings, makeSearcher(choice, searched));
+
+    REQUIRE(estimate.sampleCount > 64);
+    REQUIRE(estimate.sampleCount < 5000);
+    REQUIRE(searched.size() == estimate.sampleCount);
+    // the highest choice is the one aimed at
+    REQUIRE(estimate.error[2] / estimate.choice[2] < 0.05 * 1.5);
+
+    // and no further than the largest share allowed
+    settings.sampleShare = 0.02;
+    auto capped = ChoiceSampler::estimate(origins, settings, makeSearcher(choice, searched));
+    REQUIRE(capped.sampleCount == 100);
+}
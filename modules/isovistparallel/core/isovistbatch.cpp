@@ -0,0 +1,252 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "isovistbatch.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/shapemap.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+    constexpr double TWO_PI = 2.0 * M_PI;
+    // the rays either side of a vertex are this far from it, in radians
+    constexpr double ANGLE_STEP = 1e-9;
+    // a vertex seen only this much closer than it is counts as in view
+    constexpr double VERTEX_MARGIN = 1e-9;
+    // edges shorter than this part of the region are not occluding, as
+    // those from a vertex to the rays either side of it where lines meet
+    constexpr double EDGE_TOLERANCE = 1e-6;
+
+    double normaliseAngle(double angle) {
+        angle = std::fmod(angle, TWO_PI);
+        return angle < 0.0 ? angle + TWO_PI : angle;
+    }
+
+    struct Event {
+        // from the start of the isovist
+        double angle;
+        double distance;
+    };
+
+    struct Corner {
+        IsovistCaster::Point point;
+        // the point of a partial isovist
+        bool location;
+    };
+
+    void measure(IsovistBatch::Isovist &isovist, const std::vector<Corner> &corners,
+                 const IsovistBatch::Definition &definition, double tolerance) {
+        double area = 0.0, centroidX = 0.0, centroidY = 0.0;
+        isovist.minRadial = -1.0;
+        for (size_t i = 0; i < corners.size(); i++) {
+            const Corner &from = corners[i];
+            const Corner &to = corners[(i + 1) % corners.size()];
+            // relative to the point, to keep the sums small
+            double fx = from.point.x - definition.x, fy = from.point.y - definition.y;
+            double tx = to.point.x - definition.x, ty = to.point.y - definition.y;
+            double cross = fx * ty - tx * fy;
+            area += cross;
+            centroidX += (fx + tx) * cross;
+            centroidY += (fy + ty) * cross;
+            double length = std::hypot(tx - fx, ty - fy);
+            isovist.perimeter += length;
+            // edges along the rays are those from a vertex to the surface
+            // behind it, the rest lie on a line or the edge of the region
+            bool alongRay = std::abs(cross) <= 4.0 * ANGLE_STEP * std::hypot(fx, fy) *
+                                                   std::hypot(tx, ty);
+            if (alongRay && !from.location && !to.location && length > tolerance) {
+                isovist.occlusivity += length;
+            }
+            if (!from.location && !to.location) {
+                // the nearest point of the edge, which may lie between its ends
+                double ex = tx - fx, ey = ty - fy;
+                double along = length > 0.0 ? std::clamp(-(fx * ex + fy * ey) /
+                                                             (length * length),
+                                                         0.0, 1.0)
+                                            : 0.0;
+                double nearest = std::hypot(fx + along * ex, fy + along * ey);
+                isovist.minRadial =
+                    isovist.minRadial < 0.0 ? nearest : std::min(isovist.minRadial, nearest);
+            }
+            if (!from.location) {
+                isovist.maxRadial = std::max(isovist.maxRadial, std::hypot(fx, fy));
+            }
+        }
+        isovist.area = area * 0.5;
+        if (isovist.area > 0.0) {
+            centroidX /= 6.0 * isovist.area;
+            centroidY /= 6.0 * isovist.area;
+            isovist.driftMagnitude = std::hypot(centroidX, centroidY);
+            isovist.driftAngle = normaliseAngle(std::atan2(centroidY, centroidX)) * 180.0 / M_PI;
+        }
+        if (isovist.perimeter > 0.0) {
+            isovist.compactness =
+                4.0 * M_PI * isovist.area / (isovist.perimeter * isovist.perimeter);
+        }
+        isovist.minRadial = std::max(isovist.minRadial, 0.0);
+    }
+} // namespace
+
+IsovistBatch::Isovist IsovistBatch::makeIsovist(const IsovistCaster &caster,
+                                                const Definition &definition) {
+    Isovist isovist;
+    if (!caster.contains(definition.x, definition.y)) {
+        return isovist;
+    }
+    bool full = normaliseAngle(definition.leftAngle - definition.rightAngle) == 0.0;
+    double start = full ? 0.0 : normaliseAngle(definition.rightAngle);
+    double span = full ? TWO_PI : normaliseAngle(definition.leftAngle - definition.rightAngle);
+    double reach = caster.getDiagonal();
+    double tolerance = EDGE_TOLERANCE * reach;
+
+    std::vector<Event> events;
+    for (auto &vertex : caster.getVertices()) {
+        double dx = vertex.x - definition.x, dy = vertex.y - definition.y;
+        double distance = std::hypot(dx, dy);
+        double angle = normaliseAngle(std::atan2(dy, dx) - start);
+        if (distance > 0.0 && angle <= span) {
+            events.push_back({angle, distance});
+        }
+    }
+    std::sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+        return a.angle < b.angle || (a.angle == b.angle && a.distance < b.distance);
+    });
+
+    std::vector<Corner> corners;
+    auto addCorner = [&](IsovistCaster::Point point) {
+        if (!corners.empty() && std::abs(corners.back().point.x - point.x) <= tolerance &&
+            std::abs(corners.back().point.y - point.y) <= tolerance) {
+            return;
+        }
+        corners.push_back({point, false});
+    };
+    // where the ray lands, and how far that is
+    auto castAt = [&](double angle) {
+        double dirX = std::cos(start + angle), dirY = std::sin(start + angle);
+        auto hit = caster.cast(definition.x, definition.y, dirX, dirY, reach);
+        return std::make_pair(IsovistCaster::Point{definition.x + dirX * hit.distance,
+                                                   definition.y + dirY * hit.distance},
+                              hit.distance);
+    };
+
+    if (!full) {
+        corners.push_back({{definition.x, definition.y}, true});
+        addCorner(castAt(0.0).first);
+    }
+    const Event *previous = nullptr;
+    for (auto &event : events) {
+        // lines meeting at a vertex give it once for each
+        if (previous && event.angle - previous->angle < ANGLE_STEP * 0.5 &&
+            std::abs(event.distance - previous->distance) <= tolerance) {
+            continue;
+        }
+        double dirX = std::cos(start + event.angle), dirY = std::sin(start + event.angle);
+        auto hit = caster.cast(definition.x, definition.y, dirX, dirY,
+                               event.distance * (1.0 - VERTEX_MARGIN));
+        if (hit.line != IsovistCaster::REGION_EDGE) {
+            continue;
+        }
+        previous = &event;
+        bool hasBefore = full || event.angle >= ANGLE_STEP;
+        bool hasAfter = full || event.angle + ANGLE_STEP <= span;
+        auto before = hasBefore ? castAt(event.angle - ANGLE_STEP) : castAt(event.angle);
+        auto after = hasAfter ? castAt(event.angle + ANGLE_STEP) : castAt(event.angle);
+        if (hasBefore) {
+            addCorner(before.first);
+        }
+        // a line seen end on leaves space on both sides of its end, which
+        // would otherwise stick out of the outline as a spike
+        if (before.second <= event.distance + tolerance ||
+            after.second <= event.distance + tolerance) {
+            addCorner({definition.x + dirX * event.distance, definition.y + dirY * event.distance});
+        }
+        if (hasAfter) {
+            addCorner(after.first);
+        }
+    }
+    if (!full) {
+        addCorner(castAt(span).first);
+    }
+    if (corners.size() >= 3) {
+        isovist.polygon.reserve(corners.size());
+        for (auto &corner : corners) {
+            isovist.polygon.push_back(corner.point);
+        }
+        measure(isovist, corners, definition, tolerance);
+    }
+    return isovist;
+}
+
+void IsovistBatch::makeIsovists(const IsovistCaster &caster,
+                                const std::vector<Definition> &definitions,
+                                const AppendFunc &append, Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("making isovists");
+    }
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, definitions.size());
+    }
+    std::vector<Isovist> batch(std::min(BATCH_SIZE, definitions.size()));
+    std::atomic<bool> cancelled(false);
+    for (size_t first = 0; first < definitions.size(); first += BATCH_SIZE) {
+        int count = static_cast<int>(std::min(BATCH_SIZE, definitions.size() - first));
+
+        parallelFor(static_cast<size_t>(count), 4, [&](size_t i, int thread) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                return;
+            }
+            batch[i] =
+                makeIsovist(caster, definitions[first + i]);
+            if (telemetry) {
+                telemetry->addRecords(static_cast<size_t>(thread), 1);
+            }
+            if (comm && thread == 0 && comm->IsCancelled()) {
+                cancelled = true;
+            }
+        });
+        if (cancelled) {
+            throw Communicator::CancelledException();
+        }
+
+        for (size_t i = 0; i < static_cast<size_t>(count); i++) {
+            append(first + i, batch[i]);
+        }
+        if (comm) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD,
+                                  first + static_cast<size_t>(count));
+        }
+    }
+}
+
+int IsovistBatch::appendToMap(ShapeMap &map, const Isovist &isovist, bool simpleVersion) {
+    std::vector<Point2f> points;
+    points.reserve(isovist.polygon.size());
+    for (auto &point : isovist.polygon) {
+        points.emplace_back(point.x, point.y);
+    }
+    int shapeRef = map.makePolyShape(points, false);
+    AttributeTable &attributes = map.getAttributeTable();
+    AttributeRow &row = attributes.getRow(AttributeKey(shapeRef));
+    auto setValue = [&](const std::string &column, double value) {
+        row.setValue(attributes.getOrInsertColumn(column), static_cast<float>(value));
+    };
+    setValue(Column::ISOVIST_AREA, isovist.area);
+    if (!simpleVersion) {
+        setValue(Column::ISOVIST_COMPACTNESS, isovist.compactness);
+        setValue(Column::ISOVIST_DRIFT_ANGLE, isovist.driftAngle);
+        setValue(Column::ISOVIST_DRIFT_MAGNITUDE, isovist.driftMagnitude);
+        setValue(Column::ISOVIST_MIN_RADIAL, isovist.minRadial);
+        setValue(Column::ISOVIST_MAX_RADIAL, isovist.maxRadial);
+        setValue(Column::ISOVIST_OCCLUSIVITY, isovist.occlusivity);
+        setValue(Column::ISOVIST_PERIMETER, isovist.perimeter);
+    }
+    return shapeRef;
+}
@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "isovistcaster.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class Communicator;
+class ShapeMap;
+
+/**
+ * @brief Makes many isovists at once, such as those read from a file
+ *
+ * Each isovist is found by casting a ray to every vertex of the drawing
+ * around the point, and to either side of the ones it sees, since the
+ * nearest surface only changes at those. The isovists are independent and
+ * made on all cores, a batch at a time. Each batch is handed over in the
+ * order of the definitions before the next is started, so that the data map
+ * they are added to comes out the same whatever the number of threads.
+ */
+class IsovistBatch {
+  public:
+    static constexpr size_t BATCH_SIZE = 256;
+
+    struct Column {
+        inline static const std::string                          //
+            ISOVIST_AREA = "Isovist Area",                       //
+            ISOVIST_COMPACTNESS = "Isovist Compactness",         //
+            ISOVIST_DRIFT_ANGLE = "Isovist Drift Angle",         //
+            ISOVIST_DRIFT_MAGNITUDE = "Isovist Drift Magnitude", //
+            ISOVIST_MIN_RADIAL = "Isovist Min Radial",           //
+            ISOVIST_MAX_RADIAL = "Isovist Max Radial",           //
+            ISOVIST_OCCLUSIVITY = "Isovist Occlusivity",         //
+            ISOVIST_PERIMETER = "Isovist Perimeter";             //
+    };
+
+    struct Definition {
+        double x, y;
+        // in radians, the isovist looks anticlockwise from the right angle to
+        // the left one. Equal angles make a full isovist
+        double leftAngle = 0.0;
+        double rightAngle = 0.0;
+    };
+
+    struct Isovist {
+        // anticlockwise, starting at the point itself for partial isovists.
+        // Empty for points outside the region of the drawing
+        std::vector<IsovistCaster::Point> polygon;
+        double area = 0.0;
+        double perimeter = 0.0;
+        double compactness = 0.0;
+        // from the point to the centroid, the angle in degrees
+        double driftAngle = 0.0;
+        double driftMagnitude = 0.0;
+        double minRadial = 0.0;
+        double maxRadial = 0.0;
+        // the length of the edges that are not on a surface, behind which
+        // there is space hidden from the point
+        double occlusivity = 0.0;
+    };
+
+    // called on the calling thread, with the isovists in order
+    using AppendFunc = std::function<void(size_t index, Isovist &isovist)>;
+
+    static Isovist makeIsovist(const IsovistCaster &caster, const Definition &definition);
+    // throws if cancelled, once the batches done so far have been handed over
+    static void makeIsovists(const IsovistCaster &caster,
+                             const std::vector<Definition> &definitions, const AppendFunc &append,
+                             Communicator *comm);
+    // adds the isovist as a polygon with its measures, returns the shape. The
+    // simple version only has the area, as the isovists of the main program
+    static int appendToMap(ShapeMap &map, const Isovist &isovist, bool simpleVersion);
+};
@@ -0,0 +1,238 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "isovistcaster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // cells are sized for about this many per line
+    constexpr double CELLS_PER_LINE = 2.0;
+    constexpr int MAX_CELLS_PER_SIDE = 1024;
+    // lines are tested this many at a time
+    constexpr size_t LANES = 64;
+    constexpr double NO_CROSSING = std::numeric_limits<double>::infinity();
+
+    // the distance along the ray from the origin to where it crosses the line,
+    // all relative to the start of the ray. Branchless so that it runs a lane
+    // per line
+#pragma omp declare simd
+    inline double crossing(double dirX, double dirY, double startX, double startY, double alongX,
+                           double alongY) {
+        double denominator = dirX * alongY - dirY * alongX;
+        double divisor = denominator != 0.0 ? denominator : 1.0;
+        double t = (startX * alongY - startY * alongX) / divisor;
+        double u = (startX * dirY - startY * dirX) / divisor;
+        bool crosses = denominator != 0.0 && t > 0.0 && u >= 0.0 && u <= 1.0;
+        return crosses ? t : NO_CROSSING;
+    }
+
+    // whether the line passes through the box, by the sides of the line the
+    // corners of the box fall on
+    bool overlaps(const IsovistCaster::Line &line, double minX, double minY, double maxX,
+                  double maxY) {
+        double ex = line.x2 - line.x1, ey = line.y2 - line.y1;
+        bool below = false, above = false;
+        for (double x : {minX, maxX}) {
+            for (double y : {minY, maxY}) {
+                double side = ex * (y - line.y1) - ey * (x - line.x1);
+                below = below || side <= 0.0;
+                above = above || side >= 0.0;
+            }
+        }
+        return below && above;
+    }
+} // namespace
+
+IsovistCaster::IsovistCaster(std::vector<Line> lines, double minX, double minY, double maxX,
+                             double maxY)
+    : m_lines(std::move(lines)), m_minX(minX), m_minY(minY), m_maxX(maxX), m_maxY(maxY) {
+    indexLines();
+    findVertices();
+}
+
+double IsovistCaster::getDiagonal() const { return std::hypot(m_maxX - m_minX, m_maxY - m_minY); }
+
+void IsovistCaster::indexLines() {
+    double width = std::max(m_maxX - m_minX, 1e-9);
+    double height = std::max(m_maxY - m_minY, 1e-9);
+    double cellCount = std::max(1.0, CELLS_PER_LINE * static_cast<double>(m_lines.size()));
+    m_cellSize = std::max({std::sqrt(width * height / cellCount), width / MAX_CELLS_PER_SIDE,
+                           height / MAX_CELLS_PER_SIDE});
+    m_cols = std::max(1, static_cast<int>(std::ceil(width / m_cellSize)));
+    m_rows = std::max(1, static_cast<int>(std::ceil(height / m_cellSize)));
+
+    // the cells each line passes through, counted first and then filled in
+    auto forCellsOf = [this](const Line &line, auto cellFunc) {
+        auto clampCol = [this](double x) {
+            return std::clamp(static_cast<int>(std::floor((x - m_minX) / m_cellSize)), 0,
+                              m_cols - 1);
+        };
+        auto clampRow = [this](double y) {
+            return std::clamp(static_cast<int>(std::floor((y - m_minY) / m_cellSize)), 0,
+                              m_rows - 1);
+        };
+        int firstCol = clampCol(std::min(line.x1, line.x2));
+        int lastCol = clampCol(std::max(line.x1, line.x2));
+        int firstRow = clampRow(std::min(line.y1, line.y2));
+        int lastRow = clampRow(std::max(line.y1, line.y2));
+        for (int col = firstCol; col <= lastCol; col++) {
+            for (int row = firstRow; row <= lastRow; row++) {
+                double cellX = m_minX + col * m_cellSize, cellY = m_minY + row * m_cellSize;
+                if (overlaps(line, cellX, cellY, cellX + m_cellSize, cellY + m_cellSize)) {
+                    cellFunc(static_cast<size_t>(col) * static_cast<size_t>(m_rows) +
+                             static_cast<size_t>(row));
+                }
+            }
+        }
+    };
+
+    size_t cellCountTotal = static_cast<size_t>(m_cols) * static_cast<size_t>(m_rows);
+    m_cellStart.assign(cellCountTotal + 1, 0);
+    for (auto &line : m_lines) {
+        forCellsOf(line, [this](size_t cell) { m_cellStart[cell + 1]++; });
+    }
+    for (size_t cell = 0; cell < cellCountTotal; cell++) {
+        m_cellStart[cell + 1] += m_cellStart[cell];
+    }
+    size_t entries = m_cellStart.back();
+    m_startX.resize(entries);
+    m_startY.resize(entries);
+    m_alongX.resize(entries);
+    m_alongY.resize(entries);
+    m_lineOf.resize(entries);
+    std::vector<uint32_t> filled(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (size_t index = 0; index < m_lines.size(); index++) {
+        const Line &line = m_lines[index];
+        forCellsOf(line, [&](size_t cell) {
+            uint32_t entry = filled[cell]++;
+            m_startX[entry] = line.x1;
+            m_startY[entry] = line.y1;
+            m_alongX[entry] = line.x2 - line.x1;
+            m_alongY[entry] = line.y2 - line.y1;
+            m_lineOf[entry] = static_cast<uint32_t>(index);
+        });
+    }
+}
+
+void IsovistCaster::findVertices() {
+    m_vertices.push_back({m_minX, m_minY});
+    m_vertices.push_back({m_maxX, m_minY});
+    m_vertices.push_back({m_maxX, m_maxY});
+    m_vertices.push_back({m_minX, m_maxY});
+    for (auto &line : m_lines) {
+        for (Point end : {Point{line.x1, line.y1}, Point{line.x2, line.y2}}) {
+            if (contains(end.x, end.y)) {
+                m_vertices.push_back(end);
+            }
+        }
+    }
+    // lines crossing each other away from their ends, each pair found in the
+    // cell the crossing falls in
+    for (int col = 0; col < m_cols; col++) {
+        for (int row = 0; row < m_rows; row++) {
+            size_t cell = static_cast<size_t>(col) * static_cast<size_t>(m_rows) +
+                          static_cast<size_t>(row);
+            for (size_t a = m_cellStart[cell]; a < m_cellStart[cell + 1]; a++) {
+                for (size_t b = a + 1; b < m_cellStart[cell + 1]; b++) {
+                    double denominator = m_alongX[a] * m_alongY[b] - m_alongY[a] * m_alongX[b];
+                    if (denominator == 0.0) {
+                        continue;
+                    }
+                    double wx = m_startX[b] - m_startX[a], wy = m_startY[b] - m_startY[a];
+                    double s = (wx * m_alongY[b] - wy * m_alongX[b]) / denominator;
+                    double u = (wx * m_alongY[a] - wy * m_alongX[a]) / denominator;
+                    if (s <= 0.0 || s >= 1.0 || u <= 0.0 || u >= 1.0) {
+                        continue;
+                    }
+                    Point crossing{m_startX[a] + s * m_alongX[a], m_startY[a] + s * m_alongY[a]};
+                    double cellX = m_minX + col * m_cellSize, cellY = m_minY + row * m_cellSize;
+                    if (crossing.x >= cellX && crossing.x < cellX + m_cellSize &&
+                        crossing.y >= cellY && crossing.y < cellY + m_cellSize &&
+                        contains(crossing.x, crossing.y)) {
+                        m_vertices.push_back(crossing);
+                    }
+                }
+            }
+        }
+    }
+}
+
+IsovistCaster::Hit IsovistCaster::cast(double x, double y, double dirX, double dirY,
+                                       double maxDistance) const {
+    if (!contains(x, y)) {
+        return {0.0, REGION_EDGE};
+    }
+    double exitX = dirX > 0.0   ? (m_maxX - x) / dirX
+                   : dirX < 0.0 ? (m_minX - x) / dirX
+                                : NO_CROSSING;
+    double exitY = dirY > 0.0   ? (m_maxY - y) / dirY
+                   : dirY < 0.0 ? (m_minY - y) / dirY
+                                : NO_CROSSING;
+    Hit best{std::min({exitX, exitY, maxDistance}), REGION_EDGE};
+
+    int col = std::clamp(static_cast<int>(std::floor((x - m_minX) / m_cellSize)), 0, m_cols - 1);
+    int row = std::clamp(static_cast<int>(std::floor((y - m_minY) / m_cellSize)), 0, m_rows - 1);
+    int stepCol = dirX > 0.0 ? 1 : -1;
+    int stepRow = dirY > 0.0 ? 1 : -1;
+    // the distance to the next column and row of cells, and between them
+    double nextCol = dirX > 0.0   ? (m_minX + (col + 1) * m_cellSize - x) / dirX
+                     : dirX < 0.0 ? (m_minX + col * m_cellSize - x) / dirX
+                                  : NO_CROSSING;
+    double nextRow = dirY > 0.0   ? (m_minY + (row + 1) * m_cellSize - y) / dirY
+                     : dirY < 0.0 ? (m_minY + row * m_cellSize - y) / dirY
+                                  : NO_CROSSING;
+    double colStep = dirX != 0.0 ? m_cellSize / std::abs(dirX) : NO_CROSSING;
+    double rowStep = dirY != 0.0 ? m_cellSize / std::abs(dirY) : NO_CROSSING;
+
+    double distances[LANES];
+    while (true) {
+        size_t cell =
+            static_cast<size_t>(col) * static_cast<size_t>(m_rows) + static_cast<size_t>(row);
+        size_t last = m_cellStart[cell + 1];
+        for (size_t first = m_cellStart[cell]; first < last; first += LANES) {
+            size_t count = std::min(LANES, last - first);
+            const double *startX = m_startX.data() + first;
+            const double *startY = m_startY.data() + first;
+            const double *alongX = m_alongX.data() + first;
+            const double *alongY = m_alongY.data() + first;
+#pragma omp simd
+            for (size_t i = 0; i < count; i++) {
+                distances[i] =
+                    crossing(dirX, dirY, startX[i] - x, startY[i] - y, alongX[i], alongY[i]);
+            }
+            for (size_t i = 0; i < count; i++) {
+                // lines win over the edge of the region they lie along
+                if (distances[i] <= best.distance) {
+                    best = {distances[i], m_lineOf[first + i]};
+                }
+            }
+        }
+        // lines in later cells are all further away than the far side of this
+        double cellExit = std::min(nextCol, nextRow);
+        if (best.distance <= cellExit) {
+            break;
+        }
+        if (nextCol < nextRow) {
+            col += stepCol;
+            nextCol += colStep;
+        } else {
+            row += stepRow;
+            nextRow += rowStep;
+        }
+        if (col < 0 || row < 0 || col >= m_cols || row >= m_rows) {
+            break;
+        }
+    }
+    return best;
+}
+
+double IsovistCaster::crossingDistance(uint32_t line, double x, double y, double dirX,
+                                       double dirY) const {
+    const Line &crossed = m_lines[line];
+    return crossing(dirX, dirY, crossed.x1 - x, crossed.y1 - y, crossed.x2 - crossed.x1,
+                    crossed.y2 - crossed.y1);
+}
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Casts rays against the drawing lines of a map
+ *
+ * The lines are kept in a uniform grid of square cells over the region of
+ * the map, each cell holding the lines that pass through it with their
+ * coordinates side by side so that a cell is tested several lines at a time.
+ * A ray walks the cells it crosses from its start and stops at the first
+ * cell that holds a line closer than the far side of the cell, so it costs
+ * about as much as the space it sees. The index is built once and is only
+ * read afterwards, so any number of threads may cast at the same time.
+ */
+class IsovistCaster {
+  public:
+    struct Line {
+        double x1, y1, x2, y2;
+    };
+
+    struct Point {
+        double x, y;
+    };
+
+    // the surface of a ray that leaves the region without hitting a line
+    static constexpr uint32_t REGION_EDGE = 0xffffffff;
+
+    struct Hit {
+        double distance;
+        // the line hit, or REGION_EDGE
+        uint32_t line;
+    };
+
+  private:
+    std::vector<Line> m_lines;
+    double m_minX, m_minY, m_maxX, m_maxY;
+    double m_cellSize = 1.0;
+    int m_cols = 1;
+    int m_rows = 1;
+    // the lines of each cell, one after the other
+    std::vector<uint32_t> m_cellStart;
+    std::vector<double> m_startX, m_startY, m_alongX, m_alongY;
+    std::vector<uint32_t> m_lineOf;
+    // the ends of the lines, where they cross and the corners of the region,
+    // the only places where the nearest surface seen from a point may change
+    std::vector<Point> m_vertices;
+
+    void indexLines();
+    void findVertices();
+
+  public:
+    // points outside the region see nothing
+    IsovistCaster(std::vector<Line> lines, double minX, double minY, double maxX, double maxY);
+
+    const std::vector<Line> &getLines() const { return m_lines; }
+    const std::vector<Point> &getVertices() const { return m_vertices; }
+    bool contains(double x, double y) const {
+        return x >= m_minX && y >= m_minY && x <= m_maxX && y <= m_maxY;
+    }
+    double getDiagonal() const;
+
+    // the first surface along the ray from the point in the direction of unit
+    // length. Stops at maxDistance, returning REGION_EDGE as when it leaves
+    // the region. Lines through the start of the ray do not block it, lines
+    // along the edge of the region do
+    Hit cast(double x, double y, double dirX, double dirY, double maxDistance) const;
+    // the distance along the ray to where it crosses the given line, or
+    // infinity if it does not
+    double crossingDistance(uint32_t line, double x, double y, double dirX, double dirY) const;
+};
@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "isovistfield.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/pointmap.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+    // whether the jump between the landings of two neighbouring rays opens
+    // onto space hidden from the point
+    bool occludes(const IsovistCaster &caster, double x, double y, const IsovistCaster::Hit &near,
+                  double nearDirX, double nearDirY, const IsovistCaster::Hit &far,
+                  double farDirX, double farDirY) {
+        // the edge of the region goes on everywhere
+        if (near.line == IsovistCaster::REGION_EDGE) {
+            return false;
+        }
+        // the near line carries on to the far ray, as a wall seen at a slant
+        if (std::isfinite(caster.crossingDistance(near.line, x, y, farDirX, farDirY))) {
+            return false;
+        }
+        // the far surface ends as well, where the two meet at a corner
+        return far.line == IsovistCaster::REGION_EDGE ||
+               caster.crossingDistance(far.line, x, y, nearDirX, nearDirY) > near.distance;
+    }
+} // namespace
+
+IsovistField::IsovistField(PointMap &map, IsovistCaster caster, int rayCount)
+    : m_map(map), m_caster(std::move(caster)), m_rayCount(rayCount) {}
+
+IsovistField::Result IsovistField::analysePoints(const IsovistCaster &caster,
+                                                 const std::vector<IsovistCaster::Point> &points,
+                                                 int rayCount, Communicator *comm) {
+    if (rayCount < MIN_RAY_COUNT) {
+        throw genlib::RuntimeException("Isovists need at least " + std::to_string(MIN_RAY_COUNT) +
+                                       " rays");
+    }
+    size_t pointCount = points.size();
+    size_t rays = static_cast<size_t>(rayCount);
+    Result result;
+    result.area.resize(pointCount);
+    result.perimeter.resize(pointCount);
+    result.occlusivity.resize(pointCount);
+    result.minRadial.resize(pointCount);
+    result.maxRadial.resize(pointCount);
+
+    std::vector<double> dirX(rays), dirY(rays);
+    double step = 2.0 * M_PI / rayCount;
+    for (size_t ray = 0; ray < rays; ray++) {
+        dirX[ray] = std::cos(step * static_cast<double>(ray));
+        dirY[ray] = std::sin(step * static_cast<double>(ray));
+    }
+    double reach = caster.getDiagonal();
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("casting rays");
+    }
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, pointCount);
+    }
+    std::atomic<size_t> pointsDone(0);
+    std::atomic<bool> cancelled(false);
+
+#pragma omp parallel num_threads(getThreadBudget())
+    {
+        std::vector<IsovistCaster::Hit> hits(rays);
+
+#pragma omp for schedule(dynamic, 64)
+        for (int pointIdx = 0; pointIdx < static_cast<int>(pointCount); pointIdx++) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            int thread = getThreadNum();
+            size_t index = static_cast<size_t>(pointIdx);
+            double x = points[index].x, y = points[index].y;
+            for (size_t ray = 0; ray < rays; ray++) {
+                hits[ray] = caster.cast(x, y, dirX[ray], dirY[ray], reach);
+            }
+
+            double area = 0.0, perimeter = 0.0, occlusivity = 0.0;
+            double minRadial = reach, maxRadial = 0.0;
+            for (size_t ray = 0; ray < rays; ray++) {
+                size_t next = (ray + 1) % rays;
+                const auto &from = hits[ray], &to = hits[next];
+                area += 0.5 * from.distance * to.distance * std::sin(step);
+                perimeter += std::hypot(to.distance * dirX[next] - from.distance * dirX[ray],
+                                        to.distance * dirY[next] - from.distance * dirY[ray]);
+                minRadial = std::min(minRadial, from.distance);
+                maxRadial = std::max(maxRadial, from.distance);
+                bool fromNearer = from.distance < to.distance;
+                if (fromNearer ? occludes(caster, x, y, from, dirX[ray], dirY[ray], to,
+                                          dirX[next], dirY[next])
+                               : occludes(caster, x, y, to, dirX[next], dirY[next], from,
+                                          dirX[ray], dirY[ray])) {
+                    occlusivity += std::abs(to.distance - from.distance);
+                }
+            }
+            result.area[index] = static_cast<float>(area);
+            result.perimeter[index] = static_cast<float>(perimeter);
+            result.occlusivity[index] = static_cast<float>(occlusivity);
+            result.minRadial[index] = static_cast<float>(minRadial);
+            result.maxRadial[index] = static_cast<float>(maxRadial);
+
+            if (telemetry) {
+                telemetry->addRecords(static_cast<size_t>(thread));
+            }
+            size_t done = pointsDone.fetch_add(1) + 1;
+            if (comm && thread == 0) {
+                comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+                if (comm->IsCancelled()) {
+                    cancelled = true;
+                }
+            }
+        }
+    }
+
+    if (cancelled) {
+        throw Communicator::CancelledException();
+    }
+    return result;
+}
+
+AnalysisResult IsovistField::run(Communicator *comm) {
+    const AttributeTable &attributes = m_map.getAttributeTable();
+    std::vector<int> refs;
+    std::vector<IsovistCaster::Point> points;
+    refs.reserve(attributes.getNumRows());
+    points.reserve(attributes.getNumRows());
+    for (auto iter = attributes.begin(); iter != attributes.end(); iter++) {
+        int ref = iter->getKey().value;
+        Point2f centre = m_map.depixelate(ref);
+        refs.push_back(ref);
+        points.push_back({centre.x, centre.y});
+    }
+
+    auto field = analysePoints(m_caster, points, m_rayCount, comm);
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    AttributeTable &table = m_map.getAttributeTable();
+    size_t areaCol = table.insertOrResetColumn(Column::ISOVIST_AREA);
+    size_t perimeterCol = table.insertOrResetColumn(Column::ISOVIST_PERIMETER);
+    size_t occlusivityCol = table.insertOrResetColumn(Column::ISOVIST_OCCLUSIVITY);
+    size_t minRadialCol = table.insertOrResetColumn(Column::ISOVIST_MIN_RADIAL);
+    size_t maxRadialCol = table.insertOrResetColumn(Column::ISOVIST_MAX_RADIAL);
+    for (size_t node = 0; node < refs.size(); node++) {
+        AttributeRow &row = table.getRow(AttributeKey(refs[node]));
+        row.setValue(areaCol, field.area[node]);
+        row.setValue(perimeterCol, field.perimeter[node]);
+        row.setValue(occlusivityCol, field.occlusivity[node]);
+        row.setValue(minRadialCol, field.minRadial[node]);
+        row.setValue(maxRadialCol, field.maxRadial[node]);
+    }
+
+    AnalysisResult analysisResult;
+    analysisResult.completed = true;
+    return analysisResult;
+}
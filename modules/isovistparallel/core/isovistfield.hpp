@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "isovistbatch.hpp"
+#include "isovistcaster.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+#include <vector>
+
+class PointMap;
+
+/**
+ * @brief Isovist measures of every filled cell of a visibility graph map
+ *
+ * Each cell casts a fan of rays at even angles against the drawing lines
+ * and its isovist is taken to be the polygon through where they land. No
+ * graph is needed, and the cells are independent, so they are spread over
+ * all cores. Where the line nearest the cell ends between two rays and the
+ * surface behind carries on past it, the jump between them is counted as
+ * occluding.
+ */
+class IsovistField : public IAnalysis {
+  private:
+    PointMap &m_map;
+    IsovistCaster m_caster;
+    int m_rayCount;
+
+  public:
+    static constexpr int DEFAULT_RAY_COUNT = 1024;
+    static constexpr int MIN_RAY_COUNT = 16;
+
+    // the same columns as the isovists made one at a time
+    using Column = IsovistBatch::Column;
+
+    struct Result {
+        std::vector<float> area;
+        std::vector<float> perimeter;
+        std::vector<float> occlusivity;
+        std::vector<float> minRadial;
+        std::vector<float> maxRadial;
+    };
+
+  public:
+    // the caster holds the lines of the drawing layers that are shown
+    IsovistField(PointMap &map, IsovistCaster caster, int rayCount = DEFAULT_RAY_COUNT);
+    std::string getAnalysisName() const override { return "Isovist Field"; }
+    AnalysisResult run(Communicator *comm) override;
+
+    static Result analysePoints(const IsovistCaster &caster,
+                                const std::vector<IsovistCaster::Point> &points, int rayCount,
+                                Communicator *comm);
+};
@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/isovistparallel/core/isovistbatch.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <cmath>
+#include <random>
+
+namespace {
+    // a room with a door to a corridor and a few screens, with the lines
+    // meeting and crossing as in drawings
+    std::vector<IsovistCaster::Line> makeOffice() {
+        return {{0.0, 0.0, 20.0, 0.0},  {20.0, 0.0, 20.0, 12.0}, {20.0, 12.0, 0.0, 12.0},
+                {0.0, 12.0, 0.0, 0.0},  {0.0, 8.0, 9.0, 8.0},    {11.0, 8.0, 20.5, 8.0},
+                {4.0, 2.0, 6.0, 5.0},   {12.0, 3.0, 16.0, 3.0},  {14.0, 1.0, 14.0, 5.0},
+                {8.5, 9.0, 9.5, 11.0}};
+    }
+
+    // the first line along the ray, trying all of them
+    double castAll(const std::vector<IsovistCaster::Line> &lines, double x, double y, double dirX,
+                   double dirY, double maxDistance) {
+        double best = maxDistance;
+        for (auto &line : lines) {
+            double ax = line.x2 - line.x1, ay = line.y2 - line.y1;
+            double denominator = dirX * ay - dirY * ax;
+            if (denominator == 0.0) {
+                continue;
+            }
+            double wx = line.x1 - x, wy = line.y1 - y;
+            double t = (wx * ay - wy * ax) / denominator;
+            double u = (wx * dirY - wy * dirX) / denominator;
+            if (t > 0.0 && u >= 0.0 && u <= 1.0) {
+                best = std::min(best, t);
+            }
+        }
+        return best;
+    }
+
+    // the area seen, summed over thin slices
+    double sampledArea(const IsovistCaster &caster, double x, double y) {
+        int rays = 200000;
+        double area = 0.0;
+        for (int ray = 0; ray < rays; ray++) {
+            double angle = 2.0 * M_PI * (ray + 0.5) / rays;
+            double distance =
+                caster.cast(x, y, std::cos(angle), std::sin(angle), caster.getDiagonal())
+                    .distance;
+            area += 0.5 * distance * distance * 2.0 * M_PI / rays;
+        }
+        return area;
+    }
+} // namespace
+
+TEST_CASE("Cast rays stop at the first line", "") {
+    auto lines = makeOffice();
+    IsovistCaster caster(lines, 0.0, 0.0, 20.0, 12.0);
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> x(0.0, 20.0), y(0.0, 12.0), angle(0.0, 2.0 * M_PI);
+    for (int ray = 0; ray < 2000; ray++) {
+        double fromX = x(generator), fromY = y(generator), along = angle(generator);
+        double dirX = std::cos(along), dirY = std::sin(along);
+        auto hit = caster.cast(fromX, fromY, dirX, dirY, caster.getDiagonal());
+        REQUIRE(hit.distance ==
+                Catch::Approx(castAll(lines, fromX, fromY, dirX, dirY, caster.getDiagonal())));
+    }
+}
+
+TEST_CASE("Isovists match their measures", "") {
+    SECTION("Empty room") {
+        IsovistCaster caster({{0.0, 0.0, 10.0, 0.0}}, 0.0, 0.0, 10.0, 10.0);
+        auto isovist = IsovistBatch::makeIsovist(caster, {3.0, 4.0});
+        REQUIRE(isovist.area == Catch::Approx(100.0));
+        REQUIRE(isovist.perimeter == Catch::Approx(40.0));
+        REQUIRE(isovist.occlusivity == Catch::Approx(0.0).margin(1e-6));
+        REQUIRE(isovist.compactness == Catch::Approx(M_PI / 4.0));
+        REQUIRE(isovist.driftMagnitude == Catch::Approx(std::hypot(2.0, 1.0)));
+        REQUIRE(isovist.driftAngle == Catch::Approx(std::atan2(1.0, 2.0) * 180.0 / M_PI));
+        REQUIRE(isovist.maxRadial == Catch::Approx(std::hypot(7.0, 6.0)));
+
+        // looking up and to the right only
+        auto partial = IsovistBatch::makeIsovist(caster, {3.0, 4.0, M_PI * 0.5, 0.0});
+        REQUIRE(partial.area == Catch::Approx(42.0));
+        REQUIRE(partial.polygon.front().x == 3.0);
+        REQUIRE(partial.polygon.front().y == 4.0);
+    }
+    SECTION("Office") {
+        IsovistCaster caster(makeOffice(), 0.0, 0.0, 20.0, 12.0);
+        for (auto [x, y] : {std::pair{2.0, 3.0}, {13.0, 2.0}, {10.0, 10.0}, {18.0, 7.0}}) {
+            auto isovist = IsovistBatch::makeIsovist(caster, {x, y});
+            REQUIRE(isovist.area == Catch::Approx(sampledArea(caster, x, y)).epsilon(1e-3));
+            REQUIRE(isovist.occlusivity > 0.0);
+            REQUIRE(isovist.occlusivity < isovist.perimeter);
+        }
+    }
+    SECTION("Outside the region") {
+        IsovistCaster caster(makeOffice(), 0.0, 0.0, 20.0, 12.0);
+        REQUIRE(IsovistBatch::makeIsovist(caster, {25.0, 3.0}).polygon.empty());
+    }
+}
+
+TEST_CASE("Batches of isovists come out in order", "") {
+    IsovistCaster caster(makeOffice(), 0.0, 0.0, 20.0, 12.0);
+    std::mt19937 generator(9);
+    std::uniform_real_distribution<double> x(0.5, 19.5), y(0.5, 11.5), angle(0.0, 2.0 * M_PI);
+    std::vector<IsovistBatch::Definition> definitions;
+    for (size_t i = 0; i < IsovistBatch::BATCH_SIZE * 2 + 10; i++) {
+        double left = angle(generator);
+        definitions.push_back({x(generator), y(generator), left, i % 2 == 0 ? left : 0.0});
+    }
+    size_t next = 0;
+    IsovistBatch::makeIsovists(
+        caster, definitions,
+        [&](size_t index, IsovistBatch::Isovist &isovist) {
+            REQUIRE(index == next++);
+            auto expected = IsovistBatch::makeIsovist(caster, definitions[index]);
+            REQUIRE(isovist.polygon.size() == expected.polygon.size());
+            REQUIRE(isovist.area == expected.area);
+        },
+        nullptr);
+    REQUIRE(next == definitions.size());
+}
@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/isovistparallel/core/isovistbatch.hpp"
+#include "modules/isovistparallel/core/isovistfield.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+
+#include "catch_amalgamated.hpp"
+
+namespace {
+    // open plan with a core, desks and a partition that meets a wall
+    std::vector<IsovistCaster::Line> makeFloor() {
+        return {{0.0, 0.0, 30.0, 0.0},   {30.0, 0.0, 30.0, 20.0}, {30.0, 20.0, 0.0, 20.0},
+                {0.0, 20.0, 0.0, 0.0},   {12.0, 8.0, 18.0, 8.0},  {18.0, 8.0, 18.0, 12.0},
+                {18.0, 12.0, 12.0, 12.0}, {12.0, 12.0, 12.0, 8.0}, {3.0, 3.0, 6.0, 3.5},
+                {24.0, 15.0, 26.0, 17.0}, {22.0, 0.0, 22.0, 5.0}};
+    }
+} // namespace
+
+TEST_CASE("Isovist field matches the exact isovists", "") {
+    IsovistCaster caster(makeFloor(), 0.0, 0.0, 30.0, 20.0);
+    std::vector<IsovistCaster::Point> points = {
+        {2.0, 2.0}, {9.5, 10.0}, {20.0, 3.0}, {27.0, 18.0}, {15.0, 16.5}, {25.0, 8.0}};
+    auto field = IsovistField::analysePoints(caster, points, 4096, nullptr);
+    for (size_t point = 0; point < points.size(); point++) {
+        auto exact = IsovistBatch::makeIsovist(caster, {points[point].x, points[point].y});
+        REQUIRE(field.area[point] == Catch::Approx(exact.area).epsilon(0.005));
+        REQUIRE(field.perimeter[point] == Catch::Approx(exact.perimeter).epsilon(0.02));
+        REQUIRE(field.minRadial[point] == Catch::Approx(exact.minRadial).margin(0.01));
+        REQUIRE(field.maxRadial[point] == Catch::Approx(exact.maxRadial).epsilon(0.005));
+        REQUIRE(field.occlusivity[point] == Catch::Approx(exact.occlusivity).epsilon(0.05));
+    }
+}
+
+TEST_CASE("Isovist field needs enough rays", "") {
+    IsovistCaster caster(makeFloor(), 0.0, 0.0, 30.0, 20.0);
+    REQUIRE_THROWS_AS(IsovistField::analysePoints(caster, {{5.0, 5.0}},
+                                                  IsovistField::MIN_RAY_COUNT - 1, nullptr),
+                      genlib::RuntimeException);
+}
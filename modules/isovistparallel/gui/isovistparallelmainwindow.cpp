@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "isovistparallelmainwindow.hpp"
+
+#include "modules/isovistparallel/core/isovistfield.hpp"
+
+#include "qtgui/mainwindowhelpers.hpp"
+
+#include <QInputDialog>
+#include <QMenuBar>
+#include <QMessageBox>
+
+bool IsovistParallelMainWindow::createMenus(MainWindow *mainWindow) {
+    QMenu *toolsMenu = MainWindowHelpers::getOrAddRootMenu(mainWindow, tr("&Tools"));
+    QMenu *visibilityMenu = MainWindowHelpers::getOrAddMenu(toolsMenu, tr("&Visibility"));
+
+    QAction *isovistFieldAct = new QAction(tr("Isovist Field"), mainWindow);
+    isovistFieldAct->setStatusTip(
+        tr("Isovist area, perimeter, occlusivity and radials of every cell of the vga map"));
+    connect(isovistFieldAct, &QAction::triggered, this,
+            [this, mainWindow] { OnIsovistField(mainWindow); });
+    visibilityMenu->addAction(isovistFieldAct);
+
+    return true;
+}
+
+void IsovistParallelMainWindow::OnIsovistField(MainWindow *mainWindow) {
+    QGraphDoc *graphDoc = mainWindow->activeMapDoc();
+    if (graphDoc == nullptr)
+        return;
+
+    if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::LATTICEMAP) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please make sure the displayed map is a vga map"), QMessageBox::Ok,
+                             QMessageBox::Ok);
+        return;
+    }
+
+    bool ok;
+    int rayCount = QInputDialog::getInt(
+        mainWindow, tr("Isovist rays"),
+        tr("Number of rays cast from each cell.\nMore rays follow the walls more closely"),
+        IsovistField::DEFAULT_RAY_COUNT, IsovistField::MIN_RAY_COUNT, 65536, 256, &ok);
+    if (!ok)
+        return;
+
+    // the drawing layers that are shown block the rays
+    std::vector<IsovistCaster::Line> lines;
+    for (const SimpleLine &line : graphDoc->m_meta_graph->getVisibleDrawingLines()) {
+        lines.push_back({line.start().x, line.start().y, line.end().x, line.end().y});
+    }
+    Region4f region = graphDoc->m_meta_graph->getBoundingBox();
+    IsovistCaster caster(std::move(lines), region.bottomLeft.x, region.bottomLeft.y,
+                         region.topRight.x, region.topRight.y);
+
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+    comm->setAnalysis(
+        std::make_unique<IsovistField>(map.getInternalMap(), std::move(caster), rayCount));
+    comm->setPostAnalysisFunc([&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+        map.overrideDisplayedAttribute(-2);
+        map.setDisplayedAttribute(IsovistField::Column::ISOVIST_AREA);
+    });
+
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
+
+    graphDoc->submitJob(comm.release(), tr("Making isovist field..."),
+                        graphDoc->getDisplayedLayer());
+}
@@ -0,0 +1,16 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "qtgui/imainwindowmodule.hpp"
+
+class IsovistParallelMainWindow : public IMainWindowModule {
+  private slots:
+    void OnIsovistField(MainWindow *mainWindow);
+
+  public:
+    IsovistParallelMainWindow() : IMainWindowModule() {}
+    bool createMenus(MainWindow *mainWindow);
+};
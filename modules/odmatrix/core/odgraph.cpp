@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "odgraph.hpp"
+
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ODGraph ODGraph::fromPointMap(PointMap &map) {
+    VGACSRGraph visibility = VGACSRGraph::fromPointMap(map);
+    ODGraph graph;
+    graph.m_refs.reserve(visibility.nodeCount());
+    graph.m_edges.reserve(visibility.edgeCount());
+    std::vector<Edge> edges;
+    for (size_t node = 0; node < visibility.nodeCount(); node++) {
+        double x = visibility.getX(node), y = visibility.getY(node);
+        edges.clear();
+        for (uint32_t target : visibility.neighbours(node)) {
+            edges.push_back({target, static_cast<float>(std::hypot(visibility.getX(target) - x,
+                                                                   visibility.getY(target) - y))});
+        }
+        // merged points are the same place
+        if (visibility.getMerge(node) != VGACSRGraph::NO_MERGE) {
+            edges.push_back({visibility.getMerge(node), 0.0f});
+        }
+        graph.addNode(visibility.getRef(node), x, y, edges);
+    }
+    return graph;
+}
+
+ODGraph ODGraph::fromShapeGraph(ShapeGraph &map) {
+    auto &shapes = map.getAllShapes();
+    auto &connectors = map.getConnections();
+    if (connectors.size() != shapes.size()) {
+        throw genlib::RuntimeException("The connections of the segment map have not been made");
+    }
+    std::vector<double> lengths;
+    lengths.reserve(shapes.size());
+    for (auto &shape : shapes) {
+        lengths.push_back(shape.second.getLine().length());
+    }
+
+    ODGraph graph;
+    graph.m_refs.reserve(shapes.size());
+    std::vector<Edge> edges;
+    size_t node = 0;
+    for (auto &shape : shapes) {
+        edges.clear();
+        // the segment connections are keyed by the index of the segment
+        for (auto *segconns : {&connectors[node].backSegconns, &connectors[node].forwardSegconns}) {
+            for (auto &connection : *segconns) {
+                auto target = static_cast<size_t>(connection.first.ref);
+                if (target >= shapes.size()) {
+                    throw genlib::RuntimeException("Segment connected to a missing segment");
+                }
+                edges.push_back({static_cast<uint32_t>(target),
+                                 static_cast<float>((lengths[node] + lengths[target]) * 0.5)});
+            }
+        }
+        Point2f centroid = shape.second.getCentroid();
+        graph.addNode(shape.first, centroid.x, centroid.y, edges);
+        node++;
+    }
+    return graph;
+}
+
+void ODGraph::addNode(int ref, double x, double y, const std::vector<Edge> &edges) {
+    m_nodeOfRef.emplace(ref, static_cast<uint32_t>(m_refs.size()));
+    m_refs.push_back(ref);
+    m_x.push_back(x);
+    m_y.push_back(y);
+    m_edges.insert(m_edges.end(), edges.begin(), edges.end());
+    m_offsets.push_back(m_edges.size());
+}
+
+uint32_t ODGraph::findNode(int ref) const {
+    auto it = m_nodeOfRef.find(ref);
+    return it == m_nodeOfRef.end() ? NO_NODE : it->second;
+}
+
+std::vector<uint32_t>
+ODGraph::nearestNodes(const std::vector<std::pair<double, double>> &locations) const {
+    std::vector<uint32_t> nearest(locations.size(), NO_NODE);
+    if (m_refs.empty()) {
+        return nearest;
+    }
+
+    // a grid over the nodes with about one node in each cell
+    auto [minX, maxX] = std::minmax_element(m_x.begin(), m_x.end());
+    auto [minY, maxY] = std::minmax_element(m_y.begin(), m_y.end());
+    double left = *minX, bottom = *minY;
+    int side = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(m_refs.size()))));
+    double cellWidth = std::max((*maxX - left) / side, 1e-9);
+    double cellHeight = std::max((*maxY - bottom) / side, 1e-9);
+    auto cellOf = [&](double position, double origin, double size) {
+        return std::clamp(static_cast<int>(std::floor((position - origin) / size)), 0, side - 1);
+    };
+    auto indexOf = [side](int column, int row) {
+        return static_cast<size_t>(row) * static_cast<size_t>(side) + static_cast<size_t>(column);
+    };
+    std::vector<size_t> cellStart(static_cast<size_t>(side) * static_cast<size_t>(side) + 1, 0);
+    for (size_t node = 0; node < m_refs.size(); node++) {
+        cellStart[indexOf(cellOf(m_x[node], left, cellWidth),
+                          cellOf(m_y[node], bottom, cellHeight)) +
+                  1]++;
+    }
+    for (size_t cell = 1; cell < cellStart.size(); cell++) {
+        cellStart[cell] += cellStart[cell - 1];
+    }
+    std::vector<uint32_t> cellNodes(m_refs.size());
+    std::vector<size_t> filled(cellStart.begin(), cellStart.end() - 1);
+    for (size_t node = 0; node < m_refs.size(); node++) {
+        size_t cell =
+            indexOf(cellOf(m_x[node], left, cellWidth), cellOf(m_y[node], bottom, cellHeight));
+        cellNodes[filled[cell]++] = static_cast<uint32_t>(node);
+    }
+
+    double cellSize = std::min(cellWidth, cellHeight);
+    for (size_t location = 0; location < locations.size(); location++) {
+        auto [x, y] = locations[location];
+        int column = cellOf(x, left, cellWidth), row = cellOf(y, bottom, cellHeight);
+        double best = std::numeric_limits<double>::infinity();
+        // rings of cells around the one of the location, until no node
+        // further out can be nearer
+        for (int ring = 0; ring <= side && best > (ring - 1) * cellSize; ring++) {
+            for (int cellRow = row - ring; cellRow <= row + ring; cellRow++) {
+                if (cellRow < 0 || cellRow >= side) {
+                    continue;
+                }
+                bool edgeRow = cellRow == row - ring || cellRow == row + ring;
+                for (int cellColumn = column - ring; cellColumn <= column + ring;
+                     cellColumn += edgeRow ? 1 : std::max(1, 2 * ring)) {
+                    if (cellColumn < 0 || cellColumn >= side) {
+                        continue;
+                    }
+                    size_t cell = indexOf(cellColumn, cellRow);
+                    for (size_t entry = cellStart[cell]; entry < cellStart[cell + 1]; entry++) {
+                        uint32_t node = cellNodes[entry];
+                        double distance = std::hypot(m_x[node] - x, m_y[node] - y);
+                        if (distance < best) {
+                            best = distance;
+                            nearest[location] = node;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return nearest;
+}
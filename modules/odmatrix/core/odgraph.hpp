@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class PointMap;
+class ShapeGraph;
+
+/**
+ * @brief Weighted graph of the cells of a visibility graph map or the
+ * segments of a segment map
+ *
+ * Nodes keep the ref of their row in the attribute table of the map and a
+ * position, so that locations from other layers can be snapped to them.
+ * Connections are kept in compressed sparse row form with their lengths, and
+ * the graph is a read-only snapshot that can be searched from many threads.
+ */
+class ODGraph {
+  public:
+    static constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+    struct Edge {
+        uint32_t target;
+        float length;
+    };
+
+  private:
+    std::vector<int> m_refs;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    std::vector<size_t> m_offsets;
+    std::vector<Edge> m_edges;
+    std::unordered_map<int, uint32_t> m_nodeOfRef;
+
+  public:
+    ODGraph() : m_offsets(1, 0) {}
+
+    // cells are connected to all the cells they see, at the distance between
+    // their centres
+    static ODGraph fromPointMap(PointMap &map);
+    // segments are connected to the segments they meet, at half the length of
+    // each, so that a path is as long as the segments it goes along. Needs the
+    // connections of the map to have been made
+    static ODGraph fromShapeGraph(ShapeGraph &map);
+
+    // appends the next node. The edges may lead to nodes only added later
+    void addNode(int ref, double x, double y, const std::vector<Edge> &edges);
+
+    size_t nodeCount() const { return m_refs.size(); }
+    size_t edgeCount() const { return m_edges.size(); }
+    int getRef(size_t node) const { return m_refs[node]; }
+    double getX(size_t node) const { return m_x[node]; }
+    double getY(size_t node) const { return m_y[node]; }
+    const Edge *edgesBegin(size_t node) const { return m_edges.data() + m_offsets[node]; }
+    const Edge *edgesEnd(size_t node) const { return m_edges.data() + m_offsets[node + 1]; }
+
+    // NO_NODE if no node has the ref
+    uint32_t findNode(int ref) const;
+    // the node nearest to each of the locations, NO_NODE for all of them if
+    // the graph is empty
+    std::vector<uint32_t>
+    nearestNodes(const std::vector<std::pair<double, double>> &locations) const;
+};
@@ -0,0 +1,278 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "odmatrix.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+#include "modules/vgaparallel/core/vgaradixheap.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/pointmap.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <limits>
+
+namespace {
+    const char matrixMagic[8] = {'D', 'M', 'X', 'O', 'D', 'M', 'X', '1'};
+
+    template <typename T> void writeValue(std::ofstream &stream, const T &value) {
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    std::vector<uint32_t> nodesOf(const ODGraph &graph, const std::vector<int> &refs,
+                                  const std::vector<std::pair<double, double>> &locations) {
+        std::vector<uint32_t> nodes;
+        nodes.reserve(refs.size() + locations.size());
+        for (int ref : refs) {
+            uint32_t node = graph.findNode(ref);
+            if (node == ODGraph::NO_NODE) {
+                throw genlib::RuntimeException("Ref " + std::to_string(ref) +
+                                               " is not part of the map");
+            }
+            nodes.push_back(node);
+        }
+        auto snapped = graph.nearestNodes(locations);
+        nodes.insert(nodes.end(), snapped.begin(), snapped.end());
+        return nodes;
+    }
+} // namespace
+
+ODMatrix::ODMatrix(PointMap &map, Settings settings)
+    : m_pointMap(&map), m_settings(std::move(settings)) {}
+
+ODMatrix::ODMatrix(ShapeGraph &map, Settings settings)
+    : m_shapeGraph(&map), m_settings(std::move(settings)) {}
+
+ODMatrix::Result ODMatrix::analyse(const ODGraph &graph, const std::vector<uint32_t> &origins,
+                                   const std::vector<uint32_t> &destinations,
+                                   Communicator *comm) {
+    size_t nodeCount = graph.nodeCount();
+    for (auto *nodes : {&origins, &destinations}) {
+        for (uint32_t node : *nodes) {
+            if (node >= nodeCount) {
+                throw genlib::RuntimeException("Origin or destination outside the map");
+            }
+        }
+    }
+    Result result;
+    for (uint32_t origin : origins) {
+        result.originRefs.push_back(graph.getRef(origin));
+    }
+    for (uint32_t destination : destinations) {
+        result.destinationRefs.push_back(graph.getRef(destination));
+    }
+    size_t destinationCount = destinations.size();
+    result.distances.assign(origins.size() * destinationCount, UNREACHABLE);
+    result.routeCounts.assign(nodeCount, 0);
+
+    // destinations may share a node, each being the end of its own route
+    std::vector<uint32_t> destinationsAt(nodeCount, 0);
+    size_t distinctDestinations = 0;
+    for (uint32_t destination : destinations) {
+        if (destinationsAt[destination]++ == 0) {
+            distinctDestinations++;
+        }
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("searching from origins");
+    }
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, origins.size());
+    }
+    std::vector<std::vector<uint32_t>> threadRouteCounts(static_cast<size_t>(getMaxThreads()));
+    std::atomic<size_t> originsDone(0);
+    std::atomic<bool> cancelled(false);
+
+#pragma omp parallel num_threads(getThreadBudget())
+    {
+        int thread = getThreadNum();
+        auto &routeCounts = threadRouteCounts[static_cast<size_t>(thread)];
+        routeCounts.assign(nodeCount, 0);
+        std::vector<double> distance(nodeCount, std::numeric_limits<double>::infinity());
+        std::vector<uint32_t> parent(nodeCount, ODGraph::NO_NODE);
+        std::vector<uint8_t> settled(nodeCount, 0);
+        // routes ending in the part of the search tree below each node
+        std::vector<uint32_t> routesBelow(nodeCount, 0);
+        std::vector<uint32_t> touched;
+        std::vector<uint32_t> order;
+        VGARadixHeap heap;
+
+#pragma omp for schedule(dynamic, 1)
+        for (int originIdx = 0; originIdx < static_cast<int>(origins.size()); originIdx++) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            size_t row = static_cast<size_t>(originIdx);
+            uint32_t origin = origins[row];
+            distance[origin] = 0.0;
+            touched.push_back(origin);
+            heap.push(0.0, origin);
+            size_t remaining = distinctDestinations;
+            while (!heap.empty() && remaining > 0) {
+                auto [nodeDistance, node] = heap.pop();
+                if (settled[node]) {
+                    continue;
+                }
+                settled[node] = 1;
+                order.push_back(node);
+                if (destinationsAt[node] > 0) {
+                    remaining--;
+                }
+                for (const auto *edge = graph.edgesBegin(node); edge != graph.edgesEnd(node);
+                     edge++) {
+                    double through = nodeDistance + edge->length;
+                    if (through < distance[edge->target]) {
+                        if (distance[edge->target] == std::numeric_limits<double>::infinity()) {
+                            touched.push_back(edge->target);
+                        }
+                        distance[edge->target] = through;
+                        parent[edge->target] = node;
+                        heap.push(through, edge->target);
+                    }
+                }
+            }
+
+            float *distances = result.distances.data() + row * destinationCount;
+            for (size_t column = 0; column < destinationCount; column++) {
+                if (settled[destinations[column]]) {
+                    distances[column] = static_cast<float>(distance[destinations[column]]);
+                }
+            }
+            // nodes are settled after their parents, so going backwards each
+            // node has all the routes below it before passing them up
+            for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                uint32_t node = *it;
+                if (node != origin) {
+                    routesBelow[node] += destinationsAt[node];
+                    routesBelow[parent[node]] += routesBelow[node];
+                }
+                routeCounts[node] += routesBelow[node];
+            }
+
+            for (uint32_t node : touched) {
+                distance[node] = std::numeric_limits<double>::infinity();
+                parent[node] = ODGraph::NO_NODE;
+                settled[node] = 0;
+                routesBelow[node] = 0;
+            }
+            touched.clear();
+            order.clear();
+            heap.clear();
+
+            if (telemetry) {
+                telemetry->addRecords(static_cast<size_t>(thread));
+            }
+            size_t done = originsDone.fetch_add(1) + 1;
+            if (comm && thread == 0) {
+                comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+                if (comm->IsCancelled()) {
+                    cancelled = true;
+                }
+            }
+        }
+    }
+
+    if (cancelled) {
+        throw Communicator::CancelledException();
+    }
+    for (auto &routeCounts : threadRouteCounts) {
+        for (size_t node = 0; node < routeCounts.size(); node++) {
+            result.routeCounts[node] += routeCounts[node];
+        }
+    }
+    return result;
+}
+
+void ODMatrix::writeCSV(const Result &result, const std::string &filename) {
+    std::ofstream stream(filename, std::ios::trunc);
+    if (!stream) {
+        throw genlib::RuntimeException("Unable to write matrix file " + filename);
+    }
+    stream << "Origin";
+    for (int ref : result.destinationRefs) {
+        stream << ',' << ref;
+    }
+    stream << '\n';
+    for (size_t origin = 0; origin < result.originRefs.size(); origin++) {
+        stream << result.originRefs[origin];
+        for (size_t destination = 0; destination < result.destinationRefs.size();
+             destination++) {
+            stream << ',' << result.getDistance(origin, destination);
+        }
+        stream << '\n';
+    }
+    if (!stream) {
+        throw genlib::RuntimeException("Unable to write matrix file " + filename);
+    }
+}
+
+void ODMatrix::writeBinary(const Result &result, const std::string &filename) {
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw genlib::RuntimeException("Unable to write matrix file " + filename);
+    }
+    stream.write(matrixMagic, sizeof(matrixMagic));
+    writeValue(stream, static_cast<uint64_t>(result.originRefs.size()));
+    writeValue(stream, static_cast<uint64_t>(result.destinationRefs.size()));
+    for (auto *refs : {&result.originRefs, &result.destinationRefs}) {
+        for (int ref : *refs) {
+            writeValue(stream, static_cast<int32_t>(ref));
+        }
+    }
+    stream.write(reinterpret_cast<const char *>(result.distances.data()),
+                 static_cast<std::streamsize>(result.distances.size() * sizeof(float)));
+    if (!stream) {
+        throw genlib::RuntimeException("Unable to write matrix file " + filename);
+    }
+}
+
+AnalysisResult ODMatrix::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    ODGraph graph = m_pointMap ? ODGraph::fromPointMap(*m_pointMap)
+                               : ODGraph::fromShapeGraph(*m_shapeGraph);
+    auto origins = nodesOf(graph, m_settings.originRefs, m_settings.originLocations);
+    auto destinations =
+        nodesOf(graph, m_settings.destinationRefs, m_settings.destinationLocations);
+    if (origins.empty() || destinations.empty()) {
+        throw genlib::RuntimeException("At least one origin and one destination are required");
+    }
+
+    auto result = analyse(graph, origins, destinations, comm);
+
+    if (!m_settings.matrixFile.empty()) {
+        if (telemetry) {
+            telemetry->setPhase("writing matrix");
+        }
+        if (m_settings.format == Format::BINARY) {
+            writeBinary(result, m_settings.matrixFile);
+        } else {
+            writeCSV(result, m_settings.matrixFile);
+        }
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    AttributeTable &table =
+        m_pointMap ? m_pointMap->getAttributeTable() : m_shapeGraph->getAttributeTable();
+    size_t routeCountCol = table.insertOrResetColumn(Column::ROUTE_COUNT);
+    for (size_t node = 0; node < graph.nodeCount(); node++) {
+        table.getRow(AttributeKey(graph.getRef(node)))
+            .setValue(routeCountCol, static_cast<float>(result.routeCounts[node]));
+    }
+
+    AnalysisResult analysisResult;
+    analysisResult.completed = true;
+    analysisResult.addAttribute(Column::ROUTE_COUNT);
+    return analysisResult;
+}
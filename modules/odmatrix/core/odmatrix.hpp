@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "odgraph.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class PointMap;
+class ShapeGraph;
+
+/**
+ * @brief Shortest path distances between many origins and many destinations
+ * of a visibility graph map or a segment map
+ *
+ * One metric search is run from each origin, spread over all cores, and each
+ * stops once all the destinations are reached. Along with the matrix of
+ * distances every node counts the routes between the pairs that go through
+ * it, found from the tree of each search without walking the paths one by
+ * one.
+ */
+class ODMatrix : public IAnalysis {
+  public:
+    enum class Format { CSV, BINARY };
+
+    struct Settings {
+        // refs of the nodes of the map, as from a selection
+        std::vector<int> originRefs;
+        std::vector<int> destinationRefs;
+        // locations snapped to the nearest node, as from a data map. These
+        // come after the refs in the matrix
+        std::vector<std::pair<double, double>> originLocations;
+        std::vector<std::pair<double, double>> destinationLocations;
+        // nothing is written if empty
+        std::string matrixFile;
+        Format format = Format::CSV;
+    };
+
+    struct Column {
+        inline static const std::string  //
+            ROUTE_COUNT = "OD Route Count"; //
+    };
+
+    struct Result {
+        std::vector<int> originRefs;
+        std::vector<int> destinationRefs;
+        // by origin then destination, UNREACHABLE where there is no path
+        std::vector<float> distances;
+        // by node of the graph
+        std::vector<uint32_t> routeCounts;
+
+        float getDistance(size_t origin, size_t destination) const {
+            return distances[origin * destinationRefs.size() + destination];
+        }
+    };
+
+    static constexpr float UNREACHABLE = -1.0f;
+
+  private:
+    PointMap *m_pointMap = nullptr;
+    ShapeGraph *m_shapeGraph = nullptr;
+    Settings m_settings;
+
+  public:
+    ODMatrix(PointMap &map, Settings settings);
+    ODMatrix(ShapeGraph &map, Settings settings);
+    std::string getAnalysisName() const override { return "Origin-Destination Matrix"; }
+    AnalysisResult run(Communicator *comm) override;
+
+    // origins and destinations are nodes of the graph, and may repeat
+    static Result analyse(const ODGraph &graph, const std::vector<uint32_t> &origins,
+                          const std::vector<uint32_t> &destinations, Communicator *comm);
+
+    // a row of destination refs, then a row for each origin starting with its
+    // ref, with UNREACHABLE where there is no path
+    static void writeCSV(const Result &result, const std::string &filename);
+    // the magic, the number of origins and destinations as 64 bit integers,
+    // their refs as 32 bit integers and the distances as 32 bit floats, by
+    // origin then destination, all in the byte order of the machine
+    static void writeBinary(const Result &result, const std::string &filename);
+};
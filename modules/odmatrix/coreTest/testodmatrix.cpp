@@ -0,0 +1,193 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/odmatrix/core/odmatrix.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace {
+    // nodes scattered over a square, each connected to a few of the nearest
+    // ones in both directions, plus a few nodes on their own
+    ODGraph makeGraph(size_t connectedCount, size_t isolatedCount, unsigned int seed) {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> position(0.0, 100.0);
+        size_t nodeCount = connectedCount + isolatedCount;
+        std::vector<double> x(nodeCount), y(nodeCount);
+        for (size_t node = 0; node < nodeCount; node++) {
+            x[node] = position(generator);
+            y[node] = position(generator);
+        }
+        std::vector<std::vector<ODGraph::Edge>> edges(nodeCount);
+        for (size_t node = 1; node < connectedCount; node++) {
+            // to an earlier node, so that all are connected
+            std::uniform_int_distribution<size_t> earlier(0, node - 1);
+            for (size_t link = 0; link < 3; link++) {
+                size_t other = earlier(generator);
+                auto length =
+                    static_cast<float>(std::hypot(x[node] - x[other], y[node] - y[other]));
+                edges[node].push_back({static_cast<uint32_t>(other), length});
+                edges[other].push_back({static_cast<uint32_t>(node), length});
+            }
+        }
+        ODGraph graph;
+        for (size_t node = 0; node < nodeCount; node++) {
+            graph.addNode(static_cast<int>(node * 7 + 3), x[node], y[node], edges[node]);
+        }
+        return graph;
+    }
+
+    // distances and parents from a node, trying all the nodes at each step
+    std::pair<std::vector<double>, std::vector<uint32_t>> searchAll(const ODGraph &graph,
+                                                                    uint32_t origin) {
+        size_t nodeCount = graph.nodeCount();
+        std::vector<double> distance(nodeCount, std::numeric_limits<double>::infinity());
+        std::vector<uint32_t> parent(nodeCount, ODGraph::NO_NODE);
+        std::vector<bool> done(nodeCount, false);
+        distance[origin] = 0.0;
+        while (true) {
+            uint32_t next = ODGraph::NO_NODE;
+            for (uint32_t node = 0; node < nodeCount; node++) {
+                if (!done[node] && std::isfinite(distance[node]) &&
+                    (next == ODGraph::NO_NODE || distance[node] < distance[next])) {
+                    next = node;
+                }
+            }
+            if (next == ODGraph::NO_NODE) {
+                break;
+            }
+            done[next] = true;
+            for (auto *edge = graph.edgesBegin(next); edge != graph.edgesEnd(next); edge++) {
+                if (distance[next] + edge->length < distance[edge->target]) {
+                    distance[edge->target] = distance[next] + edge->length;
+                    parent[edge->target] = next;
+                }
+            }
+        }
+        return {distance, parent};
+    }
+
+    std::string readFile(const std::string &filename) {
+        std::ifstream stream(filename, std::ios::binary);
+        std::stringstream contents;
+        contents << stream.rdbuf();
+        return contents.str();
+    }
+} // namespace
+
+TEST_CASE("OD matrix matches searches from each origin", "") {
+    ODGraph graph = makeGraph(400, 5, 11);
+    std::mt19937 generator(3);
+    std::uniform_int_distribution<uint32_t> anyNode(0,
+                                                    static_cast<uint32_t>(graph.nodeCount() - 1));
+    std::vector<uint32_t> origins, destinations;
+    for (size_t i = 0; i < 40; i++) {
+        origins.push_back(anyNode(generator));
+    }
+    for (size_t i = 0; i < 60; i++) {
+        destinations.push_back(anyNode(generator));
+    }
+    // repeated and unreachable ones
+    origins.push_back(origins.front());
+    destinations.push_back(destinations.front());
+    destinations.push_back(402);
+
+    auto result = ODMatrix::analyse(graph, origins, destinations, nullptr);
+    REQUIRE(result.originRefs.size() == origins.size());
+    REQUIRE(result.destinationRefs.size() == destinations.size());
+    REQUIRE(result.destinationRefs.back() == graph.getRef(402));
+
+    std::vector<uint32_t> routeCounts(graph.nodeCount(), 0);
+    for (size_t origin = 0; origin < origins.size(); origin++) {
+        auto [distance, parent] = searchAll(graph, origins[origin]);
+        for (size_t destination = 0; destination < destinations.size(); destination++) {
+            uint32_t node = destinations[destination];
+            if (!std::isfinite(distance[node])) {
+                REQUIRE(result.getDistance(origin, destination) == ODMatrix::UNREACHABLE);
+                continue;
+            }
+            REQUIRE(result.getDistance(origin, destination) ==
+                    Catch::Approx(distance[node]).epsilon(1e-5));
+            if (node == origins[origin]) {
+                continue;
+            }
+            for (; node != ODGraph::NO_NODE; node = parent[node]) {
+                routeCounts[node]++;
+            }
+        }
+    }
+    REQUIRE(result.routeCounts == routeCounts);
+}
+
+TEST_CASE("OD route counts", "") {
+    // a line of four nodes with a branch off the second
+    ODGraph graph;
+    graph.addNode(10, 0.0, 0.0, {{1, 1.0f}});
+    graph.addNode(11, 1.0, 0.0, {{0, 1.0f}, {2, 1.0f}, {4, 1.0f}});
+    graph.addNode(12, 2.0, 0.0, {{1, 1.0f}, {3, 1.0f}});
+    graph.addNode(13, 3.0, 0.0, {{2, 1.0f}});
+    graph.addNode(14, 1.0, 1.0, {{1, 1.0f}});
+
+    auto result = ODMatrix::analyse(graph, {0, 4}, {3, 3, 2, 0}, nullptr);
+    REQUIRE(result.getDistance(0, 0) == 3.0f);
+    REQUIRE(result.getDistance(0, 3) == 0.0f);
+    REQUIRE(result.getDistance(1, 2) == 2.0f);
+    REQUIRE(result.getDistance(1, 3) == 2.0f);
+    // the first origin has three routes, the second four
+    REQUIRE(result.routeCounts == std::vector<uint32_t>{4, 7, 6, 4, 4});
+}
+
+TEST_CASE("OD locations snap to the nearest node", "") {
+    ODGraph graph = makeGraph(300, 0, 5);
+    std::mt19937 generator(8);
+    std::uniform_real_distribution<double> position(-20.0, 120.0);
+    std::vector<std::pair<double, double>> locations;
+    for (size_t i = 0; i < 200; i++) {
+        locations.emplace_back(position(generator), position(generator));
+    }
+    auto nearest = graph.nearestNodes(locations);
+    for (size_t i = 0; i < locations.size(); i++) {
+        auto [x, y] = locations[i];
+        double best = std::numeric_limits<double>::infinity();
+        for (size_t node = 0; node < graph.nodeCount(); node++) {
+            best = std::min(best, std::hypot(graph.getX(node) - x, graph.getY(node) - y));
+        }
+        REQUIRE(std::hypot(graph.getX(nearest[i]) - x, graph.getY(nearest[i]) - y) == best);
+    }
+    REQUIRE(ODGraph().nearestNodes(locations).front() == ODGraph::NO_NODE);
+}
+
+TEST_CASE("OD matrix files", "") {
+    ODMatrix::Result result;
+    result.originRefs = {5, 9};
+    result.destinationRefs = {1, 2, 3};
+    result.distances = {0.0f, 1.5f, ODMatrix::UNREACHABLE, 2.0f, 0.5f, 4.0f};
+
+    std::string csvFile = "odmatrixtest.csv";
+    ODMatrix::writeCSV(result, csvFile);
+    REQUIRE(readFile(csvFile) == "Origin,1,2,3\n5,0,1.5,-1\n9,2,0.5,4\n");
+    std::remove(csvFile.c_str());
+
+    std::string binaryFile = "odmatrixtest.odm";
+    ODMatrix::writeBinary(result, binaryFile);
+    std::string contents = readFile(binaryFile);
+    std::remove(binaryFile.c_str());
+    REQUIRE(contents.size() == 8 + 2 * 8 + 5 * 4 + 6 * 4);
+    uint64_t destinationCount;
+    std::memcpy(&destinationCount, contents.data() + 16, sizeof(destinationCount));
+    REQUIRE(destinationCount == 3);
+    int32_t lastRef;
+    std::memcpy(&lastRef, contents.data() + 24 + 4 * 4, sizeof(lastRef));
+    REQUIRE(lastRef == 3);
+    float lastDistance;
+    std::memcpy(&lastDistance, contents.data() + contents.size() - 4, sizeof(lastDistance));
+    REQUIRE(lastDistance == 4.0f);
+}
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "odmatrixmainwindow.hpp"
+
+#include "modules/odmatrix/core/odmatrix.hpp"
+
+#include "qtgui/graphdoc.hpp"
+#include "qtgui/mainwindowhelpers.hpp"
+
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QMenuBar>
+#include <QMessageBox>
+
+bool ODMatrixMainWindow::createMenus(MainWindow *mainWindow) {
+    QMenu *toolsMenu = MainWindowHelpers::getOrAddRootMenu(mainWindow, tr("&Tools"));
+    QMenu *visibilityMenu = MainWindowHelpers::getOrAddMenu(toolsMenu, tr("&Visibility"));
+    QMenu *visibilityPathsMenu =
+        MainWindowHelpers::getOrAddMenu(visibilityMenu, tr("Shortest Paths"));
+    QMenu *segmentMenu = MainWindowHelpers::getOrAddMenu(toolsMenu, tr("&Segment"));
+    QMenu *segmentPathsMenu = MainWindowHelpers::getOrAddMenu(segmentMenu, tr("Shortest Paths"));
+
+    for (QMenu *pathsMenu : {visibilityPathsMenu, segmentPathsMenu}) {
+        QAction *odMatrixAct = new QAction(tr("Origin-Destination Matrix"), mainWindow);
+        odMatrixAct->setStatusTip(tr("Metric shortest path distances between many origins and "
+                                     "destinations, and the number of routes through each item"));
+        connect(odMatrixAct, &QAction::triggered, this,
+                [this, mainWindow] { OnODMatrix(mainWindow); });
+        pathsMenu->addAction(odMatrixAct);
+    }
+
+    return true;
+}
+
+void ODMatrixMainWindow::OnODMatrix(MainWindow *mainWindow) {
+    QGraphDoc *graphDoc = mainWindow->activeMapDoc();
+    if (graphDoc == nullptr)
+        return;
+
+    auto mapType = graphDoc->m_meta_graph->getDisplayedMapType();
+    if (mapType != ShapeMap::LATTICEMAP && mapType != ShapeMap::SEGMENTMAP) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please make sure the displayed map is a vga or segment map"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+    bool isLattice = mapType == ShapeMap::LATTICEMAP;
+    const std::set<int> &selection =
+        isLattice ? graphDoc->m_meta_graph->getDisplayedLatticeMap().getSelSet()
+                  : graphDoc->m_meta_graph->getDisplayedShapeGraph().getSelSet();
+
+    // the origins and destinations are either the selection or the shapes of
+    // a data map, which are snapped to the nearest cell or segment
+    auto &dataMaps = graphDoc->m_meta_graph->getDataMaps();
+    QStringList sources;
+    sources << tr("Selection");
+    for (auto &dataMap : dataMaps) {
+        sources << QString::fromStdString(dataMap.getName());
+    }
+    auto pickSource = [&](const QString &title, std::vector<int> &refs,
+                          std::vector<std::pair<double, double>> &locations) {
+        bool ok;
+        QString source =
+            QInputDialog::getItem(mainWindow, title, tr("Take them from"), sources, 0, false, &ok);
+        if (!ok)
+            return false;
+        int sourceIdx = static_cast<int>(sources.indexOf(source));
+        if (sourceIdx <= 0) {
+            refs.assign(selection.begin(), selection.end());
+            return true;
+        }
+        for (auto &shape : dataMaps[static_cast<size_t>(sourceIdx - 1)]
+                               .getInternalMap()
+                               .getAllShapes()) {
+            Point2f centroid = shape.second.getCentroid();
+            locations.emplace_back(centroid.x, centroid.y);
+        }
+        return true;
+    };
+
+    ODMatrix::Settings settings;
+    if (!pickSource(tr("Origins"), settings.originRefs, settings.originLocations) ||
+        !pickSource(tr("Destinations"), settings.destinationRefs, settings.destinationLocations))
+        return;
+    if ((settings.originRefs.empty() && settings.originLocations.empty()) ||
+        (settings.destinationRefs.empty() && settings.destinationLocations.empty())) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please select the origins and destinations, or pick data maps "
+                                "that contain some"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    QString binaryFilter = tr("Binary matrix (*.odm)");
+    QString selectedFilter;
+    QString matrixFile =
+        QFileDialog::getSaveFileName(mainWindow, tr("Save Matrix As"), QString(),
+                                     tr("CSV file (*.csv)") + ";;" + binaryFilter, &selectedFilter);
+    if (matrixFile.isEmpty())
+        return;
+    settings.matrixFile = matrixFile.toStdString();
+    settings.format = selectedFilter == binaryFilter ? ODMatrix::Format::BINARY
+                                                     : ODMatrix::Format::CSV;
+
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    if (isLattice) {
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        comm->setAnalysis(std::make_unique<ODMatrix>(map.getInternalMap(), std::move(settings)));
+        comm->setPostAnalysisFunc([&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+            map.overrideDisplayedAttribute(-2);
+            map.setDisplayedAttribute(ODMatrix::Column::ROUTE_COUNT);
+        });
+    } else {
+        auto &map = graphDoc->m_meta_graph->getDisplayedShapeGraph();
+        comm->setAnalysis(std::make_unique<ODMatrix>(map.getInternalMap(), std::move(settings)));
+        comm->setPostAnalysisFunc([&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+            map.overrideDisplayedAttribute(-2);
+            map.setDisplayedAttribute(ODMatrix::Column::ROUTE_COUNT);
+        });
+    }
+
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
+
+    graphDoc->submitJob(comm.release(), tr("Calculating origin-destination matrix..."),
+                        graphDoc->getDisplayedLayer());
+}
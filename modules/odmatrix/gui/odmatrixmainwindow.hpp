@@ -0,0 +1,16 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "qtgui/imainwindowmodule.hpp"
+
+class ODMatrixMainWindow : public IMainWindowModule {
+  private slots:
+    void OnODMatrix(MainWindow *mainWindow);
+
+  public:
+    ODMatrixMainWindow() : IMainWindowModule() {}
+    bool createMenus(MainWindow *mainWindow);
+};
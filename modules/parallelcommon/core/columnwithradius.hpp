@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "salalib/genlib/stringutils.hpp"
+
+#include <string>
+
+// the name of a column of an analysis limited to a radius, -1 being the
+// whole graph, written out as salalib writes it. Radii in steps are whole
+// numbers
+inline std::string getColumnWithRadius(const std::string &column, int radius) {
+    if (radius != -1) {
+        return column + " R" + std::to_string(radius);
+    }
+    return column;
+}
+
+// radii in distance are rounded as in salalib's metric and angular analyses:
+// to whole units above 100, to four decimals on maps less than a unit wide
+// and to two otherwise
+inline std::string getColumnWithRadius(const std::string &column, double radius,
+                                       double mapWidth) {
+    if (radius != -1) {
+        if (radius > 100.0) {
+            return column + " R" + dXstring::formatString(radius, "%.f");
+        } else if (mapWidth < 1.0) {
+            return column + " R" + dXstring::formatString(radius, "%.4f");
+        }
+        return column + " R" + dXstring::formatString(radius, "%.2f");
+    }
+    return column;
+}
+
+// a distance radius needs the width of its map
+std::string getColumnWithRadius(const std::string &column, double radius) = delete;
@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "integrationmeasures.hpp"
+
+#include <cmath>
+
+IntegrationMeasures IntegrationMeasures::fromDepth(double nodeCount, double meanDepth,
+                                                   double totalDepth) {
+    IntegrationMeasures measures;
+    if (nodeCount > 2 && meanDepth > 1.0) {
+        double ra = 2.0 * (meanDepth - 1.0) / (nodeCount - 2.0);
+        measures.integHH = dvalue(nodeCount) / ra;
+        measures.integPV = pvalue(nodeCount) / ra;
+        if (totalDepth - nodeCount + 1 > 1) {
+            measures.integTK = teklinteg(nodeCount, totalDepth);
+        }
+    }
+    return measures;
+}
+
+double IntegrationMeasures::dvalue(double nodeCount) {
+    return 2.0 * (nodeCount * (log2((nodeCount + 2.0) / 3.0) - 1.0) + 1.0) /
+           ((nodeCount - 1.0) * (nodeCount - 2.0));
+}
+
+double IntegrationMeasures::pvalue(double nodeCount) {
+    return 2.0 * (nodeCount - log2(nodeCount) - 1.0) / ((nodeCount - 1.0) * (nodeCount - 2.0));
+}
+
+double IntegrationMeasures::teklinteg(double nodeCount, double totalDepth) {
+    return log(0.5 * (nodeCount - 2.0)) / log(totalDepth - nodeCount + 1.0);
+}
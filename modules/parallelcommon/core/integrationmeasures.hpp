@@ -0,0 +1,25 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+/**
+ * @brief Integration from the mean depth of a node
+ *
+ * The normalisations of the Depthmap 4 manual, shared by the parallel
+ * analyses of visibility graphs and axial maps. The node count includes the
+ * node itself.
+ */
+struct IntegrationMeasures {
+    double integHH = -1.0;
+    double integPV = -1.0;
+    double integTK = -1.0;
+
+    // the measures stay at -1 where they are not defined, as in salalib
+    static IntegrationMeasures fromDepth(double nodeCount, double meanDepth, double totalDepth);
+
+    static double dvalue(double nodeCount);
+    static double pvalue(double nodeCount);
+    static double teklinteg(double nodeCount, double totalDepth);
+};
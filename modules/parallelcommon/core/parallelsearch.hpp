@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// The parallel analyses run their searches over the origins with parallelFor.
+// Each thread keeps the state of its searches between origins, indexed by
+// getThreadNum() in a vector of getMaxThreads(), and after each origin only
+// resets what that search wrote, so an origin costs what it reaches rather
+// than the size of the graph.
+
+inline int getThreadNum() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+inline int getMaxThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// where the analysis running on the calling thread reads how many threads it
+// may use. An executor running several analyses side by side points it at a
+// budget that it lowers and raises as the others start and finish
+inline thread_local const std::atomic<int> *tl_threadBudget = nullptr;
+
+inline void setThreadBudget(const std::atomic<int> *budget) { tl_threadBudget = budget; }
+
+// all of the threads unless an executor has set a budget
+inline int getThreadBudget() {
+    int maxThreads = getMaxThreads();
+    if (tl_threadBudget == nullptr) {
+        return maxThreads;
+    }
+    return std::clamp(tl_threadBudget->load(std::memory_order_relaxed), 1, maxThreads);
+}
+
+// runs body(index, thread) for every index in [0, count), with thread in
+// [0, getMaxThreads()). The indices are handed out in rounds of a few chunks
+// per thread, and each round runs on the threads of the budget as it is when
+// the round starts. A long analysis thus gives threads back soon after
+// another one starts beside it
+template <typename Body> void parallelFor(size_t count, size_t chunk, const Body &body) {
+    size_t round = chunk * 16 * static_cast<size_t>(getMaxThreads());
+    for (size_t first = 0; first < count; first += round) {
+        int end = static_cast<int>(std::min(count, first + round));
+        [[maybe_unused]] int threads = getThreadBudget();
+        [[maybe_unused]] int chunkSize = static_cast<int>(chunk);
+#pragma omp parallel for num_threads(threads) schedule(dynamic, chunkSize)
+        for (int index = static_cast<int>(first); index < end; index++) {
+            body(static_cast<size_t>(index), getThreadNum());
+        }
+    }
+}
+
+// the finest power of two that keeps the largest possible total within an
+// int64. Totals added up as integers come out the same in any order, so
+// results do not depend on the number of threads
+inline double fixedPointScale(double largestTotal) {
+    int exponent;
+    std::frexp(std::max(largestTotal, 1.0), &exponent);
+    return std::ldexp(1.0, std::min(24, 62 - exponent));
+}
@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "salalib/attributetable.hpp"
+#include "salalib/genlib/comm.hpp"
+#include "salalib/metagraphreadwrite.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <string>
+#include <vector>
+
+// the graphs of the testdata folder and the columns salalib writes for them,
+// for the tests that compare the parallel analyses with those of salalib
+namespace salalibparity {
+    class QuietCommunicator : public Communicator {
+      public:
+        void CommPostMessage(size_t, size_t) const override {}
+    };
+
+    inline MetaGraphReadWrite::MetaGraphData readTestData(const std::string &name) {
+        auto data = MetaGraphReadWrite::readFromFile(std::string(TESTDATA_DIR) + "/" + name);
+        REQUIRE(data.readWriteStatus == MetaGraphReadWrite::ReadWriteStatus::OK);
+        return data;
+    }
+
+    // the values of a column in the order of the rows
+    inline std::vector<float> getColumn(const AttributeTable &table, const std::string &column) {
+        REQUIRE(table.hasColumn(column));
+        size_t col = table.getColumnIndex(column);
+        std::vector<float> values;
+        values.reserve(table.getNumRows());
+        for (auto iter = table.begin(); iter != table.end(); iter++) {
+            values.push_back(iter->getRow().getValue(col));
+        }
+        return values;
+    }
+
+    // the columns salalib wrote, read before the analysis under test writes
+    // over them
+    inline std::vector<std::vector<float>> getColumns(const AttributeTable &table,
+                                                      const std::vector<std::string> &columns) {
+        std::vector<std::vector<float>> values;
+        for (auto &column : columns) {
+            values.push_back(getColumn(table, column));
+        }
+        return values;
+    }
+
+    // the columns hold the same values, up to the order sums were taken in
+    inline void requireSameColumns(const AttributeTable &table,
+                                   const std::vector<std::string> &columns,
+                                   const std::vector<std::vector<float>> &expected) {
+        for (size_t c = 0; c < columns.size(); c++) {
+            INFO(columns[c]);
+            auto actual = getColumn(table, columns[c]);
+            REQUIRE(actual.size() == expected[c].size());
+            for (size_t row = 0; row < actual.size(); row++) {
+                REQUIRE(actual[row] == Catch::Approx(expected[c][row]).epsilon(1e-5));
+            }
+        }
+    }
+} // namespace salalibparity
@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/parallelcommon/core/columnwithradius.hpp"
+
+#include "catch_amalgamated.hpp"
+
+TEST_CASE("Radii in steps are whole numbers", "") {
+    REQUIRE(getColumnWithRadius("Visual Mean Depth", -1) == "Visual Mean Depth");
+    REQUIRE(getColumnWithRadius("Visual Mean Depth", 3) == "Visual Mean Depth R3");
+}
+
+TEST_CASE("Radii in distance are rounded as in salalib", "") {
+    REQUIRE(getColumnWithRadius("Metric Node Count", -1.0, 50.0) == "Metric Node Count");
+    REQUIRE(getColumnWithRadius("Metric Node Count", 6.5, 50.0) == "Metric Node Count R6.50");
+    // large radii to whole units, on maps of any size
+    REQUIRE(getColumnWithRadius("Metric Node Count", 150.25, 50.0) == "Metric Node Count R150");
+    REQUIRE(getColumnWithRadius("Metric Node Count", 150.25, 0.5) == "Metric Node Count R150");
+    // more decimals on maps less than a unit wide
+    REQUIRE(getColumnWithRadius("Metric Node Count", 0.125, 0.5) ==
+            "Metric Node Count R0.1250");
+}
@@ -0,0 +1,27 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/parallelcommon/core/integrationmeasures.hpp"
+
+#include "catch_amalgamated.hpp"
+
+TEST_CASE("Integration from the mean depth", "") {
+    // five nodes, the four others at a total depth of 8
+    auto measures = IntegrationMeasures::fromDepth(5, 2.0, 8.0);
+    REQUIRE(measures.integHH == Catch::Approx(0.527990).epsilon(1e-5));
+    REQUIRE(measures.integPV == Catch::Approx(0.419518).epsilon(1e-5));
+    REQUIRE(measures.integTK == Catch::Approx(0.292481).epsilon(1e-5));
+}
+
+TEST_CASE("Integration is not defined for too few or too shallow nodes", "") {
+    auto pair = IntegrationMeasures::fromDepth(2, 1.0, 1.0);
+    REQUIRE(pair.integHH == -1.0);
+    REQUIRE(pair.integPV == -1.0);
+    REQUIRE(pair.integTK == -1.0);
+
+    // everything one step away
+    auto star = IntegrationMeasures::fromDepth(6, 1.0, 5.0);
+    REQUIRE(star.integHH == -1.0);
+    REQUIRE(star.integTK == -1.0);
+}
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "segmentgraph.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+SegmentGraph::SegmentGraph(std::vector<int> refs, std::vector<double> lengths,
+                           std::vector<Arc> arcs)
+    : m_refs(std::move(refs)), m_lengths(std::move(lengths)) {
+    std::stable_sort(arcs.begin(), arcs.end(),
+                     [](const Arc &a, const Arc &b) { return a.from < b.from; });
+    m_offsets.assign(stateCount() + 1, 0);
+    m_targets.reserve(arcs.size());
+    m_turns.reserve(arcs.size());
+    for (const Arc &arc : arcs) {
+        m_offsets[arc.from + 1]++;
+        m_targets.push_back(arc.to);
+        m_turns.push_back(arc.turn);
+    }
+    for (size_t state = 0; state < stateCount(); state++) {
+        m_offsets[state + 1] += m_offsets[state];
+    }
+}
+
+SegmentGraph SegmentGraph::fromMap(ShapeGraph &map) {
+    auto &shapes = map.getAllShapes();
+    auto &connectors = map.getConnections();
+    if (connectors.size() != shapes.size()) {
+        throw genlib::RuntimeException("The connections of the segment map have not been made");
+    }
+    std::vector<int> refs;
+    std::vector<double> lengths;
+    refs.reserve(shapes.size());
+    lengths.reserve(shapes.size());
+    for (auto &shape : shapes) {
+        refs.push_back(shape.first);
+        lengths.push_back(shape.second.getLine().length());
+    }
+
+    std::vector<Arc> arcs;
+    for (uint32_t segment = 0; segment < connectors.size(); segment++) {
+        for (bool forward : {false, true}) {
+            // the segment connections are keyed by the index of the segment
+            // and the way it is gone along
+            auto &segconns = forward ? connectors[segment].forwardSegconns
+                                     : connectors[segment].backSegconns;
+            for (auto &connection : segconns) {
+                auto target = static_cast<size_t>(connection.first.ref);
+                if (target >= shapes.size()) {
+                    throw genlib::RuntimeException("Segment connected to a missing segment");
+                }
+                arcs.push_back({stateOf(segment, forward),
+                                stateOf(static_cast<uint32_t>(target), connection.first.dir == 1),
+                                connection.second});
+            }
+        }
+    }
+    return SegmentGraph(std::move(refs), std::move(lengths), std::move(arcs));
+}
+
+SegmentGraph SegmentGraph::subgraph(const std::vector<uint32_t> &segments) const {
+    constexpr uint32_t LEFT_OUT = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> renumbered(segmentCount(), LEFT_OUT);
+    std::vector<int> refs;
+    std::vector<double> lengths;
+    refs.reserve(segments.size());
+    lengths.reserve(segments.size());
+    for (uint32_t segment : segments) {
+        renumbered[segment] = static_cast<uint32_t>(refs.size());
+        refs.push_back(m_refs[segment]);
+        lengths.push_back(m_lengths[segment]);
+    }
+    std::vector<Arc> arcs;
+    for (uint32_t segment : segments) {
+        for (bool forward : {false, true}) {
+            uint32_t state = stateOf(segment, forward);
+            for (size_t arc = arcsBegin(state); arc < arcsEnd(state); arc++) {
+                uint32_t target = m_targets[arc];
+                uint32_t targetSegment = renumbered[segmentOf(target)];
+                if (targetSegment == LEFT_OUT) {
+                    continue;
+                }
+                arcs.push_back({stateOf(renumbered[segment], forward),
+                                stateOf(targetSegment, isForward(target)), m_turns[arc]});
+            }
+        }
+    }
+    return SegmentGraph(std::move(refs), std::move(lengths), std::move(arcs));
+}
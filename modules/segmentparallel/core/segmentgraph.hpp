@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ShapeGraph;
+
+/**
+ * @brief The segments of a segment map as a directed graph of the ways
+ * along them
+ *
+ * Each segment is two states, one for going along it towards its end and
+ * one towards its start, and a connection leads from a state to the states
+ * that can be gone into from the end it is going towards, with the turn
+ * between the two. This keeps a route from turning back on itself where the
+ * segments meet, as the searches of salalib do. The graph is a read-only
+ * snapshot that can be searched from many threads.
+ */
+class SegmentGraph {
+  public:
+    struct Arc {
+        uint32_t from;
+        uint32_t to;
+        // a right angle is 1, going straight on 0
+        float turn;
+    };
+
+  private:
+    std::vector<int> m_refs;
+    std::vector<double> m_lengths;
+    std::vector<size_t> m_offsets;
+    std::vector<uint32_t> m_targets;
+    std::vector<float> m_turns;
+
+  public:
+    // refs and lengths by segment, arcs between the states, in any order
+    SegmentGraph(std::vector<int> refs, std::vector<double> lengths, std::vector<Arc> arcs);
+    // needs the connections of the map to have been made
+    static SegmentGraph fromMap(ShapeGraph &map);
+    // only the given segments, numbered in the order given, and the arcs
+    // between them
+    SegmentGraph subgraph(const std::vector<uint32_t> &segments) const;
+
+    static uint32_t stateOf(uint32_t segment, bool forward) {
+        return segment * 2 + (forward ? 1 : 0);
+    }
+    static uint32_t segmentOf(uint32_t state) { return state / 2; }
+    static bool isForward(uint32_t state) { return state % 2 == 1; }
+
+    size_t segmentCount() const { return m_refs.size(); }
+    size_t stateCount() const { return m_refs.size() * 2; }
+    int getRef(uint32_t segment) const { return m_refs[segment]; }
+    double getLength(uint32_t segment) const { return m_lengths[segment]; }
+    // the arcs of a state are those from arcsBegin to arcsEnd
+    size_t arcsBegin(uint32_t state) const { return m_offsets[state]; }
+    size_t arcsEnd(uint32_t state) const { return m_offsets[state + 1]; }
+    size_t arcCount() const { return m_targets.size(); }
+    uint32_t getTarget(size_t arc) const { return m_targets[arc]; }
+    float getTurn(size_t arc) const { return m_turns[arc]; }
+};
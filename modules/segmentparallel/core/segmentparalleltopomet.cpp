@@ -0,0 +1,473 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "segmentparalleltopomet.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace {
+    constexpr int64_t UNREACHED = std::numeric_limits<int64_t>::max();
+    constexpr uint32_t NO_STATE = std::numeric_limits<uint32_t>::max();
+
+    // from the middle of one segment to the middle of the next
+    double stepLength(const SegmentGraph &graph, uint32_t state, size_t arc) {
+        return (graph.getLength(SegmentGraph::segmentOf(state)) +
+                graph.getLength(SegmentGraph::segmentOf(graph.getTarget(arc)))) *
+               0.5;
+    }
+
+    // ordered by changes of direction, then by distance
+    struct Queued {
+        int64_t turns;
+        double distance;
+        uint32_t state;
+
+        bool operator>(const Queued &other) const {
+            return turns != other.turns ? turns > other.turns : distance > other.distance;
+        }
+    };
+
+    // the search from one origin, by state and by segment
+    struct Search {
+        // by state
+        std::vector<int64_t> turns;
+        std::vector<double> distance;
+        std::vector<uint8_t> settled;
+        std::vector<uint32_t> pending;
+        std::vector<double> sigma;
+        std::vector<double> delta;
+        std::vector<double> deltaSLW;
+        // by segment, the state it was first reached by
+        std::vector<uint32_t> segmentState;
+        std::vector<double> segmentSigma;
+
+        std::vector<uint32_t> touched;
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> reachedSegments;
+        std::vector<uint32_t> topological;
+        std::vector<Queued> heap;
+
+        // by segment
+        std::vector<int64_t> choice;
+        std::vector<int64_t> choiceSLW;
+
+        bool sameCost(uint32_t state, uint32_t other) const {
+            return turns[state] == turns[other] && distance[state] == distance[other];
+        }
+    };
+} // namespace
+
+std::string SegmentParallelTopoMet::getColumn(Measure measure, const std::string &column,
+                                              double radius) {
+    std::ostringstream text;
+    text << (measure == Measure::TOPOLOGICAL ? "Topological " : "Metric ") << column;
+    if (radius != -1) {
+        text << " R" << std::fixed << std::setprecision(0) << radius << " metric";
+    }
+    return text.str();
+}
+
+SegmentParallelTopoMet::SegmentParallelTopoMet(ShapeGraph &map, Settings settings)
+    : m_map(map), m_settings(std::move(settings)) {}
+
+std::vector<uint32_t> SegmentParallelTopoMet::segmentsWithin(const SegmentGraph &graph,
+                                                             const std::vector<uint32_t> &origins,
+                                                             double radius) {
+    std::vector<double> distance(graph.stateCount(), std::numeric_limits<double>::infinity());
+    std::vector<std::pair<double, uint32_t>> heap;
+    for (uint32_t origin : origins) {
+        for (bool forward : {false, true}) {
+            uint32_t state = SegmentGraph::stateOf(origin, forward);
+            distance[state] = 0.0;
+            heap.emplace_back(0.0, state);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<>());
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+        auto [stateDistance, state] = heap.back();
+        heap.pop_back();
+        if (stateDistance != distance[state]) {
+            continue;
+        }
+        for (size_t arc = graph.arcsBegin(state); arc < graph.arcsEnd(state); arc++) {
+            uint32_t target = graph.getTarget(arc);
+            double targetDistance = stateDistance + stepLength(graph, state, arc);
+            if ((radius != -1 && targetDistance > radius) || targetDistance >= distance[target]) {
+                continue;
+            }
+            distance[target] = targetDistance;
+            heap.emplace_back(targetDistance, target);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
+        }
+    }
+
+    std::vector<uint32_t> segments;
+    for (uint32_t segment = 0; segment < graph.segmentCount(); segment++) {
+        if (std::isfinite(distance[SegmentGraph::stateOf(segment, false)]) ||
+            std::isfinite(distance[SegmentGraph::stateOf(segment, true)])) {
+            segments.push_back(segment);
+        }
+    }
+    return segments;
+}
+
+std::vector<SegmentParallelTopoMet::Measures>
+SegmentParallelTopoMet::analyseGraph(const SegmentGraph &graph, Measure measure, double radius,
+                                     const std::vector<uint32_t> &origins, Communicator *comm,
+                                     const std::vector<int> &axialLines) {
+    size_t segmentCount = graph.segmentCount();
+    std::vector<Measures> measures(segmentCount);
+    if (segmentCount == 0) {
+        return measures;
+    }
+    bool topological = measure == Measure::TOPOLOGICAL;
+    if (topological && axialLines.size() != segmentCount) {
+        throw genlib::RuntimeException("Topological analysis needs the axial line of each segment");
+    }
+
+    std::vector<int64_t> stepTurns(graph.arcCount(), 0);
+    std::vector<double> stepLengths(graph.arcCount());
+    double totalLength = 0.0;
+    for (uint32_t state = 0; state < graph.stateCount(); state++) {
+        for (size_t arc = graph.arcsBegin(state); arc < graph.arcsEnd(state); arc++) {
+            // as in salalib, the direction changes where the route goes on
+            // to a segment of another axial line
+            if (topological && axialLines[SegmentGraph::segmentOf(state)] !=
+                                   axialLines[SegmentGraph::segmentOf(graph.getTarget(arc))]) {
+                stepTurns[arc] = 1;
+            }
+            stepLengths[arc] = stepLength(graph, state, arc);
+        }
+    }
+    for (uint32_t segment = 0; segment < segmentCount; segment++) {
+        totalLength += graph.getLength(segment);
+    }
+
+    std::vector<uint32_t> allSegments;
+    if (origins.empty()) {
+        for (uint32_t segment = 0; segment < segmentCount; segment++) {
+            allSegments.push_back(segment);
+        }
+    }
+    const std::vector<uint32_t> &searched = origins.empty() ? allSegments : origins;
+
+    double segments = static_cast<double>(segmentCount);
+    double choiceScale = fixedPointScale(segments * segments);
+    double choiceSLWScale = fixedPointScale(totalLength * totalLength);
+
+    std::vector<Search> searches(static_cast<size_t>(getMaxThreads()));
+    for (auto &search : searches) {
+        search.turns.resize(graph.stateCount(), UNREACHED);
+        search.distance.resize(graph.stateCount(), 0.0);
+        search.settled.resize(graph.stateCount(), 0);
+        search.pending.resize(graph.stateCount(), 0);
+        search.sigma.resize(graph.stateCount(), 0.0);
+        search.delta.resize(graph.stateCount(), 0.0);
+        search.deltaSLW.resize(graph.stateCount(), 0.0);
+        search.segmentState.resize(segmentCount, NO_STATE);
+        search.segmentSigma.resize(segmentCount, 0.0);
+        search.choice.resize(segmentCount, 0);
+        search.choiceSLW.resize(segmentCount, 0);
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, searched.size());
+    }
+    std::atomic<size_t> originsDone(0);
+    std::atomic<bool> cancelled(false);
+
+    parallelFor(searched.size(), 16, [&](size_t originIdx, int thread) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Search &search = searches[static_cast<size_t>(thread)];
+        uint32_t origin = searched[originIdx];
+
+        for (bool forward : {false, true}) {
+            uint32_t state = SegmentGraph::stateOf(origin, forward);
+            search.turns[state] = 0;
+            search.distance[state] = 0.0;
+            search.touched.push_back(state);
+            search.heap.push_back({0, 0.0, state});
+        }
+        while (!search.heap.empty()) {
+            std::pop_heap(search.heap.begin(), search.heap.end(), std::greater<>());
+            Queued queued = search.heap.back();
+            search.heap.pop_back();
+            uint32_t state = queued.state;
+            if (search.settled[state] || queued.turns != search.turns[state] ||
+                queued.distance != search.distance[state]) {
+                continue;
+            }
+            search.settled[state] = 1;
+            search.order.push_back(state);
+            uint32_t segment = SegmentGraph::segmentOf(state);
+            if (search.segmentState[segment] == NO_STATE) {
+                search.segmentState[segment] = state;
+                search.reachedSegments.push_back(segment);
+            }
+            for (size_t arc = graph.arcsBegin(state); arc < graph.arcsEnd(state); arc++) {
+                uint32_t target = graph.getTarget(arc);
+                int64_t turns = queued.turns + stepTurns[arc];
+                double distance = queued.distance + stepLengths[arc];
+                // nothing past the radius is gone on from
+                if (search.settled[target] || (radius != -1 && distance > radius)) {
+                    continue;
+                }
+                if (turns < search.turns[target] ||
+                    (turns == search.turns[target] && distance < search.distance[target])) {
+                    if (search.turns[target] == UNREACHED) {
+                        search.touched.push_back(target);
+                    }
+                    search.turns[target] = turns;
+                    search.distance[target] = distance;
+                    search.heap.push_back({turns, distance, target});
+                    std::push_heap(search.heap.begin(), search.heap.end(), std::greater<>());
+                }
+            }
+        }
+
+        Measures &originMeasure = measures[origin];
+        double nodeCount = static_cast<double>(search.reachedSegments.size());
+        double totalDepth = 0.0, depthSLW = 0.0, lengthReached = 0.0;
+        for (uint32_t segment : search.reachedSegments) {
+            uint32_t state = search.segmentState[segment];
+            double depth = topological ? static_cast<double>(search.turns[state])
+                                       : search.distance[state];
+            double length = graph.getLength(segment);
+            totalDepth += depth;
+            depthSLW += depth * length;
+            lengthReached += length;
+        }
+        originMeasure.totalNodes = static_cast<float>(nodeCount);
+        originMeasure.totalLength = static_cast<float>(lengthReached);
+        originMeasure.totalDepth = static_cast<float>(totalDepth);
+        if (nodeCount > 1) {
+            originMeasure.meanDepth = static_cast<float>(totalDepth / (nodeCount - 1.0));
+        }
+        double othersLength = lengthReached - graph.getLength(origin);
+        if (othersLength > 0.0) {
+            originMeasure.meanDepthSLW = static_cast<float>(depthSLW / othersLength);
+        }
+
+        // the arcs on the best routes form a graph without cycles, gone
+        // through in the order of its arcs to count the routes and back
+        // again to share out the pairs of segments between them
+        auto isTight = [&](uint32_t from, size_t arc) {
+            uint32_t target = graph.getTarget(arc);
+            return search.settled[target] && SegmentGraph::segmentOf(target) != origin &&
+                   search.turns[from] + stepTurns[arc] == search.turns[target] &&
+                   search.distance[from] + stepLengths[arc] == search.distance[target];
+        };
+        for (uint32_t state : search.order) {
+            search.sigma[state] = 0.0;
+            for (size_t arc = graph.arcsBegin(state); arc < graph.arcsEnd(state); arc++) {
+                if (isTight(state, arc)) {
+                    search.pending[graph.getTarget(arc)]++;
+                }
+            }
+        }
+        for (bool forward : {false, true}) {
+            uint32_t state = SegmentGraph::stateOf(origin, forward);
+            search.sigma[state] = 1.0;
+            search.topological.push_back(state);
+        }
+        for (size_t idx = 0; idx < search.topological.size(); idx++) {
+            uint32_t state = search.topological[idx];
+            for (size_t arc = graph.arcsBegin(state); arc < graph.arcsEnd(state); arc++) {
+                if (!isTight(state, arc)) {
+                    continue;
+                }
+                uint32_t target = graph.getTarget(arc);
+                search.sigma[target] += search.sigma[state];
+                if (--search.pending[target] == 0) {
+                    search.topological.push_back(target);
+                }
+            }
+        }
+        for (uint32_t segment : search.reachedSegments) {
+            search.segmentSigma[segment] = 0.0;
+        }
+        auto endsAt = [&](uint32_t state) {
+            return search.sameCost(state, search.segmentState[SegmentGraph::segmentOf(state)]);
+        };
+        for (uint32_t state : search.topological) {
+            if (endsAt(state)) {
+                search.segmentSigma[SegmentGraph::segmentOf(state)] += search.sigma[state];
+            }
+        }
+
+        double originLength = graph.getLength(origin);
+        for (size_t idx = search.topological.size(); idx-- > 0;) {
+            uint32_t state = search.topological[idx];
+            double delta = 0.0, deltaSLW = 0.0;
+            for (size_t arc = graph.arcsBegin(state); arc < graph.arcsEnd(state); arc++) {
+                uint32_t target = graph.getTarget(arc);
+                // targets on cycles without length are never gone through
+                if (!isTight(state, arc) || search.pending[target] != 0) {
+                    continue;
+                }
+                uint32_t segment = SegmentGraph::segmentOf(target);
+                double ending = endsAt(target)
+                                    ? search.sigma[target] / search.segmentSigma[segment]
+                                    : 0.0;
+                double share = search.sigma[state] / search.sigma[target];
+                delta += share * (ending + search.delta[target]);
+                deltaSLW +=
+                    share * (ending * graph.getLength(segment) + search.deltaSLW[target]);
+            }
+            search.delta[state] = delta;
+            search.deltaSLW[state] = deltaSLW;
+            uint32_t segment = SegmentGraph::segmentOf(state);
+            if (segment == origin) {
+                continue;
+            }
+            search.choice[segment] += std::llround(delta * choiceScale);
+            search.choiceSLW[segment] += std::llround(originLength * deltaSLW * choiceSLWScale);
+        }
+
+        for (uint32_t state : search.touched) {
+            search.turns[state] = UNREACHED;
+            search.settled[state] = 0;
+            search.pending[state] = 0;
+        }
+        for (uint32_t segment : search.reachedSegments) {
+            search.segmentState[segment] = NO_STATE;
+        }
+        search.touched.clear();
+        search.order.clear();
+        search.reachedSegments.clear();
+        search.topological.clear();
+
+        if (telemetry) {
+            telemetry->addRecords(static_cast<size_t>(thread));
+        }
+        size_t done = originsDone.fetch_add(1) + 1;
+        if (comm && thread == 0) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+            if (comm->IsCancelled()) {
+                cancelled = true;
+            }
+        }
+    });
+
+    if (cancelled) {
+        throw Communicator::CancelledException();
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("merging choice");
+    }
+#pragma omp parallel for num_threads(getThreadBudget()) schedule(static)
+    for (int segmentIdx = 0; segmentIdx < static_cast<int>(segmentCount); segmentIdx++) {
+        size_t segment = static_cast<size_t>(segmentIdx);
+        int64_t total = 0, totalSLW = 0;
+        for (const auto &search : searches) {
+            total += search.choice[segment];
+            totalSLW += search.choiceSLW[segment];
+        }
+        measures[segment].choice = static_cast<float>(static_cast<double>(total) / choiceScale);
+        measures[segment].choiceSLW =
+            static_cast<float>(static_cast<double>(totalSLW) / choiceSLWScale);
+    }
+    return measures;
+}
+
+AnalysisResult SegmentParallelTopoMet::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    SegmentGraph graph = SegmentGraph::fromMap(m_map);
+    AttributeTable &table = m_map.getAttributeTable();
+
+    std::vector<int> axialLines;
+    if (m_settings.measure == Measure::TOPOLOGICAL) {
+        if (!table.hasColumn(AXIAL_LINE_REF)) {
+            throw genlib::RuntimeException("The segment map has no " + AXIAL_LINE_REF +
+                                           " column to count changes of direction by");
+        }
+        size_t lineCol = table.getColumnIndex(AXIAL_LINE_REF);
+        for (uint32_t segment = 0; segment < graph.segmentCount(); segment++) {
+            axialLines.push_back(static_cast<int>(
+                table.getRow(AttributeKey(graph.getRef(segment))).getValue(lineCol)));
+        }
+    }
+
+    std::vector<uint32_t> origins;
+    if (m_settings.selectionOnly) {
+        for (uint32_t segment = 0; segment < graph.segmentCount(); segment++) {
+            if (m_settings.selection.count(graph.getRef(segment)) != 0) {
+                origins.push_back(segment);
+            }
+        }
+        if (origins.empty()) {
+            throw genlib::RuntimeException("No segments are selected to search from");
+        }
+        if (telemetry) {
+            telemetry->setPhase("taking out the segments in reach");
+        }
+        std::vector<uint32_t> within = segmentsWithin(graph, origins, m_settings.radius);
+        for (uint32_t &origin : origins) {
+            origin = static_cast<uint32_t>(
+                std::lower_bound(within.begin(), within.end(), origin) - within.begin());
+        }
+        graph = graph.subgraph(within);
+        if (!axialLines.empty()) {
+            std::vector<int> withinLines;
+            for (uint32_t segment : within) {
+                withinLines.push_back(axialLines[segment]);
+            }
+            axialLines = std::move(withinLines);
+        }
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("searching from segments");
+    }
+    auto measures =
+        analyseGraph(graph, m_settings.measure, m_settings.radius, origins, comm, axialLines);
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    AnalysisResult result;
+    auto writeColumn = [&](const std::string &column,
+                           const std::function<float(const Measures &)> &value) {
+        std::string name = getColumn(m_settings.measure, column, m_settings.radius);
+        size_t col = table.insertOrResetColumn(name);
+        for (uint32_t segment = 0; segment < graph.segmentCount(); segment++) {
+            table.getRow(AttributeKey(graph.getRef(segment)))
+                .setValue(col, value(measures[segment]));
+        }
+        result.addAttribute(name);
+    };
+    writeColumn(Column::CHOICE, [](const Measures &measure) { return measure.choice; });
+    writeColumn(Column::CHOICE_SLW, [](const Measures &measure) { return measure.choiceSLW; });
+    writeColumn(Column::MEAN_DEPTH, [](const Measures &measure) { return measure.meanDepth; });
+    writeColumn(Column::MEAN_DEPTH_SLW,
+                [](const Measures &measure) { return measure.meanDepthSLW; });
+    writeColumn(Column::TOTAL_DEPTH, [](const Measures &measure) { return measure.totalDepth; });
+    writeColumn(Column::TOTAL_NODES, [](const Measures &measure) { return measure.totalNodes; });
+    writeColumn(Column::TOTAL_LENGTH,
+                [](const Measures &measure) { return measure.totalLength; });
+
+    result.completed = true;
+    return result;
+}
@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "segmentgraph.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+class ShapeGraph;
+
+/**
+ * @brief Topological or metric segment analysis, searching from many
+ * segments at once
+ *
+ * The parallel counterpart of salalib's topological and metric analysis.
+ * Metric routes are the shortest from the middle of one segment to the
+ * middle of the other. Topological routes are those that go on to another
+ * axial line the fewest times, and the shortest of those, the axial line of
+ * each segment being the one it was made from. Every thread searches from its
+ * own segments with its own queue, and stops going further along a route
+ * once it is past the radius, which is always metric. Choice totals are
+ * kept in fixed point so that they add up the same whichever thread
+ * searched from which segment.
+ *
+ * From a selection, only the segments within the radius of it can be on
+ * its routes, so those are taken out into a smaller graph before searching.
+ */
+class SegmentParallelTopoMet : public IAnalysis {
+  public:
+    enum class Measure { TOPOLOGICAL, METRIC };
+
+    struct Settings {
+        Measure measure = Measure::METRIC;
+        // metric, -1 for the whole map
+        double radius = -1;
+        // refs of the only segments to search from, when set
+        bool selectionOnly = false;
+        std::set<int> selection;
+    };
+
+    // what a segment has within the radius, -1 where it is not defined or
+    // the segment was not searched from. Depth is in changes of direction
+    // or in distance, and [SLW] weighs the segments by their length
+    struct Measures {
+        float choice = -1.0f;
+        float choiceSLW = -1.0f;
+        float meanDepth = -1.0f;
+        float meanDepthSLW = -1.0f;
+        float totalDepth = -1.0f;
+        float totalNodes = -1.0f;
+        float totalLength = -1.0f;
+    };
+
+    struct Column {
+        inline static const std::string          //
+            CHOICE = "Choice",                   //
+            CHOICE_SLW = "Choice [SLW]",         //
+            MEAN_DEPTH = "Mean Depth",           //
+            MEAN_DEPTH_SLW = "Mean Depth [SLW]", //
+            TOTAL_DEPTH = "Total Depth",         //
+            TOTAL_NODES = "Total Nodes",         //
+            TOTAL_LENGTH = "Total Length";       //
+    };
+    static std::string getColumn(Measure measure, const std::string &column, double radius);
+    // the axial line each segment was made from, as salalib names it
+    inline static const std::string AXIAL_LINE_REF = "Axial Line Ref";
+
+  private:
+    ShapeGraph &m_map;
+    Settings m_settings;
+
+  public:
+    SegmentParallelTopoMet(ShapeGraph &map, Settings settings);
+    std::string getAnalysisName() const override {
+        return m_settings.measure == Measure::TOPOLOGICAL ? "Parallel Topological Analysis"
+                                                          : "Parallel Metric Analysis";
+    }
+    AnalysisResult run(Communicator *comm) override;
+
+    // the measures of every segment, from the given segments or from all of
+    // them if none are given. Topological analysis needs the axial line of
+    // each segment
+    static std::vector<Measures> analyseGraph(const SegmentGraph &graph, Measure measure,
+                                              double radius, const std::vector<uint32_t> &origins,
+                                              Communicator *comm,
+                                              const std::vector<int> &axialLines = {});
+    // the segments within the radius of any of the origins, in order
+    static std::vector<uint32_t> segmentsWithin(const SegmentGraph &graph,
+                                                const std::vector<uint32_t> &origins,
+                                                double radius);
+};
@@ -0,0 +1,708 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "segmentparalleltulip.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+namespace {
+    constexpr int64_t UNREACHED = std::numeric_limits<int64_t>::max();
+    // the full angular analysis keeps its turns in fixed point as well, so
+    // that routes of the same angle cost exactly the same
+    constexpr double FULL_ANGULAR_STEPS = 1 << 20;
+
+    // the search from one origin, by state and by segment
+    struct Search {
+        // by state
+        std::vector<int64_t> cost;
+        // how far along the radius the shortest route of least angle goes
+        std::vector<double> extent;
+        std::vector<uint8_t> settled;
+        std::vector<uint32_t> pending;
+        std::vector<double> sigma;
+        std::vector<double> delta;
+        std::vector<double> weightedDelta;
+        std::vector<double> weightedDelta2;
+        // by segment
+        std::vector<int64_t> segmentDepth;
+        std::vector<double> segmentSigma;
+        std::vector<double> segmentDelta;
+
+        std::vector<uint32_t> touched;
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> reachedSegments;
+        std::vector<uint32_t> topological;
+
+        // the queue, as one bucket per whole tulip bin wrapping around, or
+        // as a heap of costs for the full angular analysis
+        std::vector<std::vector<uint32_t>> buckets;
+        std::vector<std::pair<int64_t, uint32_t>> heap;
+        int64_t current = 0;
+        size_t bucketIdx = 0;
+        size_t queued = 0;
+
+        // by segment then radius
+        std::vector<int64_t> choice;
+        std::vector<int64_t> weightedChoice;
+        std::vector<int64_t> weightedChoice2;
+        std::vector<int64_t> choiceSquares;
+
+        void push(uint32_t state, int64_t stateCost) {
+            if (buckets.empty()) {
+                heap.emplace_back(stateCost, state);
+                std::push_heap(heap.begin(), heap.end(), std::greater<>());
+                return;
+            }
+            buckets[static_cast<size_t>(stateCost) % buckets.size()].push_back(state);
+            queued++;
+        }
+
+        // the states in order of cost, including those since queued again
+        // at a lower cost, until the queue is empty
+        bool pop(uint32_t &state, int64_t &stateCost) {
+            if (buckets.empty()) {
+                if (heap.empty()) {
+                    return false;
+                }
+                std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+                stateCost = heap.back().first;
+                state = heap.back().second;
+                heap.pop_back();
+                return true;
+            }
+            while (queued > 0) {
+                // arcs without a turn add to the bucket being gone through
+                auto &bucket = buckets[static_cast<size_t>(current) % buckets.size()];
+                if (bucketIdx < bucket.size()) {
+                    state = bucket[bucketIdx++];
+                    stateCost = current;
+                    queued--;
+                    return true;
+                }
+                bucket.clear();
+                bucketIdx = 0;
+                current++;
+            }
+            buckets[static_cast<size_t>(current) % buckets.size()].clear();
+            bucketIdx = 0;
+            current = 0;
+            return false;
+        }
+    };
+} // namespace
+
+std::string SegmentParallelTulip::makeRadiusText(RadiusType radiusType, double radius) {
+    if (radius == -1) {
+        return "";
+    }
+    std::ostringstream text;
+    text << " R";
+    switch (radiusType) {
+    case RadiusType::TOPOLOGICAL:
+        text << static_cast<int>(radius) << " step";
+        break;
+    case RadiusType::METRIC:
+        text << std::fixed << std::setprecision(0) << radius << " metric";
+        break;
+    default:
+        text << std::fixed << std::setprecision(2) << radius;
+        break;
+    }
+    return text.str();
+}
+
+SegmentParallelTulip::SegmentParallelTulip(ShapeGraph &map, Settings settings)
+    : m_map(map), m_settings(std::move(settings)) {}
+
+std::vector<SegmentParallelTulip::Measures>
+SegmentParallelTulip::analyseGraph(const SegmentGraph &graph, const Parameters &parameters,
+                                   Communicator *comm) {
+    size_t segmentCount = graph.segmentCount();
+    size_t radiusCount = parameters.radii.size();
+    std::vector<Measures> measures(segmentCount * radiusCount);
+    if (segmentCount == 0 || radiusCount == 0) {
+        return measures;
+    }
+    bool weighted = !parameters.weights.empty();
+    bool weighted2 = !parameters.weights2.empty();
+    bool choice = parameters.choice;
+    bool squared = choice && parameters.choiceSquares;
+    bool fullAngular = parameters.tulipBins == 0;
+    auto weightOf = [&](uint32_t segment) {
+        return weighted ? parameters.weights[segment] : 1.0;
+    };
+    // larger ones would make for more buckets than the searches can hold
+    for (double routeWeight : parameters.routeWeights) {
+        if (!(routeWeight >= 0.0 && routeWeight <= 1.0)) {
+            throw genlib::RuntimeException("Route weights need to be between 0 and 1");
+        }
+    }
+
+    // one search reaches as far as the largest radius, and the smaller
+    // radii take what is within them from it
+    double largestRadius = 0.0;
+    for (double radius : parameters.radii) {
+        if (radius == -1 || largestRadius == -1) {
+            largestRadius = -1;
+        } else {
+            largestRadius = std::max(largestRadius, radius);
+        }
+    }
+
+    // the turns in bins, and how far each arc goes along the radius
+    double stepsPerQuarter = fullAngular ? FULL_ANGULAR_STEPS : parameters.tulipBins / 4.0;
+    std::vector<int64_t> steps(graph.arcCount());
+    std::vector<double> extents(graph.arcCount());
+    int64_t maxStep = 0;
+    for (uint32_t state = 0; state < graph.stateCount(); state++) {
+        for (size_t arc = graph.arcsBegin(state); arc < graph.arcsEnd(state); arc++) {
+            uint32_t target = SegmentGraph::segmentOf(graph.getTarget(arc));
+            double turn = graph.getTurn(arc);
+            double routeWeight =
+                parameters.routeWeights.empty() ? 1.0 : parameters.routeWeights[target];
+            double step = turn * stepsPerQuarter * routeWeight;
+            steps[arc] = std::max<int64_t>(
+                0, static_cast<int64_t>(fullAngular ? std::round(step) : std::floor(step)));
+            maxStep = std::max(maxStep, steps[arc]);
+            switch (parameters.radiusType) {
+            case RadiusType::TOPOLOGICAL:
+                extents[arc] = 1.0;
+                break;
+            case RadiusType::METRIC:
+                extents[arc] = (graph.getLength(SegmentGraph::segmentOf(state)) +
+                                graph.getLength(target)) *
+                               0.5;
+                break;
+            case RadiusType::ANGULAR:
+                extents[arc] = turn;
+                break;
+            default:
+                extents[arc] = 0.0;
+                break;
+            }
+        }
+    }
+
+    std::vector<uint32_t> origins = parameters.origins;
+    if (origins.empty()) {
+        for (uint32_t segment = 0; segment < segmentCount; segment++) {
+            origins.push_back(segment);
+        }
+    }
+
+    double totalWeight = 0.0, totalWeight2 = 0.0;
+    for (uint32_t segment = 0; segment < segmentCount; segment++) {
+        totalWeight += std::abs(weightOf(segment));
+        totalWeight2 += weighted2 ? std::abs(parameters.weights2[segment]) : 0.0;
+    }
+    double segments = static_cast<double>(segmentCount);
+    double choiceScale = fixedPointScale(segments * segments);
+    double weightedChoiceScale = fixedPointScale(totalWeight * totalWeight);
+    double weightedChoice2Scale = fixedPointScale(totalWeight * totalWeight2);
+    double choiceSquaresScale = fixedPointScale(segments * segments * segments);
+
+    std::vector<Search> searches(static_cast<size_t>(getMaxThreads()));
+    for (auto &search : searches) {
+        search.cost.resize(graph.stateCount(), UNREACHED);
+        search.extent.resize(graph.stateCount(), 0.0);
+        search.settled.resize(graph.stateCount(), 0);
+        search.pending.resize(graph.stateCount(), 0);
+        search.segmentDepth.resize(segmentCount, UNREACHED);
+        if (!fullAngular) {
+            search.buckets.resize(static_cast<size_t>(maxStep) + 1);
+        }
+        if (choice) {
+            search.sigma.resize(graph.stateCount(), 0.0);
+            search.delta.resize(graph.stateCount(), 0.0);
+            search.segmentSigma.resize(segmentCount, 0.0);
+            search.choice.resize(segmentCount * radiusCount, 0);
+            if (weighted) {
+                search.weightedDelta.resize(graph.stateCount(), 0.0);
+                search.weightedChoice.resize(segmentCount * radiusCount, 0);
+            }
+            if (weighted2) {
+                search.weightedDelta2.resize(graph.stateCount(), 0.0);
+                search.weightedChoice2.resize(segmentCount * radiusCount, 0);
+            }
+            if (squared) {
+                search.segmentDelta.resize(segmentCount, 0.0);
+                search.choiceSquares.resize(segmentCount * radiusCount, 0);
+            }
+        }
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, origins.size());
+    }
+    std::atomic<size_t> originsDone(0);
+    std::atomic<bool> cancelled(false);
+
+    parallelFor(origins.size(), 16, [&](size_t originIdx, int thread) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Search &search = searches[static_cast<size_t>(thread)];
+        uint32_t origin = origins[originIdx];
+
+        for (bool forward : {false, true}) {
+            uint32_t state = SegmentGraph::stateOf(origin, forward);
+            search.cost[state] = 0;
+            search.extent[state] = 0.0;
+            search.touched.push_back(state);
+            search.push(state, 0);
+        }
+        uint32_t state;
+        int64_t current;
+        while (search.pop(state, current)) {
+            if (search.cost[state] != current) {
+                continue;
+            }
+            // a settled state comes out again when a route of the same angle
+            // but a shorter extent reaches it, and goes on from there, as
+            // what it left beyond the radius may now be within it
+            if (!search.settled[state]) {
+                search.settled[state] = 1;
+                search.order.push_back(state);
+            }
+            for (size_t arc = graph.arcsBegin(state); arc < graph.arcsEnd(state); arc++) {
+                uint32_t target = graph.getTarget(arc);
+                double extent = search.extent[state] + extents[arc];
+                if (largestRadius != -1 && extent > largestRadius) {
+                    continue;
+                }
+                int64_t cost = current + steps[arc];
+                if (cost < search.cost[target]) {
+                    if (search.cost[target] == UNREACHED) {
+                        search.touched.push_back(target);
+                    }
+                    search.cost[target] = cost;
+                    search.extent[target] = extent;
+                    search.push(target, cost);
+                } else if (cost == search.cost[target] && extent < search.extent[target]) {
+                    search.extent[target] = extent;
+                    if (search.settled[target]) {
+                        search.push(target, cost);
+                    }
+                }
+            }
+        }
+
+        // the arcs that lie on routes of least angle form a graph without
+        // cycles, but for those without a turn. The choice goes through it
+        // in the order of its arcs
+        auto isTight = [&](uint32_t from, size_t arc) {
+            uint32_t target = graph.getTarget(arc);
+            return search.settled[target] && SegmentGraph::segmentOf(target) != origin &&
+                   search.cost[from] + steps[arc] == search.cost[target];
+        };
+        for (uint32_t reached : search.order) {
+            for (size_t arc = graph.arcsBegin(reached); arc < graph.arcsEnd(reached); arc++) {
+                if (isTight(reached, arc)) {
+                    search.pending[graph.getTarget(arc)]++;
+                }
+            }
+        }
+        for (bool forward : {false, true}) {
+            search.topological.push_back(SegmentGraph::stateOf(origin, forward));
+        }
+        for (size_t idx = 0; idx < search.topological.size(); idx++) {
+            uint32_t from = search.topological[idx];
+            for (size_t arc = graph.arcsBegin(from); arc < graph.arcsEnd(from); arc++) {
+                if (!isTight(from, arc)) {
+                    continue;
+                }
+                uint32_t target = graph.getTarget(arc);
+                if (--search.pending[target] == 0) {
+                    search.topological.push_back(target);
+                }
+            }
+        }
+
+        for (size_t r = 0; r < radiusCount; r++) {
+            double radius = parameters.radii[r];
+            auto withinRadius = [&](double extent) { return radius == -1 || extent <= radius; };
+
+            for (uint32_t reached : search.order) {
+                uint32_t segment = SegmentGraph::segmentOf(reached);
+                if (search.segmentDepth[segment] == UNREACHED &&
+                    withinRadius(search.extent[reached])) {
+                    search.segmentDepth[segment] = search.cost[reached];
+                    search.reachedSegments.push_back(segment);
+                }
+            }
+
+            Measures &measure = measures[origin * radiusCount + r];
+            double nodeCount = static_cast<double>(search.reachedSegments.size());
+            double totalDepth = 0.0, weightReached = 0.0, weightedDepth = 0.0;
+            for (uint32_t segment : search.reachedSegments) {
+                double depth = static_cast<double>(search.segmentDepth[segment]) / stepsPerQuarter;
+                totalDepth += depth;
+                weightReached += weightOf(segment);
+                weightedDepth += depth * weightOf(segment);
+            }
+            measure.nodeCount = static_cast<float>(nodeCount);
+            measure.totalDepth = static_cast<float>(totalDepth);
+            if (nodeCount > 1) {
+                measure.meanDepth = static_cast<float>(totalDepth / (nodeCount - 1.0));
+            }
+            if (totalDepth > 0.0) {
+                measure.integration = static_cast<float>(nodeCount * nodeCount / totalDepth);
+            }
+            if (weighted) {
+                measure.totalWeight = static_cast<float>(weightReached);
+                measure.weightedTotalDepth = static_cast<float>(weightedDepth);
+                if (weightedDepth > 0.0) {
+                    measure.weightedIntegration =
+                        static_cast<float>(weightReached * weightReached / weightedDepth);
+                }
+            }
+
+            if (choice) {
+                // the routes are counted along the arcs within the radius,
+                // and gone back along to share out the pairs of segments
+                // between them. States left pending are on cycles without
+                // a turn and are not gone through
+                auto onRoute = [&](uint32_t from, size_t arc) {
+                    return isTight(from, arc) && search.pending[graph.getTarget(arc)] == 0 &&
+                           withinRadius(search.extent[from] + extents[arc]);
+                };
+                for (uint32_t reached : search.topological) {
+                    search.sigma[reached] = 0.0;
+                }
+                for (bool forward : {false, true}) {
+                    search.sigma[SegmentGraph::stateOf(origin, forward)] = 1.0;
+                }
+                for (uint32_t from : search.topological) {
+                    if (search.sigma[from] == 0.0) {
+                        continue;
+                    }
+                    for (size_t arc = graph.arcsBegin(from); arc < graph.arcsEnd(from); arc++) {
+                        if (onRoute(from, arc)) {
+                            search.sigma[graph.getTarget(arc)] += search.sigma[from];
+                        }
+                    }
+                }
+                for (uint32_t segment : search.reachedSegments) {
+                    search.segmentSigma[segment] = 0.0;
+                    if (squared) {
+                        search.segmentDelta[segment] = 0.0;
+                    }
+                }
+                for (uint32_t reached : search.topological) {
+                    uint32_t segment = SegmentGraph::segmentOf(reached);
+                    if (search.cost[reached] == search.segmentDepth[segment]) {
+                        search.segmentSigma[segment] += search.sigma[reached];
+                    }
+                }
+
+                double originWeight = weightOf(origin);
+                for (size_t idx = search.topological.size(); idx-- > 0;) {
+                    uint32_t from = search.topological[idx];
+                    if (search.sigma[from] == 0.0) {
+                        continue;
+                    }
+                    double delta = 0.0, weightedDelta = 0.0, weightedDelta2 = 0.0;
+                    for (size_t arc = graph.arcsBegin(from); arc < graph.arcsEnd(from); arc++) {
+                        if (!onRoute(from, arc)) {
+                            continue;
+                        }
+                        uint32_t target = graph.getTarget(arc);
+                        uint32_t segment = SegmentGraph::segmentOf(target);
+                        // the share of the pair with the segment that ends here
+                        double ending = 0.0;
+                        if (search.cost[target] == search.segmentDepth[segment]) {
+                            ending = search.sigma[target] / search.segmentSigma[segment];
+                        }
+                        double share = search.sigma[from] / search.sigma[target];
+                        delta += share * (ending + search.delta[target]);
+                        if (weighted) {
+                            weightedDelta += share * (ending * parameters.weights[segment] +
+                                                      search.weightedDelta[target]);
+                        }
+                        if (weighted2) {
+                            weightedDelta2 += share * (ending * parameters.weights2[segment] +
+                                                       search.weightedDelta2[target]);
+                        }
+                    }
+                    search.delta[from] = delta;
+                    if (weighted) {
+                        search.weightedDelta[from] = weightedDelta;
+                    }
+                    if (weighted2) {
+                        search.weightedDelta2[from] = weightedDelta2;
+                    }
+                    uint32_t segment = SegmentGraph::segmentOf(from);
+                    if (segment == origin) {
+                        continue;
+                    }
+                    size_t choiceIdx = segment * radiusCount + r;
+                    search.choice[choiceIdx] += std::llround(delta * choiceScale);
+                    if (squared) {
+                        search.segmentDelta[segment] += delta;
+                    }
+                    if (weighted) {
+                        search.weightedChoice[choiceIdx] +=
+                            std::llround(originWeight * weightedDelta * weightedChoiceScale);
+                    }
+                    if (weighted2) {
+                        search.weightedChoice2[choiceIdx] +=
+                            std::llround(originWeight * weightedDelta2 * weightedChoice2Scale);
+                    }
+                }
+            }
+
+            if (squared) {
+                // the choice from this origin is that of both ways along
+                for (uint32_t segment : search.reachedSegments) {
+                    double delta = search.segmentDelta[segment];
+                    search.choiceSquares[segment * radiusCount + r] +=
+                        std::llround(delta * delta * choiceSquaresScale);
+                }
+            }
+            for (uint32_t segment : search.reachedSegments) {
+                search.segmentDepth[segment] = UNREACHED;
+            }
+            search.reachedSegments.clear();
+        }
+
+        for (uint32_t reached : search.touched) {
+            search.cost[reached] = UNREACHED;
+            search.settled[reached] = 0;
+            search.pending[reached] = 0;
+        }
+        search.touched.clear();
+        search.order.clear();
+        search.topological.clear();
+
+        if (telemetry) {
+            telemetry->addRecords(static_cast<size_t>(thread));
+        }
+        size_t done = originsDone.fetch_add(1) + 1;
+        if (comm && thread == 0) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+            if (comm->IsCancelled()) {
+                cancelled = true;
+            }
+        }
+    });
+
+    if (cancelled) {
+        throw Communicator::CancelledException();
+    }
+    if (!choice) {
+        return measures;
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("merging choice");
+    }
+#pragma omp parallel for num_threads(getThreadBudget()) schedule(static)
+    for (int segmentIdx = 0; segmentIdx < static_cast<int>(segmentCount); segmentIdx++) {
+        size_t segment = static_cast<size_t>(segmentIdx);
+        for (size_t r = 0; r < radiusCount; r++) {
+            size_t idx = segment * radiusCount + r;
+            int64_t total = 0, weightedTotal = 0, weightedTotal2 = 0, squaresTotal = 0;
+            for (const auto &search : searches) {
+                total += search.choice[idx];
+                if (squared) {
+                    squaresTotal += search.choiceSquares[idx];
+                }
+                if (weighted) {
+                    weightedTotal += search.weightedChoice[idx];
+                }
+                if (weighted2) {
+                    weightedTotal2 += search.weightedChoice2[idx];
+                }
+            }
+            measures[idx].choice = static_cast<double>(total) / choiceScale;
+            if (squared) {
+                measures[idx].choiceSquares =
+                    static_cast<double>(squaresTotal) / choiceSquaresScale;
+            }
+            if (weighted) {
+                measures[idx].weightedChoice =
+                    static_cast<float>(static_cast<double>(weightedTotal) / weightedChoiceScale);
+            }
+            if (weighted2) {
+                measures[idx].weightedChoice2 =
+                    static_cast<float>(static_cast<double>(weightedTotal2) / weightedChoice2Scale);
+            }
+        }
+    }
+    return measures;
+}
+
+AnalysisResult SegmentParallelTulip::run(Communicator *comm) {
+    if (m_settings.tulipBins != 0 && m_settings.tulipBins < 4) {
+        throw genlib::RuntimeException(
+            "The tulip analysis needs at least 4 bins, or none for full angular analysis");
+    }
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    SegmentGraph graph = SegmentGraph::fromMap(m_map);
+    AttributeTable &table = m_map.getAttributeTable();
+
+    Parameters parameters;
+    parameters.radii.assign(m_settings.radiusSet.begin(), m_settings.radiusSet.end());
+    parameters.radiusType = m_settings.radiusType;
+    parameters.tulipBins = m_settings.tulipBins;
+    parameters.choice = m_settings.choice && !m_settings.sampleChoice;
+    auto readColumn = [&](int col, std::vector<double> &values) {
+        if (col == -1) {
+            return std::string();
+        }
+        for (uint32_t segment = 0; segment < graph.segmentCount(); segment++) {
+            values.push_back(table.getRow(AttributeKey(graph.getRef(segment)))
+                                 .getValue(static_cast<size_t>(col)));
+        }
+        return table.getColumnName(static_cast<size_t>(col));
+    };
+    std::string weightColumn = readColumn(m_settings.weightedMeasureCol, parameters.weights);
+    std::string weightColumn2 = readColumn(m_settings.weightedMeasureCol2, parameters.weights2);
+    readColumn(m_settings.routeweightCol, parameters.routeWeights);
+    // route weights count relative to the largest one
+    if (!parameters.routeWeights.empty()) {
+        double largest = 0.0;
+        for (double routeWeight : parameters.routeWeights) {
+            if (routeWeight < 0.0) {
+                throw genlib::RuntimeException("Route weights cannot be negative");
+            }
+            largest = std::max(largest, routeWeight);
+        }
+        if (largest > 0.0) {
+            for (double &routeWeight : parameters.routeWeights) {
+                routeWeight /= largest;
+            }
+        }
+    }
+    if (m_settings.selectionOnly) {
+        for (uint32_t segment = 0; segment < graph.segmentCount(); segment++) {
+            if (m_settings.selection.count(graph.getRef(segment)) != 0) {
+                parameters.origins.push_back(segment);
+            }
+        }
+        if (parameters.origins.empty()) {
+            throw genlib::RuntimeException("No segments are selected to search from");
+        }
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("searching from segments");
+    }
+    auto measures = analyseGraph(graph, parameters, comm);
+
+    ChoiceSampler::Estimate sampled;
+    if (m_settings.choice && m_settings.sampleChoice) {
+        if (telemetry) {
+            telemetry->setPhase("sampling choice");
+        }
+        std::vector<uint32_t> origins = parameters.origins;
+        if (origins.empty()) {
+            origins.resize(graph.segmentCount());
+            std::iota(origins.begin(), origins.end(), 0);
+        }
+        Parameters sampleParameters = parameters;
+        sampleParameters.choice = true;
+        sampleParameters.choiceSquares = true;
+        sampleParameters.weights.clear();
+        sampleParameters.weights2.clear();
+        sampled = ChoiceSampler::estimate(
+            origins, m_settings.choiceSampling, [&](const std::vector<uint32_t> &sample) {
+                sampleParameters.origins = sample;
+                auto fromSample = analyseGraph(graph, sampleParameters, comm);
+                ChoiceSampler::Totals totals;
+                for (const Measures &measure : fromSample) {
+                    totals.choice.push_back(measure.choice);
+                    totals.choiceSquares.push_back(measure.choiceSquares);
+                }
+                return totals;
+            });
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    AnalysisResult result;
+    auto writeColumn = [&](const std::string &column, size_t r,
+                           const std::function<float(const Measures &)> &value) {
+        std::string name =
+            getColumn(m_settings.tulipBins, column, m_settings.radiusType, parameters.radii[r]);
+        size_t col = table.insertOrResetColumn(name);
+        for (uint32_t segment = 0; segment < graph.segmentCount(); segment++) {
+            table.getRow(AttributeKey(graph.getRef(segment)))
+                .setValue(col, value(measures[segment * parameters.radii.size() + r]));
+        }
+        result.addAttribute(name);
+    };
+    auto writeSampled = [&](const std::string &column, size_t r,
+                            const std::vector<double> &values) {
+        std::string name =
+            getColumn(m_settings.tulipBins, column, m_settings.radiusType, parameters.radii[r]);
+        size_t col = table.insertOrResetColumn(name);
+        for (uint32_t segment = 0; segment < graph.segmentCount(); segment++) {
+            table.getRow(AttributeKey(graph.getRef(segment)))
+                .setValue(col, static_cast<float>(values[segment * parameters.radii.size() + r]));
+        }
+        result.addAttribute(name);
+    };
+    std::string weightText = " [" + weightColumn + " Wgt]";
+    for (size_t r = 0; r < parameters.radii.size(); r++) {
+        if (!sampled.choice.empty()) {
+            writeSampled(Column::CHOICE_SAMPLED, r, sampled.choice);
+            writeSampled(Column::CHOICE_SAMPLED_ERROR, r, sampled.error);
+        }
+        if (parameters.choice) {
+            writeColumn(Column::CHOICE, r,
+                        [](const Measures &measure) { return static_cast<float>(measure.choice); });
+            if (!parameters.weights.empty()) {
+                writeColumn(Column::CHOICE + weightText, r,
+                            [](const Measures &measure) { return measure.weightedChoice; });
+            }
+            if (!parameters.weights2.empty()) {
+                std::string pairText = weightColumn.empty() ? weightColumn2
+                                                            : weightColumn + "-" + weightColumn2;
+                writeColumn(Column::CHOICE + " [" + pairText + " Wgt]", r,
+                            [](const Measures &measure) { return measure.weightedChoice2; });
+            }
+        }
+        writeColumn(Column::INTEGRATION, r,
+                    [](const Measures &measure) { return measure.integration; });
+        if (!parameters.weights.empty()) {
+            writeColumn(Column::INTEGRATION + weightText, r,
+                        [](const Measures &measure) { return measure.weightedIntegration; });
+        }
+        writeColumn(Column::MEAN_DEPTH, r,
+                    [](const Measures &measure) { return measure.meanDepth; });
+        writeColumn(Column::NODE_COUNT, r,
+                    [](const Measures &measure) { return measure.nodeCount; });
+        writeColumn(Column::TOTAL_DEPTH, r,
+                    [](const Measures &measure) { return measure.totalDepth; });
+        if (!parameters.weights.empty()) {
+            writeColumn(Column::TOTAL_DEPTH + weightText, r,
+                        [](const Measures &measure) { return measure.weightedTotalDepth; });
+            writeColumn(Column::TOTAL + " " + weightColumn, r,
+                        [](const Measures &measure) { return measure.totalWeight; });
+        }
+    }
+
+    result.completed = true;
+    return result;
+}
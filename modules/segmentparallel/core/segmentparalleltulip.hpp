@@ -0,0 +1,125 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "segmentgraph.hpp"
+
+#include "modules/choicesampling/core/choicesampler.hpp"
+
+#include "salalib/ianalysis.hpp"
+#include "salalib/radiustype.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+class ShapeGraph;
+
+/**
+ * @brief Tulip or full angular segment analysis, searching from many
+ * segments at once
+ *
+ * Turns are rounded to one of the tulip bins so that the searches can keep
+ * their queue as one bucket per whole number of bins. Without bins the turns
+ * are kept in fine fixed point instead, and the queue is a heap. Every
+ * thread has its own queue and its own choice totals, and the totals are
+ * kept in fixed point so that merging those of the threads at the end does
+ * not depend on which thread searched from which segment. Choice is shared
+ * between all the routes of least angle.
+ *
+ * There is one search from each segment, out to the largest radius. A
+ * segment is within a smaller radius when the shortest of the routes of
+ * least angle to it is, as it is gone along.
+ */
+class SegmentParallelTulip : public IAnalysis {
+  public:
+    struct Settings {
+        // -1 is the whole map
+        std::set<double> radiusSet;
+        RadiusType radiusType = RadiusType::ANGULAR;
+        // 0 for full angular analysis
+        int tulipBins = 1024;
+        bool choice = false;
+        // refs of the only segments to search from, when set
+        bool selectionOnly = false;
+        std::set<int> selection;
+        // columns of the attribute table, -1 for none
+        int weightedMeasureCol = -1;
+        int weightedMeasureCol2 = -1;
+        int routeweightCol = -1;
+        // estimates choice from a sample of the origins instead
+        bool sampleChoice = false;
+        ChoiceSampler::Settings choiceSampling;
+    };
+
+    // what the searches need, in terms of the segments of the graph
+    struct Parameters {
+        std::vector<double> radii;
+        RadiusType radiusType = RadiusType::ANGULAR;
+        int tulipBins = 1024;
+        bool choice = false;
+        // adds up the squares of the choice from each origin as well
+        bool choiceSquares = false;
+        // every segment if empty
+        std::vector<uint32_t> origins;
+        // by segment, or empty if not given. Route weights scale the turns
+        // into each segment, and are between 0 and 1
+        std::vector<double> weights;
+        std::vector<double> weights2;
+        std::vector<double> routeWeights;
+    };
+
+    // what a segment has in reach of one radius, -1 where it is not defined
+    // or the segment was not searched from
+    struct Measures {
+        float nodeCount = -1.0f;
+        float totalDepth = -1.0f;
+        float meanDepth = -1.0f;
+        float integration = -1.0f;
+        float totalWeight = -1.0f;
+        float weightedTotalDepth = -1.0f;
+        float weightedIntegration = -1.0f;
+        // in double, as the sampling adds them up again
+        double choice = -1.0;
+        float weightedChoice = -1.0f;
+        float weightedChoice2 = -1.0f;
+        double choiceSquares = -1.0;
+    };
+
+    struct Column {
+        inline static const std::string                          //
+            CHOICE = "Choice",                                   //
+            CHOICE_SAMPLED = "Choice [Sampled]",                 //
+            CHOICE_SAMPLED_ERROR = "Choice 95% Error [Sampled]", //
+            INTEGRATION = "Integration",                         //
+            MEAN_DEPTH = "Mean Depth",                           //
+            NODE_COUNT = "Node Count",                           //
+            TOTAL_DEPTH = "Total Depth",                         //
+            TOTAL = "Total";                                     //
+    };
+    // as the segment analyses of salalib name their radii
+    static std::string makeRadiusText(RadiusType radiusType, double radius);
+    static std::string getColumn(int tulipBins, const std::string &column,
+                                 RadiusType radiusType, double radius) {
+        std::string prefix = tulipBins == 0 ? "Angular " : "T" + std::to_string(tulipBins) + " ";
+        return prefix + column + makeRadiusText(radiusType, radius);
+    }
+
+  private:
+    ShapeGraph &m_map;
+    Settings m_settings;
+
+  public:
+    SegmentParallelTulip(ShapeGraph &map, Settings settings);
+    std::string getAnalysisName() const override {
+        return m_settings.tulipBins == 0 ? "Parallel Angular Analysis" : "Parallel Tulip Analysis";
+    }
+    AnalysisResult run(Communicator *comm) override;
+
+    // the measures of every segment at every radius, radius by radius for
+    // each segment
+    static std::vector<Measures> analyseGraph(const SegmentGraph &graph,
+                                              const Parameters &parameters, Communicator *comm);
+};
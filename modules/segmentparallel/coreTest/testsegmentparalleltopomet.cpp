@@ -0,0 +1,153 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/parallelcommon/coreTest/salalibparity.hpp"
+#include "modules/segmentparallel/core/segmentparalleltopomet.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/segmmodules/segmmetric.hpp"
+#include "salalib/segmmodules/segmtopological.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include "catch_amalgamated.hpp"
+
+namespace {
+    void connect(std::vector<SegmentGraph::Arc> &arcs, uint32_t from, uint32_t to, float turn) {
+        arcs.push_back({SegmentGraph::stateOf(from, true), SegmentGraph::stateOf(to, true), turn});
+        arcs.push_back(
+            {SegmentGraph::stateOf(to, false), SegmentGraph::stateOf(from, false), turn});
+    }
+
+    SegmentGraph makeGraph(std::vector<double> lengths, std::vector<SegmentGraph::Arc> arcs) {
+        std::vector<int> refs;
+        for (size_t segment = 0; segment < lengths.size(); segment++) {
+            refs.push_back(static_cast<int>(segment) + 100);
+        }
+        return SegmentGraph(refs, std::move(lengths), std::move(arcs));
+    }
+
+    SegmentGraph makeLine(size_t segmentCount) {
+        std::vector<SegmentGraph::Arc> arcs;
+        for (uint32_t segment = 0; segment + 1 < segmentCount; segment++) {
+            connect(arcs, segment, segment + 1, 0.0f);
+        }
+        return makeGraph(std::vector<double>(segmentCount, 10.0), std::move(arcs));
+    }
+
+    using Measure = SegmentParallelTopoMet::Measure;
+} // namespace
+
+TEST_CASE("Metric analysis of a straight line of segments", "") {
+    SegmentGraph graph = makeLine(4);
+    auto measures = SegmentParallelTopoMet::analyseGraph(graph, Measure::METRIC, -1, {}, nullptr);
+
+    REQUIRE(measures[0].totalNodes == 4.0f);
+    REQUIRE(measures[0].totalLength == Catch::Approx(40.0));
+    REQUIRE(measures[0].totalDepth == Catch::Approx(10.0 + 20.0 + 30.0));
+    REQUIRE(measures[0].meanDepth == Catch::Approx(20.0));
+    REQUIRE(measures[0].meanDepthSLW == Catch::Approx(20.0));
+    for (uint32_t segment = 0; segment < 4; segment++) {
+        // each way between the segments before and those after
+        double choice = 2.0 * segment * (3.0 - segment);
+        REQUIRE(measures[segment].choice == Catch::Approx(choice));
+        REQUIRE(measures[segment].choiceSLW == Catch::Approx(choice * 100.0));
+    }
+
+    // the search goes no further than the radius
+    auto within = SegmentParallelTopoMet::analyseGraph(graph, Measure::METRIC, 25.0, {}, nullptr);
+    REQUIRE(within[0].totalNodes == 3.0f);
+    REQUIRE(within[1].totalNodes == 4.0f);
+    REQUIRE(within[1].choice == Catch::Approx(2.0));
+}
+
+TEST_CASE("Topological routes change direction the fewest times", "") {
+    // straight on along three long segments, or round two corners through
+    // a short one
+    std::vector<SegmentGraph::Arc> arcs;
+    connect(arcs, 0, 1, 0.0f);
+    connect(arcs, 1, 2, 0.0f);
+    connect(arcs, 2, 4, 0.0f);
+    connect(arcs, 0, 3, 1.0f);
+    connect(arcs, 3, 4, 1.0f);
+    SegmentGraph graph = makeGraph({10.0, 10.0, 10.0, 2.0, 10.0}, std::move(arcs));
+    std::vector<uint32_t> origins = {0};
+
+    auto metric =
+        SegmentParallelTopoMet::analyseGraph(graph, Measure::METRIC, -1, origins, nullptr);
+    REQUIRE(metric[0].totalDepth == Catch::Approx(10.0 + 20.0 + 6.0 + 12.0));
+    REQUIRE(metric[3].choice == Catch::Approx(1.0));
+    REQUIRE(metric[1].choice == Catch::Approx(1.0));
+    REQUIRE(metric[3].totalNodes == -1.0f);
+
+    // the short segment is on an axial line of its own
+    std::vector<int> axialLines = {0, 0, 0, 1, 0};
+    auto topological = SegmentParallelTopoMet::analyseGraph(graph, Measure::TOPOLOGICAL, -1,
+                                                            origins, nullptr, axialLines);
+    REQUIRE(topological[0].totalDepth == Catch::Approx(1.0));
+    REQUIRE(topological[3].choice == Catch::Approx(0.0));
+    REQUIRE(topological[1].choice == Catch::Approx(2.0));
+    REQUIRE(topological[2].choice == Catch::Approx(1.0));
+}
+
+TEST_CASE("TopoMet from a selection searches only the segments in reach of it", "") {
+    SegmentGraph graph = makeLine(8);
+    std::vector<uint32_t> origins = {2, 3};
+    auto within = SegmentParallelTopoMet::segmentsWithin(graph, origins, 15.0);
+    REQUIRE(within == std::vector<uint32_t>{1, 2, 3, 4});
+
+    SegmentGraph compact = graph.subgraph(within);
+    REQUIRE(compact.segmentCount() == 4);
+    REQUIRE(compact.getRef(0) == 101);
+    REQUIRE(compact.arcCount() == 6);
+
+    auto whole = SegmentParallelTopoMet::analyseGraph(graph, Measure::METRIC, 15.0, origins,
+                                                      nullptr);
+    auto fromCompact = SegmentParallelTopoMet::analyseGraph(compact, Measure::METRIC, 15.0,
+                                                            {1, 2}, nullptr);
+    for (uint32_t segment = 0; segment < 4; segment++) {
+        const auto &measure = whole[within[segment]];
+        REQUIRE(fromCompact[segment].totalNodes == measure.totalNodes);
+        REQUIRE(fromCompact[segment].totalDepth == measure.totalDepth);
+        REQUIRE(fromCompact[segment].choice == measure.choice);
+    }
+}
+
+TEST_CASE("Topological routes need the axial lines of the segments", "") {
+    SegmentGraph graph = makeLine(3);
+    REQUIRE_THROWS_AS(
+        SegmentParallelTopoMet::analyseGraph(graph, Measure::TOPOLOGICAL, -1, {}, nullptr),
+        genlib::RuntimeException);
+}
+
+TEST_CASE("Parallel topological and metric analysis matches salalib's", "") {
+    auto data = salalibparity::readTestData("barnsbury_segment.graph");
+    REQUIRE(!data.shapeGraphs.empty());
+    ShapeGraph &map = *data.shapeGraphs.front();
+    salalibparity::QuietCommunicator comm;
+    Measure measure = GENERATE(Measure::TOPOLOGICAL, Measure::METRIC);
+    double radius = 1200.0;
+
+    if (measure == Measure::TOPOLOGICAL) {
+        SegmentTopological(map, radius, std::nullopt).run(&comm);
+    } else {
+        SegmentMetric(map, radius, std::nullopt).run(&comm);
+    }
+    // choice is shared between all the best routes here, so only the
+    // depths and totals are compared
+    std::vector<std::string> columns;
+    for (auto &column : {SegmentParallelTopoMet::Column::MEAN_DEPTH,
+                         SegmentParallelTopoMet::Column::MEAN_DEPTH_SLW,
+                         SegmentParallelTopoMet::Column::TOTAL_DEPTH,
+                         SegmentParallelTopoMet::Column::TOTAL_NODES,
+                         SegmentParallelTopoMet::Column::TOTAL_LENGTH}) {
+        columns.push_back(SegmentParallelTopoMet::getColumn(measure, column, radius));
+    }
+    auto expected = salalibparity::getColumns(map.getAttributeTable(), columns);
+
+    SegmentParallelTopoMet::Settings settings;
+    settings.measure = measure;
+    settings.radius = radius;
+    SegmentParallelTopoMet(map, settings).run(&comm);
+    salalibparity::requireSameColumns(map.getAttributeTable(), columns, expected);
+}
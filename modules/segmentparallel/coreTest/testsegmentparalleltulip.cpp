@@ -0,0 +1,310 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/segmentparallel/core/segmentparalleltulip.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <numeric>
+#include <random>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+    // the end of one segment meeting the other, both ways
+    void connect(std::vector<SegmentGraph::Arc> &arcs, uint32_t from, bool fromForward,
+                 uint32_t to, bool toForward, float turn) {
+        arcs.push_back({SegmentGraph::stateOf(from, fromForward),
+                        SegmentGraph::stateOf(to, toForward), turn});
+        arcs.push_back({SegmentGraph::stateOf(to, !toForward),
+                        SegmentGraph::stateOf(from, !fromForward), turn});
+    }
+
+    SegmentGraph makeGraph(size_t segmentCount, std::vector<SegmentGraph::Arc> arcs) {
+        std::vector<int> refs;
+        for (size_t segment = 0; segment < segmentCount; segment++) {
+            refs.push_back(static_cast<int>(segment));
+        }
+        return SegmentGraph(refs, std::vector<double>(segmentCount, 10.0), std::move(arcs));
+    }
+
+    const SegmentParallelTulip::Measures &measureOf(
+        const std::vector<SegmentParallelTulip::Measures> &measures,
+        const SegmentParallelTulip::Parameters &parameters, uint32_t segment, size_t r = 0) {
+        return measures[segment * parameters.radii.size() + r];
+    }
+} // namespace
+
+TEST_CASE("Tulip analysis of a line of segments turning at right angles", "") {
+    std::vector<SegmentGraph::Arc> arcs;
+    for (uint32_t segment = 0; segment + 1 < 5; segment++) {
+        connect(arcs, segment, true, segment + 1, true, 1.0f);
+    }
+    SegmentGraph graph = makeGraph(5, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {-1, 2.0};
+    parameters.choice = true;
+    auto measures = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+
+    const auto &first = measureOf(measures, parameters, 0);
+    REQUIRE(first.nodeCount == 5.0f);
+    REQUIRE(first.totalDepth == Catch::Approx(1.0 + 2.0 + 3.0 + 4.0));
+    REQUIRE(first.meanDepth == Catch::Approx(10.0 / 4.0));
+    REQUIRE(first.integration == Catch::Approx(25.0 / 10.0));
+    for (uint32_t segment = 0; segment < 5; segment++) {
+        // each way between the segments before and those after
+        double choice = 2.0 * segment * (4.0 - segment);
+        REQUIRE(measureOf(measures, parameters, segment).choice == Catch::Approx(choice));
+    }
+
+    // two right angles away at most
+    REQUIRE(measureOf(measures, parameters, 0, 1).nodeCount == 3.0f);
+    REQUIRE(measureOf(measures, parameters, 2, 1).nodeCount == 5.0f);
+    REQUIRE(measureOf(measures, parameters, 1, 1).choice == Catch::Approx(2.0));
+    REQUIRE(measureOf(measures, parameters, 2, 1).choice == Catch::Approx(2.0));
+}
+
+TEST_CASE("Tulip choice is shared between routes of the same angle", "") {
+    // a loop of four segments, with the opposite one equally far either way
+    std::vector<SegmentGraph::Arc> arcs;
+    for (uint32_t segment = 0; segment < 4; segment++) {
+        connect(arcs, segment, true, (segment + 1) % 4, true, 1.0f);
+    }
+    SegmentGraph graph = makeGraph(4, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {-1};
+    parameters.choice = true;
+    parameters.weights = {1.0, 2.0, 3.0, 4.0};
+    auto measures = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+
+    for (uint32_t segment = 0; segment < 4; segment++) {
+        const auto &measure = measureOf(measures, parameters, segment);
+        REQUIRE(measure.nodeCount == 4.0f);
+        REQUIRE(measure.totalDepth == Catch::Approx(4.0));
+        REQUIRE(measure.integration == Catch::Approx(4.0));
+        REQUIRE(measure.choice == Catch::Approx(1.0));
+        REQUIRE(measure.totalWeight == Catch::Approx(10.0));
+        // half of each way between the two segments on either side
+        double before = parameters.weights[(segment + 3) % 4];
+        double after = parameters.weights[(segment + 1) % 4];
+        REQUIRE(measure.weightedChoice == Catch::Approx(before * after));
+    }
+}
+
+TEST_CASE("Tulip analysis from the selection only", "") {
+    std::vector<SegmentGraph::Arc> arcs;
+    for (uint32_t segment = 0; segment + 1 < 4; segment++) {
+        connect(arcs, segment, true, segment + 1, true, 0.5f);
+    }
+    SegmentGraph graph = makeGraph(4, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {-1};
+    parameters.choice = true;
+    parameters.origins = {0};
+    auto measures = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+
+    REQUIRE(measureOf(measures, parameters, 0).nodeCount == 4.0f);
+    REQUIRE(measureOf(measures, parameters, 1).nodeCount == -1.0f);
+    // only the routes from the first segment
+    REQUIRE(measureOf(measures, parameters, 1).choice == Catch::Approx(2.0));
+    REQUIRE(measureOf(measures, parameters, 2).choice == Catch::Approx(1.0));
+}
+
+TEST_CASE("Tulip radius takes the shortest of the routes of least angle", "") {
+    // O X A B in a line and a shortcut O P Q A, none of them turning. The
+    // long way reaches A first, and B is only within the radius the short way
+    std::vector<SegmentGraph::Arc> arcs;
+    connect(arcs, 0, true, 1, true, 0.0f);
+    connect(arcs, 1, true, 2, true, 0.0f);
+    connect(arcs, 2, true, 3, true, 0.0f);
+    connect(arcs, 0, true, 4, true, 0.0f);
+    connect(arcs, 4, true, 5, true, 0.0f);
+    connect(arcs, 5, true, 2, true, 0.0f);
+    SegmentGraph graph({0, 1, 2, 3, 4, 5}, {10.0, 100.0, 10.0, 40.0, 1.0, 1.0}, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {130.0};
+    parameters.radiusType = RadiusType::METRIC;
+    parameters.choice = true;
+    auto measures = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+    REQUIRE(measureOf(measures, parameters, 0).nodeCount == 6.0f);
+    REQUIRE(measureOf(measures, parameters, 0).totalDepth == 0.0f);
+}
+
+TEST_CASE("Tulip radii share one search from each segment", "") {
+    std::mt19937 generator(11);
+    std::uniform_int_distribution<uint32_t> pick(0, 99);
+    std::uniform_real_distribution<float> turn(0.0f, 2.0f);
+    std::bernoulli_distribution way(0.5);
+    std::vector<SegmentGraph::Arc> arcs;
+    for (size_t connection = 0; connection < 250; connection++) {
+        uint32_t from = pick(generator), to = pick(generator);
+        if (from != to) {
+            connect(arcs, from, way(generator), to, way(generator), turn(generator));
+        }
+    }
+    SegmentGraph graph = makeGraph(100, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {-1, 1.0, 2.5};
+    parameters.tulipBins = 16;
+    parameters.choice = true;
+    auto measures = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+
+    SegmentParallelTulip::Parameters whole = parameters;
+    whole.radii = {-1};
+    auto alone = SegmentParallelTulip::analyseGraph(graph, whole, nullptr);
+
+    for (uint32_t segment = 0; segment < 100; segment++) {
+        const auto &measure = measureOf(measures, parameters, segment);
+        REQUIRE(measure.nodeCount == alone[segment].nodeCount);
+        REQUIRE(measure.totalDepth == alone[segment].totalDepth);
+        REQUIRE(measure.choice == alone[segment].choice);
+        // the smaller radii have what is within them of the search
+        REQUIRE(measureOf(measures, parameters, segment, 1).nodeCount <=
+                measureOf(measures, parameters, segment, 2).nodeCount);
+        REQUIRE(measureOf(measures, parameters, segment, 2).nodeCount <= measure.nodeCount);
+    }
+}
+
+TEST_CASE("Full angular analysis of a line of segments", "") {
+    std::vector<SegmentGraph::Arc> arcs;
+    for (uint32_t segment = 0; segment + 1 < 4; segment++) {
+        connect(arcs, segment, true, segment + 1, true, 0.3f);
+    }
+    SegmentGraph graph = makeGraph(4, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {-1, 0.7};
+    parameters.tulipBins = 0;
+    parameters.choice = true;
+    auto measures = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+
+    // the turns as they are, not rounded down to a bin
+    const auto &first = measureOf(measures, parameters, 0);
+    REQUIRE(first.nodeCount == 4.0f);
+    REQUIRE(first.totalDepth == Catch::Approx(0.3 + 0.6 + 0.9).epsilon(1e-5));
+    REQUIRE(measureOf(measures, parameters, 1).choice == Catch::Approx(4.0));
+    REQUIRE(measureOf(measures, parameters, 0, 1).nodeCount == 3.0f);
+    REQUIRE(measureOf(measures, parameters, 1, 1).choice == Catch::Approx(2.0));
+    REQUIRE(SegmentParallelTulip::getColumn(0, SegmentParallelTulip::Column::INTEGRATION,
+                                            RadiusType::ANGULAR, 0.7) ==
+            "Angular Integration R0.70");
+}
+
+TEST_CASE("Tulip route weights scale the turns into each segment", "") {
+    std::vector<SegmentGraph::Arc> arcs;
+    connect(arcs, 0, true, 1, true, 1.0f);
+    connect(arcs, 1, true, 2, true, 1.0f);
+    SegmentGraph graph = makeGraph(3, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {-1};
+    parameters.routeWeights = {1.0, 0.5, 0.0};
+    auto measures = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+    REQUIRE(measureOf(measures, parameters, 0).totalDepth == Catch::Approx(0.5 + 0.5));
+    REQUIRE(measureOf(measures, parameters, 2).totalDepth == Catch::Approx(0.5 + 1.5));
+
+    // anything else would need more buckets than there are turns
+    parameters.routeWeights = {1.0, 2.0, 0.0};
+    REQUIRE_THROWS_AS(SegmentParallelTulip::analyseGraph(graph, parameters, nullptr),
+                      genlib::RuntimeException);
+    parameters.routeWeights = {1.0, -0.5, 0.0};
+    REQUIRE_THROWS_AS(SegmentParallelTulip::analyseGraph(graph, parameters, nullptr),
+                      genlib::RuntimeException);
+}
+
+TEST_CASE("Tulip choice from a sample of segments", "") {
+    std::mt19937 generator(2);
+    std::uniform_int_distribution<uint32_t> pick(0, 119);
+    std::uniform_real_distribution<float> turn(0.0f, 2.0f);
+    std::bernoulli_distribution way(0.5);
+    std::vector<SegmentGraph::Arc> arcs;
+    for (size_t connection = 0; connection < 300; connection++) {
+        uint32_t from = pick(generator), to = pick(generator);
+        if (from != to) {
+            connect(arcs, from, way(generator), to, way(generator), turn(generator));
+        }
+    }
+    SegmentGraph graph = makeGraph(120, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {-1, 2.0};
+    parameters.tulipBins = 32;
+    parameters.choice = true;
+    auto exact = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+
+    parameters.choiceSquares = true;
+    parameters.origins = {7};
+    for (const auto &measure : SegmentParallelTulip::analyseGraph(graph, parameters, nullptr)) {
+        REQUIRE(measure.choiceSquares ==
+                Catch::Approx(double(measure.choice) * measure.choice).margin(1e-3));
+    }
+
+    std::vector<uint32_t> origins(120);
+    std::iota(origins.begin(), origins.end(), 0);
+    ChoiceSampler::Settings settings;
+    settings.sampling = ChoiceSampler::Sampling::UNIFORM;
+    settings.sampleShare = 1.0;
+    auto everySegment =
+        ChoiceSampler::estimate(origins, settings, [&](const std::vector<uint32_t> &sample) {
+            parameters.origins = sample;
+            ChoiceSampler::Totals totals;
+            for (const auto &measure :
+                 SegmentParallelTulip::analyseGraph(graph, parameters, nullptr)) {
+                totals.choice.push_back(measure.choice);
+                totals.choiceSquares.push_back(measure.choiceSquares);
+            }
+            return totals;
+        });
+    REQUIRE(everySegment.sampleCount == 120);
+    for (size_t idx = 0; idx < exact.size(); idx++) {
+        REQUIRE(everySegment.choice[idx] == Catch::Approx(exact[idx].choice).margin(1e-3));
+        REQUIRE(everySegment.error[idx] == 0.0);
+    }
+}
+
+TEST_CASE("Tulip choice does not depend on the number of threads", "") {
+    std::mt19937 generator(5);
+    std::uniform_int_distribution<uint32_t> pick(0, 299);
+    std::uniform_real_distribution<float> turn(0.0f, 2.0f);
+    std::bernoulli_distribution way(0.5);
+    std::vector<SegmentGraph::Arc> arcs;
+    for (size_t connection = 0; connection < 700; connection++) {
+        uint32_t from = pick(generator), to = pick(generator);
+        if (from != to) {
+            connect(arcs, from, way(generator), to, way(generator), turn(generator));
+        }
+    }
+    SegmentGraph graph = makeGraph(300, std::move(arcs));
+
+    SegmentParallelTulip::Parameters parameters;
+    parameters.radii = {-1, 3.0};
+    parameters.tulipBins = 8;
+    parameters.choice = true;
+    parameters.weights.assign(300, 0.3);
+
+    auto measures = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+#ifdef _OPENMP
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(threads > 1 ? 1 : 4);
+#endif
+    auto again = SegmentParallelTulip::analyseGraph(graph, parameters, nullptr);
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+
+    for (size_t idx = 0; idx < measures.size(); idx++) {
+        REQUIRE(measures[idx].nodeCount == again[idx].nodeCount);
+        REQUIRE(measures[idx].choice == again[idx].choice);
+        REQUIRE(measures[idx].weightedChoice == again[idx].weightedChoice);
+    }
+}
@@ -0,0 +1,189 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "segmentparallelmainwindow.hpp"
+
+#include "modules/segmentparallel/core/segmentparalleltopomet.hpp"
+#include "modules/segmentparallel/core/segmentparalleltulip.hpp"
+
+#include "qtgui/dialogs/SegmentAnalysisDlg.hpp"
+#include "qtgui/dialogs/TopoMetDlg.hpp"
+#include "qtgui/mainwindowhelpers.hpp"
+
+#include <QInputDialog>
+#include <QMenuBar>
+#include <QMessageBox>
+
+namespace {
+    // the sampling of the segments searched from for choice, false if cancelled
+    bool getChoiceSampling(QWidget *parent, ChoiceSampler::Settings &settings) {
+        bool ok = false;
+        QStringList samplings = {QObject::tr("Adaptive"), QObject::tr("Uniform")};
+        QString sampling = QInputDialog::getItem(
+            parent, QObject::tr("Choice sampling"),
+            QObject::tr("Adaptive sampling searches from as many segments as it takes for the "
+                        "highest choice to be within the target error.\nUniform sampling "
+                        "searches from a fixed share of them"),
+            samplings, 0, false, &ok);
+        if (!ok)
+            return false;
+        if (sampling == samplings[0]) {
+            settings.sampling = ChoiceSampler::Sampling::ADAPTIVE;
+            double targetError = QInputDialog::getDouble(
+                parent, QObject::tr("Target error"),
+                QObject::tr("Error of the estimated choice to aim for, in percent"), 10.0, 0.1,
+                50.0, 1, &ok);
+            if (!ok)
+                return false;
+            settings.targetError = targetError / 100.0;
+            settings.sampleShare = 1.0;
+        } else {
+            settings.sampling = ChoiceSampler::Sampling::UNIFORM;
+            double share = QInputDialog::getDouble(
+                parent, QObject::tr("Sample size"),
+                QObject::tr("Share of the segments to search from, in percent of those selected "
+                            "or of all of them"),
+                10.0, 0.1, 100.0, 1, &ok);
+            if (!ok)
+                return false;
+            settings.sampleShare = share / 100.0;
+        }
+        return true;
+    }
+} // namespace
+
+bool SegmentParallelMainWindow::createMenus(MainWindow *mainWindow) {
+    QMenu *toolsMenu = MainWindowHelpers::getOrAddRootMenu(mainWindow, tr("&Tools"));
+    QMenu *segmentMenu = MainWindowHelpers::getOrAddMenu(toolsMenu, tr("&Segment"));
+
+    QAction *segmentParallelAct = new QAction(tr("Run Parallel Angular Analysis..."), mainWindow);
+    segmentParallelAct->setStatusTip(
+        tr("Tulip or full angular analysis of the displayed segment map, searching from many "
+           "segments at once"));
+    connect(segmentParallelAct, &QAction::triggered, this,
+            [this, mainWindow] { OnSegmentParallel(mainWindow, false); });
+    segmentMenu->addAction(segmentParallelAct);
+    QAction *segmentSampledAct =
+        new QAction(tr("Run Parallel Angular Analysis (Sampled Choice)..."), mainWindow);
+    segmentSampledAct->setStatusTip(tr(
+        "Angular analysis of the displayed segment map, with choice estimated from a sample of "
+        "segments"));
+    connect(segmentSampledAct, &QAction::triggered, this,
+            [this, mainWindow] { OnSegmentParallel(mainWindow, true); });
+    segmentMenu->addAction(segmentSampledAct);
+    QAction *topoMetParallelAct =
+        new QAction(tr("Run Parallel Topological / Metric Analysis..."), mainWindow);
+    topoMetParallelAct->setStatusTip(
+        tr("Topological or metric analysis of the displayed segment map, searching from many "
+           "segments at once"));
+    connect(topoMetParallelAct, &QAction::triggered, this,
+            [this, mainWindow] { OnTopoMetParallel(mainWindow); });
+    segmentMenu->addAction(topoMetParallelAct);
+
+    return true;
+}
+
+void SegmentParallelMainWindow::OnSegmentParallel(MainWindow *mainWindow, bool sampleChoice) {
+    QGraphDoc *graphDoc = mainWindow->activeMapDoc();
+    if (graphDoc == nullptr)
+        return;
+
+    if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::SEGMENTMAP) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please make sure the displayed map is a segment map"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    // the dialog leaves its choices in the options of the main window
+    CSegmentAnalysisDlg dlg(graphDoc->m_meta_graph);
+    if (dlg.exec() != QDialog::Accepted)
+        return;
+    const auto &options = mainWindow->m_options;
+    ChoiceSampler::Settings choiceSampling;
+    if (sampleChoice && options.choice && !getChoiceSampling(mainWindow, choiceSampling))
+        return;
+
+    auto &map = graphDoc->m_meta_graph->getDisplayedShapeGraph();
+    SegmentParallelTulip::Settings settings;
+    settings.radiusSet = options.radiusSet;
+    settings.radiusType = options.radiusType;
+    settings.tulipBins = options.tulipBins;
+    settings.choice = options.choice;
+    settings.selectionOnly = options.selOnly;
+    if (options.selOnly) {
+        settings.selection = map.getSelSet();
+    }
+    settings.weightedMeasureCol = options.weightedMeasureCol;
+    settings.weightedMeasureCol2 = options.weightedMeasureCol2;
+    settings.routeweightCol = options.routeweightCol;
+    settings.sampleChoice = sampleChoice;
+    settings.choiceSampling = choiceSampling;
+
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    comm->setAnalysis(std::make_unique<SegmentParallelTulip>(map.getInternalMap(), settings));
+    double radius = *options.radiusSet.rbegin();
+    if (options.radiusSet.count(-1) != 0) {
+        radius = -1;
+    }
+    comm->setPostAnalysisFunc([&map, settings, radius](std::unique_ptr<IAnalysis> &,
+                                                       AnalysisResult &) {
+        map.overrideDisplayedAttribute(-2);
+        map.setDisplayedAttribute(SegmentParallelTulip::getColumn(
+            settings.tulipBins, SegmentParallelTulip::Column::INTEGRATION, settings.radiusType,
+            radius));
+    });
+
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
+
+    graphDoc->submitJob(comm.release(), tr("Performing parallel segment line analysis..."),
+                        graphDoc->getDisplayedLayer());
+}
+
+void SegmentParallelMainWindow::OnTopoMetParallel(MainWindow *mainWindow) {
+    QGraphDoc *graphDoc = mainWindow->activeMapDoc();
+    if (graphDoc == nullptr)
+        return;
+
+    if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::SEGMENTMAP) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please make sure the displayed map is a segment map"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+
+    CTopoMetDlg dlg;
+    if (dlg.exec() != QDialog::Accepted)
+        return;
+
+    auto &map = graphDoc->m_meta_graph->getDisplayedShapeGraph();
+    SegmentParallelTopoMet::Settings settings;
+    settings.measure = dlg.isAnalysisTopological() ? SegmentParallelTopoMet::Measure::TOPOLOGICAL
+                                                   : SegmentParallelTopoMet::Measure::METRIC;
+    settings.radius = dlg.m_dradius;
+    settings.selectionOnly = dlg.m_selected_only;
+    if (dlg.m_selected_only) {
+        settings.selection = map.getSelSet();
+    }
+
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    comm->setAnalysis(std::make_unique<SegmentParallelTopoMet>(map.getInternalMap(), settings));
+    comm->setPostAnalysisFunc([&map, settings](std::unique_ptr<IAnalysis> &, AnalysisResult &) {
+        map.overrideDisplayedAttribute(-2);
+        map.setDisplayedAttribute(SegmentParallelTopoMet::getColumn(
+            settings.measure, SegmentParallelTopoMet::Column::MEAN_DEPTH, settings.radius));
+    });
+
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
+
+    graphDoc->submitJob(comm.release(),
+                        settings.measure == SegmentParallelTopoMet::Measure::TOPOLOGICAL
+                            ? tr("Performing parallel topological analysis...")
+                            : tr("Performing parallel metric analysis..."),
+                        graphDoc->getDisplayedLayer());
+}
@@ -0,0 +1,17 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "qtgui/imainwindowmodule.hpp"
+
+class SegmentParallelMainWindow : public IMainWindowModule {
+  private slots:
+    void OnSegmentParallel(MainWindow *mainWindow, bool sampleChoice);
+    void OnTopoMetParallel(MainWindow *mainWindow);
+
+  public:
+    SegmentParallelMainWindow() : IMainWindowModule() {}
+    bool createMenus(MainWindow *mainWindow);
+};
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "segmentindexedshortestpath.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <utility>
+
+const std::string &SegmentIndexedShortestPath::getColumn(CostType costType) {
+    switch (costType) {
+    case CostType::METRIC:
+        return Column::METRIC_INDEXED_SHORTEST_PATH;
+    case CostType::TOPOLOGICAL:
+        return Column::TOPOLOGICAL_INDEXED_SHORTEST_PATH;
+    case CostType::ANGULAR:
+        break;
+    }
+    return Column::ANGULAR_INDEXED_SHORTEST_PATH;
+}
+
+AnalysisResult SegmentIndexedShortestPath::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("indexing routes");
+    }
+    auto index = m_indices.get(m_map, m_costType);
+    uint32_t from = index->findSegment(m_refFrom);
+    uint32_t to = index->findSegment(m_refTo);
+    if (from == SegmentRouteIndex::NO_SEGMENT || to == SegmentRouteIndex::NO_SEGMENT) {
+        throw genlib::RuntimeException("Both ends of the path need to be segments of the map");
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("searching");
+    }
+    SegmentRouteIndex::Query query(*index);
+    auto route = query.findRoute(from, to);
+    if (route.segments.empty()) {
+        throw genlib::RuntimeException("There is no path between the segments");
+    }
+
+    AttributeTable &table = m_map.getAttributeTable();
+    const std::string &column = getColumn(m_costType);
+    size_t pathCol = table.insertOrResetColumn(column);
+    for (size_t step = 0; step < route.segments.size(); step++) {
+        table.getRow(AttributeKey(index->getRef(route.segments[step])))
+            .setValue(pathCol, static_cast<float>(route.costs[step]));
+    }
+
+    AnalysisResult result;
+    result.completed = true;
+    result.addAttribute(column);
+    return result;
+}
+
+AnalysisResult SegmentRouteIndexing::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    using CostType = SegmentRouteIndex::CostType;
+    for (auto [costType, phase] : {std::pair{CostType::METRIC, "indexing metric routes"},
+                                   std::pair{CostType::TOPOLOGICAL, "indexing topological routes"},
+                                   std::pair{CostType::ANGULAR, "indexing angular routes"}}) {
+        if (telemetry) {
+            telemetry->setPhase(phase);
+        }
+        m_indices.get(m_map, costType);
+    }
+    AnalysisResult result;
+    result.completed = true;
+    return result;
+}
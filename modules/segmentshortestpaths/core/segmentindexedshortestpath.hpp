@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "segmentrouteindex.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+
+class ShapeGraph;
+
+/**
+ * @brief Metric, topological or angular shortest path between two segments, through
+ * the route index of the map
+ *
+ * The index is made on the first query of a map and kept in the cache of the
+ * document for the ones after it.
+ */
+class SegmentIndexedShortestPath : public IAnalysis {
+  public:
+    using CostType = SegmentRouteIndex::CostType;
+
+    struct Column {
+        inline static const std::string                                              //
+            METRIC_INDEXED_SHORTEST_PATH = "Metric Indexed Shortest Path",           //
+            TOPOLOGICAL_INDEXED_SHORTEST_PATH = "Topological Indexed Shortest Path", //
+            ANGULAR_INDEXED_SHORTEST_PATH = "Angular Indexed Shortest Path";         //
+    };
+    static const std::string &getColumn(CostType costType);
+
+  private:
+    ShapeGraph &m_map;
+    SegmentRouteIndexCache &m_indices;
+    CostType m_costType;
+    int m_refFrom;
+    int m_refTo;
+
+  public:
+    SegmentIndexedShortestPath(ShapeGraph &map, SegmentRouteIndexCache &indices,
+                               CostType costType, int refFrom, int refTo)
+        : m_map(map), m_indices(indices), m_costType(costType), m_refFrom(refFrom),
+          m_refTo(refTo) {}
+    std::string getAnalysisName() const override { return "Indexed Segment Shortest Path"; }
+    AnalysisResult run(Communicator *comm) override;
+};
+
+/**
+ * @brief Makes the metric, topological and angular route indices of a segment map
+ * ahead of the queries
+ */
+class SegmentRouteIndexing : public IAnalysis {
+    ShapeGraph &m_map;
+    SegmentRouteIndexCache &m_indices;
+
+  public:
+    SegmentRouteIndexing(ShapeGraph &map, SegmentRouteIndexCache &indices)
+        : m_map(map), m_indices(indices) {}
+    std::string getAnalysisName() const override { return "Segment Route Indexing"; }
+    AnalysisResult run(Communicator *comm) override;
+};
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "segmentpathtree.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+    constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+    // segments settled between looking at the clock
+    constexpr size_t CLOCK_INTERVAL = 64;
+} // namespace
+
+SegmentPathTree::SegmentPathTree(std::vector<int> refs,
+                                 const std::vector<Connection> &connections, uint32_t origin)
+    : m_refs(std::move(refs)), m_origin(origin) {
+    size_t segmentCount = m_refs.size();
+    if (origin >= segmentCount) {
+        throw genlib::RuntimeException("Segment outside the map");
+    }
+    m_offsets.assign(segmentCount + 1, 0);
+    for (auto &connection : connections) {
+        if (connection.from >= segmentCount || connection.to >= segmentCount) {
+            throw genlib::RuntimeException("Connection to a segment outside the map");
+        }
+        m_offsets[connection.from + 1]++;
+        m_offsets[connection.to + 1]++;
+    }
+    for (size_t segment = 0; segment < segmentCount; segment++) {
+        m_offsets[segment + 1] += m_offsets[segment];
+    }
+    m_targets.resize(m_offsets.back());
+    m_steps.resize(m_offsets.back());
+    std::vector<size_t> next(m_offsets.begin(), m_offsets.end() - 1);
+    for (auto &connection : connections) {
+        m_targets[next[connection.from]] = connection.to;
+        m_steps[next[connection.from]++] = connection.cost;
+        m_targets[next[connection.to]] = connection.from;
+        m_steps[next[connection.to]++] = connection.cost;
+    }
+
+    m_cost.assign(segmentCount, UNREACHED);
+    m_parent.assign(segmentCount, SegmentRouteIndex::NO_SEGMENT);
+    m_settled.assign(segmentCount, 0);
+    m_cost[origin] = 0.0;
+    m_queue.emplace(0.0, origin);
+}
+
+std::unique_ptr<SegmentPathTree> SegmentPathTree::fromMap(ShapeGraph &map, CostType costType,
+                                                          int originRef) {
+    std::vector<int> refs;
+    for (auto &shape : map.getAllShapes()) {
+        refs.push_back(shape.first);
+    }
+    auto origin = std::find(refs.begin(), refs.end(), originRef);
+    if (origin == refs.end()) {
+        return nullptr;
+    }
+    auto originSegment = static_cast<uint32_t>(origin - refs.begin());
+    return std::make_unique<SegmentPathTree>(
+        std::move(refs), SegmentRouteIndex::getConnections(map, costType), originSegment);
+}
+
+void SegmentPathTree::settleNext() {
+    while (!m_queue.empty()) {
+        auto [cost, segment] = m_queue.top();
+        m_queue.pop();
+        if (m_settled[segment]) {
+            continue;
+        }
+        m_settled[segment] = 1;
+        m_settledCount++;
+        for (size_t idx = m_offsets[segment]; idx < m_offsets[segment + 1]; idx++) {
+            uint32_t target = m_targets[idx];
+            if (!m_settled[target] && cost + m_steps[idx] < m_cost[target]) {
+                m_cost[target] = cost + m_steps[idx];
+                m_parent[target] = segment;
+                m_queue.emplace(m_cost[target], target);
+            }
+        }
+        return;
+    }
+}
+
+std::optional<SegmentPathTree::Route>
+SegmentPathTree::findRoute(uint32_t to, std::chrono::microseconds budget) {
+    if (to >= m_refs.size()) {
+        return Route();
+    }
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    while (!m_settled[to] && !m_queue.empty()) {
+        for (size_t count = 0; count < CLOCK_INTERVAL && !m_settled[to] && !m_queue.empty();
+             count++) {
+            settleNext();
+        }
+        if (!m_settled[to] && std::chrono::steady_clock::now() >= deadline) {
+            return std::nullopt;
+        }
+    }
+
+    Route route;
+    if (!m_settled[to]) {
+        return route;
+    }
+    for (uint32_t segment = to; segment != SegmentRouteIndex::NO_SEGMENT;
+         segment = m_parent[segment]) {
+        route.segments.push_back(segment);
+    }
+    std::reverse(route.segments.begin(), route.segments.end());
+    for (uint32_t segment : route.segments) {
+        route.costs.push_back(m_cost[segment]);
+    }
+    return route;
+}
+
+uint32_t SegmentPathTree::findSegment(int ref) const {
+    // the shapes of a map are in the order of their refs
+    auto it = std::lower_bound(m_refs.begin(), m_refs.end(), ref);
+    if (it != m_refs.end() && *it == ref) {
+        return static_cast<uint32_t>(it - m_refs.begin());
+    }
+    it = std::find(m_refs.begin(), m_refs.end(), ref);
+    return it == m_refs.end() ? SegmentRouteIndex::NO_SEGMENT
+                              : static_cast<uint32_t>(it - m_refs.begin());
+}
@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "segmentrouteindex.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+class ShapeGraph;
+
+/**
+ * @brief Shortest routes from one segment to any other, searched only as
+ * far as the segments asked for
+ *
+ * The connections of the map are taken once, with the same costs as the
+ * route index, and the search from the origin is kept between queries so
+ * that each one only settles the segments it has not reached yet. A query
+ * stops when its time runs out and carries on the next time it is asked.
+ */
+class SegmentPathTree {
+  public:
+    using CostType = SegmentRouteIndex::CostType;
+    using Connection = SegmentRouteIndex::Connection;
+    using Route = SegmentRouteIndex::Route;
+
+  private:
+    std::vector<int> m_refs;
+    // connections of each segment, both ways
+    std::vector<size_t> m_offsets;
+    std::vector<uint32_t> m_targets;
+    std::vector<double> m_steps;
+
+    uint32_t m_origin;
+    std::vector<double> m_cost;
+    std::vector<uint32_t> m_parent;
+    std::vector<uint8_t> m_settled;
+    std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>,
+                        std::greater<std::pair<double, uint32_t>>>
+        m_queue;
+    size_t m_settledCount = 0;
+
+    void settleNext();
+
+  public:
+    // refs are those of the segments in the attribute table
+    SegmentPathTree(std::vector<int> refs, const std::vector<Connection> &connections,
+                    uint32_t origin);
+    // nullptr if no segment of the map has the ref
+    static std::unique_ptr<SegmentPathTree> fromMap(ShapeGraph &map, CostType costType,
+                                                    int originRef);
+
+    // the route from the origin, with no segments if the segment cannot be
+    // reached, or nothing if the time ran out before the segment was settled
+    std::optional<Route> findRoute(uint32_t to, std::chrono::microseconds budget);
+
+    size_t segmentCount() const { return m_refs.size(); }
+    int getRef(uint32_t segment) const { return m_refs[segment]; }
+    // NO_SEGMENT if no segment has the ref
+    uint32_t findSegment(int ref) const;
+    uint32_t getOrigin() const { return m_origin; }
+    size_t getSettledCount() const { return m_settledCount; }
+    bool isComplete() const { return m_queue.empty(); }
+};
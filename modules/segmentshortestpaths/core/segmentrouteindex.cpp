@@ -0,0 +1,372 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "segmentrouteindex.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/shapegraph.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace {
+    constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+    // segments settled by each search for another way round a segment
+    // before giving up and adding the shortcut anyway
+    constexpr size_t WITNESS_SETTLE_LIMIT = 200;
+
+    using Entry = std::pair<double, uint32_t>;
+    using MinQueue = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>;
+
+    uint32_t otherEnd(uint32_t from, uint32_t to, uint32_t end) { return end == from ? to : from; }
+} // namespace
+
+SegmentRouteIndex::SegmentRouteIndex(std::vector<int> refs,
+                                     const std::vector<Connection> &connections)
+    : m_refs(std::move(refs)) {
+    contract(connections);
+}
+
+void SegmentRouteIndex::contract(const std::vector<Connection> &connections) {
+    size_t segmentCount = m_refs.size();
+    // the arcs of each segment, to either end, including those to segments
+    // already taken out
+    std::vector<std::vector<uint32_t>> arcsOf(segmentCount);
+    auto addArc = [&](const Arc &newArc) {
+        // only the cheapest arc between two segments is kept
+        for (uint32_t arcIdx : arcsOf[newArc.from]) {
+            Arc &arc = m_arcs[arcIdx];
+            if (otherEnd(arc.from, arc.to, newArc.from) == newArc.to) {
+                if (newArc.cost < arc.cost) {
+                    arc = newArc;
+                }
+                return;
+            }
+        }
+        auto arcIdx = static_cast<uint32_t>(m_arcs.size());
+        m_arcs.push_back(newArc);
+        arcsOf[newArc.from].push_back(arcIdx);
+        arcsOf[newArc.to].push_back(arcIdx);
+    };
+    for (auto &connection : connections) {
+        if (connection.from >= segmentCount || connection.to >= segmentCount) {
+            throw genlib::RuntimeException("Connection to a segment outside the map");
+        }
+        if (connection.from != connection.to) {
+            addArc({connection.from, connection.to, connection.cost, NO_SEGMENT, NO_ARC, NO_ARC});
+        }
+    }
+
+    std::vector<uint8_t> contracted(segmentCount, 0);
+    std::vector<uint32_t> contractedNeighbours(segmentCount, 0);
+    std::vector<double> witnessCost(segmentCount, UNREACHED);
+    std::vector<uint32_t> witnessTouched;
+    std::vector<std::pair<uint32_t, uint32_t>> neighbours;
+
+    // the shortcuts needed to take the segment out, added if asked to
+    auto shortcutsFor = [&](uint32_t segment, bool add) {
+        neighbours.clear();
+        double furthest = 0.0;
+        for (uint32_t arcIdx : arcsOf[segment]) {
+            uint32_t neighbour = otherEnd(m_arcs[arcIdx].from, m_arcs[arcIdx].to, segment);
+            if (!contracted[neighbour]) {
+                neighbours.emplace_back(neighbour, arcIdx);
+                furthest = std::max(furthest, m_arcs[arcIdx].cost);
+            }
+        }
+        size_t shortcutCount = 0;
+        for (size_t first = 0; first + 1 < neighbours.size(); first++) {
+            auto [from, fromArc] = neighbours[first];
+            double viaCost = m_arcs[fromArc].cost;
+            // another way from the first neighbour to the rest, around the
+            // segment and no longer than going through it
+            MinQueue queue;
+            witnessCost[from] = 0.0;
+            witnessTouched.push_back(from);
+            queue.emplace(0.0, from);
+            size_t settled = 0;
+            while (!queue.empty() && settled < WITNESS_SETTLE_LIMIT) {
+                auto [cost, node] = queue.top();
+                queue.pop();
+                if (cost > witnessCost[node]) {
+                    continue;
+                }
+                if (cost > viaCost + furthest) {
+                    break;
+                }
+                settled++;
+                for (uint32_t arcIdx : arcsOf[node]) {
+                    const Arc &arc = m_arcs[arcIdx];
+                    uint32_t next = otherEnd(arc.from, arc.to, node);
+                    if (next == segment || contracted[next] ||
+                        cost + arc.cost >= witnessCost[next]) {
+                        continue;
+                    }
+                    if (witnessCost[next] == UNREACHED) {
+                        witnessTouched.push_back(next);
+                    }
+                    witnessCost[next] = cost + arc.cost;
+                    queue.emplace(witnessCost[next], next);
+                }
+            }
+            for (size_t second = first + 1; second < neighbours.size(); second++) {
+                auto [to, toArc] = neighbours[second];
+                double shortcutCost = viaCost + m_arcs[toArc].cost;
+                if (witnessCost[to] <= shortcutCost) {
+                    continue;
+                }
+                shortcutCount++;
+                if (add) {
+                    addArc({from, to, shortcutCost, segment, fromArc, toArc});
+                }
+            }
+            for (uint32_t node : witnessTouched) {
+                witnessCost[node] = UNREACHED;
+            }
+            witnessTouched.clear();
+        }
+        return shortcutCount;
+    };
+    // segments that add fewer arcs than they take away go first, spread
+    // out over the map by counting the neighbours already taken out
+    auto priorityOf = [&](uint32_t segment) {
+        auto shortcutCount = static_cast<double>(shortcutsFor(segment, false));
+        return shortcutCount - static_cast<double>(neighbours.size()) +
+               contractedNeighbours[segment];
+    };
+
+    MinQueue order;
+    for (uint32_t segment = 0; segment < segmentCount; segment++) {
+        order.emplace(priorityOf(segment), segment);
+    }
+    std::vector<std::vector<uint32_t>> upArcs(segmentCount);
+    while (!order.empty()) {
+        uint32_t segment = order.top().second;
+        order.pop();
+        if (contracted[segment]) {
+            continue;
+        }
+        // priorities change as the neighbours are taken out, so they are
+        // checked again when they come up
+        double priority = priorityOf(segment);
+        if (!order.empty() && priority > order.top().first) {
+            order.emplace(priority, segment);
+            continue;
+        }
+        for (auto [neighbour, arcIdx] : neighbours) {
+            upArcs[segment].push_back(arcIdx);
+            contractedNeighbours[neighbour]++;
+        }
+        shortcutsFor(segment, true);
+        contracted[segment] = 1;
+    }
+
+    m_upOffsets.assign(1, 0);
+    for (auto &arcs : upArcs) {
+        m_upArcs.insert(m_upArcs.end(), arcs.begin(), arcs.end());
+        m_upOffsets.push_back(m_upArcs.size());
+    }
+}
+
+std::vector<SegmentRouteIndex::Connection> SegmentRouteIndex::getConnections(ShapeGraph &map,
+                                                                             CostType costType) {
+    auto &shapes = map.getAllShapes();
+    auto &connectors = map.getConnections();
+    if (connectors.size() != shapes.size()) {
+        throw genlib::RuntimeException("The connections of the segment map have not been made");
+    }
+    std::vector<double> lengths;
+    lengths.reserve(shapes.size());
+    for (auto &shape : shapes) {
+        lengths.push_back(shape.second.getLine().length());
+    }
+    std::vector<Connection> connections;
+    for (size_t segment = 0; segment < connectors.size(); segment++) {
+        for (auto *segconns :
+             {&connectors[segment].backSegconns, &connectors[segment].forwardSegconns}) {
+            for (auto &connection : *segconns) {
+                // the segment connections are keyed by the index of the
+                // segment, and are there from both ends
+                auto target = static_cast<size_t>(connection.first.ref);
+                if (target <= segment || target >= shapes.size()) {
+                    continue;
+                }
+                double cost = connection.second;
+                if (costType == CostType::METRIC) {
+                    cost = (lengths[segment] + lengths[target]) * 0.5;
+                } else if (costType == CostType::TOPOLOGICAL) {
+                    cost = connection.second > 0.0f ? 1.0 : 0.0;
+                }
+                connections.push_back(
+                    {static_cast<uint32_t>(segment), static_cast<uint32_t>(target), cost});
+            }
+        }
+    }
+    return connections;
+}
+
+SegmentRouteIndex SegmentRouteIndex::fromMap(ShapeGraph &map, CostType costType) {
+    std::vector<int> refs;
+    for (auto &shape : map.getAllShapes()) {
+        refs.push_back(shape.first);
+    }
+    return SegmentRouteIndex(std::move(refs), getConnections(map, costType));
+}
+
+uint32_t SegmentRouteIndex::findSegment(int ref) const {
+    // the shapes of a map are in the order of their refs
+    auto it = std::lower_bound(m_refs.begin(), m_refs.end(), ref);
+    if (it != m_refs.end() && *it == ref) {
+        return static_cast<uint32_t>(it - m_refs.begin());
+    }
+    it = std::find(m_refs.begin(), m_refs.end(), ref);
+    return it == m_refs.end() ? NO_SEGMENT : static_cast<uint32_t>(it - m_refs.begin());
+}
+
+size_t SegmentRouteIndex::getShortcutCount() const {
+    return static_cast<size_t>(std::count_if(m_arcs.begin(), m_arcs.end(), [](const Arc &arc) {
+        return arc.middle != NO_SEGMENT;
+    }));
+}
+
+void SegmentRouteIndex::unpack(uint32_t arcIdx, uint32_t from, Route &route) const {
+    const Arc &arc = m_arcs[arcIdx];
+    if (arc.middle == NO_SEGMENT) {
+        route.segments.push_back(otherEnd(arc.from, arc.to, from));
+        route.costs.push_back(route.costs.back() + arc.cost);
+    } else if (from == arc.from) {
+        unpack(arc.fromArc, from, route);
+        unpack(arc.toArc, arc.middle, route);
+    } else {
+        unpack(arc.toArc, from, route);
+        unpack(arc.fromArc, arc.middle, route);
+    }
+}
+
+SegmentRouteIndex::Query::Query(const SegmentRouteIndex &index) : m_index(index) {
+    for (int side = 0; side < 2; side++) {
+        m_cost[side].assign(index.segmentCount(), UNREACHED);
+        m_parentArc[side].assign(index.segmentCount(), NO_ARC);
+    }
+}
+
+SegmentRouteIndex::Route SegmentRouteIndex::Query::findRoute(uint32_t from, uint32_t to) {
+    Route route;
+    if (from >= m_index.segmentCount() || to >= m_index.segmentCount()) {
+        throw genlib::RuntimeException("Segment outside the map");
+    }
+    if (from == to) {
+        route.segments.push_back(from);
+        route.costs.push_back(0.0);
+        return route;
+    }
+
+    // both searches only go up the hierarchy, and meet at the segment
+    // taken out last on the route
+    MinQueue queues[2];
+    uint32_t starts[2] = {from, to};
+    for (int side = 0; side < 2; side++) {
+        m_cost[side][starts[side]] = 0.0;
+        queues[side].emplace(0.0, starts[side]);
+    }
+    m_touched.push_back(from);
+    m_touched.push_back(to);
+    double best = UNREACHED;
+    uint32_t meeting = NO_SEGMENT;
+    while (!queues[0].empty() || !queues[1].empty()) {
+        int side = queues[1].empty() ||
+                           (!queues[0].empty() && queues[0].top().first <= queues[1].top().first)
+                       ? 0
+                       : 1;
+        auto [cost, segment] = queues[side].top();
+        queues[side].pop();
+        if (cost >= best) {
+            // nothing further on this side can make the route shorter
+            queues[side] = MinQueue();
+            continue;
+        }
+        if (cost > m_cost[side][segment]) {
+            continue;
+        }
+        if (m_cost[1 - side][segment] != UNREACHED &&
+            cost + m_cost[1 - side][segment] < best) {
+            best = cost + m_cost[1 - side][segment];
+            meeting = segment;
+        }
+        for (size_t up = m_index.m_upOffsets[segment]; up < m_index.m_upOffsets[segment + 1];
+             up++) {
+            uint32_t arcIdx = m_index.m_upArcs[up];
+            const Arc &arc = m_index.m_arcs[arcIdx];
+            uint32_t next = otherEnd(arc.from, arc.to, segment);
+            if (cost + arc.cost < m_cost[side][next]) {
+                if (m_cost[0][next] == UNREACHED && m_cost[1][next] == UNREACHED) {
+                    m_touched.push_back(next);
+                }
+                m_cost[side][next] = cost + arc.cost;
+                m_parentArc[side][next] = arcIdx;
+                queues[side].emplace(m_cost[side][next], next);
+            }
+        }
+    }
+
+    if (meeting != NO_SEGMENT) {
+        // the arcs from the start up to the meeting, then down to the end
+        std::vector<std::pair<uint32_t, uint32_t>> arcs;
+        for (uint32_t segment = meeting; segment != from;) {
+            const Arc &arc = m_index.m_arcs[m_parentArc[0][segment]];
+            uint32_t previous = otherEnd(arc.from, arc.to, segment);
+            arcs.emplace_back(m_parentArc[0][segment], previous);
+            segment = previous;
+        }
+        std::reverse(arcs.begin(), arcs.end());
+        for (uint32_t segment = meeting; segment != to;) {
+            const Arc &arc = m_index.m_arcs[m_parentArc[1][segment]];
+            arcs.emplace_back(m_parentArc[1][segment], segment);
+            segment = otherEnd(arc.from, arc.to, segment);
+        }
+        route.segments.push_back(from);
+        route.costs.push_back(0.0);
+        for (auto [arcIdx, arcFrom] : arcs) {
+            m_index.unpack(arcIdx, arcFrom, route);
+        }
+    }
+
+    for (uint32_t segment : m_touched) {
+        for (int side = 0; side < 2; side++) {
+            m_cost[side][segment] = UNREACHED;
+            m_parentArc[side][segment] = NO_ARC;
+        }
+    }
+    m_touched.clear();
+    return route;
+}
+
+std::shared_ptr<const SegmentRouteIndex> SegmentRouteIndexCache::get(ShapeGraph &map,
+                                                                    CostType costType) {
+    uint64_t changeCount;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_indices.find({&map, costType});
+        if (it != m_indices.end()) {
+            return it->second;
+        }
+        changeCount = m_changeCount;
+    }
+    // made outside the lock, so that clearing does not wait for it. Only kept
+    // if the map has not been edited in the meantime
+    auto index =
+        std::make_shared<const SegmentRouteIndex>(SegmentRouteIndex::fromMap(map, costType));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (changeCount == m_changeCount) {
+        m_indices[{&map, costType}] = index;
+    }
+    return index;
+}
+
+void SegmentRouteIndexCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_indices.clear();
+    m_changeCount++;
+}
@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class ShapeGraph;
+
+/**
+ * @brief Contraction hierarchy of the segments of a segment map, to answer
+ * many shortest path queries on the same map
+ *
+ * The segments are taken out of the graph one at a time, least important
+ * first, and where a path between two of their neighbours went through
+ * them and there is no other as short, a shortcut is added between the
+ * neighbours. A query then searches from both ends only towards segments
+ * taken out later, which on street networks reaches a few hundred segments
+ * where a plain search reaches all of them. Shortcuts keep the segment they
+ * went through, so routes are unpacked back to the segments.
+ *
+ * Segments are numbered in the order of the shapes of the map, as are their
+ * connections, which go both ways.
+ */
+class SegmentRouteIndex {
+  public:
+    enum class CostType {
+        // the length of the segments, half of each of the two at either end
+        METRIC,
+        // one for every change of direction, none along a straight line
+        TOPOLOGICAL,
+        // the angle of every change of direction, a right angle counting as 1
+        ANGULAR
+    };
+
+    static constexpr uint32_t NO_SEGMENT = std::numeric_limits<uint32_t>::max();
+
+    struct Connection {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    struct Route {
+        // from the first segment to the last, empty if they are not connected
+        std::vector<uint32_t> segments;
+        // the cost up to each of the segments
+        std::vector<double> costs;
+    };
+
+  private:
+    struct Arc {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+        // the segment a shortcut goes through and the arcs either side of
+        // it, NO_ARC for connections of the map
+        uint32_t middle;
+        uint32_t fromArc;
+        uint32_t toArc;
+    };
+    static constexpr uint32_t NO_ARC = std::numeric_limits<uint32_t>::max();
+
+    std::vector<int> m_refs;
+    std::vector<Arc> m_arcs;
+    // the arcs of each segment to those taken out after it
+    std::vector<size_t> m_upOffsets;
+    std::vector<uint32_t> m_upArcs;
+
+    void contract(const std::vector<Connection> &connections);
+    void unpack(uint32_t arc, uint32_t from, Route &route) const;
+
+  public:
+    // refs are those of the segments in the attribute table
+    SegmentRouteIndex(std::vector<int> refs, const std::vector<Connection> &connections);
+
+    static std::vector<Connection> getConnections(ShapeGraph &map, CostType costType);
+    static SegmentRouteIndex fromMap(ShapeGraph &map, CostType costType);
+
+    size_t segmentCount() const { return m_refs.size(); }
+    int getRef(uint32_t segment) const { return m_refs[segment]; }
+    // NO_SEGMENT if no segment has the ref
+    uint32_t findSegment(int ref) const;
+    size_t getShortcutCount() const;
+
+    /**
+     * @brief Holds what a search needs between queries, so that they do not
+     * allocate. One for each thread
+     */
+    class Query {
+        const SegmentRouteIndex &m_index;
+        std::vector<double> m_cost[2];
+        std::vector<uint32_t> m_parentArc[2];
+        std::vector<uint32_t> m_touched;
+
+      public:
+        explicit Query(const SegmentRouteIndex &index);
+        Route findRoute(uint32_t from, uint32_t to);
+    };
+};
+
+/**
+ * @brief The route indices of the segment maps of a document
+ *
+ * An index is made on the first query of a map and cost, and kept for the
+ * queries after it. The document clears them all when segments or their
+ * connections are edited or maps are taken out, and they go with it when it
+ * is closed.
+ */
+class SegmentRouteIndexCache {
+    using CostType = SegmentRouteIndex::CostType;
+
+    std::mutex m_mutex;
+    std::map<std::pair<const ShapeGraph *, CostType>, std::shared_ptr<const SegmentRouteIndex>>
+        m_indices;
+    // counts the clears, for the indices that were being made across one
+    uint64_t m_changeCount = 0;
+
+  public:
+    std::shared_ptr<const SegmentRouteIndex> get(ShapeGraph &map, CostType costType);
+    // drops every index, for when the maps have changed
+    void clear();
+};
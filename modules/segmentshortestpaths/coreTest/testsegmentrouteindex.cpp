@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/segmentshortestpaths/core/segmentpathtree.hpp"
+#include "modules/segmentshortestpaths/core/segmentrouteindex.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <cmath>
+#include <functional>
+#include <map>
+#include <queue>
+#include <random>
+
+namespace {
+    using Connection = SegmentRouteIndex::Connection;
+
+    // a street grid with some streets missing, and a few segments off on
+    // their own. Streets along a row or column carry on straight
+    std::vector<Connection> makeStreets(int side, bool topological, unsigned int seed) {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> length(5.0, 50.0);
+        std::bernoulli_distribution missing(0.15);
+        auto segmentAt = [side](int x, int y) { return static_cast<uint32_t>(x * side + y); };
+        std::vector<Connection> connections;
+        for (int x = 0; x < side; x++) {
+            for (int y = 0; y < side; y++) {
+                for (auto [nextX, nextY] : {std::pair{x + 1, y}, {x, y + 1}}) {
+                    if (nextX >= side || nextY >= side || missing(generator)) {
+                        continue;
+                    }
+                    // every third segment turns into its neighbour
+                    double cost = topological ? ((x + y) % 3 == 0 ? 1.0 : 0.0) : length(generator);
+                    connections.push_back({segmentAt(x, y), segmentAt(nextX, nextY), cost});
+                }
+            }
+        }
+        return connections;
+    }
+
+    std::vector<int> makeRefs(size_t count) {
+        std::vector<int> refs;
+        for (size_t segment = 0; segment < count; segment++) {
+            refs.push_back(static_cast<int>(segment * 2 + 1));
+        }
+        return refs;
+    }
+
+    std::vector<double> searchAll(size_t segmentCount, const std::vector<Connection> &connections,
+                                  uint32_t from) {
+        std::vector<std::vector<std::pair<uint32_t, double>>> adjacency(segmentCount);
+        for (auto &connection : connections) {
+            adjacency[connection.from].emplace_back(connection.to, connection.cost);
+            adjacency[connection.to].emplace_back(connection.from, connection.cost);
+        }
+        std::vector<double> cost(segmentCount, std::numeric_limits<double>::infinity());
+        std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>,
+                            std::greater<std::pair<double, uint32_t>>>
+            queue;
+        cost[from] = 0.0;
+        queue.emplace(0.0, from);
+        while (!queue.empty()) {
+            auto [segmentCost, segment] = queue.top();
+            queue.pop();
+            if (segmentCost > cost[segment]) {
+                continue;
+            }
+            for (auto [next, step] : adjacency[segment]) {
+                if (segmentCost + step < cost[next]) {
+                    cost[next] = segmentCost + step;
+                    queue.emplace(cost[next], next);
+                }
+            }
+        }
+        return cost;
+    }
+} // namespace
+
+TEST_CASE("Indexed routes are as short as searching the whole map", "") {
+    int side = 30;
+    size_t segmentCount = static_cast<size_t>(side * side) + 5;
+    for (bool topological : {false, true}) {
+        auto connections = makeStreets(side, topological, topological ? 2 : 1);
+        SegmentRouteIndex index(makeRefs(segmentCount), connections);
+        REQUIRE(index.segmentCount() == segmentCount);
+
+        std::map<std::pair<uint32_t, uint32_t>, double> costOf;
+        for (auto &connection : connections) {
+            costOf[std::minmax(connection.from, connection.to)] = connection.cost;
+        }
+        SegmentRouteIndex::Query query(index);
+        std::mt19937 generator(6);
+        std::uniform_int_distribution<uint32_t> anySegment(
+            0, static_cast<uint32_t>(segmentCount - 1));
+        for (int pair = 0; pair < 100; pair++) {
+            uint32_t from = anySegment(generator), to = anySegment(generator);
+            double expected = searchAll(segmentCount, connections, from)[to];
+            auto route = query.findRoute(from, to);
+            if (!std::isfinite(expected)) {
+                REQUIRE(route.segments.empty());
+                continue;
+            }
+            REQUIRE(route.segments.front() == from);
+            REQUIRE(route.segments.back() == to);
+            REQUIRE(route.costs.back() == Catch::Approx(expected).margin(1e-9));
+            // unpacked into the connections of the map
+            for (size_t step = 1; step < route.segments.size(); step++) {
+                auto it = costOf.find(std::minmax(route.segments[step - 1], route.segments[step]));
+                REQUIRE(it != costOf.end());
+                REQUIRE(route.costs[step] - route.costs[step - 1] == Catch::Approx(it->second));
+            }
+        }
+    }
+}
+
+TEST_CASE("Route index refs", "") {
+    auto connections = makeStreets(10, false, 3);
+    auto refs = makeRefs(100);
+    SegmentRouteIndex index(refs, connections);
+    REQUIRE(index.findSegment(21) == 10);
+    REQUIRE(index.findSegment(20) == SegmentRouteIndex::NO_SEGMENT);
+    REQUIRE(index.getRef(10) == 21);
+}
+
+TEST_CASE("Path trees answer from one segment as they grow", "") {
+    int side = 30;
+    size_t segmentCount = static_cast<size_t>(side * side) + 5;
+    auto connections = makeStreets(side, false, 4);
+    uint32_t from = 17;
+    auto expected = searchAll(segmentCount, connections, from);
+    SegmentPathTree tree(makeRefs(segmentCount), connections, from);
+    REQUIRE(tree.findSegment(35) == from);
+
+    // with no time at all the search still moves on every time
+    auto far = static_cast<uint32_t>(segmentCount - 6);
+    size_t settled = 0;
+    std::optional<SegmentPathTree::Route> route;
+    while (!(route = tree.findRoute(far, std::chrono::microseconds(0)))) {
+        REQUIRE(tree.getSettledCount() > settled);
+        settled = tree.getSettledCount();
+    }
+
+    for (uint32_t to = 0; to < segmentCount; to++) {
+        route = tree.findRoute(to, std::chrono::seconds(10));
+        REQUIRE(route);
+        if (!std::isfinite(expected[to])) {
+            REQUIRE(route->segments.empty());
+            continue;
+        }
+        REQUIRE(route->segments.front() == from);
+        REQUIRE(route->segments.back() == to);
+        REQUIRE(route->costs.back() == Catch::Approx(expected[to]).margin(1e-9));
+    }
+    REQUIRE(tree.isComplete());
+}
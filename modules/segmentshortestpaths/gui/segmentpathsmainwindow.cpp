@@ -4,12 +4,15 @@
 
 #include "segmentpathsmainwindow.hpp"
 
+#include "modules/segmentshortestpaths/core/segmentindexedshortestpath.hpp"
+
 #include "salalib/segmmodules/segmmetricshortestpath.hpp"
 #include "salalib/segmmodules/segmtopologicalshortestpath.hpp"
 #include "salalib/segmmodules/segmtulipshortestpath.hpp"
 
 #include "qtgui/graphdoc.hpp"
 #include "qtgui/mainwindowhelpers.hpp"
+#include "qtgui/views/mapview.hpp"
 
 #include <QMenuBar>
 #include <QMessageBox>
@@ -37,6 +40,61 @@ bool SegmentPathsMainWindow::createMenus(MainWindow *mainWindow) {
             [this, mainWindow] { OnShortestPath(mainWindow, PathType::TOPOLOGICAL); });
     shortestPathsMenu->addAction(topoPathAct);
 
+    shortestPathsMenu->addSeparator();
+
+    QAction *indexingAct = new QAction(tr("Index routes"), mainWindow);
+    indexingAct->setStatusTip(
+        tr("Prepare the segment map for fast metric and topological shortest paths"));
+    connect(indexingAct, &QAction::triggered, this,
+            [this, mainWindow] { OnRouteIndexing(mainWindow); });
+    shortestPathsMenu->addAction(indexingAct);
+
+    QAction *indexedMetricPathAct = new QAction(tr("Metric shortest path (indexed)"), mainWindow);
+    indexedMetricPathAct->setStatusTip(
+        tr("Create a metric shortest path through the route index"));
+    connect(indexedMetricPathAct, &QAction::triggered, this,
+            [this, mainWindow] { OnShortestPath(mainWindow, PathType::INDEXED_METRIC); });
+    shortestPathsMenu->addAction(indexedMetricPathAct);
+
+    QAction *indexedTopoPathAct =
+        new QAction(tr("Topological shortest path (indexed)"), mainWindow);
+    indexedTopoPathAct->setStatusTip(
+        tr("Create a topological shortest path through the route index"));
+    connect(indexedTopoPathAct, &QAction::triggered, this,
+            [this, mainWindow] { OnShortestPath(mainWindow, PathType::INDEXED_TOPOLOGICAL); });
+    shortestPathsMenu->addAction(indexedTopoPathAct);
+
+    QAction *indexedAngularPathAct =
+        new QAction(tr("Angular shortest path (indexed)"), mainWindow);
+    indexedAngularPathAct->setStatusTip(
+        tr("Create an angular shortest path through the route index"));
+    connect(indexedAngularPathAct, &QAction::triggered, this,
+            [this, mainWindow] { OnShortestPath(mainWindow, PathType::INDEXED_ANGULAR); });
+    shortestPathsMenu->addAction(indexedAngularPathAct);
+
+    shortestPathsMenu->addSeparator();
+
+    QAction *angularPreviewAct = new QAction(tr("Angular path preview"), mainWindow);
+    angularPreviewAct->setStatusTip(
+        tr("Click a segment and follow the mouse with the angular shortest path from it"));
+    connect(angularPreviewAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPathPreview(mainWindow, PathType::ANGULAR); });
+    shortestPathsMenu->addAction(angularPreviewAct);
+
+    QAction *metricPreviewAct = new QAction(tr("Metric path preview"), mainWindow);
+    metricPreviewAct->setStatusTip(
+        tr("Click a segment and follow the mouse with the metric shortest path from it"));
+    connect(metricPreviewAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPathPreview(mainWindow, PathType::METRIC); });
+    shortestPathsMenu->addAction(metricPreviewAct);
+
+    QAction *topoPreviewAct = new QAction(tr("Topological path preview"), mainWindow);
+    topoPreviewAct->setStatusTip(
+        tr("Click a segment and follow the mouse with the topological shortest path from it"));
+    connect(topoPreviewAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPathPreview(mainWindow, PathType::TOPOLOGICAL); });
+    shortestPathsMenu->addAction(topoPreviewAct);
+
     return true;
 }
 
@@ -45,12 +103,6 @@ void SegmentPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pat
     if (graphDoc == nullptr)
         return;
 
-    if (graphDoc->m_communicator) {
-        QMessageBox::warning(mainWindow, tr("Warning"),
-                             tr("Please wait, another process is running"), QMessageBox::Ok,
-                             QMessageBox::Ok);
-        return;
-    }
     if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::SEGMENTMAP) {
         QMessageBox::warning(mainWindow, tr("Warning"),
                              tr("Please make sure the displayed map is a segment map"),
@@ -67,37 +119,97 @@ void SegmentPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pat
     int refFrom = *graphDoc->m_meta_graph->getDisplayedShapeGraph().getSelSet().begin();
     int refTo = *graphDoc->m_meta_graph->getDisplayedShapeGraph().getSelSet().rbegin();
 
-    graphDoc->m_communicator = new CMSCommunicator();
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
     auto &map = graphDoc->m_meta_graph->getDisplayedShapeGraph();
     switch (pathType) {
     case PathType::ANGULAR:
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+        comm->setAnalysis(std::unique_ptr<IAnalysis>(
             new SegmentTulipShortestPath(map.getInternalMap(), 1024, refFrom, refTo)));
         map.overrideDisplayedAttribute(-2); // <- override if it's already showing
         map.setDisplayedAttribute(SegmentTulipShortestPath::Column::ANGULAR_SHORTEST_PATH_ANGLE);
         break;
     case PathType::METRIC: {
         auto &selected = map.getSelSet();
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+        comm->setAnalysis(std::unique_ptr<IAnalysis>(
             new SegmentMetricShortestPath(map.getInternalMap(), refFrom, refTo)));
         map.overrideDisplayedAttribute(-2);
         map.setDisplayedAttribute(SegmentMetricShortestPath::Column::METRIC_SHORTEST_PATH_DISTANCE);
         break;
     }
     case PathType::TOPOLOGICAL: {
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+        comm->setAnalysis(std::unique_ptr<IAnalysis>(
             new SegmentTopologicalShortestPath(map.getInternalMap(), refFrom, refTo)));
         map.overrideDisplayedAttribute(-2); // <- override if it's already showing
         map.setDisplayedAttribute(
             SegmentTopologicalShortestPath::Column::TOPOLOGICAL_SHORTEST_PATH_DEPTH);
         break;
     }
+    case PathType::INDEXED_METRIC:
+    case PathType::INDEXED_TOPOLOGICAL:
+    case PathType::INDEXED_ANGULAR: {
+        auto costType = SegmentIndexedShortestPath::CostType::ANGULAR;
+        if (pathType == PathType::INDEXED_METRIC) {
+            costType = SegmentIndexedShortestPath::CostType::METRIC;
+        } else if (pathType == PathType::INDEXED_TOPOLOGICAL) {
+            costType = SegmentIndexedShortestPath::CostType::TOPOLOGICAL;
+        }
+        comm->setAnalysis(std::unique_ptr<IAnalysis>(
+            new SegmentIndexedShortestPath(map.getInternalMap(), graphDoc->m_routeIndices,
+                                           costType, refFrom, refTo)));
+        map.overrideDisplayedAttribute(-2); // <- override if it's already showing
+        map.setDisplayedAttribute(SegmentIndexedShortestPath::getColumn(costType));
+        break;
+    }
+    }
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS, QGraphDoc::NEW_DATA);
+
+    graphDoc->submitJob(comm.release(), tr("Calculating shortest path..."),
+                        graphDoc->getDisplayedLayer());
+}
+
+void SegmentPathsMainWindow::OnRouteIndexing(MainWindow *mainWindow) {
+    QGraphDoc *graphDoc = mainWindow->activeMapDoc();
+    if (graphDoc == nullptr)
+        return;
+
+    if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::SEGMENTMAP) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please make sure the displayed map is a segment map"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
     }
-    graphDoc->m_communicator->SetFunction(CMSCommunicator::FROMCONNECTOR);
-    graphDoc->m_communicator->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
-    graphDoc->m_communicator->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS,
-                                                    QGraphDoc::NEW_DATA);
 
-    graphDoc->CreateWaitDialog(tr("Calculating shortest path..."));
-    graphDoc->m_thread.render(graphDoc);
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    auto &map = graphDoc->m_meta_graph->getDisplayedShapeGraph();
+    comm->setAnalysis(std::unique_ptr<IAnalysis>(
+        new SegmentRouteIndexing(map.getInternalMap(), graphDoc->m_routeIndices)));
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+
+    graphDoc->submitJob(comm.release(), tr("Indexing routes..."), graphDoc->getDisplayedLayer());
+}
+
+void SegmentPathsMainWindow::OnPathPreview(MainWindow *mainWindow, PathType pathType) {
+    MapView *mapView = mainWindow->activeMapView();
+    if (mapView == nullptr)
+        return;
+
+    if (mapView->getGraphDoc()->m_meta_graph->getDisplayedMapType() != ShapeMap::SEGMENTMAP) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please make sure the displayed map is a segment map"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+    MapView::PathPreviewType previewType = MapView::PathPreviewType::ANGULAR;
+    if (pathType == PathType::METRIC) {
+        previewType = MapView::PathPreviewType::METRIC;
+    } else if (pathType == PathType::TOPOLOGICAL) {
+        previewType = MapView::PathPreviewType::TOPOLOGICAL;
+    }
+    if (!mapView->OnModePathPreview(previewType)) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Path previews are only shown in the GL map view"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+    }
 }
@@ -9,10 +9,19 @@
 class SegmentPathsMainWindow : public IMainWindowModule {
 
   private:
-    enum PathType { ANGULAR, METRIC, TOPOLOGICAL };
+    enum PathType {
+        ANGULAR,
+        METRIC,
+        TOPOLOGICAL,
+        INDEXED_METRIC,
+        INDEXED_TOPOLOGICAL,
+        INDEXED_ANGULAR
+    };
 
   private slots:
     void OnShortestPath(MainWindow *mainWindow, PathType pathType);
+    void OnRouteIndexing(MainWindow *mainWindow);
+    void OnPathPreview(MainWindow *mainWindow, PathType pathType);
 
   public:
     SegmentPathsMainWindow() : IMainWindowModule() {}
@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgaangularglobalbucketed.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/genlib/exceptions.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr uint32_t UNREACHED = std::numeric_limits<uint32_t>::max();
+
+    // a search by turns, with the depths filed into buckets
+    struct Search {
+        // depths in bins
+        std::vector<uint32_t> depth;
+        // the direction of the step the node was reached with
+        std::vector<uint16_t> incoming;
+        // nodes taken in with the node they are merged with
+        std::vector<uint8_t> merged;
+        std::vector<uint32_t> touched;
+        // one bucket per depth, reused in a circle as a turn costs at most
+        // half the bins
+        std::vector<std::vector<uint32_t>> buckets;
+    };
+} // namespace
+
+VGAAngularGlobalBucketed::Result VGAAngularGlobalBucketed::analyseGraph(const VGACSRGraph &graph,
+                                                                        double radius, int bins,
+                                                                        Communicator *comm) {
+    if (bins < MIN_BINS || bins > MAX_BINS) {
+        throw genlib::RuntimeException("Angular bins must be from " + std::to_string(MIN_BINS) +
+                                       " to " + std::to_string(MAX_BINS));
+    }
+    size_t nodeCount = graph.nodeCount();
+    Result result;
+    result.meanDepth.assign(nodeCount, -1.0f);
+    result.totalDepth.assign(nodeCount, -1.0f);
+    result.nodeCount.assign(nodeCount, -1.0f);
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("binning directions");
+    }
+    // the direction of every connection, in the order they are traversed
+    std::vector<size_t> firstEdge(nodeCount + 1, 0);
+    for (size_t node = 0; node < nodeCount; node++) {
+        firstEdge[node + 1] = firstEdge[node] + graph.neighbours(node).size();
+    }
+    std::vector<uint16_t> directions(firstEdge[nodeCount]);
+    double binsPerRadian = bins / (2.0 * M_PI);
+    parallelFor(nodeCount, 256, [&](size_t node, int) {
+        size_t edge = firstEdge[node];
+        for (uint32_t connected : graph.neighbours(node)) {
+            long bin = std::lround(std::atan2(graph.getY(connected) - graph.getY(node),
+                                              graph.getX(connected) - graph.getX(node)) *
+                                   binsPerRadian);
+            directions[edge++] = static_cast<uint16_t>(((bin % bins) + bins) % bins);
+        }
+    });
+
+    // right angles are a quarter of the bins
+    double depthPerBin = 4.0 / bins;
+    uint32_t maxTurn = static_cast<uint32_t>(bins / 2);
+    uint32_t radiusBins = UNREACHED - 1;
+    if (radius != -1) {
+        radiusBins = static_cast<uint32_t>(std::floor(radius / depthPerBin + 1e-9));
+    }
+
+    std::vector<Search> searches(static_cast<size_t>(getMaxThreads()));
+    for (auto &search : searches) {
+        search.depth.resize(nodeCount, UNREACHED);
+        search.incoming.resize(nodeCount, 0);
+        search.merged.resize(nodeCount, 0);
+        search.buckets.resize(maxTurn + 1);
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("traversing");
+    }
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, nodeCount);
+    }
+    std::atomic<size_t> sourcesDone(0);
+    std::atomic<bool> cancelled(false);
+
+    parallelFor(nodeCount, 16, [&](size_t sourceIdx, int thread) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Search &search = searches[static_cast<size_t>(thread)];
+        uint32_t source = static_cast<uint32_t>(sourceIdx);
+        search.depth[source] = 0;
+        search.touched.push_back(source);
+        search.buckets[0].push_back(source);
+
+        uint64_t totalBins = 0;
+        size_t totalNodes = 0;
+        size_t queued = 1;
+        for (uint32_t depth = 0; queued > 0; depth++) {
+            // steps without a turn land in the bucket being emptied
+            auto &bucket = search.buckets[depth % (maxTurn + 1)];
+            while (!bucket.empty()) {
+                uint32_t node = bucket.back();
+                bucket.pop_back();
+                queued--;
+                if (search.depth[node] != depth || search.merged[node]) {
+                    continue;
+                }
+                if (node != source) {
+                    totalBins += depth;
+                    totalNodes++;
+                }
+                // the node it is merged with is the same place, the search goes
+                // on from there at the same depth without counting it again
+                uint32_t merge = graph.getMerge(node);
+                if (merge != VGACSRGraph::NO_MERGE && !search.merged[merge]) {
+                    if (search.depth[merge] == UNREACHED) {
+                        search.touched.push_back(merge);
+                    }
+                    search.depth[merge] = depth;
+                    search.merged[node] = 1;
+                    search.merged[merge] = 1;
+                } else {
+                    merge = VGACSRGraph::NO_MERGE;
+                }
+                for (uint32_t from : {node, merge}) {
+                    if (from == VGACSRGraph::NO_MERGE) {
+                        continue;
+                    }
+                    size_t edge = firstEdge[from];
+                    for (uint32_t connected : graph.neighbours(from)) {
+                        uint16_t direction = directions[edge++];
+                        uint32_t turn = 0;
+                        // the first step from the source, or from the other
+                        // of a merged pair, is not a turn
+                        if (from != source && from != merge) {
+                            uint32_t difference = static_cast<uint32_t>(
+                                std::abs(direction - search.incoming[from]));
+                            turn = std::min(difference, static_cast<uint32_t>(bins) - difference);
+                        }
+                        uint32_t newDepth = depth + turn;
+                        if (newDepth > radiusBins || newDepth >= search.depth[connected]) {
+                            continue;
+                        }
+                        if (search.depth[connected] == UNREACHED) {
+                            search.touched.push_back(connected);
+                        }
+                        search.depth[connected] = newDepth;
+                        search.incoming[connected] = direction;
+                        search.buckets[newDepth % (maxTurn + 1)].push_back(connected);
+                        queued++;
+                    }
+                }
+            }
+        }
+        for (uint32_t node : search.touched) {
+            search.depth[node] = UNREACHED;
+            search.merged[node] = 0;
+        }
+        search.touched.clear();
+
+        if (totalNodes > 0) {
+            double totalDepth = double(totalBins) * depthPerBin;
+            result.totalDepth[source] = static_cast<float>(totalDepth);
+            result.meanDepth[source] = static_cast<float>(totalDepth / double(totalNodes));
+        }
+        result.nodeCount[source] = static_cast<float>(totalNodes);
+
+        if (telemetry) {
+            telemetry->addRecords(static_cast<size_t>(thread));
+        }
+        size_t done = sourcesDone.fetch_add(1) + 1;
+        if (comm && thread == 0) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+            if (comm->IsCancelled()) {
+                cancelled = true;
+            }
+        }
+    });
+
+    if (cancelled) {
+        throw Communicator::CancelledException();
+    }
+    return result;
+}
+
+AnalysisResult VGAAngularGlobalBucketed::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(m_map, m_graphStorage);
+
+    auto angular = analyseGraph(graph, m_radius, m_bins, comm);
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    double mapWidth = graph.getMapWidth();
+    graph.copyColumnToMap(
+        m_map, getColumnWithBinsAndRadius(Column::ANGULAR_MEAN_DEPTH, m_bins, m_radius, mapWidth),
+        angular.meanDepth);
+    graph.copyColumnToMap(
+        m_map, getColumnWithBinsAndRadius(Column::ANGULAR_TOTAL_DEPTH, m_bins, m_radius, mapWidth),
+        angular.totalDepth);
+    graph.copyColumnToMap(
+        m_map, getColumnWithBinsAndRadius(Column::ANGULAR_NODE_COUNT, m_bins, m_radius, mapWidth),
+        angular.nodeCount);
+
+    AnalysisResult result;
+    result.completed = true;
+    return result;
+}
@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacsrgraph.hpp"
+
+#include "modules/parallelcommon/core/columnwithradius.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+#include <vector>
+
+class PointMap;
+
+/**
+ * @brief Global angular analysis over turns quantised into bins
+ *
+ * As with the tulip bins of segment analysis, the direction of every
+ * connection is rounded to one of a number of bins around the circle, so
+ * that each turn costs a whole number of bins. A search then keeps the
+ * points it reaches in one bucket per depth, and takes them out in order
+ * of depth without a priority queue. The depths are those of the angular
+ * analysis to within half a bin per turn.
+ */
+class VGAAngularGlobalBucketed : public IAnalysis {
+  public:
+    static constexpr int DEFAULT_BINS = 1024;
+    static constexpr int MIN_BINS = 8;
+    static constexpr int MAX_BINS = 65536;
+
+  private:
+    PointMap &m_map;
+    double m_radius;
+    int m_bins;
+    VGACSRGraph::Storage m_graphStorage = VGACSRGraph::Storage::PLAIN;
+
+  public:
+    struct Column {
+        inline static const std::string                  //
+            ANGULAR_MEAN_DEPTH = "Angular Mean Depth",   //
+            ANGULAR_TOTAL_DEPTH = "Angular Total Depth", //
+            ANGULAR_NODE_COUNT = "Angular Node Count";   //
+    };
+    static std::string getColumnWithBinsAndRadius(const std::string &column, int bins,
+                                                  double radius, double mapWidth) {
+        return getColumnWithRadius(column + " [T" + std::to_string(bins) + "]", radius, mapWidth);
+    }
+
+    struct Result {
+        std::vector<float> meanDepth;
+        std::vector<float> totalDepth;
+        std::vector<float> nodeCount;
+    };
+
+  public:
+    // a radius of -1 is the whole graph, otherwise it is in right angles.
+    // The bins are around the whole circle, from MIN_BINS to MAX_BINS
+    VGAAngularGlobalBucketed(PointMap &map, double radius, int bins = DEFAULT_BINS)
+        : m_map(map), m_radius(radius), m_bins(bins) {}
+    std::string getAnalysisName() const override {
+        return "Global Angular Analysis (Bucketed)";
+    }
+    void setGraphStorage(VGACSRGraph::Storage graphStorage) { m_graphStorage = graphStorage; }
+    AnalysisResult run(Communicator *comm) override;
+
+    static Result analyseGraph(const VGACSRGraph &graph, double radius, int bins,
+                               Communicator *comm);
+};
@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgablockedbitset.hpp"
+
+size_t VGABlockedBitset::append(const std::vector<uint32_t> &sortedIndices,
+                                std::vector<uint32_t> &positions, std::vector<Block> &blocks) {
+    size_t blockCount = 0;
+    for (uint32_t index : sortedIndices) {
+        uint32_t position = static_cast<uint32_t>(index / BLOCK_BITS);
+        if (blockCount == 0 || positions.back() != position) {
+            positions.push_back(position);
+            blocks.emplace_back();
+            blocks.back().words.fill(0);
+            blockCount++;
+        }
+        size_t bit = index % BLOCK_BITS;
+        blocks.back().words[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    return blockCount;
+}
+
+size_t VGABlockedBitset::intersectionCount(const VGABlockedBitset &other) const {
+    size_t count = 0;
+    size_t i = 0, j = 0;
+    while (i < m_blockCount && j < other.m_blockCount) {
+        if (m_positions[i] < other.m_positions[j]) {
+            i++;
+        } else if (m_positions[i] > other.m_positions[j]) {
+            j++;
+        } else {
+            Block common;
+            for (size_t w = 0; w < BLOCK_WORDS; w++) {
+                common.words[w] = m_blocks[i].words[w] & other.m_blocks[j].words[w];
+            }
+            count += bitCount(common);
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
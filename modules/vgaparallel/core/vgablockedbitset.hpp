@@ -0,0 +1,80 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Set of node indices kept as the non-empty blocks of a bitset
+ *
+ * Visible sets are made of runs of neighbouring cells, so the blocks of a
+ * bitset that hold any bits tend to be well filled, and only those are
+ * stored, ordered by position. Intersecting two sets merges their block
+ * lists and counts the bits of the matching blocks with AND and popcount,
+ * in fixed-width loops that the compiler vectorises.
+ *
+ * The set is a view into storage filled with append(), which must not grow
+ * while the view is in use.
+ */
+class VGABlockedBitset {
+  public:
+    static constexpr size_t BLOCK_WORDS = 4;
+    static constexpr size_t BLOCK_BITS = BLOCK_WORDS * 64;
+
+    struct Block {
+        std::array<uint64_t, BLOCK_WORDS> words;
+    };
+
+  private:
+    const uint32_t *m_positions = nullptr;
+    const Block *m_blocks = nullptr;
+    size_t m_blockCount = 0;
+    size_t m_count = 0;
+
+  public:
+    VGABlockedBitset() {}
+    VGABlockedBitset(const uint32_t *positions, const Block *blocks, size_t blockCount,
+                     size_t count)
+        : m_positions(positions), m_blocks(blocks), m_blockCount(blockCount), m_count(count) {}
+
+    // stores the set of the given indices, which must be sorted, and returns
+    // the number of blocks it took
+    static size_t append(const std::vector<uint32_t> &sortedIndices,
+                         std::vector<uint32_t> &positions, std::vector<Block> &blocks);
+
+    static size_t bitCount(const Block &block) {
+        size_t count = 0;
+        for (uint64_t word : block.words) {
+            count += std::bitset<64>(word).count();
+        }
+        return count;
+    }
+
+    size_t count() const { return m_count; }
+    size_t getBlockCount() const { return m_blockCount; }
+    uint32_t getPosition(size_t block) const { return m_positions[block]; }
+    const Block &getBlock(size_t block) const { return m_blocks[block]; }
+
+    size_t intersectionCount(const VGABlockedBitset &other) const;
+
+    // calls func with every index of the set, in increasing order
+    template <typename Func> void forEach(Func func) const {
+        for (size_t block = 0; block < m_blockCount; block++) {
+            size_t base = static_cast<size_t>(m_positions[block]) * BLOCK_BITS;
+            for (size_t w = 0; w < BLOCK_WORDS; w++) {
+                uint64_t bits = m_blocks[block].words[w];
+                for (size_t bit = 0; bits != 0; bit++, bits >>= 1) {
+                    if (bits & 1) {
+                        func(base + w * 64 + bit);
+                    }
+                }
+            }
+        }
+    }
+};
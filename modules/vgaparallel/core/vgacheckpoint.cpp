@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgacheckpoint.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+    const char checkpointMagic[8] = {'D', 'M', 'X', 'C', 'K', 'P', 'T', '1'};
+
+    template <typename T> void writeValue(std::ofstream &stream, const T &value) {
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T> bool readValue(std::ifstream &stream, T &value) {
+        stream.read(reinterpret_cast<char *>(&value), sizeof(T));
+        return stream.good();
+    }
+
+    void writeString(std::ofstream &stream, const std::string &str) {
+        writeValue(stream, static_cast<uint64_t>(str.size()));
+        stream.write(str.data(), static_cast<std::streamsize>(str.size()));
+    }
+
+    bool readString(std::ifstream &stream, std::string &str) {
+        uint64_t size;
+        if (!readValue(stream, size) || size > (1 << 16)) {
+            return false;
+        }
+        str.resize(size);
+        stream.read(str.data(), static_cast<std::streamsize>(size));
+        return stream.good();
+    }
+} // namespace
+
+VGACheckpoint::VGACheckpoint(std::string analysisKey, uint64_t graphSignature, size_t sourceCount)
+    : m_analysisKey(std::move(analysisKey)), m_graphSignature(graphSignature),
+      m_done(sourceCount, 0) {}
+
+bool VGACheckpoint::matches(const std::string &analysisKey, uint64_t graphSignature,
+                            size_t sourceCount) const {
+    return m_analysisKey == analysisKey && m_graphSignature == graphSignature &&
+           m_done.size() == sourceCount;
+}
+
+size_t VGACheckpoint::getDoneCount() const {
+    return static_cast<size_t>(std::count(m_done.begin(), m_done.end(), 1));
+}
+
+std::vector<std::pair<size_t, size_t>> VGACheckpoint::getDoneRanges() const {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    size_t source = 0;
+    while (source < m_done.size()) {
+        if (!m_done[source]) {
+            source++;
+            continue;
+        }
+        size_t first = source;
+        while (source < m_done.size() && m_done[source]) {
+            source++;
+        }
+        ranges.emplace_back(first, source);
+    }
+    return ranges;
+}
+
+std::vector<float> &VGACheckpoint::getColumn(const std::string &name, float defaultValue) {
+    auto it = std::find_if(m_columns.begin(), m_columns.end(),
+                           [&name](const auto &column) { return column.first == name; });
+    if (it != m_columns.end()) {
+        return it->second;
+    }
+    m_columns.emplace_back(name, std::vector<float>(m_done.size(), defaultValue));
+    return m_columns.back().second;
+}
+
+void VGACheckpoint::save(const std::string &filename) const {
+    std::string tempFilename = filename + ".tmp";
+    {
+        std::ofstream stream(tempFilename, std::ios::binary | std::ios::trunc);
+        if (!stream) {
+            throw genlib::RuntimeException("Unable to write checkpoint file " + tempFilename);
+        }
+        stream.write(checkpointMagic, sizeof(checkpointMagic));
+        writeString(stream, m_analysisKey);
+        writeValue(stream, m_graphSignature);
+        writeValue(stream, static_cast<uint64_t>(m_done.size()));
+
+        auto ranges = getDoneRanges();
+        writeValue(stream, static_cast<uint64_t>(ranges.size()));
+        for (auto &range : ranges) {
+            writeValue(stream, static_cast<uint64_t>(range.first));
+            writeValue(stream, static_cast<uint64_t>(range.second));
+        }
+
+        writeValue(stream, static_cast<uint64_t>(m_columns.size()));
+        for (auto &column : m_columns) {
+            writeString(stream, column.first);
+            stream.write(reinterpret_cast<const char *>(column.second.data()),
+                         static_cast<std::streamsize>(column.second.size() * sizeof(float)));
+        }
+        if (!stream) {
+            throw genlib::RuntimeException("Unable to write checkpoint file " + tempFilename);
+        }
+    }
+    std::remove(filename.c_str());
+    if (std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
+        throw genlib::RuntimeException("Unable to replace checkpoint file " + filename);
+    }
+}
+
+std::optional<VGACheckpoint> VGACheckpoint::load(const std::string &filename) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream) {
+        return std::nullopt;
+    }
+    char magic[sizeof(checkpointMagic)];
+    stream.read(magic, sizeof(magic));
+    if (!stream || !std::equal(magic, magic + sizeof(magic), checkpointMagic)) {
+        return std::nullopt;
+    }
+    std::string analysisKey;
+    uint64_t graphSignature, sourceCount, rangeCount;
+    if (!readString(stream, analysisKey) || !readValue(stream, graphSignature) ||
+        !readValue(stream, sourceCount) || !readValue(stream, rangeCount)) {
+        return std::nullopt;
+    }
+    VGACheckpoint checkpoint(analysisKey, graphSignature, sourceCount);
+    for (uint64_t i = 0; i < rangeCount; i++) {
+        uint64_t first, last;
+        if (!readValue(stream, first) || !readValue(stream, last) || first > last ||
+            last > sourceCount) {
+            return std::nullopt;
+        }
+        std::fill(checkpoint.m_done.begin() + static_cast<std::ptrdiff_t>(first),
+                  checkpoint.m_done.begin() + static_cast<std::ptrdiff_t>(last), 1);
+    }
+    uint64_t columnCount;
+    if (!readValue(stream, columnCount)) {
+        return std::nullopt;
+    }
+    for (uint64_t i = 0; i < columnCount; i++) {
+        std::string name;
+        if (!readString(stream, name)) {
+            return std::nullopt;
+        }
+        std::vector<float> &column = checkpoint.getColumn(name);
+        stream.read(reinterpret_cast<char *>(column.data()),
+                    static_cast<std::streamsize>(column.size() * sizeof(float)));
+        if (!stream) {
+            return std::nullopt;
+        }
+    }
+    return checkpoint;
+}
+
+void VGACheckpoint::remove(const std::string &filename) { std::remove(filename.c_str()); }
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Partial result of an analysis that runs once per source node
+ *
+ * Holds which sources have been completed and the per-node columns computed
+ * so far. A checkpoint is only valid for the analysis (and its parameters)
+ * and the graph it was taken from, which are identified by the analysis key
+ * and the graph signature.
+ */
+class VGACheckpoint {
+    std::string m_analysisKey;
+    uint64_t m_graphSignature = 0;
+    // one flag per source. Different threads may mark different sources
+    std::vector<uint8_t> m_done;
+    // a deque so that references to columns stay valid when more are added
+    std::deque<std::pair<std::string, std::vector<float>>> m_columns;
+
+  public:
+    VGACheckpoint(std::string analysisKey, uint64_t graphSignature, size_t sourceCount);
+
+    const std::string &getAnalysisKey() const { return m_analysisKey; }
+    uint64_t getGraphSignature() const { return m_graphSignature; }
+    size_t getSourceCount() const { return m_done.size(); }
+    bool matches(const std::string &analysisKey, uint64_t graphSignature,
+                 size_t sourceCount) const;
+
+    bool isDone(size_t source) const { return m_done[source] != 0; }
+    void markDone(size_t source) { m_done[source] = 1; }
+    size_t getDoneCount() const;
+    // the completed sources as [first, last) ranges
+    std::vector<std::pair<size_t, size_t>> getDoneRanges() const;
+
+    // adds the column with all values set to the default if it does not
+    // exist yet. Not to be called while other threads use the checkpoint
+    std::vector<float> &getColumn(const std::string &name, float defaultValue = -1.0f);
+    const std::deque<std::pair<std::string, std::vector<float>>> &getColumns() const {
+        return m_columns;
+    }
+
+    // written to a temporary file first so that an interrupted save does not
+    // destroy the previous checkpoint
+    void save(const std::string &filename) const;
+    // returns nothing if the file does not exist or is not a checkpoint
+    static std::optional<VGACheckpoint> load(const std::string &filename);
+    static void remove(const std::string &filename);
+};
@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "modules/parallelcommon/core/columnwithradius.hpp"
+
+#include <string>
+
+/**
+ * @brief Columns of the global visibility analyses
+ *
+ * Named as in salalib, so every kernel writes the same columns.
+ */
+struct VGAVisualGlobalColumn {
+    inline static const std::string                                 //
+        VISUAL_ENTROPY = "Visual Entropy",                          //
+        VISUAL_INTEGRATION_HH = "Visual Integration [HH]",          //
+        VISUAL_INTEGRATION_PV = "Visual Integration [P-value]",     //
+        VISUAL_INTEGRATION_TK = "Visual Integration [Tekl]",        //
+        VISUAL_MEAN_DEPTH = "Visual Mean Depth",                    //
+        VISUAL_NODE_COUNT = "Visual Node Count",                    //
+        VISUAL_REL_ENTROPY = "Visual Relativised Entropy";          //
+};
+
+/**
+ * @brief Columns of the global metric analyses
+ *
+ * Named as in salalib, so every kernel writes the same columns.
+ */
+struct VGAMetricGlobalColumn {
+    inline static const std::string                                              //
+        METRIC_MEAN_SHORTEST_PATH_DISTANCE = "Metric Mean Shortest-Path Distance", //
+        METRIC_MEAN_STRAIGHT_LINE_DISTANCE = "Metric Mean Straight-Line Distance", //
+        METRIC_NODE_COUNT = "Metric Node Count";                                 //
+};
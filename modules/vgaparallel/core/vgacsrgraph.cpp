@@ -0,0 +1,324 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgacsrgraph.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/pointmap.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace {
+    const char graphMagic[8] = {'D', 'M', 'X', 'V', 'G', 'A', 'G', '4'};
+
+    template <typename T> void writeValue(std::ofstream &stream, const T &value) {
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T> bool readValue(std::ifstream &stream, T &value) {
+        stream.read(reinterpret_cast<char *>(&value), sizeof(T));
+        return stream.good();
+    }
+
+    void encodeTarget(std::vector<uint8_t> &encoded, uint32_t previous, uint32_t target) {
+        uint32_t difference = target - previous;
+        // zigzag, so that small steps back also take few bytes
+        uint32_t zigzag = (difference << 1) ^ (0u - (difference >> 31));
+        while (zigzag >= 0x80) {
+            encoded.push_back(static_cast<uint8_t>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        encoded.push_back(static_cast<uint8_t>(zigzag));
+    }
+
+    template <typename T> void writeValues(std::ofstream &stream, const std::vector<T> &values) {
+        uint64_t size = values.size();
+        stream.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        stream.write(reinterpret_cast<const char *>(values.data()),
+                     static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+
+    template <typename T> bool readValues(std::ifstream &stream, std::vector<T> &values) {
+        uint64_t size;
+        stream.read(reinterpret_cast<char *>(&size), sizeof(size));
+        if (!stream.good() || size > (uint64_t(1) << 40) / sizeof(T)) {
+            return false;
+        }
+        values.resize(size);
+        stream.read(reinterpret_cast<char *>(values.data()),
+                    static_cast<std::streamsize>(size * sizeof(T)));
+        return stream.good();
+    }
+} // namespace
+
+VGACSRGraph VGACSRGraph::fromAdjacency(std::vector<int> refs,
+                                       const std::vector<std::vector<uint32_t>> &adjacency) {
+    VGACSRGraph graph;
+    graph.m_refs = std::move(refs);
+    graph.m_offsets.reserve(adjacency.size() + 1);
+    for (auto &connections : adjacency) {
+        graph.m_targets.insert(graph.m_targets.end(), connections.begin(), connections.end());
+        graph.m_offsets.push_back(graph.m_targets.size());
+    }
+    graph.m_edgeCount = graph.m_targets.size();
+    return graph;
+}
+
+VGACSRGraph VGACSRGraph::fromPointMap(PointMap &map, Storage storage) {
+    VGACSRGraph graph;
+    const AttributeTable &attributes = map.getAttributeTable();
+    graph.m_refs.reserve(attributes.getNumRows());
+    for (auto iter = attributes.begin(); iter != attributes.end(); iter++) {
+        graph.m_refs.push_back(iter->getKey().value);
+    }
+    // the attribute table is ordered by key, so the refs can be searched
+    auto nodeOf = [&graph](PixelRef pix) {
+        auto it = std::lower_bound(graph.m_refs.begin(), graph.m_refs.end(), int(pix));
+        return static_cast<uint32_t>(it - graph.m_refs.begin());
+    };
+
+    graph.m_storage = storage;
+    graph.m_mapWidth = map.getRegion().width();
+    graph.m_offsets.reserve(graph.m_refs.size() + 1);
+    graph.m_x.resize(graph.m_refs.size());
+    graph.m_y.resize(graph.m_refs.size());
+    PixelRefVector hood;
+    for (size_t node = 0; node < graph.m_refs.size(); node++) {
+        PixelRef pix = graph.m_refs[node];
+        Point &point = map.getPoint(pix);
+        hood.clear();
+        point.getNode().contents(hood);
+        // encoded straight away, so that the plain targets of the whole
+        // graph are never held next to the encoded ones
+        uint32_t previous = static_cast<uint32_t>(node);
+        for (PixelRef &connected : hood) {
+            if (connected == pix) {
+                continue;
+            }
+            uint32_t target = nodeOf(connected);
+            if (storage == Storage::DELTA_VARINT) {
+                encodeTarget(graph.m_encoded, previous, target);
+                previous = target;
+            } else {
+                graph.m_targets.push_back(target);
+            }
+            graph.m_edgeCount++;
+        }
+        if (point.getMergePixel() != NoPixel) {
+            graph.setMerge(node, nodeOf(point.getMergePixel()));
+        }
+        graph.m_offsets.push_back(storage == Storage::DELTA_VARINT ? graph.m_encoded.size()
+                                                                   : graph.m_targets.size());
+
+        Point2f position = map.depixelate(pix);
+        graph.m_x[node] = position.x;
+        graph.m_y[node] = position.y;
+    }
+    graph.m_encoded.shrink_to_fit();
+    return graph;
+}
+
+void VGACSRGraph::setStorage(Storage storage) {
+    if (storage == m_storage) {
+        return;
+    }
+    std::vector<size_t> offsets;
+    offsets.reserve(m_offsets.size());
+    offsets.push_back(0);
+    if (storage == Storage::DELTA_VARINT) {
+        std::vector<uint8_t> encoded;
+        for (size_t node = 0; node < nodeCount(); node++) {
+            uint32_t previous = static_cast<uint32_t>(node);
+            for (uint32_t target : neighbours(node)) {
+                encodeTarget(encoded, previous, target);
+                previous = target;
+            }
+            offsets.push_back(encoded.size());
+        }
+        encoded.shrink_to_fit();
+        m_encoded = std::move(encoded);
+        m_targets = std::vector<uint32_t>();
+    } else {
+        std::vector<uint32_t> targets;
+        targets.reserve(m_edgeCount);
+        for (size_t node = 0; node < nodeCount(); node++) {
+            for (uint32_t target : neighbours(node)) {
+                targets.push_back(target);
+            }
+            offsets.push_back(targets.size());
+        }
+        m_targets = std::move(targets);
+        m_encoded = std::vector<uint8_t>();
+    }
+    m_offsets = std::move(offsets);
+    m_storage = storage;
+}
+
+size_t VGACSRGraph::getConnectionBytes() const {
+    return m_offsets.size() * sizeof(size_t) + m_targets.size() * sizeof(uint32_t) +
+           m_encoded.size();
+}
+
+void VGACSRGraph::setPosition(size_t node, double x, double y) {
+    if (m_x.empty()) {
+        m_x.resize(nodeCount());
+        m_y.resize(nodeCount());
+    }
+    m_x[node] = x;
+    m_y[node] = y;
+}
+
+void VGACSRGraph::setMerge(size_t node, size_t other) {
+    if (m_merges.empty()) {
+        m_merges.resize(nodeCount(), NO_MERGE);
+    }
+    m_merges[node] = static_cast<uint32_t>(other);
+    m_merges[other] = static_cast<uint32_t>(node);
+}
+
+void VGACSRGraph::copyColumnToMap(PointMap &map, const std::string &columnName,
+                                  const std::vector<float> &values) const {
+    AttributeTable &attributes = map.getAttributeTable();
+    size_t colIdx = attributes.insertOrResetColumn(columnName);
+    for (size_t node = 0; node < m_refs.size(); node++) {
+        attributes.getRow(AttributeKey(m_refs[node])).setValue(colIdx, values[node]);
+    }
+}
+
+uint64_t VGACSRGraph::getSignature() const {
+    // FNV-1a over the node refs and the connections
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        for (int byte = 0; byte < 8; byte++) {
+            hash ^= (value >> (byte * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    };
+    mix(m_refs.size());
+    for (int ref : m_refs) {
+        mix(static_cast<uint32_t>(ref));
+    }
+    // the same for either storage
+    uint64_t edges = 0;
+    mix(edges);
+    for (size_t node = 0; node < nodeCount(); node++) {
+        edges += neighbours(node).size();
+        mix(edges);
+    }
+    for (size_t node = 0; node < nodeCount(); node++) {
+        for (uint32_t target : neighbours(node)) {
+            mix(target);
+        }
+    }
+    // and the merges, if there are any
+    for (uint32_t merge : m_merges) {
+        mix(merge);
+    }
+    return hash;
+}
+
+void VGACSRGraph::save(const std::string &filename) const {
+    std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+    if (!stream) {
+        throw genlib::RuntimeException("Unable to write graph file " + filename);
+    }
+    stream.write(graphMagic, sizeof(graphMagic));
+    writeValue(stream, static_cast<uint8_t>(m_storage));
+    writeValue(stream, static_cast<uint64_t>(m_edgeCount));
+    writeValues(stream, m_refs);
+    writeValues(stream, m_offsets);
+    writeValues(stream, m_targets);
+    writeValues(stream, m_encoded);
+    writeValues(stream, m_x);
+    writeValues(stream, m_y);
+    writeValues(stream, m_merges);
+    writeValue(stream, m_mapWidth);
+    if (!stream) {
+        throw genlib::RuntimeException("Unable to write graph file " + filename);
+    }
+}
+
+std::optional<VGACSRGraph> VGACSRGraph::load(const std::string &filename) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream) {
+        return std::nullopt;
+    }
+    char magic[sizeof(graphMagic)];
+    stream.read(magic, sizeof(magic));
+    if (!stream || !std::equal(magic, magic + sizeof(magic), graphMagic)) {
+        return std::nullopt;
+    }
+    VGACSRGraph graph;
+    uint8_t storage;
+    uint64_t edgeCount;
+    if (!readValue(stream, storage) || !readValue(stream, edgeCount) ||
+        !readValues(stream, graph.m_refs) || !readValues(stream, graph.m_offsets) ||
+        !readValues(stream, graph.m_targets) || !readValues(stream, graph.m_encoded) ||
+        !readValues(stream, graph.m_x) || !readValues(stream, graph.m_y) ||
+        !readValues(stream, graph.m_merges) || !readValue(stream, graph.m_mapWidth)) {
+        return std::nullopt;
+    }
+    if (storage > static_cast<uint8_t>(Storage::DELTA_VARINT)) {
+        return std::nullopt;
+    }
+    graph.m_storage = static_cast<Storage>(storage);
+    graph.m_edgeCount = static_cast<size_t>(edgeCount);
+    if (!graph.isValid()) {
+        return std::nullopt;
+    }
+    return graph;
+}
+
+bool VGACSRGraph::isValid() const {
+    bool plain = m_storage == Storage::PLAIN;
+    size_t connectionsSize = plain ? m_targets.size() : m_encoded.size();
+    if (m_offsets.size() != m_refs.size() + 1 || m_offsets.front() != 0 ||
+        m_offsets.back() != connectionsSize ||
+        !std::is_sorted(m_offsets.begin(), m_offsets.end()) ||
+        (plain ? !m_encoded.empty() : !m_targets.empty())) {
+        return false;
+    }
+    if (m_x.size() != m_y.size() || (!m_x.empty() && m_x.size() != m_refs.size())) {
+        return false;
+    }
+    if (!m_merges.empty()) {
+        if (m_merges.size() != m_refs.size()) {
+            return false;
+        }
+        for (size_t node = 0; node < nodeCount(); node++) {
+            uint32_t other = m_merges[node];
+            if (other != NO_MERGE && (other >= nodeCount() || m_merges[other] != node)) {
+                return false;
+            }
+        }
+    }
+    if (!plain) {
+        // every node has to end on a complete target of at most five bytes
+        // before it can be decoded
+        for (size_t node = 0; node < nodeCount(); node++) {
+            size_t length = 0;
+            for (size_t byte = m_offsets[node]; byte < m_offsets[node + 1]; byte++) {
+                length = m_encoded[byte] < 0x80 ? 0 : length + 1;
+                if (length >= 5) {
+                    return false;
+                }
+            }
+            if (length != 0) {
+                return false;
+            }
+        }
+    }
+    // make sure the connections stay within the graph
+    size_t edges = 0;
+    for (size_t node = 0; node < nodeCount(); node++) {
+        for (uint32_t target : neighbours(node)) {
+            if (target >= nodeCount()) {
+                return false;
+            }
+            edges++;
+        }
+    }
+    return edges == m_edgeCount;
+}
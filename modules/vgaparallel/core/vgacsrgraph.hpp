@@ -0,0 +1,192 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+class PointMap;
+
+/**
+ * @brief Visibility graph of a PointMap in compressed sparse row form
+ *
+ * Nodes are numbered in the order of the rows of the attribute table of the
+ * map, so per-node results can be written back row by row. The graph is a
+ * read-only snapshot and can be shared between threads.
+ *
+ * The connections are either kept as plain node indices or, to save memory on
+ * large maps, as the difference of each index from the previous one in
+ * variable length bytes. Cells mostly see cells in the same or nearby
+ * columns, whose indices are close, so most connections take one byte
+ * instead of four. Both are traversed the same way and in the same order.
+ *
+ * Merged points are not connections. As in salalib, a merged pair is taken
+ * as one place: a search that reaches one of them goes on from the other at
+ * no extra step or distance, and only the one reached first is counted.
+ */
+class VGACSRGraph {
+  public:
+    enum class Storage { PLAIN, DELTA_VARINT };
+    static constexpr uint32_t NO_MERGE = UINT32_MAX;
+
+    class Neighbours;
+
+    class NeighbourIterator {
+        // plain storage walks the targets, delta storage decodes the bytes
+        // of one target at a time
+        const uint32_t *m_target = nullptr;
+        const uint8_t *m_byte = nullptr;
+        const uint8_t *m_end = nullptr;
+        const uint8_t *m_next = nullptr;
+        uint32_t m_value = 0;
+
+        void decode() {
+            if (m_byte == m_end) {
+                return;
+            }
+            uint32_t zigzag = 0;
+            int shift = 0;
+            const uint8_t *byte = m_byte;
+            for (; *byte & 0x80; byte++, shift += 7) {
+                zigzag |= static_cast<uint32_t>(*byte & 0x7f) << shift;
+            }
+            zigzag |= static_cast<uint32_t>(*byte) << shift;
+            m_next = byte + 1;
+            // differences wrap around, so they are always exact
+            m_value += (zigzag >> 1) ^ (0u - (zigzag & 1));
+        }
+
+        friend class Neighbours;
+
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint32_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint32_t *;
+        using reference = uint32_t;
+
+        explicit NeighbourIterator(const uint32_t *target) : m_target(target) {}
+        NeighbourIterator(const uint8_t *byte, const uint8_t *end, uint32_t previous)
+            : m_byte(byte), m_end(end), m_value(previous) {
+            decode();
+        }
+        uint32_t operator*() const { return m_target ? *m_target : m_value; }
+        NeighbourIterator &operator++() {
+            if (m_target) {
+                ++m_target;
+            } else {
+                m_byte = m_next;
+                decode();
+            }
+            return *this;
+        }
+        bool operator==(const NeighbourIterator &other) const {
+            return m_target == other.m_target && m_byte == other.m_byte;
+        }
+        bool operator!=(const NeighbourIterator &other) const { return !(*this == other); }
+    };
+
+    class Neighbours {
+        NeighbourIterator m_begin;
+        NeighbourIterator m_end;
+
+      public:
+        Neighbours(NeighbourIterator begin, NeighbourIterator end) : m_begin(begin), m_end(end) {}
+        NeighbourIterator begin() const { return m_begin; }
+        NeighbourIterator end() const { return m_end; }
+        size_t size() const {
+            if (m_begin.m_target) {
+                return static_cast<size_t>(m_end.m_target - m_begin.m_target);
+            }
+            // every target ends in a byte without the continuation bit
+            return static_cast<size_t>(std::count_if(m_begin.m_byte, m_end.m_byte,
+                                                     [](uint8_t byte) { return byte < 0x80; }));
+        }
+    };
+
+  private:
+    Storage m_storage = Storage::PLAIN;
+    std::vector<int> m_refs;
+    // into the targets, or into the encoded bytes
+    std::vector<size_t> m_offsets;
+    std::vector<uint32_t> m_targets;
+    std::vector<uint8_t> m_encoded;
+    size_t m_edgeCount = 0;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    // the node each node is merged with, empty if there are no merges
+    std::vector<uint32_t> m_merges;
+    double m_mapWidth = 0.0;
+
+    // whether the connections can be traversed safely
+    bool isValid() const;
+
+  public:
+    VGACSRGraph() : m_offsets(1, 0) {}
+
+    // refs are the packed PixelRefs of the nodes, adjacency the indices of
+    // the nodes each node is connected to
+    static VGACSRGraph fromAdjacency(std::vector<int> refs,
+                                     const std::vector<std::vector<uint32_t>> &adjacency);
+    static VGACSRGraph fromPointMap(PointMap &map, Storage storage = Storage::PLAIN);
+
+    Storage getStorage() const { return m_storage; }
+    // re-encodes the connections, traversal gives the same results either way
+    void setStorage(Storage storage);
+    // bytes taken by the connections and their offsets
+    size_t getConnectionBytes() const;
+
+    size_t nodeCount() const { return m_refs.size(); }
+    size_t edgeCount() const { return m_edgeCount; }
+    int getRef(size_t node) const { return m_refs[node]; }
+    const std::vector<int> &getRefs() const { return m_refs; }
+    Neighbours neighbours(size_t node) const {
+        if (m_storage == Storage::PLAIN) {
+            return Neighbours(NeighbourIterator(m_targets.data() + m_offsets[node]),
+                              NeighbourIterator(m_targets.data() + m_offsets[node + 1]));
+        }
+        // the first target is relative to the node itself
+        const uint8_t *first = m_encoded.data() + m_offsets[node];
+        const uint8_t *last = m_encoded.data() + m_offsets[node + 1];
+        return Neighbours(NeighbourIterator(first, last, static_cast<uint32_t>(node)),
+                          NeighbourIterator(last, last, 0));
+    }
+
+    bool hasMerges() const { return !m_merges.empty(); }
+    uint32_t getMerge(size_t node) const {
+        return m_merges.empty() ? NO_MERGE : m_merges[node];
+    }
+    // merges the two nodes with each other
+    void setMerge(size_t node, size_t other);
+
+    // positions are only filled in for graphs taken from a map
+    bool hasPositions() const { return !m_x.empty(); }
+    void setPosition(size_t node, double x, double y);
+    double getX(size_t node) const { return m_x[node]; }
+    double getY(size_t node) const { return m_y[node]; }
+
+    // the width of the region of the map the graph was taken from, which
+    // the names of columns with a distance radius depend on
+    double getMapWidth() const { return m_mapWidth; }
+    void setMapWidth(double mapWidth) { m_mapWidth = mapWidth; }
+
+    // writes one value per node to the rows of the map the graph was taken from
+    void copyColumnToMap(PointMap &map, const std::string &columnName,
+                         const std::vector<float> &values) const;
+
+    // the graph on its own, to be analysed away from its map
+    void save(const std::string &filename) const;
+    // returns nothing if the file does not exist or is not a graph
+    static std::optional<VGACSRGraph> load(const std::string &filename);
+
+    // fingerprint of the connections, used to tell whether a map has
+    // changed since a result was stored for it
+    uint64_t getSignature() const;
+};
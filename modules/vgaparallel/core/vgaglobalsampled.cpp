@@ -0,0 +1,457 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgaglobalsampled.hpp"
+
+#include "vgacsrgraph.hpp"
+#include "vgavisualmeasures.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <random>
+
+namespace {
+    // 95% confidence
+    constexpr double Z_VALUE = 1.96;
+    constexpr size_t PILOT_SAMPLES = 64;
+    // the sample is sized so that this share of the points gets within the
+    // target error, the rest are the few with very uneven depths
+    constexpr double COVERED_SHARE = 0.9;
+
+    // hands out the points to sample in an order where every prefix is a
+    // usable sample on its own
+    class SampleOrder {
+        std::vector<uint32_t> m_order;
+        std::vector<bool> m_used;
+        VGAGlobalSampled::Sampling m_sampling;
+        double m_rotation;
+        size_t m_next = 0;
+
+        // radical inverse in base 2, which fills [0, 1) ever more finely
+        static double vanDerCorput(size_t index) {
+            double value = 0.0, base = 0.5;
+            for (; index != 0; index >>= 1, base *= 0.5) {
+                if (index & 1) {
+                    value += base;
+                }
+            }
+            return value;
+        }
+
+      public:
+        SampleOrder(size_t nodeCount, VGAGlobalSampled::Sampling sampling, unsigned int seed)
+            : m_used(nodeCount, false), m_sampling(sampling) {
+            std::mt19937 generator(seed);
+            m_rotation = std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+            if (sampling == VGAGlobalSampled::Sampling::RANDOM) {
+                m_order.resize(nodeCount);
+                std::iota(m_order.begin(), m_order.end(), 0);
+                std::shuffle(m_order.begin(), m_order.end(), generator);
+            }
+        }
+
+        uint32_t next() {
+            size_t index = m_next++;
+            if (m_sampling == VGAGlobalSampled::Sampling::RANDOM) {
+                return m_order[index];
+            }
+            // points are in row order, so even steps through them are even
+            // steps over the map; taken points pass on to the next free one
+            double position = vanDerCorput(index + 1) + m_rotation;
+            position -= std::floor(position);
+            size_t node = std::min(m_used.size() - 1,
+                                   static_cast<size_t>(position * double(m_used.size())));
+            while (m_used[node]) {
+                node = (node + 1) % m_used.size();
+            }
+            m_used[node] = true;
+            return static_cast<uint32_t>(node);
+        }
+    };
+
+    // depths from the sources each point was reached from
+    struct Accumulator {
+        std::vector<double> sum;
+        std::vector<double> sumSquares;
+        std::vector<uint32_t> count;
+
+        void add(uint32_t node, double depth) {
+            sum[node] += depth;
+            sumSquares[node] += depth * depth;
+            count[node]++;
+        }
+    };
+
+    // the searches from the sampled sources, and what they add up to
+    struct Search {
+        Accumulator accumulator;
+        std::vector<double> depth;
+        std::vector<uint32_t> parent;
+        std::vector<uint8_t> settled;
+        std::vector<uint32_t> reached;
+        std::vector<uint32_t> frontier;
+        std::vector<uint32_t> nextFrontier;
+        std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>,
+                            std::greater<std::pair<double, uint32_t>>>
+            queue;
+    };
+
+    constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+    double stepLength(const VGACSRGraph &graph, uint32_t from, uint32_t to) {
+        return std::hypot(graph.getX(to) - graph.getX(from), graph.getY(to) - graph.getY(from));
+    }
+
+    // the turn from one step to the next, a right angle counting as 1
+    double turnAngle(const VGACSRGraph &graph, uint32_t previous, uint32_t from, uint32_t to) {
+        double ax = graph.getX(from) - graph.getX(previous);
+        double ay = graph.getY(from) - graph.getY(previous);
+        double bx = graph.getX(to) - graph.getX(from);
+        double by = graph.getY(to) - graph.getY(from);
+        double lengths = std::hypot(ax, ay) * std::hypot(bx, by);
+        if (lengths == 0.0) {
+            return 0.0;
+        }
+        double cosine = std::clamp((ax * bx + ay * by) / lengths, -1.0, 1.0);
+        return std::acos(cosine) / (M_PI * 0.5);
+    }
+
+    void searchVisual(const VGACSRGraph &graph, uint32_t source, double radius, Search &search) {
+        search.depth[source] = 0.0;
+        search.reached.push_back(source);
+        uint32_t sourceMerge = graph.getMerge(source);
+        if (sourceMerge != VGACSRGraph::NO_MERGE) {
+            search.depth[sourceMerge] = 0.0;
+            search.reached.push_back(sourceMerge);
+        }
+        search.frontier.assign(1, source);
+        for (int depth = 1; !search.frontier.empty(); depth++) {
+            if (radius != -1 && depth > radius) {
+                break;
+            }
+            search.nextFrontier.clear();
+            for (uint32_t node : search.frontier) {
+                // a merged pair is one place, reached at the same depth
+                for (uint32_t from : {node, graph.getMerge(node)}) {
+                    if (from == NO_NODE) {
+                        continue;
+                    }
+                    for (uint32_t connected : graph.neighbours(from)) {
+                        if (search.depth[connected] != std::numeric_limits<double>::infinity()) {
+                            continue;
+                        }
+                        search.nextFrontier.push_back(connected);
+                        for (uint32_t place : {connected, graph.getMerge(connected)}) {
+                            if (place != NO_NODE) {
+                                search.depth[place] = depth;
+                                search.reached.push_back(place);
+                                search.accumulator.add(place, depth);
+                            }
+                        }
+                    }
+                }
+            }
+            std::swap(search.frontier, search.nextFrontier);
+        }
+    }
+
+    // metric and angular depths, both shortest paths over weighted steps
+    template <typename StepCost>
+    void searchWeighted(const VGACSRGraph &graph, uint32_t source, double radius, Search &search,
+                        StepCost stepCost) {
+        search.depth[source] = 0.0;
+        search.reached.push_back(source);
+        search.queue.emplace(0.0, source);
+        while (!search.queue.empty()) {
+            auto [depth, node] = search.queue.top();
+            search.queue.pop();
+            if (depth > search.depth[node] || search.settled[node]) {
+                continue;
+            }
+            search.settled[node] = 1;
+            if (node != source) {
+                search.accumulator.add(node, depth);
+            }
+            // the node it is merged with is the same place, the search goes on
+            // from there at the same depth and without a turn
+            uint32_t merge = graph.getMerge(node);
+            if (merge != VGACSRGraph::NO_MERGE && !search.settled[merge]) {
+                if (search.depth[merge] == std::numeric_limits<double>::infinity()) {
+                    search.reached.push_back(merge);
+                }
+                search.depth[merge] = depth;
+                search.parent[merge] = NO_NODE;
+                search.settled[merge] = 1;
+                if (node != source) {
+                    search.accumulator.add(merge, depth);
+                }
+            }
+            for (uint32_t from : {node, merge}) {
+                if (from == NO_NODE) {
+                    continue;
+                }
+                for (uint32_t connected : graph.neighbours(from)) {
+                    double newDepth = depth + stepCost(search.parent[from], from, connected);
+                    if (radius != -1 && newDepth > radius) {
+                        continue;
+                    }
+                    if (newDepth < search.depth[connected]) {
+                        if (search.depth[connected] == std::numeric_limits<double>::infinity()) {
+                            search.reached.push_back(connected);
+                        }
+                        search.depth[connected] = newDepth;
+                        search.parent[connected] = from;
+                        search.queue.emplace(newDepth, connected);
+                    }
+                }
+            }
+        }
+    }
+} // namespace
+
+std::string VGAGlobalSampled::getMainColumn(const Settings &settings, double mapWidth) {
+    switch (settings.measure) {
+    case Measure::METRIC:
+        return getColumnWithRadius(Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE, settings.radius,
+                                   mapWidth);
+    case Measure::ANGULAR:
+        return getColumnWithRadius(Column::ANGULAR_MEAN_DEPTH, settings.radius, mapWidth);
+    case Measure::VISUAL:
+        break;
+    }
+    return getColumnWithRadius(Column::VISUAL_INTEGRATION_HH, static_cast<int>(settings.radius));
+}
+
+VGAGlobalSampled::Result VGAGlobalSampled::analyseGraph(const VGACSRGraph &graph,
+                                                        const Settings &settings,
+                                                        Communicator *comm) {
+    size_t nodeCount = graph.nodeCount();
+    Result result;
+    result.meanDepth.assign(nodeCount, -1.0f);
+    result.nodeCount.assign(nodeCount, -1.0f);
+    result.meanDepthError.assign(nodeCount, -1.0f);
+    if (nodeCount == 0) {
+        return result;
+    }
+
+    std::vector<Search> searches(static_cast<size_t>(getMaxThreads()));
+    for (auto &search : searches) {
+        search.accumulator.sum.resize(nodeCount, 0.0);
+        search.accumulator.sumSquares.resize(nodeCount, 0.0);
+        search.accumulator.count.resize(nodeCount, 0);
+        search.depth.resize(nodeCount, std::numeric_limits<double>::infinity());
+        search.parent.resize(nodeCount, NO_NODE);
+        search.settled.resize(nodeCount, 0);
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    SampleOrder order(nodeCount, settings.sampling, settings.seed);
+    std::vector<uint32_t> sources;
+    std::vector<bool> isSource(nodeCount, false);
+    std::atomic<size_t> sourcesDone(0);
+
+    auto runSources = [&](size_t sampleCount) {
+        size_t firstSource = sources.size();
+        while (sources.size() < sampleCount) {
+            sources.push_back(order.next());
+            isSource[sources.back()] = true;
+        }
+        if (comm) {
+            comm->CommPostMessage(Communicator::NUM_RECORDS, sampleCount);
+        }
+        std::atomic<bool> cancelled(false);
+        parallelFor(sampleCount - firstSource, 1, [&](size_t i, int thread) {
+            if (cancelled.load(std::memory_order_relaxed)) {
+                return;
+            }
+            Search &search = searches[static_cast<size_t>(thread)];
+            uint32_t source = sources[firstSource + i];
+            switch (settings.measure) {
+            case Measure::VISUAL:
+                searchVisual(graph, source, settings.radius, search);
+                break;
+            case Measure::METRIC:
+                searchWeighted(graph, source, settings.radius, search,
+                               [&graph](uint32_t, uint32_t from, uint32_t to) {
+                                   return stepLength(graph, from, to);
+                               });
+                break;
+            case Measure::ANGULAR:
+                // the first step from the source is not a turn
+                searchWeighted(graph, source, settings.radius, search,
+                               [&graph](uint32_t previous, uint32_t from, uint32_t to) {
+                                   return previous == NO_NODE
+                                              ? 0.0
+                                              : turnAngle(graph, previous, from, to);
+                               });
+                break;
+            }
+            for (uint32_t node : search.reached) {
+                search.depth[node] = std::numeric_limits<double>::infinity();
+                search.parent[node] = NO_NODE;
+                search.settled[node] = 0;
+            }
+            search.reached.clear();
+
+            if (telemetry) {
+                telemetry->addRecords(static_cast<size_t>(thread));
+            }
+            size_t done = ++sourcesDone;
+            if (comm) {
+                if (thread == 0) {
+                    comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+                }
+                if (comm->IsCancelled()) {
+                    cancelled = true;
+                }
+            }
+        });
+        if (cancelled) {
+            throw Communicator::CancelledException();
+        }
+    };
+
+    Accumulator total;
+    auto sumAccumulators = [&]() {
+        total.sum.assign(nodeCount, 0.0);
+        total.sumSquares.assign(nodeCount, 0.0);
+        total.count.assign(nodeCount, 0);
+        for (auto &search : searches) {
+            for (size_t node = 0; node < nodeCount; node++) {
+                total.sum[node] += search.accumulator.sum[node];
+                total.sumSquares[node] += search.accumulator.sumSquares[node];
+                total.count[node] += search.accumulator.count[node];
+            }
+        }
+    };
+    auto variance = [&total](size_t node) {
+        double count = total.count[node];
+        double mean = total.sum[node] / count;
+        return std::max(0.0, (total.sumSquares[node] - count * mean * mean) / (count - 1.0));
+    };
+
+    if (telemetry) {
+        telemetry->setPhase("pilot sample");
+    }
+    runSources(std::min(nodeCount, PILOT_SAMPLES));
+    sumAccumulators();
+
+    // the sample size that brings the relative error of a point within the
+    // target, from how much its depths varied in the pilot
+    std::vector<double> needed;
+    for (size_t node = 0; node < nodeCount; node++) {
+        if (total.count[node] < 2 || total.sum[node] <= 0.0) {
+            continue;
+        }
+        double mean = total.sum[node] / total.count[node];
+        double relativeSpread = std::sqrt(variance(node)) / mean;
+        needed.push_back(std::pow(Z_VALUE * relativeSpread / settings.targetError, 2.0));
+    }
+    size_t sampleCount = sources.size();
+    if (!needed.empty()) {
+        auto covered = needed.begin() + static_cast<std::ptrdiff_t>(
+                                            COVERED_SHARE * double(needed.size() - 1));
+        std::nth_element(needed.begin(), covered, needed.end());
+        // fewer are needed when the sample is a large part of the points
+        double required = *covered / (1.0 + *covered / double(nodeCount));
+        sampleCount = std::clamp(static_cast<size_t>(std::ceil(required)), sampleCount, nodeCount);
+    }
+
+    if (sampleCount > sources.size()) {
+        if (telemetry) {
+            telemetry->setPhase("sampling");
+        }
+        runSources(sampleCount);
+        sumAccumulators();
+    }
+    result.sampleCount = sources.size();
+
+    for (size_t node = 0; node < nodeCount; node++) {
+        double others = double(sources.size()) - (isSource[node] ? 1.0 : 0.0);
+        if (others <= 0.0) {
+            continue;
+        }
+        double count = total.count[node];
+        // the share of the sample reached stands for the share of the map
+        double reachable = count / others * double(nodeCount - 1);
+        result.nodeCount[node] = static_cast<float>(1.0 + reachable);
+        if (count == 0) {
+            continue;
+        }
+        double mean = total.sum[node] / count;
+        result.meanDepth[node] = static_cast<float>(mean);
+        if (count >= 2) {
+            double correction = reachable > 1.0 ? std::max(0.0, (reachable - count) /
+                                                                     (reachable - 1.0))
+                                                : 0.0;
+            result.meanDepthError[node] =
+                static_cast<float>(Z_VALUE * std::sqrt(variance(node) / count * correction));
+        }
+    }
+    return result;
+}
+
+AnalysisResult VGAGlobalSampled::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(m_map, m_graphStorage);
+
+    auto result = analyseGraph(graph, m_settings, comm);
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    double radius = m_settings.radius;
+    double mapWidth = graph.getMapWidth();
+    auto writeColumn = [&](const std::string &column, const std::vector<float> &values) {
+        // visibility radii are in steps, the others in distance
+        graph.copyColumnToMap(m_map,
+                              m_settings.measure == Measure::VISUAL
+                                  ? getColumnWithRadius(column, static_cast<int>(radius))
+                                  : getColumnWithRadius(column, radius, mapWidth),
+                              values);
+    };
+    switch (m_settings.measure) {
+    case Measure::VISUAL: {
+        std::vector<float> integration(graph.nodeCount(), -1.0f);
+        for (size_t node = 0; node < graph.nodeCount(); node++) {
+            if (result.meanDepth[node] != -1.0f) {
+                integration[node] =
+                    VGAVisualMeasures::fromMeanDepth(result.nodeCount[node], result.meanDepth[node])
+                        .integHH;
+            }
+        }
+        writeColumn(Column::VISUAL_MEAN_DEPTH, result.meanDepth);
+        writeColumn(Column::VISUAL_INTEGRATION_HH, integration);
+        writeColumn(Column::VISUAL_NODE_COUNT, result.nodeCount);
+        writeColumn(Column::VISUAL_MEAN_DEPTH_ERROR, result.meanDepthError);
+        break;
+    }
+    case Measure::METRIC:
+        writeColumn(Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE, result.meanDepth);
+        writeColumn(Column::METRIC_NODE_COUNT, result.nodeCount);
+        writeColumn(Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE_ERROR, result.meanDepthError);
+        break;
+    case Measure::ANGULAR:
+        writeColumn(Column::ANGULAR_MEAN_DEPTH, result.meanDepth);
+        writeColumn(Column::ANGULAR_NODE_COUNT, result.nodeCount);
+        writeColumn(Column::ANGULAR_MEAN_DEPTH_ERROR, result.meanDepthError);
+        break;
+    }
+
+    AnalysisResult analysisResult;
+    analysisResult.completed = true;
+    return analysisResult;
+}
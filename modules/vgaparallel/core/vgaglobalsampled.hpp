@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacsrgraph.hpp"
+
+#include "modules/parallelcommon/core/columnwithradius.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+#include <vector>
+
+class PointMap;
+
+/**
+ * @brief Global visibility, metric or angular analysis from a sample of points
+ *
+ * Depths are symmetric, so the mean depth of a point can be estimated from
+ * its depth to a sample of the points rather than to all of them. A pilot
+ * sample measures how much the depths vary, and the sample is grown until
+ * the mean depth of most points is expected to be within the target error,
+ * at 95% confidence. The margin each point actually got is written out
+ * with the estimates.
+ *
+ * Angular depth follows the turns along the path, which makes it only
+ * nearly symmetric, so its estimates are slightly less reliable.
+ */
+class VGAGlobalSampled : public IAnalysis {
+  public:
+    enum class Measure { VISUAL, METRIC, ANGULAR };
+    enum class Sampling { STRATIFIED, RANDOM };
+
+    struct Settings {
+        Measure measure = Measure::VISUAL;
+        // -1 is the whole graph, visual radii are whole steps
+        double radius = -1;
+        // relative error of the mean depth
+        double targetError = 0.05;
+        // stratified samples are spread evenly over the map
+        Sampling sampling = Sampling::STRATIFIED;
+        unsigned int seed = 0;
+    };
+
+    struct Result {
+        size_t sampleCount = 0;
+        std::vector<float> meanDepth;
+        std::vector<float> nodeCount;
+        // half the width of the 95% confidence interval of the mean depth
+        std::vector<float> meanDepthError;
+    };
+
+    struct Column {
+        inline static const std::string                                          //
+            VISUAL_MEAN_DEPTH = "Visual Mean Depth [Sampled]",                   //
+            VISUAL_INTEGRATION_HH = "Visual Integration [HH] [Sampled]",         //
+            VISUAL_NODE_COUNT = "Visual Node Count [Sampled]",                   //
+            VISUAL_MEAN_DEPTH_ERROR = "Visual Mean Depth 95% Error [Sampled]",   //
+            METRIC_MEAN_SHORTEST_PATH_DISTANCE =                                 //
+                "Metric Mean Shortest-Path Distance [Sampled]",                  //
+            METRIC_NODE_COUNT = "Metric Node Count [Sampled]",                   //
+            METRIC_MEAN_SHORTEST_PATH_DISTANCE_ERROR =                           //
+                "Metric Mean Shortest-Path Distance 95% Error [Sampled]",        //
+            ANGULAR_MEAN_DEPTH = "Angular Mean Depth [Sampled]",                 //
+            ANGULAR_NODE_COUNT = "Angular Node Count [Sampled]",                 //
+            ANGULAR_MEAN_DEPTH_ERROR = "Angular Mean Depth 95% Error [Sampled]"; //
+    };
+
+  private:
+    PointMap &m_map;
+    Settings m_settings;
+    VGACSRGraph::Storage m_graphStorage = VGACSRGraph::Storage::PLAIN;
+
+  public:
+    VGAGlobalSampled(PointMap &map, Settings settings) : m_map(map), m_settings(settings) {}
+    std::string getAnalysisName() const override { return "Sampled Global Analysis"; }
+    void setGraphStorage(VGACSRGraph::Storage graphStorage) { m_graphStorage = graphStorage; }
+    AnalysisResult run(Communicator *comm) override;
+
+    // the column shown once the analysis is done, on a map of the given width
+    static std::string getMainColumn(const Settings &settings, double mapWidth);
+
+    static Result analyseGraph(const VGACSRGraph &graph, const Settings &settings,
+                               Communicator *comm);
+};
@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgametricglobalradixheap.hpp"
+
+#include "vgaradixheap.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // distances from the current source, and the nodes given one
+    struct Search {
+        std::vector<double> distance;
+        std::vector<uint32_t> reached;
+        VGARadixHeap queue;
+    };
+} // namespace
+
+VGAMetricGlobalRadixHeap::Result
+VGAMetricGlobalRadixHeap::analyseGraph(const VGACSRGraph &graph, double radius,
+                                       Communicator *comm) {
+    size_t nodeCount = graph.nodeCount();
+    Result result;
+    result.meanShortestPathDistance.resize(nodeCount);
+    result.meanStraightLineDistance.resize(nodeCount);
+    result.nodeCount.resize(nodeCount);
+
+    std::vector<Search> searches(static_cast<size_t>(getMaxThreads()));
+    for (auto &search : searches) {
+        search.distance.resize(nodeCount, std::numeric_limits<double>::infinity());
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, nodeCount);
+    }
+    std::atomic<size_t> sourcesDone(0);
+    std::atomic<bool> cancelled(false);
+
+    parallelFor(nodeCount, 16, [&](size_t source, int thread) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Search &search = searches[static_cast<size_t>(thread)];
+        search.distance[source] = 0.0;
+        search.queue.clear();
+        search.queue.push(0.0, static_cast<uint32_t>(source));
+
+        double totalDistance = 0.0;
+        double totalStraightLine = 0.0;
+        int totalNodes = 0;
+        while (!search.queue.empty()) {
+            auto [distance, node] = search.queue.pop();
+            if (distance > search.distance[node]) {
+                continue;
+            }
+            search.reached.push_back(node);
+            totalDistance += distance;
+            totalStraightLine += std::hypot(graph.getX(node) - graph.getX(source),
+                                            graph.getY(node) - graph.getY(source));
+            totalNodes++;
+            // the node it is merged with is the same place, so the search goes
+            // on from there at the same distance without counting it again
+            uint32_t merge = graph.getMerge(node);
+            if (merge != VGACSRGraph::NO_MERGE) {
+                search.distance[merge] = -std::numeric_limits<double>::infinity();
+                search.reached.push_back(merge);
+            }
+            for (uint32_t from : {node, merge}) {
+                if (from == VGACSRGraph::NO_MERGE) {
+                    continue;
+                }
+                for (uint32_t connected : graph.neighbours(from)) {
+                    double newDistance =
+                        distance + std::hypot(graph.getX(connected) - graph.getX(from),
+                                              graph.getY(connected) - graph.getY(from));
+                    if (radius != -1 && newDistance > radius) {
+                        continue;
+                    }
+                    if (newDistance < search.distance[connected]) {
+                        search.distance[connected] = newDistance;
+                        search.queue.push(newDistance, connected);
+                    }
+                }
+            }
+        }
+        for (uint32_t node : search.reached) {
+            search.distance[node] = std::numeric_limits<double>::infinity();
+        }
+        search.reached.clear();
+
+        result.meanShortestPathDistance[source] = static_cast<float>(totalDistance / totalNodes);
+        result.meanStraightLineDistance[source] =
+            static_cast<float>(totalStraightLine / totalNodes);
+        result.nodeCount[source] = static_cast<float>(totalNodes);
+
+        if (telemetry) {
+            telemetry->addRecords(static_cast<size_t>(thread));
+        }
+        size_t done = sourcesDone.fetch_add(1) + 1;
+        if (comm && thread == 0) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+            if (comm->IsCancelled()) {
+                cancelled = true;
+            }
+        }
+    });
+
+    if (cancelled) {
+        throw Communicator::CancelledException();
+    }
+    return result;
+}
+
+AnalysisResult VGAMetricGlobalRadixHeap::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(m_map, m_graphStorage);
+
+    if (telemetry) {
+        telemetry->setPhase("traversing");
+    }
+    auto metric = analyseGraph(graph, m_radius, comm);
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    double mapWidth = graph.getMapWidth();
+    graph.copyColumnToMap(
+        m_map,
+        getColumnWithRadius(Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE, m_radius, mapWidth),
+        metric.meanShortestPathDistance);
+    graph.copyColumnToMap(
+        m_map,
+        getColumnWithRadius(Column::METRIC_MEAN_STRAIGHT_LINE_DISTANCE, m_radius, mapWidth),
+        metric.meanStraightLineDistance);
+    graph.copyColumnToMap(m_map,
+                          getColumnWithRadius(Column::METRIC_NODE_COUNT, m_radius, mapWidth),
+                          metric.nodeCount);
+
+    AnalysisResult result;
+    result.completed = true;
+    return result;
+}
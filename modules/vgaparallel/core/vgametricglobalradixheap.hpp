@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacolumns.hpp"
+#include "vgacsrgraph.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+#include <vector>
+
+class PointMap;
+
+/**
+ * @brief Global metric analysis with a radix heap in each search
+ *
+ * The lengths of the steps are distances between cell centres, never
+ * negative, so every search only ever takes out distances that do not go
+ * down. A radix heap then does the work of the priority queue for less.
+ * Produces the same columns as the other global metric analyses.
+ */
+class VGAMetricGlobalRadixHeap : public IAnalysis {
+  private:
+    PointMap &m_map;
+    double m_radius;
+    VGACSRGraph::Storage m_graphStorage = VGACSRGraph::Storage::PLAIN;
+
+  public:
+    using Column = VGAMetricGlobalColumn;
+
+    struct Result {
+        std::vector<float> meanShortestPathDistance;
+        std::vector<float> meanStraightLineDistance;
+        std::vector<float> nodeCount;
+    };
+
+  public:
+    // a radius of -1 is the whole graph
+    VGAMetricGlobalRadixHeap(PointMap &map, double radius) : m_map(map), m_radius(radius) {}
+    std::string getAnalysisName() const override {
+        return "Global Metric Analysis (Radix Heap)";
+    }
+    void setGraphStorage(VGACSRGraph::Storage graphStorage) { m_graphStorage = graphStorage; }
+    AnalysisResult run(Communicator *comm) override;
+
+    static Result analyseGraph(const VGACSRGraph &graph, double radius, Communicator *comm);
+};
@@ -0,0 +1,138 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgametricglobalresumable.hpp"
+
+#include "vgacsrgraph.hpp"
+#include "vgasourcesweep.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace {
+    // distances from the current source, and the nodes given one
+    struct Search {
+        std::vector<double> distance;
+        std::vector<uint32_t> reached;
+        std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>,
+                            std::greater<std::pair<double, uint32_t>>>
+            queue;
+    };
+} // namespace
+
+AnalysisResult VGAMetricGlobalResumable::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(m_map, m_graphStorage);
+    size_t nodeCount = graph.nodeCount();
+
+    std::optional<VGACheckpoint> checkpoint;
+    if (!m_checkpointFile.empty()) {
+        checkpoint = VGACheckpoint::load(m_checkpointFile);
+        if (checkpoint &&
+            !checkpoint->matches(getAnalysisKey(), graph.getSignature(), nodeCount)) {
+            checkpoint.reset();
+        }
+    }
+    if (!checkpoint) {
+        checkpoint.emplace(getAnalysisKey(), graph.getSignature(), nodeCount);
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("traversing");
+    }
+    VGASourceSweep sweep(*checkpoint, m_checkpointFile);
+    analyseGraph(graph, m_radius, sweep, comm);
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    for (auto &column : checkpoint->getColumns()) {
+        graph.copyColumnToMap(m_map, column.first, column.second);
+    }
+    if (!m_checkpointFile.empty()) {
+        VGACheckpoint::remove(m_checkpointFile);
+    }
+
+    AnalysisResult result;
+    result.completed = true;
+    return result;
+}
+
+void VGAMetricGlobalResumable::analyseGraph(const VGACSRGraph &graph, double radius,
+                                            VGASourceSweep &sweep, Communicator *comm) {
+    VGACheckpoint &checkpoint = sweep.getCheckpoint();
+    double mapWidth = graph.getMapWidth();
+    std::vector<float> &shortestPathCol = checkpoint.getColumn(
+        getColumnWithRadius(Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE, radius, mapWidth));
+    std::vector<float> &straightLineCol = checkpoint.getColumn(
+        getColumnWithRadius(Column::METRIC_MEAN_STRAIGHT_LINE_DISTANCE, radius, mapWidth));
+    std::vector<float> &nodeCountCol =
+        checkpoint.getColumn(getColumnWithRadius(Column::METRIC_NODE_COUNT, radius, mapWidth));
+
+    std::vector<Search> searches(static_cast<size_t>(getMaxThreads()));
+    for (auto &search : searches) {
+        search.distance.resize(graph.nodeCount(), std::numeric_limits<double>::infinity());
+    }
+
+    sweep.run(comm, [&](size_t source, int thread) {
+        Search &search = searches[static_cast<size_t>(thread)];
+        search.distance[source] = 0.0;
+        search.queue.emplace(0.0, static_cast<uint32_t>(source));
+
+        double totalDistance = 0.0;
+        double totalStraightLine = 0.0;
+        int totalNodes = 0;
+        while (!search.queue.empty()) {
+            auto [distance, node] = search.queue.top();
+            search.queue.pop();
+            if (distance > search.distance[node]) {
+                continue;
+            }
+            search.reached.push_back(node);
+            totalDistance += distance;
+            totalStraightLine += std::hypot(graph.getX(node) - graph.getX(source),
+                                            graph.getY(node) - graph.getY(source));
+            totalNodes++;
+            // the node it is merged with is the same place, so the search goes
+            // on from there at the same distance without counting it again
+            uint32_t merge = graph.getMerge(node);
+            if (merge != VGACSRGraph::NO_MERGE) {
+                search.distance[merge] = -std::numeric_limits<double>::infinity();
+                search.reached.push_back(merge);
+            }
+            for (uint32_t from : {node, merge}) {
+                if (from == VGACSRGraph::NO_MERGE) {
+                    continue;
+                }
+                for (uint32_t connected : graph.neighbours(from)) {
+                    double newDistance =
+                        distance + std::hypot(graph.getX(connected) - graph.getX(from),
+                                              graph.getY(connected) - graph.getY(from));
+                    if (radius != -1 && newDistance > radius) {
+                        continue;
+                    }
+                    if (newDistance < search.distance[connected]) {
+                        search.distance[connected] = newDistance;
+                        search.queue.emplace(newDistance, connected);
+                    }
+                }
+            }
+        }
+        for (uint32_t node : search.reached) {
+            search.distance[node] = std::numeric_limits<double>::infinity();
+        }
+        search.reached.clear();
+
+        shortestPathCol[source] = static_cast<float>(totalDistance / totalNodes);
+        straightLineCol[source] = static_cast<float>(totalStraightLine / totalNodes);
+        nodeCountCol[source] = static_cast<float>(totalNodes);
+    });
+}
@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacolumns.hpp"
+#include "vgacsrgraph.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+
+class PointMap;
+class VGASourceSweep;
+
+/**
+ * @brief Global metric analysis that can be interrupted and resumed
+ *
+ * Shortest paths follow the visibility connections, weighted by the distance
+ * between the cell centres. Progress is written to a checkpoint file, and a
+ * matching checkpoint found when the analysis starts is picked up from where
+ * it was left.
+ */
+class VGAMetricGlobalResumable : public IAnalysis {
+  private:
+    PointMap &m_map;
+    double m_radius;
+    std::string m_checkpointFile;
+    VGACSRGraph::Storage m_graphStorage = VGACSRGraph::Storage::PLAIN;
+
+  public:
+    using Column = VGAMetricGlobalColumn;
+
+  public:
+    // a radius of -1 is the whole graph
+    VGAMetricGlobalResumable(PointMap &map, double radius) : m_map(map), m_radius(radius) {}
+    std::string getAnalysisName() const override { return "Global Metric Analysis (Resumable)"; }
+    // identifies the analysis and its parameters in a checkpoint
+    static std::string getAnalysisKey(double radius) {
+        return "metric-global radius " + std::to_string(radius);
+    }
+    std::string getAnalysisKey() const { return getAnalysisKey(m_radius); }
+    // no checkpoints are written if this is not set
+    void setCheckpointFile(std::string checkpointFile) {
+        m_checkpointFile = std::move(checkpointFile);
+    }
+    void setGraphStorage(VGACSRGraph::Storage graphStorage) { m_graphStorage = graphStorage; }
+    AnalysisResult run(Communicator *comm) override;
+
+    // runs the sources of the sweep, adding the columns to its checkpoint
+    static void analyseGraph(const VGACSRGraph &graph, double radius, VGASourceSweep &sweep,
+                             Communicator *comm);
+};
@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgapathtree.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+    constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+    // cells settled between looking at the clock
+    constexpr size_t CLOCK_INTERVAL = 64;
+} // namespace
+
+VGAPathTree::VGAPathTree(std::unique_ptr<const Graph> graph, uint32_t origin, PathType pathType)
+    : m_graph(std::move(graph)), m_origin(origin), m_pathType(pathType),
+      m_cost(m_graph->nodeCount(), UNREACHED), m_parent(m_graph->nodeCount(), NO_NODE),
+      m_settled(m_graph->nodeCount(), 0) {
+    if (origin < m_graph->nodeCount()) {
+        m_cost[origin] = 0.0;
+        m_heap.push(0.0, origin);
+    }
+}
+
+void VGAPathTree::settleNext() {
+    while (!m_heap.empty()) {
+        auto [key, node] = m_heap.pop();
+        if (m_settled[node]) {
+            continue;
+        }
+        m_settled[node] = 1;
+        m_settledCount++;
+        m_graph->getNeighbours(node, m_neighbours);
+        // merged points are the same place, and going on from one is not a turn
+        uint32_t merge = m_graph->getMerge(node);
+        if (merge != VGACSRGraph::NO_MERGE) {
+            m_neighbours.push_back(merge);
+        }
+        for (uint32_t next : m_neighbours) {
+            if (m_settled[next]) {
+                continue;
+            }
+            double step = 1.0;
+            if (next == merge) {
+                step = 0.0;
+            } else if (m_pathType == PathType::METRIC) {
+                step = std::hypot(m_graph->getX(next) - m_graph->getX(node),
+                                  m_graph->getY(next) - m_graph->getY(node));
+            } else if (m_pathType == PathType::ANGULAR) {
+                step = node == m_origin || m_parent[node] == merge
+                           ? 0.0
+                           : VGAPointToPointPath::turnAngle(*m_graph, m_parent[node], node, next);
+            }
+            double cost = m_cost[node] + step;
+            if (cost >= m_cost[next]) {
+                continue;
+            }
+            m_cost[next] = cost;
+            m_parent[next] = node;
+            m_heap.push(std::max(key, cost), next);
+        }
+        return;
+    }
+}
+
+std::optional<VGAPathTree::Path> VGAPathTree::findPath(uint32_t to,
+                                                       std::chrono::microseconds budget) {
+    if (to >= m_graph->nodeCount()) {
+        return Path();
+    }
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    while (!m_settled[to] && !m_heap.empty()) {
+        for (size_t count = 0; count < CLOCK_INTERVAL && !m_settled[to] && !m_heap.empty();
+             count++) {
+            settleNext();
+        }
+        if (!m_settled[to] && std::chrono::steady_clock::now() >= deadline) {
+            return std::nullopt;
+        }
+    }
+
+    Path path;
+    path.settledCount = m_settledCount;
+    if (!m_settled[to]) {
+        return path;
+    }
+    for (uint32_t node = to; node != NO_NODE; node = m_parent[node]) {
+        path.nodes.push_back(node);
+    }
+    std::reverse(path.nodes.begin(), path.nodes.end());
+    for (uint32_t node : path.nodes) {
+        path.costs.push_back(m_cost[node]);
+    }
+    return path;
+}
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgapointtopointpath.hpp"
+#include "vgaradixheap.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Shortest paths from one cell to any other, searched only as far
+ * as the cells asked for
+ *
+ * The search from the origin is kept between queries and carries on from
+ * where it stopped, so a cell it has already settled is answered by
+ * walking back up the tree, and one further out only settles the cells in
+ * between. A query stops when its time runs out and can be asked again to
+ * carry on, so that it can be called while the mouse moves.
+ */
+class VGAPathTree {
+  public:
+    using PathType = VGAPointToPointPath::PathType;
+    using Graph = VGAPointToPointPath::Graph;
+    using Path = VGAPointToPointPath::Path;
+
+  private:
+    std::unique_ptr<const Graph> m_graph;
+    uint32_t m_origin;
+    PathType m_pathType;
+    std::vector<double> m_cost;
+    std::vector<uint32_t> m_parent;
+    std::vector<uint8_t> m_settled;
+    VGARadixHeap m_heap;
+    std::vector<uint32_t> m_neighbours;
+    size_t m_settledCount = 0;
+
+    void settleNext();
+
+  public:
+    VGAPathTree(std::unique_ptr<const Graph> graph, uint32_t origin, PathType pathType);
+
+    // the path from the origin, with no nodes if the cell cannot be
+    // reached, or nothing if the time ran out before the cell was settled
+    std::optional<Path> findPath(uint32_t to, std::chrono::microseconds budget);
+
+    const Graph &getGraph() const { return *m_graph; }
+    uint32_t getOrigin() const { return m_origin; }
+    PathType getPathType() const { return m_pathType; }
+    size_t getSettledCount() const { return m_settledCount; }
+    // every cell the origin reaches has been settled
+    bool isComplete() const { return m_heap.empty(); }
+};
@@ -0,0 +1,292 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgapointtopointpath.hpp"
+
+#include "vgaradixheap.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/pointmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+    constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+
+    struct Search {
+        uint32_t start;
+        std::vector<double> cost;
+        std::vector<uint32_t> parent;
+        std::vector<uint8_t> settled;
+        VGARadixHeap heap;
+
+        Search(size_t nodeCount, uint32_t start)
+            : start(start), cost(nodeCount, UNREACHED), parent(nodeCount, NO_NODE),
+              settled(nodeCount, 0) {
+            cost[start] = 0.0;
+            heap.push(0.0, start);
+        }
+    };
+} // namespace
+
+void VGAPointToPointPath::CSRGraphView::getNeighbours(uint32_t node,
+                                                      std::vector<uint32_t> &neighbours) const {
+    neighbours.clear();
+    for (uint32_t target : m_graph.neighbours(node)) {
+        neighbours.push_back(target);
+    }
+}
+
+VGAPointToPointPath::PointMapView::PointMapView(PointMap &map)
+    : m_map(map), m_rows(map.getRows()),
+      m_nodeCount(static_cast<size_t>(map.getCols()) * static_cast<size_t>(map.getRows())) {}
+
+void VGAPointToPointPath::PointMapView::getNeighbours(uint32_t node,
+                                                      std::vector<uint32_t> &neighbours) const {
+    neighbours.clear();
+    PixelRef pix = pixelOf(node);
+    Point &point = m_map.getPoint(pix);
+    if (!point.filled()) {
+        return;
+    }
+    m_hood.clear();
+    point.getNode().contents(m_hood);
+    for (PixelRef &connected : m_hood) {
+        if (connected != pix) {
+            neighbours.push_back(nodeOf(connected));
+        }
+    }
+}
+
+uint32_t VGAPointToPointPath::PointMapView::getMerge(uint32_t node) const {
+    const Point &point = m_map.getPoint(pixelOf(node));
+    if (!point.filled() || point.getMergePixel() == NoPixel) {
+        return VGACSRGraph::NO_MERGE;
+    }
+    return nodeOf(point.getMergePixel());
+}
+
+bool VGAPointToPointPath::PointMapView::hasMerges() const {
+    for (uint32_t node = 0; node < m_nodeCount; node++) {
+        if (getMerge(node) != VGACSRGraph::NO_MERGE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double VGAPointToPointPath::PointMapView::getX(uint32_t node) const {
+    return m_map.depixelate(pixelOf(node)).x;
+}
+
+double VGAPointToPointPath::PointMapView::getY(uint32_t node) const {
+    return m_map.depixelate(pixelOf(node)).y;
+}
+
+double VGAPointToPointPath::PointMapView::getMaxStep() const {
+    return std::hypot(m_map.getCols(), m_map.getRows()) * m_map.getSpacing();
+}
+
+double VGAPointToPointPath::turnAngle(const Graph &graph, uint32_t from, uint32_t via,
+                                      uint32_t to) {
+    double inX = graph.getX(via) - graph.getX(from), inY = graph.getY(via) - graph.getY(from);
+    double outX = graph.getX(to) - graph.getX(via), outY = graph.getY(to) - graph.getY(via);
+    return std::atan2(std::abs(inX * outY - inY * outX), inX * outX + inY * outY) / (M_PI * 0.5);
+}
+
+const std::string &VGAPointToPointPath::getColumn(PathType pathType) {
+    switch (pathType) {
+    case PathType::VISUAL:
+        return Column::VISUAL_POINT_TO_POINT_PATH;
+    case PathType::METRIC:
+        return Column::METRIC_POINT_TO_POINT_PATH;
+    case PathType::ANGULAR:
+        break;
+    }
+    return Column::ANGULAR_POINT_TO_POINT_PATH;
+}
+
+VGAPointToPointPath::Path VGAPointToPointPath::findPath(const Graph &graph, uint32_t from,
+                                                        uint32_t to, PathType pathType) {
+    Path path;
+    if (from == to) {
+        path.nodes.push_back(from);
+        path.costs.push_back(0.0);
+        return path;
+    }
+
+    double boundScale = 0.0;
+    if (graph.hasMerges()) {
+        // a merged pair is crossed at no cost, however far apart the two are
+    } else if (pathType == PathType::METRIC) {
+        boundScale = 1.0;
+    } else if (pathType == PathType::VISUAL && graph.getMaxStep() > 0.0) {
+        boundScale = 1.0 / graph.getMaxStep();
+    }
+    // leads the forward search, and the backward one by its negative
+    auto potential = [&](uint32_t node) {
+        if (boundScale == 0.0) {
+            return 0.0;
+        }
+        double x = graph.getX(node), y = graph.getY(node);
+        return 0.5 * boundScale *
+               (std::hypot(graph.getX(to) - x, graph.getY(to) - y) -
+                std::hypot(graph.getX(from) - x, graph.getY(from) - y));
+    };
+    double fromPotential = potential(from), toPotential = potential(to);
+
+    Search forward(graph.nodeCount(), from), backward(graph.nodeCount(), to);
+    // merged points are the same place, and going on from one is not a turn
+    auto stepCost = [&](const Search &search, uint32_t node, uint32_t next) {
+        uint32_t merge = graph.getMerge(node);
+        if (next == merge) {
+            return 0.0;
+        }
+        switch (pathType) {
+        case PathType::VISUAL:
+            return 1.0;
+        case PathType::METRIC:
+            return std::hypot(graph.getX(next) - graph.getX(node),
+                              graph.getY(next) - graph.getY(node));
+        case PathType::ANGULAR:
+            break;
+        }
+        return node == search.start || search.parent[node] == merge
+                   ? 0.0
+                   : turnAngle(graph, search.parent[node], node, next);
+    };
+    auto meetingCost = [&](uint32_t node) {
+        double cost = forward.cost[node] + backward.cost[node];
+        uint32_t merge = graph.getMerge(node);
+        if (pathType == PathType::ANGULAR && node != from && node != to &&
+            forward.parent[node] != merge && backward.parent[node] != merge) {
+            cost += turnAngle(graph, forward.parent[node], node, backward.parent[node]);
+        }
+        return cost;
+    };
+
+    double best = UNREACHED;
+    uint32_t meeting = NO_NODE;
+    std::vector<uint32_t> neighbours;
+    while (!forward.heap.empty() && !backward.heap.empty()) {
+        double forwardTop = forward.heap.top(), backwardTop = backward.heap.top();
+        // both keys are offset by the potentials, as is the best path
+        if (forwardTop + backwardTop >= best + toPotential - fromPotential) {
+            break;
+        }
+        bool isForward = forwardTop <= backwardTop;
+        Search &search = isForward ? forward : backward;
+        Search &other = isForward ? backward : forward;
+        double sign = isForward ? 1.0 : -1.0;
+        double offset = isForward ? -fromPotential : toPotential;
+
+        auto [key, node] = search.heap.pop();
+        if (search.settled[node]) {
+            continue;
+        }
+        search.settled[node] = 1;
+        path.settledCount++;
+        graph.getNeighbours(node, neighbours);
+        if (graph.getMerge(node) != VGACSRGraph::NO_MERGE) {
+            neighbours.push_back(graph.getMerge(node));
+        }
+        for (uint32_t next : neighbours) {
+            if (search.settled[next]) {
+                continue;
+            }
+            double cost = search.cost[node] + stepCost(search, node, next);
+            if (cost >= search.cost[next]) {
+                continue;
+            }
+            search.cost[next] = cost;
+            search.parent[next] = node;
+            // rounding may take the key a little below the one just popped
+            search.heap.push(std::max(key, cost + sign * potential(next) + offset), next);
+            if (other.cost[next] != UNREACHED && meetingCost(next) < best) {
+                best = meetingCost(next);
+                meeting = next;
+            }
+        }
+    }
+    if (meeting == NO_NODE) {
+        return path;
+    }
+
+    for (uint32_t node = meeting; node != NO_NODE; node = forward.parent[node]) {
+        path.nodes.push_back(node);
+    }
+    std::reverse(path.nodes.begin(), path.nodes.end());
+    for (uint32_t node = backward.parent[meeting]; node != NO_NODE; node = backward.parent[node]) {
+        path.nodes.push_back(node);
+    }
+    path.costs.push_back(0.0);
+    for (size_t step = 1; step < path.nodes.size(); step++) {
+        uint32_t node = path.nodes[step - 1], next = path.nodes[step];
+        uint32_t merge = graph.getMerge(node);
+        double cost = 1.0;
+        if (next == merge) {
+            cost = 0.0;
+        } else if (pathType == PathType::METRIC) {
+            cost = std::hypot(graph.getX(next) - graph.getX(node),
+                              graph.getY(next) - graph.getY(node));
+        } else if (pathType == PathType::ANGULAR) {
+            cost = step == 1 || path.nodes[step - 2] == merge
+                       ? 0.0
+                       : turnAngle(graph, path.nodes[step - 2], node, next);
+        }
+        path.costs.push_back(path.costs.back() + cost);
+    }
+    return path;
+}
+
+VGAPointToPointPath::Path VGAPointToPointPath::findPath(const VGACSRGraph &graph, uint32_t from,
+                                                        uint32_t to, PathType pathType) {
+    double maxStep = 0.0;
+    if (pathType == PathType::VISUAL) {
+        for (uint32_t node = 0; node < graph.nodeCount(); node++) {
+            for (uint32_t target : graph.neighbours(node)) {
+                maxStep = std::max(maxStep, std::hypot(graph.getX(target) - graph.getX(node),
+                                                       graph.getY(target) - graph.getY(node)));
+            }
+        }
+    }
+    return findPath(CSRGraphView(graph, maxStep), from, to, pathType);
+}
+
+AnalysisResult VGAPointToPointPath::run(Communicator *comm) {
+    if (!m_map.getPoint(m_from).filled() || !m_map.getPoint(m_to).filled()) {
+        throw genlib::RuntimeException("Both ends of the path need to be filled cells");
+    }
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("searching from both ends");
+    }
+    PointMapView graph(m_map);
+    auto path = findPath(graph, graph.nodeOf(m_from), graph.nodeOf(m_to), m_pathType);
+    if (telemetry) {
+        telemetry->addRecords(0, path.settledCount);
+    }
+    if (path.nodes.empty()) {
+        throw genlib::RuntimeException("There is no path between the cells");
+    }
+
+    AttributeTable &table = m_map.getAttributeTable();
+    const std::string &column = getColumn(m_pathType);
+    size_t pathCol = table.insertOrResetColumn(column);
+    for (size_t step = 0; step < path.nodes.size(); step++) {
+        table.getRow(AttributeKey(graph.pixelOf(path.nodes[step])))
+            .setValue(pathCol, static_cast<float>(path.costs[step]));
+    }
+
+    AnalysisResult result;
+    result.completed = true;
+    result.addAttribute(column);
+    return result;
+}
@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacsrgraph.hpp"
+
+#include "salalib/ianalysis.hpp"
+#include "salalib/pixelref.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class PointMap;
+
+/**
+ * @brief Shortest path between two cells, searched from both ends at once
+ *
+ * One search grows from each cell, always the one whose next cell is
+ * nearer, until no path through the cells still to be taken can be
+ * shorter than the best path met so far. Both are led towards the other
+ * end by half the difference of a lower bound on the cost to each end,
+ * which keeps the steps of either search from going below zero. The bound
+ * is the straight line distance for metric paths and that distance over the
+ * longest connection for visual paths. Angular paths, and paths on graphs
+ * with merged points, which are one place however far apart they are, have
+ * no useful bound and meet in the middle unled.
+ *
+ * The search only takes the connections of the cells it reaches, so on a
+ * map it does not need the whole graph first.
+ */
+class VGAPointToPointPath : public IAnalysis {
+  public:
+    enum class PathType { VISUAL, METRIC, ANGULAR };
+
+    struct Column {
+        inline static const std::string                                   //
+            VISUAL_POINT_TO_POINT_PATH = "Visual Point-to-Point Path",   //
+            METRIC_POINT_TO_POINT_PATH = "Metric Point-to-Point Path",   //
+            ANGULAR_POINT_TO_POINT_PATH = "Angular Point-to-Point Path"; //
+    };
+    static const std::string &getColumn(PathType pathType);
+
+    // what the search needs to know of the cells it reaches
+    class Graph {
+      public:
+        virtual ~Graph() = default;
+        virtual size_t nodeCount() const = 0;
+        virtual void getNeighbours(uint32_t node, std::vector<uint32_t> &neighbours) const = 0;
+        virtual double getX(uint32_t node) const = 0;
+        virtual double getY(uint32_t node) const = 0;
+        // no connection is longer than this
+        virtual double getMaxStep() const = 0;
+        // the node merged with the given one, taken at no cost
+        virtual uint32_t getMerge(uint32_t node) const = 0;
+        virtual bool hasMerges() const = 0;
+    };
+
+    class CSRGraphView : public Graph {
+        const VGACSRGraph &m_graph;
+        double m_maxStep;
+
+      public:
+        CSRGraphView(const VGACSRGraph &graph, double maxStep)
+            : m_graph(graph), m_maxStep(maxStep) {}
+        size_t nodeCount() const override { return m_graph.nodeCount(); }
+        void getNeighbours(uint32_t node, std::vector<uint32_t> &neighbours) const override;
+        double getX(uint32_t node) const override { return m_graph.getX(node); }
+        double getY(uint32_t node) const override { return m_graph.getY(node); }
+        double getMaxStep() const override { return m_maxStep; }
+        uint32_t getMerge(uint32_t node) const override { return m_graph.getMerge(node); }
+        bool hasMerges() const override { return m_graph.hasMerges(); }
+    };
+
+    // the cells of the map by column then row, empty ones having no
+    // connections
+    class PointMapView : public Graph {
+        PointMap &m_map;
+        int m_rows;
+        size_t m_nodeCount;
+        mutable PixelRefVector m_hood;
+
+      public:
+        explicit PointMapView(PointMap &map);
+        uint32_t nodeOf(PixelRef pix) const {
+            return static_cast<uint32_t>(pix.x) * static_cast<uint32_t>(m_rows) +
+                   static_cast<uint32_t>(pix.y);
+        }
+        PixelRef pixelOf(uint32_t node) const {
+            return PixelRef(static_cast<short>(node / static_cast<uint32_t>(m_rows)),
+                            static_cast<short>(node % static_cast<uint32_t>(m_rows)));
+        }
+        size_t nodeCount() const override { return m_nodeCount; }
+        void getNeighbours(uint32_t node, std::vector<uint32_t> &neighbours) const override;
+        double getX(uint32_t node) const override;
+        double getY(uint32_t node) const override;
+        double getMaxStep() const override;
+        uint32_t getMerge(uint32_t node) const override;
+        // looks through the cells once, without taking their connections
+        bool hasMerges() const override;
+    };
+
+    struct Path {
+        // from the first cell to the last, empty if they are not connected
+        std::vector<uint32_t> nodes;
+        // the cost up to each of the nodes, in steps, distance or turns with
+        // a right angle counting as 1
+        std::vector<double> costs;
+        // cells taken by either search
+        size_t settledCount = 0;
+    };
+
+  private:
+    PointMap &m_map;
+    PixelRef m_from;
+    PixelRef m_to;
+    PathType m_pathType;
+
+  public:
+    VGAPointToPointPath(PointMap &map, PixelRef from, PixelRef to, PathType pathType)
+        : m_map(map), m_from(from), m_to(to), m_pathType(pathType) {}
+    std::string getAnalysisName() const override { return "Point-to-Point Shortest Path"; }
+    AnalysisResult run(Communicator *comm) override;
+
+    // the turn from the step into the middle node to the step out, a right
+    // angle counting as 1
+    static double turnAngle(const Graph &graph, uint32_t from, uint32_t via, uint32_t to);
+
+    static Path findPath(const Graph &graph, uint32_t from, uint32_t to, PathType pathType);
+    static Path findPath(const VGACSRGraph &graph, uint32_t from, uint32_t to,
+                         PathType pathType);
+};
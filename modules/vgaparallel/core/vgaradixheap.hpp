@@ -0,0 +1,128 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "salalib/genlib/exceptions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Priority queue for searches whose keys never go below the last one
+ * taken out
+ *
+ * Entries are kept in buckets by the highest bit in which their key differs
+ * from the last key taken out. Taking out from an empty lowest bucket moves
+ * the entries of the next bucket down, each entry moving at most once per
+ * bit, so pushing and popping take constant time on average where a binary
+ * heap needs a logarithm of its size. The keys are non-negative doubles,
+ * which sort the same way as their bits read as integers. That is the case
+ * for shortest paths over non-negative lengths.
+ */
+class VGARadixHeap {
+    static constexpr size_t BUCKET_COUNT = 65;
+    std::array<std::vector<std::pair<uint64_t, uint32_t>>, BUCKET_COUNT> m_buckets;
+    uint64_t m_last = 0;
+    size_t m_size = 0;
+
+    static uint64_t keyOf(double value) {
+        uint64_t key;
+        std::memcpy(&key, &value, sizeof(key));
+        return key;
+    }
+    static double valueOf(uint64_t key) {
+        double value;
+        std::memcpy(&value, &key, sizeof(value));
+        return value;
+    }
+    size_t bucketOf(uint64_t key) const {
+        uint64_t difference = key ^ m_last;
+        if (difference == 0) {
+            return 0;
+        }
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, difference);
+        return static_cast<size_t>(index) + 1;
+#else
+        return static_cast<size_t>(64 - __builtin_clzll(difference));
+#endif
+    }
+
+    // brings the smallest keys down to the lowest bucket, if it is empty.
+    // False when there is nothing to bring down
+    bool refill() {
+        if (!m_buckets[0].empty()) {
+            return true;
+        }
+        if (m_size == 0) {
+            return false;
+        }
+        size_t bucket = 1;
+        while (m_buckets[bucket].empty()) {
+            bucket++;
+        }
+        auto &entries = m_buckets[bucket];
+        uint64_t smallest = entries.front().first;
+        for (auto &entry : entries) {
+            smallest = std::min(smallest, entry.first);
+        }
+        // every entry differs from the new last key in a lower bit
+        m_last = smallest;
+        for (auto &entry : entries) {
+            m_buckets[bucketOf(entry.first)].push_back(entry);
+        }
+        entries.clear();
+        return true;
+    }
+
+  public:
+    bool empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+    // the distance must not be below the one last popped
+    void push(double distance, uint32_t node) {
+        uint64_t key = keyOf(distance);
+        m_buckets[bucketOf(key)].emplace_back(key, node);
+        m_size++;
+    }
+
+    // the distance that would be popped next, without popping it, infinity
+    // when the queue is empty. Later pushes must not be below it
+    double top() {
+        if (!refill()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return valueOf(m_last);
+    }
+
+    std::pair<double, uint32_t> pop() {
+        if (!refill()) {
+            throw genlib::RuntimeException("Nothing left to pop from the queue");
+        }
+        auto entry = m_buckets[0].back();
+        m_buckets[0].pop_back();
+        m_size--;
+        return {valueOf(entry.first), entry.second};
+    }
+
+    // empties the queue for a new search starting from zero
+    void clear() {
+        for (auto &bucket : m_buckets) {
+            bucket.clear();
+        }
+        m_last = 0;
+        m_size = 0;
+    }
+};
@@ -0,0 +1,248 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgashard.hpp"
+
+#include "vgacsrgraph.hpp"
+#include "vgametricglobalresumable.hpp"
+#include "vgasourcesweep.hpp"
+#include "vgavisualglobalresumable.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    const std::string manifestHeader = "depthmapX vga shard 1";
+    const std::string graphFilename = "graph.vgagraph";
+
+    const char *getAnalysisName(VGAShard::Analysis analysis) {
+        switch (analysis) {
+        case VGAShard::Analysis::VISUAL_GLOBAL:
+            return "visual-global";
+        case VGAShard::Analysis::METRIC_GLOBAL:
+            return "metric-global";
+        }
+        return "";
+    }
+
+    std::vector<int> getVisualRadii(const std::vector<double> &radii) {
+        std::vector<int> visualRadii;
+        for (double radius : radii) {
+            visualRadii.push_back(static_cast<int>(radius));
+        }
+        return VGAVisualGlobalResumable::sortRadii(std::move(visualRadii));
+    }
+
+    double getMetricRadius(const std::vector<double> &radii) {
+        if (radii.size() != 1) {
+            throw genlib::RuntimeException("Metric shards take exactly one radius");
+        }
+        return radii.front();
+    }
+
+    std::string inFolderOf(const std::string &manifestFile, const std::string &filename) {
+        return (std::filesystem::path(manifestFile).parent_path() / filename).string();
+    }
+} // namespace
+
+void VGAShard::Manifest::save(const std::string &filename) const {
+    std::ofstream stream(filename, std::ios::trunc);
+    if (!stream) {
+        throw genlib::RuntimeException("Unable to write shard manifest " + filename);
+    }
+    // enough digits for the radii to read back exactly
+    stream.precision(17);
+    stream << manifestHeader << "\n";
+    stream << "analysis " << getAnalysisName(analysis) << "\n";
+    stream << "radii";
+    for (double radius : radii) {
+        stream << " " << radius;
+    }
+    stream << "\n";
+    stream << "graph " << graphFile << "\n";
+    stream << "sources " << firstSource << " " << lastSource << "\n";
+    stream << "output " << outputFile << "\n";
+    if (!stream) {
+        throw genlib::RuntimeException("Unable to write shard manifest " + filename);
+    }
+}
+
+std::optional<VGAShard::Manifest> VGAShard::Manifest::load(const std::string &filename) {
+    std::ifstream stream(filename);
+    std::string line;
+    if (!std::getline(stream, line) || line != manifestHeader) {
+        return std::nullopt;
+    }
+    Manifest manifest;
+    bool hasAnalysis = false, hasSources = false;
+    while (std::getline(stream, line)) {
+        std::istringstream values(line);
+        std::string name;
+        values >> name;
+        if (name == "analysis") {
+            std::string analysis;
+            values >> analysis;
+            for (auto candidate : {Analysis::VISUAL_GLOBAL, Analysis::METRIC_GLOBAL}) {
+                if (analysis == getAnalysisName(candidate)) {
+                    manifest.analysis = candidate;
+                    hasAnalysis = true;
+                }
+            }
+        } else if (name == "radii") {
+            double radius;
+            while (values >> radius) {
+                manifest.radii.push_back(radius);
+            }
+        } else if (name == "graph") {
+            values >> manifest.graphFile;
+        } else if (name == "sources") {
+            hasSources = static_cast<bool>(values >> manifest.firstSource >> manifest.lastSource);
+        } else if (name == "output") {
+            values >> manifest.outputFile;
+        }
+    }
+    if (!hasAnalysis || !hasSources || manifest.radii.empty() || manifest.graphFile.empty() ||
+        manifest.outputFile.empty() || manifest.firstSource > manifest.lastSource) {
+        return std::nullopt;
+    }
+    return manifest;
+}
+
+std::string VGAShard::getAnalysisKey(Analysis analysis, const std::vector<double> &radii) {
+    switch (analysis) {
+    case Analysis::VISUAL_GLOBAL:
+        return VGAVisualGlobalResumable::getAnalysisKey(getVisualRadii(radii));
+    case Analysis::METRIC_GLOBAL:
+        return VGAMetricGlobalResumable::getAnalysisKey(getMetricRadius(radii));
+    }
+    return "";
+}
+
+std::vector<std::string> VGAShard::prepare(const VGACSRGraph &graph, Analysis analysis,
+                                           const std::vector<double> &radii, size_t shardCount,
+                                           const std::string &folder) {
+    std::filesystem::create_directories(folder);
+    // manifests of an earlier split would be merged along with these
+    for (auto &manifestFile : findManifests(folder)) {
+        std::filesystem::remove(manifestFile);
+    }
+    graph.save((std::filesystem::path(folder) / graphFilename).string());
+
+    size_t sourceCount = graph.nodeCount();
+    shardCount = std::max<size_t>(1, std::min(shardCount, sourceCount));
+    std::vector<std::string> manifestFiles;
+    for (size_t shard = 0; shard < shardCount; shard++) {
+        Manifest manifest;
+        manifest.analysis = analysis;
+        manifest.radii = radii;
+        manifest.graphFile = graphFilename;
+        manifest.firstSource = sourceCount * shard / shardCount;
+        manifest.lastSource = sourceCount * (shard + 1) / shardCount;
+        std::string name = "shard" + std::to_string(shard);
+        manifest.outputFile = name + ".result";
+        std::string manifestFile =
+            (std::filesystem::path(folder) / (name + MANIFEST_EXTENSION)).string();
+        manifest.save(manifestFile);
+        manifestFiles.push_back(manifestFile);
+    }
+    return manifestFiles;
+}
+
+std::vector<std::string> VGAShard::findManifests(const std::string &folder) {
+    std::vector<std::string> manifestFiles;
+    std::error_code error;
+    for (auto &entry : std::filesystem::directory_iterator(folder, error)) {
+        if (entry.path().extension() == MANIFEST_EXTENSION) {
+            manifestFiles.push_back(entry.path().string());
+        }
+    }
+    std::sort(manifestFiles.begin(), manifestFiles.end());
+    return manifestFiles;
+}
+
+void VGAShard::run(const std::string &manifestFile, Communicator *comm) {
+    auto manifest = Manifest::load(manifestFile);
+    if (!manifest) {
+        throw genlib::RuntimeException("Unable to read shard manifest " + manifestFile);
+    }
+    auto graph = VGACSRGraph::load(inFolderOf(manifestFile, manifest->graphFile));
+    if (!graph) {
+        throw genlib::RuntimeException("Unable to read the graph of shard " + manifestFile);
+    }
+    std::string analysisKey = getAnalysisKey(manifest->analysis, manifest->radii);
+    std::string outputFile = inFolderOf(manifestFile, manifest->outputFile);
+
+    auto checkpoint = VGACheckpoint::load(outputFile);
+    if (checkpoint &&
+        !checkpoint->matches(analysisKey, graph->getSignature(), graph->nodeCount())) {
+        checkpoint.reset();
+    }
+    if (!checkpoint) {
+        checkpoint.emplace(analysisKey, graph->getSignature(), graph->nodeCount());
+    }
+
+    VGASourceSweep sweep(*checkpoint, outputFile);
+    sweep.setSourceRange(manifest->firstSource, manifest->lastSource);
+    switch (manifest->analysis) {
+    case Analysis::VISUAL_GLOBAL:
+        VGAVisualGlobalResumable::analyseGraph(*graph, getVisualRadii(manifest->radii), sweep,
+                                               comm);
+        break;
+    case Analysis::METRIC_GLOBAL:
+        VGAMetricGlobalResumable::analyseGraph(*graph, getMetricRadius(manifest->radii), sweep,
+                                               comm);
+        break;
+    }
+    checkpoint->save(outputFile);
+}
+
+VGACheckpoint VGAShard::merge(const std::vector<std::string> &manifestFiles) {
+    if (manifestFiles.empty()) {
+        throw genlib::RuntimeException("No shards to merge");
+    }
+    std::optional<VGACheckpoint> merged;
+    for (auto &manifestFile : manifestFiles) {
+        auto manifest = Manifest::load(manifestFile);
+        if (!manifest) {
+            throw genlib::RuntimeException("Unable to read shard manifest " + manifestFile);
+        }
+        auto partial = VGACheckpoint::load(inFolderOf(manifestFile, manifest->outputFile));
+        if (!partial) {
+            throw genlib::RuntimeException("Shard " + manifestFile + " has no results");
+        }
+        if (!merged) {
+            merged.emplace(partial->getAnalysisKey(), partial->getGraphSignature(),
+                           partial->getSourceCount());
+        }
+        if (!partial->matches(merged->getAnalysisKey(), merged->getGraphSignature(),
+                              merged->getSourceCount()) ||
+            partial->getAnalysisKey() != getAnalysisKey(manifest->analysis, manifest->radii) ||
+            manifest->lastSource > partial->getSourceCount()) {
+            throw genlib::RuntimeException("Shard " + manifestFile +
+                                           " belongs to a different analysis or graph");
+        }
+        for (size_t source = manifest->firstSource; source < manifest->lastSource; source++) {
+            if (!partial->isDone(source)) {
+                throw genlib::RuntimeException("Shard " + manifestFile + " is not complete");
+            }
+        }
+        for (auto &column : partial->getColumns()) {
+            std::vector<float> &mergedColumn = merged->getColumn(column.first);
+            std::copy(column.second.begin() + static_cast<std::ptrdiff_t>(manifest->firstSource),
+                      column.second.begin() + static_cast<std::ptrdiff_t>(manifest->lastSource),
+                      mergedColumn.begin() + static_cast<std::ptrdiff_t>(manifest->firstSource));
+        }
+        for (size_t source = manifest->firstSource; source < manifest->lastSource; source++) {
+            merged->markDone(source);
+        }
+    }
+    if (merged->getDoneCount() != merged->getSourceCount()) {
+        throw genlib::RuntimeException("The shards do not cover all the sources");
+    }
+    return std::move(*merged);
+}
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacheckpoint.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+class Communicator;
+class VGACSRGraph;
+
+/**
+ * @brief A global analysis split into shards that run as separate processes
+ *
+ * A shard folder holds the graph and one manifest per shard, each naming a
+ * range of sources and the file the shard writes its results to. The shards
+ * may run on this machine or have the folder copied to others. The results
+ * are checkpoints, so a shard that is stopped resumes when run again, and
+ * since every value depends only on its own source the merged result is the
+ * same as that of a single run.
+ */
+class VGAShard {
+  public:
+    enum class Analysis { VISUAL_GLOBAL, METRIC_GLOBAL };
+
+    struct Manifest {
+        Analysis analysis = Analysis::VISUAL_GLOBAL;
+        // visual radii are whole steps, -1 is the whole graph
+        std::vector<double> radii;
+        // files are relative to the folder of the manifest
+        std::string graphFile;
+        std::string outputFile;
+        size_t firstSource = 0;
+        size_t lastSource = 0;
+
+        void save(const std::string &filename) const;
+        // returns nothing if the file does not exist or is not a manifest
+        static std::optional<Manifest> load(const std::string &filename);
+    };
+
+    inline static const std::string MANIFEST_EXTENSION = ".vgashard";
+
+    // the key of the checkpoints the shards of the analysis write
+    static std::string getAnalysisKey(Analysis analysis, const std::vector<double> &radii);
+
+    // writes the graph and the manifests to the folder, returns the manifests.
+    // Results already in the folder are kept, for the shards to continue from
+    static std::vector<std::string> prepare(const VGACSRGraph &graph, Analysis analysis,
+                                            const std::vector<double> &radii, size_t shardCount,
+                                            const std::string &folder);
+    // the manifests of a shard folder, in order
+    static std::vector<std::string> findManifests(const std::string &folder);
+    // runs the sources of one shard, continuing from its output if there is one
+    static void run(const std::string &manifestFile, Communicator *comm);
+    // combines the outputs of all the shards into one checkpoint with every
+    // source done. Throws if any output is missing, incomplete or does not
+    // belong to the same analysis and graph as the rest
+    static VGACheckpoint merge(const std::vector<std::string> &manifestFiles);
+};
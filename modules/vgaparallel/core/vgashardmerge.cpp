@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgashardmerge.hpp"
+
+#include "vgacsrgraph.hpp"
+#include "vgashard.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+
+AnalysisResult VGAShardMerge::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("merging shards");
+    }
+    auto manifestFiles = VGAShard::findManifests(m_folder);
+    if (manifestFiles.empty()) {
+        throw genlib::RuntimeException("No shards found in " + m_folder);
+    }
+    VGACheckpoint merged = VGAShard::merge(manifestFiles);
+
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(m_map);
+    if (!merged.matches(merged.getAnalysisKey(), graph.getSignature(), graph.nodeCount())) {
+        throw genlib::RuntimeException("The shards in " + m_folder +
+                                       " were prepared from a different map");
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    AnalysisResult result;
+    for (auto &column : merged.getColumns()) {
+        graph.copyColumnToMap(m_map, column.first, column.second);
+        result.addAttribute(column.first);
+    }
+    result.completed = true;
+    return result;
+}
@@ -0,0 +1,28 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+
+class PointMap;
+
+/**
+ * @brief Writes the merged results of a shard folder to the map
+ *
+ * The shards must have been prepared from this map; results of a map that has
+ * changed since are refused.
+ */
+class VGAShardMerge : public IAnalysis {
+  private:
+    PointMap &m_map;
+    std::string m_folder;
+
+  public:
+    VGAShardMerge(PointMap &map, std::string folder) : m_map(map), m_folder(std::move(folder)) {}
+    std::string getAnalysisName() const override { return "Merge Shard Results"; }
+    AnalysisResult run(Communicator *comm) override;
+};
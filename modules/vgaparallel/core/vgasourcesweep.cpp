@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgasourcesweep.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+
+#include <algorithm>
+
+VGASourceSweep::VGASourceSweep(VGACheckpoint &checkpoint, std::string checkpointFile,
+                               std::chrono::seconds saveInterval)
+    : m_checkpoint(checkpoint), m_checkpointFile(std::move(checkpointFile)),
+      m_saveInterval(saveInterval) {}
+
+void VGASourceSweep::saveCheckpoint() const {
+    if (!m_checkpointFile.empty()) {
+        m_checkpoint.save(m_checkpointFile);
+    }
+}
+
+void VGASourceSweep::run(Communicator *comm, const SourceFunc &func) {
+    size_t firstSource = std::min(m_firstSource, m_checkpoint.getSourceCount());
+    size_t lastSource = std::min(m_lastSource, m_checkpoint.getSourceCount());
+    size_t sourceCount = lastSource - std::min(firstSource, lastSource);
+    std::vector<size_t> remaining;
+    for (size_t source = firstSource; source < lastSource; source++) {
+        if (!m_checkpoint.isDone(source)) {
+            remaining.push_back(source);
+        }
+    }
+    size_t alreadyDone = sourceCount - remaining.size();
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, sourceCount);
+        comm->CommPostMessage(Communicator::CURRENT_RECORD, alreadyDone);
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+
+    auto lastSave = std::chrono::steady_clock::now();
+    for (size_t blockStart = 0; blockStart < remaining.size(); blockStart += m_blockSize) {
+        size_t blockSize = std::min(m_blockSize, remaining.size() - blockStart);
+
+        parallelFor(blockSize, 4, [&](size_t i, int thread) {
+            size_t source = remaining[blockStart + i];
+            func(source, thread);
+            m_checkpoint.markDone(source);
+            if (telemetry) {
+                telemetry->addRecords(static_cast<size_t>(thread));
+            }
+        });
+
+        if (comm) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD,
+                                  alreadyDone + blockStart + blockSize);
+            if (comm->IsCancelled()) {
+                saveCheckpoint();
+                throw Communicator::CancelledException();
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastSave >= m_saveInterval) {
+            saveCheckpoint();
+            lastSave = now;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacheckpoint.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+class Communicator;
+
+/**
+ * @brief Runs a per-source computation over all the sources of a checkpoint
+ *
+ * Sources already completed in the checkpoint are skipped. The rest are run
+ * in parallel in blocks; between blocks the progress is reported, the
+ * checkpoint is saved every saveInterval and cancellation is checked. A
+ * cancelled sweep saves the checkpoint before throwing, so that it can be
+ * resumed.
+ */
+class VGASourceSweep {
+  public:
+    // called concurrently for different sources, thread is in [0, getMaxThreads())
+    using SourceFunc = std::function<void(size_t source, int thread)>;
+
+  private:
+    VGACheckpoint &m_checkpoint;
+    std::string m_checkpointFile;
+    std::chrono::seconds m_saveInterval;
+    size_t m_blockSize = 1024;
+    size_t m_firstSource = 0;
+    size_t m_lastSource = static_cast<size_t>(-1);
+
+    void saveCheckpoint() const;
+
+  public:
+    // an empty checkpointFile keeps the checkpoint in memory only
+    VGASourceSweep(VGACheckpoint &checkpoint, std::string checkpointFile,
+                   std::chrono::seconds saveInterval = std::chrono::seconds(60));
+
+    VGACheckpoint &getCheckpoint() { return m_checkpoint; }
+    void setBlockSize(size_t blockSize) { m_blockSize = blockSize; }
+    // only runs the sources in [firstSource, lastSource), for shards of an
+    // analysis that run separately
+    void setSourceRange(size_t firstSource, size_t lastSource) {
+        m_firstSource = firstSource;
+        m_lastSource = lastSource;
+    }
+    void run(Communicator *comm, const SourceFunc &func);
+};
@@ -0,0 +1,246 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgavisualglobalbitparallel.hpp"
+
+#include "vgacsrgraph.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+    constexpr size_t WORD_BITS = 64;
+    constexpr size_t WORD_COUNT = VGAVisualGlobalBitParallel::BATCH_SIZE / WORD_BITS;
+
+    // one bit per source of the batch, the fixed size lets the compiler
+    // turn the loops below into vector instructions
+    struct SourceSet {
+        std::array<uint64_t, WORD_COUNT> words;
+
+        void clear() { words.fill(0); }
+        void set(size_t bit) { words[bit / WORD_BITS] |= uint64_t(1) << (bit % WORD_BITS); }
+        void add(const SourceSet &other) {
+            for (size_t w = 0; w < WORD_COUNT; w++) {
+                words[w] |= other.words[w];
+            }
+        }
+        void remove(const SourceSet &other) {
+            for (size_t w = 0; w < WORD_COUNT; w++) {
+                words[w] &= ~other.words[w];
+            }
+        }
+        bool contains(const SourceSet &other) const {
+            uint64_t missing = 0;
+            for (size_t w = 0; w < WORD_COUNT; w++) {
+                missing |= other.words[w] & ~words[w];
+            }
+            return missing == 0;
+        }
+        bool empty() const {
+            uint64_t any = 0;
+            for (size_t w = 0; w < WORD_COUNT; w++) {
+                any |= words[w];
+            }
+            return any == 0;
+        }
+    };
+
+    size_t countTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return index;
+#else
+        return static_cast<size_t>(__builtin_ctzll(word));
+#endif
+    }
+
+    // the sources of a batch that have seen, visit and will next visit each
+    // node
+    struct Batch {
+        std::vector<SourceSet> seen;
+        std::vector<SourceSet> visit;
+        std::vector<SourceSet> next;
+        std::array<std::vector<int>, VGAVisualGlobalBitParallel::BATCH_SIZE> distribution;
+        std::array<int, VGAVisualGlobalBitParallel::BATCH_SIZE> levelCount;
+    };
+} // namespace
+
+std::vector<VGAVisualMeasures> VGAVisualGlobalBitParallel::analyseGraph(const VGACSRGraph &graph,
+                                                                        int radius,
+                                                                        Communicator *comm) {
+    size_t nodeCount = graph.nodeCount();
+    std::vector<VGAVisualMeasures> measures(nodeCount);
+    if (nodeCount == 0) {
+        return measures;
+    }
+
+    std::vector<Batch> batches(static_cast<size_t>(getMaxThreads()));
+    for (auto &batch : batches) {
+        batch.seen.resize(nodeCount);
+        batch.visit.resize(nodeCount);
+        batch.next.resize(nodeCount);
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    size_t batchCount = (nodeCount + BATCH_SIZE - 1) / BATCH_SIZE;
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, nodeCount);
+    }
+    std::atomic<size_t> sourcesDone(0);
+    std::atomic<bool> cancelled(false);
+
+    parallelFor(batchCount, 1, [&](size_t batchIdx, int thread) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Batch &batch = batches[static_cast<size_t>(thread)];
+        size_t firstSource = batchIdx * BATCH_SIZE;
+        size_t sourceCount = std::min(BATCH_SIZE, nodeCount - firstSource);
+
+        SourceSet allSources;
+        allSources.clear();
+        for (size_t node = 0; node < nodeCount; node++) {
+            batch.seen[node].clear();
+            batch.visit[node].clear();
+        }
+        for (size_t i = 0; i < sourceCount; i++) {
+            allSources.set(i);
+            batch.seen[firstSource + i].set(i);
+            batch.visit[firstSource + i].set(i);
+            uint32_t merge = graph.getMerge(firstSource + i);
+            if (merge != VGACSRGraph::NO_MERGE) {
+                batch.seen[merge].set(i);
+                batch.visit[merge].set(i);
+            }
+            batch.distribution[i].assign(1, 1);
+        }
+
+        for (int depth = 1; radius == -1 || depth <= radius; depth++) {
+            batch.levelCount.fill(0);
+            bool reachedAny = false;
+            // the graph is undirected, so every node collects the sources
+            // that reach it from its neighbours without writing to them
+            for (size_t node = 0; node < nodeCount; node++) {
+                // a merged pair is one place, taken with the first of the two
+                uint32_t merge = graph.getMerge(node);
+                if (merge < node) {
+                    continue;
+                }
+                SourceSet &reached = batch.next[node];
+                reached.clear();
+                if (merge != VGACSRGraph::NO_MERGE) {
+                    batch.next[merge].clear();
+                }
+                SourceSet &seen = batch.seen[node];
+                if (seen.contains(allSources)) {
+                    continue;
+                }
+                for (uint32_t connected : graph.neighbours(node)) {
+                    reached.add(batch.visit[connected]);
+                }
+                if (merge != VGACSRGraph::NO_MERGE) {
+                    for (uint32_t connected : graph.neighbours(merge)) {
+                        reached.add(batch.visit[connected]);
+                    }
+                }
+                reached.remove(seen);
+                if (reached.empty()) {
+                    continue;
+                }
+                seen.add(reached);
+                if (merge != VGACSRGraph::NO_MERGE) {
+                    batch.seen[merge] = seen;
+                    batch.next[merge] = reached;
+                }
+                reachedAny = true;
+                for (size_t w = 0; w < WORD_COUNT; w++) {
+                    for (uint64_t bits = reached.words[w]; bits != 0; bits &= bits - 1) {
+                        batch.levelCount[w * WORD_BITS + countTrailingZeros(bits)]++;
+                    }
+                }
+            }
+            if (!reachedAny) {
+                break;
+            }
+            std::swap(batch.visit, batch.next);
+            // depths are contiguous, a source that reached nothing now is done
+            for (size_t i = 0; i < sourceCount; i++) {
+                if (batch.levelCount[i] != 0) {
+                    batch.distribution[i].push_back(batch.levelCount[i]);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < sourceCount; i++) {
+            measures[firstSource + i] = VGAVisualMeasures::fromDistribution(
+                batch.distribution[i].data(), batch.distribution[i].size());
+        }
+
+        if (telemetry) {
+            telemetry->addRecords(static_cast<size_t>(thread), sourceCount);
+        }
+        size_t done = sourcesDone.fetch_add(sourceCount) + sourceCount;
+        if (comm) {
+            if (thread == 0) {
+                comm->CommPostMessage(Communicator::CURRENT_RECORD, done);
+            }
+            if (comm->IsCancelled()) {
+                cancelled = true;
+            }
+        }
+    });
+
+    if (cancelled) {
+        throw Communicator::CancelledException();
+    }
+    return measures;
+}
+
+AnalysisResult VGAVisualGlobalBitParallel::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(m_map, m_graphStorage);
+
+    if (telemetry) {
+        telemetry->setPhase("traversing");
+    }
+    auto measures = analyseGraph(graph, m_radius, comm);
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    size_t nodeCount = graph.nodeCount();
+    std::vector<float> values(nodeCount);
+    auto writeColumn = [&](const std::string &column, float VGAVisualMeasures::*measure) {
+        for (size_t node = 0; node < nodeCount; node++) {
+            values[node] = measures[node].*measure;
+        }
+        graph.copyColumnToMap(m_map, getColumnWithRadius(column, m_radius), values);
+    };
+    writeColumn(Column::VISUAL_ENTROPY, &VGAVisualMeasures::entropy);
+    writeColumn(Column::VISUAL_INTEGRATION_HH, &VGAVisualMeasures::integHH);
+    writeColumn(Column::VISUAL_INTEGRATION_PV, &VGAVisualMeasures::integPV);
+    writeColumn(Column::VISUAL_INTEGRATION_TK, &VGAVisualMeasures::integTK);
+    writeColumn(Column::VISUAL_MEAN_DEPTH, &VGAVisualMeasures::meanDepth);
+    writeColumn(Column::VISUAL_NODE_COUNT, &VGAVisualMeasures::nodeCount);
+    writeColumn(Column::VISUAL_REL_ENTROPY, &VGAVisualMeasures::relEntropy);
+
+    AnalysisResult result;
+    result.completed = true;
+    return result;
+}
@@ -0,0 +1,52 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacolumns.hpp"
+#include "vgacsrgraph.hpp"
+#include "vgavisualmeasures.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+#include <vector>
+
+class PointMap;
+
+/**
+ * @brief Global visibility analysis running many sources in one traversal
+ *
+ * Each node carries one bit per source for the sources that have seen it
+ * and those that reached it last, and a level of the search ORs together
+ * the bits of the neighbours of every node. A batch of BATCH_SIZE sources
+ * is thus traversed at the cost of a single breadth-first search, which
+ * pays off on dense graphs where every node sees thousands of others.
+ * Produces the same columns as the global visibility analysis of salalib.
+ */
+class VGAVisualGlobalBitParallel : public IAnalysis {
+  public:
+    static constexpr size_t BATCH_SIZE = 256;
+
+  private:
+    PointMap &m_map;
+    int m_radius;
+    VGACSRGraph::Storage m_graphStorage = VGACSRGraph::Storage::PLAIN;
+
+  public:
+    using Column = VGAVisualGlobalColumn;
+
+  public:
+    // a radius of -1 is the whole graph
+    VGAVisualGlobalBitParallel(PointMap &map, int radius) : m_map(map), m_radius(radius) {}
+    std::string getAnalysisName() const override {
+        return "Global Visibility Analysis (Bit-parallel)";
+    }
+    void setGraphStorage(VGACSRGraph::Storage graphStorage) { m_graphStorage = graphStorage; }
+    AnalysisResult run(Communicator *comm) override;
+
+    // the measures of every node of the graph, in node order
+    static std::vector<VGAVisualMeasures> analyseGraph(const VGACSRGraph &graph, int radius,
+                                                       Communicator *comm);
+};
@@ -0,0 +1,184 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgavisualglobalresumable.hpp"
+
+#include "vgacsrgraph.hpp"
+#include "vgasourcesweep.hpp"
+#include "vgavisualmeasures.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // a breadth-first search, visitedBy holds the mark of the last source
+    // that reached the node so it never has to be cleared
+    struct Traversal {
+        std::vector<uint32_t> visitedBy;
+        std::vector<uint32_t> frontier;
+        std::vector<uint32_t> nextFrontier;
+        std::vector<int> distribution;
+    };
+
+    // the columns of one radius, kept in the checkpoint
+    struct RadiusColumns {
+        int radius;
+        std::vector<float> *meanDepth;
+        std::vector<float> *nodeCount;
+        std::vector<float> *integHH;
+        std::vector<float> *integPV;
+        std::vector<float> *integTK;
+        std::vector<float> *entropy;
+        std::vector<float> *relEntropy;
+    };
+} // namespace
+
+VGAVisualGlobalResumable::VGAVisualGlobalResumable(PointMap &map, std::vector<int> radii)
+    : m_map(map), m_radii(sortRadii(std::move(radii))) {}
+
+std::vector<int> VGAVisualGlobalResumable::sortRadii(std::vector<int> radii) {
+    // the whole graph goes last, after the radii in increasing order
+    std::sort(radii.begin(), radii.end(), [](int a, int b) {
+        return (a == -1 ? std::numeric_limits<int>::max() : a) <
+               (b == -1 ? std::numeric_limits<int>::max() : b);
+    });
+    radii.erase(std::unique(radii.begin(), radii.end()), radii.end());
+    return radii;
+}
+
+std::string VGAVisualGlobalResumable::getAnalysisKey(const std::vector<int> &radii) {
+    std::string key = "visual-global radii ";
+    for (size_t i = 0; i < radii.size(); i++) {
+        key += (i == 0 ? "" : ",") + std::to_string(radii[i]);
+    }
+    return key;
+}
+
+AnalysisResult VGAVisualGlobalResumable::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(m_map, m_graphStorage);
+    size_t nodeCount = graph.nodeCount();
+
+    std::optional<VGACheckpoint> checkpoint;
+    if (!m_checkpointFile.empty()) {
+        checkpoint = VGACheckpoint::load(m_checkpointFile);
+        if (checkpoint &&
+            !checkpoint->matches(getAnalysisKey(), graph.getSignature(), nodeCount)) {
+            checkpoint.reset();
+        }
+    }
+    if (!checkpoint) {
+        checkpoint.emplace(getAnalysisKey(), graph.getSignature(), nodeCount);
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("traversing");
+    }
+    VGASourceSweep sweep(*checkpoint, m_checkpointFile);
+    analyseGraph(graph, m_radii, sweep, comm);
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    for (auto &column : checkpoint->getColumns()) {
+        graph.copyColumnToMap(m_map, column.first, column.second);
+    }
+    if (!m_checkpointFile.empty()) {
+        VGACheckpoint::remove(m_checkpointFile);
+    }
+
+    AnalysisResult result;
+    result.completed = true;
+    return result;
+}
+
+void VGAVisualGlobalResumable::analyseGraph(const VGACSRGraph &graph,
+                                            const std::vector<int> &radii, VGASourceSweep &sweep,
+                                            Communicator *comm) {
+    VGACheckpoint &checkpoint = sweep.getCheckpoint();
+    std::vector<RadiusColumns> radiusColumns;
+    for (int radius : radii) {
+        auto column = [&checkpoint, radius](const std::string &name) {
+            return &checkpoint.getColumn(getColumnWithRadius(name, radius));
+        };
+        radiusColumns.push_back({radius, column(Column::VISUAL_MEAN_DEPTH),
+                                 column(Column::VISUAL_NODE_COUNT),
+                                 column(Column::VISUAL_INTEGRATION_HH),
+                                 column(Column::VISUAL_INTEGRATION_PV),
+                                 column(Column::VISUAL_INTEGRATION_TK),
+                                 column(Column::VISUAL_ENTROPY),
+                                 column(Column::VISUAL_REL_ENTROPY)});
+    }
+    // the traversal only needs to go as deep as the largest radius
+    int maxRadius = radii.empty() ? -1 : radii.back();
+
+    std::vector<Traversal> traversals(static_cast<size_t>(getMaxThreads()));
+    for (auto &traversal : traversals) {
+        // sources are numbered from 1 so that 0 means not visited
+        traversal.visitedBy.resize(graph.nodeCount(), 0);
+    }
+
+    sweep.run(comm, [&](size_t source, int thread) {
+        Traversal &traversal = traversals[static_cast<size_t>(thread)];
+        uint32_t mark = static_cast<uint32_t>(source + 1);
+        // a merged pair is one place, reached and counted together
+        auto visit = [&graph, &traversal, mark](uint32_t node) {
+            traversal.visitedBy[node] = mark;
+            uint32_t merge = graph.getMerge(node);
+            if (merge != VGACSRGraph::NO_MERGE) {
+                traversal.visitedBy[merge] = mark;
+            }
+        };
+        traversal.frontier.assign(1, static_cast<uint32_t>(source));
+        visit(static_cast<uint32_t>(source));
+        traversal.distribution.clear();
+
+        for (int depth = 0; !traversal.frontier.empty(); depth++) {
+            traversal.distribution.push_back(static_cast<int>(traversal.frontier.size()));
+            if (maxRadius != -1 && depth >= maxRadius) {
+                break;
+            }
+            traversal.nextFrontier.clear();
+            auto expand = [&](uint32_t node) {
+                for (uint32_t connected : graph.neighbours(node)) {
+                    if (traversal.visitedBy[connected] != mark) {
+                        visit(connected);
+                        traversal.nextFrontier.push_back(connected);
+                    }
+                }
+            };
+            for (uint32_t node : traversal.frontier) {
+                expand(node);
+                uint32_t merge = graph.getMerge(node);
+                if (merge != VGACSRGraph::NO_MERGE) {
+                    expand(merge);
+                }
+            }
+            std::swap(traversal.frontier, traversal.nextFrontier);
+        }
+
+        for (const RadiusColumns &columns : radiusColumns) {
+            // the depths within this radius, the source itself at depth 0
+            size_t depthCount = traversal.distribution.size();
+            if (columns.radius != -1) {
+                depthCount = std::min(depthCount, static_cast<size_t>(columns.radius) + 1);
+            }
+            auto measures =
+                VGAVisualMeasures::fromDistribution(traversal.distribution.data(), depthCount);
+            (*columns.nodeCount)[source] = measures.nodeCount;
+            (*columns.meanDepth)[source] = measures.meanDepth;
+            (*columns.integHH)[source] = measures.integHH;
+            (*columns.integPV)[source] = measures.integPV;
+            (*columns.integTK)[source] = measures.integTK;
+            (*columns.entropy)[source] = measures.entropy;
+            (*columns.relEntropy)[source] = measures.relEntropy;
+        }
+    });
+}
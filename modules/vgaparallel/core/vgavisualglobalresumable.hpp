@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "vgacolumns.hpp"
+#include "vgacsrgraph.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <string>
+#include <vector>
+
+class PointMap;
+class VGASourceSweep;
+
+/**
+ * @brief Global visibility analysis that can be interrupted and resumed
+ *
+ * Computes the same measures as the global visibility analysis of salalib,
+ * for any number of radii at once: a single traversal from each source goes
+ * as deep as the largest radius and each radius reads the depths within it.
+ * Progress is written to a checkpoint file, and a matching checkpoint found
+ * when the analysis starts is picked up from where it was left.
+ */
+class VGAVisualGlobalResumable : public IAnalysis {
+  private:
+    PointMap &m_map;
+    std::vector<int> m_radii;
+    std::string m_checkpointFile;
+    VGACSRGraph::Storage m_graphStorage = VGACSRGraph::Storage::PLAIN;
+
+  public:
+    using Column = VGAVisualGlobalColumn;
+
+  public:
+    // a radius of -1 is the whole graph
+    VGAVisualGlobalResumable(PointMap &map, int radius)
+        : VGAVisualGlobalResumable(map, std::vector<int>{radius}) {}
+    VGAVisualGlobalResumable(PointMap &map, std::vector<int> radii);
+    std::string getAnalysisName() const override {
+        return "Global Visibility Analysis (Resumable)";
+    }
+    // the radii in the order they are calculated in, without repeats
+    static std::vector<int> sortRadii(std::vector<int> radii);
+    // identifies the analysis and its parameters in a checkpoint
+    static std::string getAnalysisKey(const std::vector<int> &radii);
+    std::string getAnalysisKey() const { return getAnalysisKey(m_radii); }
+    // no checkpoints are written if this is not set
+    void setCheckpointFile(std::string checkpointFile) {
+        m_checkpointFile = std::move(checkpointFile);
+    }
+    void setGraphStorage(VGACSRGraph::Storage graphStorage) { m_graphStorage = graphStorage; }
+    AnalysisResult run(Communicator *comm) override;
+
+    // runs the sources of the sweep, adding the columns of every radius to
+    // its checkpoint. The radii have to be sorted
+    static void analyseGraph(const VGACSRGraph &graph, const std::vector<int> &radii,
+                             VGASourceSweep &sweep, Communicator *comm);
+};
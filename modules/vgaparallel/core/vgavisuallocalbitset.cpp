@@ -0,0 +1,250 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgavisuallocalbitset.hpp"
+
+#include "vgablockedbitset.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include "salalib/genlib/comm.hpp"
+#include "salalib/pointmap.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+    constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+    // the first tile is kept small, later ones are sized by the memory taken
+    constexpr size_t FIRST_TILE_SIZE = 4096;
+    constexpr size_t MIN_TILE_SIZE = 256;
+
+    // where the set of a node needed by the current tile is stored
+    struct SetLocation {
+        size_t thread;
+        size_t firstBlock;
+        size_t blockCount;
+        size_t count;
+    };
+
+    // per-thread storage and scratch space, kept between tiles
+    struct Workspace {
+        std::vector<uint32_t> neighbours;
+        std::vector<uint32_t> positions;
+        std::vector<VGABlockedBitset::Block> blocks;
+        // dense bitset for the union of the neighbourhoods of a node, with
+        // the blocks that have been written to
+        std::vector<VGABlockedBitset::Block> reach;
+        std::vector<uint32_t> reachTouched;
+    };
+} // namespace
+
+VGAVisualLocalBitset::Result
+VGAVisualLocalBitset::analyseNeighbourhoods(size_t nodeCount, const NeighbourFunc &neighbours,
+                                            size_t memoryBudget, Communicator *comm) {
+    Result result;
+    result.clusteringCoefficient.assign(nodeCount, -1.0f);
+    result.control.assign(nodeCount, -1.0f);
+    result.controllability.assign(nodeCount, -1.0f);
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, nodeCount);
+    }
+
+    std::vector<Workspace> workspaces(static_cast<size_t>(getMaxThreads()));
+    size_t reachBlocks = (nodeCount + VGABlockedBitset::BLOCK_BITS - 1) /
+                         VGABlockedBitset::BLOCK_BITS;
+    for (auto &workspace : workspaces) {
+        VGABlockedBitset::Block empty;
+        empty.words.fill(0);
+        workspace.reach.assign(reachBlocks, empty);
+    }
+
+    std::vector<uint32_t> slotOf(nodeCount, NO_SLOT);
+    std::vector<uint32_t> slotNodes;
+    std::vector<SetLocation> locations;
+    std::vector<VGABlockedBitset> sets;
+
+    // builds the sets of the slots from the given one onwards
+    auto buildSets = [&](size_t firstSlot) {
+        locations.resize(slotNodes.size());
+        parallelFor(slotNodes.size() - firstSlot, 64, [&](size_t index, int thread) {
+            size_t slot = firstSlot + index;
+            Workspace &workspace = workspaces[static_cast<size_t>(thread)];
+            uint32_t node = slotNodes[slot];
+            workspace.neighbours.clear();
+            neighbours(node, workspace.neighbours);
+            // a node is not part of its own neighbourhood
+            workspace.neighbours.erase(std::remove(workspace.neighbours.begin(),
+                                                   workspace.neighbours.end(), node),
+                                       workspace.neighbours.end());
+            std::sort(workspace.neighbours.begin(), workspace.neighbours.end());
+            workspace.neighbours.erase(
+                std::unique(workspace.neighbours.begin(), workspace.neighbours.end()),
+                workspace.neighbours.end());
+            size_t firstBlock = workspace.blocks.size();
+            size_t blockCount = VGABlockedBitset::append(workspace.neighbours,
+                                                         workspace.positions, workspace.blocks);
+            locations[slot] = {static_cast<size_t>(thread), firstBlock, blockCount,
+                               workspace.neighbours.size()};
+        });
+    };
+
+    size_t tileSize = std::min(nodeCount, FIRST_TILE_SIZE);
+    for (size_t tileStart = 0; tileStart < nodeCount;) {
+        size_t tileEnd = std::min(nodeCount, tileStart + tileSize);
+
+        // the points of the tile take the first slots, then come the points
+        // they see from outside the tile
+        slotNodes.clear();
+        for (size_t node = tileStart; node < tileEnd; node++) {
+            slotOf[node] = static_cast<uint32_t>(slotNodes.size());
+            slotNodes.push_back(static_cast<uint32_t>(node));
+        }
+        buildSets(0);
+        size_t tileSlots = slotNodes.size();
+        for (size_t slot = 0; slot < tileSlots; slot++) {
+            const SetLocation &location = locations[slot];
+            const Workspace &workspace = workspaces[location.thread];
+            VGABlockedBitset(workspace.positions.data() + location.firstBlock,
+                             workspace.blocks.data() + location.firstBlock, location.blockCount,
+                             location.count)
+                .forEach([&](size_t connected) {
+                    if (slotOf[connected] == NO_SLOT) {
+                        slotOf[connected] = static_cast<uint32_t>(slotNodes.size());
+                        slotNodes.push_back(static_cast<uint32_t>(connected));
+                    }
+                });
+        }
+        buildSets(tileSlots);
+
+        // all sets are built, the storage does not move any more
+        sets.clear();
+        size_t memoryUsed = 0;
+        for (const SetLocation &location : locations) {
+            const Workspace &workspace = workspaces[location.thread];
+            sets.emplace_back(workspace.positions.data() + location.firstBlock,
+                              workspace.blocks.data() + location.firstBlock, location.blockCount,
+                              location.count);
+            memoryUsed += location.blockCount *
+                          (sizeof(uint32_t) + sizeof(VGABlockedBitset::Block));
+        }
+        memoryUsed += locations.size() * (sizeof(SetLocation) + sizeof(VGABlockedBitset));
+
+        parallelFor(tileSlots, 16, [&](size_t slot, int thread) {
+            Workspace &workspace = workspaces[static_cast<size_t>(thread)];
+            const VGABlockedBitset &hood = sets[slot];
+            size_t node = tileStart + slot;
+            size_t hoodSize = hood.count();
+            if (hoodSize > 1) {
+                size_t cluster = 0;
+                double control = 0.0;
+                workspace.reachTouched.clear();
+                hood.forEach([&](size_t connected) {
+                    const VGABlockedBitset &connectedHood = sets[slotOf[connected]];
+                    cluster += hood.intersectionCount(connectedHood);
+                    if (connectedHood.count() > 0) {
+                        control += 1.0 / double(connectedHood.count());
+                    }
+                    for (size_t block = 0; block < connectedHood.getBlockCount(); block++) {
+                        uint32_t position = connectedHood.getPosition(block);
+                        auto &reachBlock = workspace.reach[position];
+                        bool wasEmpty = VGABlockedBitset::bitCount(reachBlock) == 0;
+                        for (size_t w = 0; w < VGABlockedBitset::BLOCK_WORDS; w++) {
+                            reachBlock.words[w] |= connectedHood.getBlock(block).words[w];
+                        }
+                        if (wasEmpty) {
+                            workspace.reachTouched.push_back(position);
+                        }
+                    }
+                });
+                size_t reachCount = 0;
+                for (uint32_t position : workspace.reachTouched) {
+                    reachCount += VGABlockedBitset::bitCount(workspace.reach[position]);
+                    workspace.reach[position].words.fill(0);
+                }
+                result.clusteringCoefficient[node] =
+                    static_cast<float>(double(cluster) / double(hoodSize * (hoodSize - 1)));
+                result.control[node] = static_cast<float>(control);
+                if (reachCount > 0) {
+                    result.controllability[node] =
+                        static_cast<float>(double(hoodSize) / double(reachCount));
+                }
+            }
+            if (telemetry) {
+                telemetry->addRecords(static_cast<size_t>(thread));
+            }
+        });
+
+        for (uint32_t node : slotNodes) {
+            slotOf[node] = NO_SLOT;
+        }
+        for (auto &workspace : workspaces) {
+            workspace.positions.clear();
+            workspace.blocks.clear();
+        }
+
+        if (comm) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD, tileEnd);
+            if (comm->IsCancelled()) {
+                throw Communicator::CancelledException();
+            }
+        }
+
+        // grow or shrink the next tile towards the budget, at most doubling
+        // it as the sets along the edges do not grow with the tile
+        double scale = double(memoryBudget) / double(std::max<size_t>(memoryUsed, 1));
+        tileSize = static_cast<size_t>(double(tileSize) * std::min(scale, 2.0));
+        tileSize = std::max(tileSize, MIN_TILE_SIZE);
+        tileStart = tileEnd;
+    }
+    return result;
+}
+
+AnalysisResult VGAVisualLocalBitset::run(Communicator *comm) {
+    const AttributeTable &attributes = m_map.getAttributeTable();
+    std::vector<int> refs;
+    refs.reserve(attributes.getNumRows());
+    for (auto iter = attributes.begin(); iter != attributes.end(); iter++) {
+        refs.push_back(iter->getKey().value);
+    }
+
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("analysing tiles");
+    }
+    // the attribute table is ordered by key, so the refs can be searched,
+    // and nearby points end up in the same blocks
+    auto result = analyseNeighbourhoods(
+        refs.size(),
+        [this, &refs](size_t node, std::vector<uint32_t> &neighbours) {
+            PixelRefVector hood;
+            m_map.getPoint(refs[node]).getNode().contents(hood);
+            for (PixelRef &connected : hood) {
+                auto it = std::lower_bound(refs.begin(), refs.end(), int(connected));
+                neighbours.push_back(static_cast<uint32_t>(it - refs.begin()));
+            }
+        },
+        m_memoryBudget, comm);
+
+    if (telemetry) {
+        telemetry->setPhase("writing results");
+    }
+    AttributeTable &table = m_map.getAttributeTable();
+    size_t clusterCol = table.insertOrResetColumn(Column::VISUAL_CLUSTERING_COEFFICIENT);
+    size_t controlCol = table.insertOrResetColumn(Column::VISUAL_CONTROL);
+    size_t controllabilityCol = table.insertOrResetColumn(Column::VISUAL_CONTROLLABILITY);
+    for (size_t node = 0; node < refs.size(); node++) {
+        AttributeRow &row = table.getRow(AttributeKey(refs[node]));
+        row.setValue(clusterCol, result.clusteringCoefficient[node]);
+        row.setValue(controlCol, result.control[node]);
+        row.setValue(controllabilityCol, result.controllability[node]);
+    }
+
+    AnalysisResult analysisResult;
+    analysisResult.completed = true;
+    return analysisResult;
+}
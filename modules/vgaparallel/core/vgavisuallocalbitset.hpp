@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "salalib/ianalysis.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class PointMap;
+
+/**
+ * @brief Local visibility analysis within a memory budget
+ *
+ * The visible set of every point is kept as a blocked bitset, and the points
+ * are analysed in tiles of consecutive rows: a tile only needs the sets of
+ * its points and of the points they see. The tile size follows the memory
+ * the previous tile took, so that the sets held at any time stay within the
+ * budget, at the cost of building the sets along the edges of the tiles
+ * more than once.
+ */
+class VGAVisualLocalBitset : public IAnalysis {
+  private:
+    PointMap &m_map;
+    size_t m_memoryBudget;
+
+  public:
+    struct Column {
+        inline static const std::string                                      //
+            VISUAL_CLUSTERING_COEFFICIENT = "Visual Clustering Coefficient", //
+            VISUAL_CONTROL = "Visual Control",                               //
+            VISUAL_CONTROLLABILITY = "Visual Controllability";               //
+    };
+
+    struct Result {
+        std::vector<float> clusteringCoefficient;
+        std::vector<float> control;
+        std::vector<float> controllability;
+    };
+
+    // fills in the nodes the node sees, in any order, and is called from
+    // several threads at once
+    using NeighbourFunc = std::function<void(size_t node, std::vector<uint32_t> &neighbours)>;
+
+  public:
+    // the budget is in bytes, for the visible sets held at any one time
+    VGAVisualLocalBitset(PointMap &map, size_t memoryBudget)
+        : m_map(map), m_memoryBudget(memoryBudget) {}
+    std::string getAnalysisName() const override {
+        return "Local Visibility Analysis (Compressed Bitsets)";
+    }
+    AnalysisResult run(Communicator *comm) override;
+
+    static Result analyseNeighbourhoods(size_t nodeCount, const NeighbourFunc &neighbours,
+                                        size_t memoryBudget, Communicator *comm);
+};
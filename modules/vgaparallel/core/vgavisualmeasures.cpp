@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgavisualmeasures.hpp"
+
+#include "modules/parallelcommon/core/integrationmeasures.hpp"
+
+#include <cmath>
+
+namespace {
+    void setIntegration(VGAVisualMeasures &measures, double nodeCount, double meanDepth,
+                        double totalDepth) {
+        measures.meanDepth = static_cast<float>(meanDepth);
+        auto integration = IntegrationMeasures::fromDepth(nodeCount, meanDepth, totalDepth);
+        measures.integHH = static_cast<float>(integration.integHH);
+        measures.integPV = static_cast<float>(integration.integPV);
+        measures.integTK = static_cast<float>(integration.integTK);
+    }
+} // namespace
+
+VGAVisualMeasures VGAVisualMeasures::fromMeanDepth(double nodeCount, double meanDepth) {
+    VGAVisualMeasures measures;
+    measures.nodeCount = static_cast<float>(nodeCount);
+    if (nodeCount > 1) {
+        setIntegration(measures, nodeCount, meanDepth, meanDepth * (nodeCount - 1.0));
+    }
+    return measures;
+}
+
+VGAVisualMeasures VGAVisualMeasures::fromDistribution(const int *distribution,
+                                                      size_t depthCount) {
+    VGAVisualMeasures measures;
+    int totalDepth = 0;
+    int totalNodes = 0;
+    for (size_t depth = 0; depth < depthCount; depth++) {
+        totalDepth += static_cast<int>(depth) * distribution[depth];
+        totalNodes += distribution[depth];
+    }
+
+    measures.nodeCount = static_cast<float>(totalNodes);
+    if (totalNodes <= 1) {
+        return measures;
+    }
+    double meanDepth = double(totalDepth) / double(totalNodes - 1);
+    setIntegration(measures, totalNodes, meanDepth, totalDepth);
+    double entropy = 0.0, relEntropy = 0.0, factorial = 1.0;
+    for (size_t k = 1; k < depthCount; k++) {
+        double prob = double(distribution[k]) / double(totalNodes - 1);
+        entropy -= prob * log2(prob);
+        // Formula from Turner 2001, "Depthmap"
+        factorial *= double(k + 1);
+        double q = (pow(meanDepth, double(k)) / factorial) * exp(-meanDepth);
+        relEntropy += prob * log2(prob / q);
+    }
+    measures.entropy = static_cast<float>(entropy);
+    measures.relEntropy = static_cast<float>(relEntropy);
+    return measures;
+}
@@ -0,0 +1,32 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Global visibility measures of a node
+ *
+ * Everything the global visibility analysis reports about a node follows
+ * from how many nodes lie at each depth from it, so kernels that traverse
+ * the graph differently can share the calculation. Measures that are not
+ * defined for a node are left at -1.
+ */
+struct VGAVisualMeasures {
+    float nodeCount = -1.0f;
+    float meanDepth = -1.0f;
+    float integHH = -1.0f;
+    float integPV = -1.0f;
+    float integTK = -1.0f;
+    float entropy = -1.0f;
+    float relEntropy = -1.0f;
+
+    // distribution holds the number of nodes at each depth, starting with
+    // the node itself at depth 0
+    static VGAVisualMeasures fromDistribution(const int *distribution, size_t depthCount);
+    // for estimates, where only the mean depth is known, so there is no
+    // entropy
+    static VGAVisualMeasures fromMeanDepth(double nodeCount, double meanDepth);
+};
@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgaangularglobalbucketed.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+
+#include "vgatestplan.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace {
+    // two rooms joined by a door, with a pillar in one of them
+    VGACSRGraph makeRooms() {
+        std::vector<vgatestplan::Line> lines = {
+            {10.0, 0.0, 10.0, 6.0}, {10.0, 8.0, 10.0, 12.0}, {4.0, 4.0, 5.0, 5.0}};
+        vgatestplan::Grid grid;
+        grid.cols = 20;
+        grid.rows = 12;
+        grid.originX = 0.5;
+        grid.originY = 0.5;
+        for (int x = 0; x < grid.cols; x++) {
+            for (int y = 0; y < grid.rows; y++) {
+                // the wall and the pillar take up the cells they pass through
+                bool wall = x == 9 && (y < 6 || y >= 8);
+                bool pillar = x == 4 && y == 4;
+                grid.filled.push_back(!wall && !pillar);
+            }
+        }
+        return vgatestplan::makeGraph(grid, lines);
+    }
+
+    // the turns on the best path to each point, a right angle counting as 1
+    std::vector<double> exactMeanDepths(const VGACSRGraph &graph) {
+        size_t nodeCount = graph.nodeCount();
+        std::vector<double> means(nodeCount);
+        for (uint32_t source = 0; source < nodeCount; source++) {
+            std::vector<double> depth(nodeCount, std::numeric_limits<double>::infinity());
+            std::vector<uint32_t> parent(nodeCount, source);
+            std::priority_queue<std::pair<double, uint32_t>,
+                                std::vector<std::pair<double, uint32_t>>,
+                                std::greater<std::pair<double, uint32_t>>>
+                queue;
+            depth[source] = 0.0;
+            queue.emplace(0.0, source);
+            double total = 0.0;
+            while (!queue.empty()) {
+                auto [nodeDepth, node] = queue.top();
+                queue.pop();
+                if (nodeDepth > depth[node]) {
+                    continue;
+                }
+                total += nodeDepth;
+                for (uint32_t connected : graph.neighbours(node)) {
+                    double turn = 0.0;
+                    if (node != source) {
+                        double inAngle = std::atan2(graph.getY(node) - graph.getY(parent[node]),
+                                                    graph.getX(node) - graph.getX(parent[node]));
+                        double outAngle = std::atan2(graph.getY(connected) - graph.getY(node),
+                                                     graph.getX(connected) - graph.getX(node));
+                        turn = std::abs(std::remainder(outAngle - inAngle, 2.0 * M_PI)) /
+                               (M_PI * 0.5);
+                    }
+                    if (nodeDepth + turn < depth[connected]) {
+                        depth[connected] = nodeDepth + turn;
+                        parent[connected] = node;
+                        queue.emplace(depth[connected], connected);
+                    }
+                }
+            }
+            means[source] = total / double(nodeCount - 1);
+        }
+        return means;
+    }
+} // namespace
+
+TEST_CASE("Bucketed angular depths are within the bins of the exact ones", "") {
+    VGACSRGraph graph = makeRooms();
+    auto exact = exactMeanDepths(graph);
+
+    auto coarse = VGAAngularGlobalBucketed::analyseGraph(graph, -1, 64, nullptr);
+    auto fine = VGAAngularGlobalBucketed::analyseGraph(graph, -1, 4096, nullptr);
+    double coarseError = 0.0, fineError = 0.0;
+    for (size_t node = 0; node < graph.nodeCount(); node++) {
+        REQUIRE(fine.nodeCount[node] == float(graph.nodeCount() - 1));
+        REQUIRE(fine.totalDepth[node] ==
+                Catch::Approx(fine.meanDepth[node] * fine.nodeCount[node]).epsilon(1e-5));
+        // a path turns a few times, the directions on either side of each
+        // turn are rounded by up to half a bin
+        REQUIRE(std::abs(fine.meanDepth[node] - exact[node]) < 3.0 * 4.0 / 4096);
+        coarseError = std::max(coarseError, std::abs(coarse.meanDepth[node] - exact[node]));
+        fineError = std::max(fineError, std::abs(fine.meanDepth[node] - exact[node]));
+    }
+    REQUIRE(fineError < coarseError);
+}
+
+TEST_CASE("Bucketed angular radius", "") {
+    VGACSRGraph graph = makeRooms();
+    auto all = VGAAngularGlobalBucketed::analyseGraph(graph, -1, 1024, nullptr);
+    // only the points in view, no turns at all
+    auto straight = VGAAngularGlobalBucketed::analyseGraph(graph, 0.0, 1024, nullptr);
+    for (size_t node = 0; node < graph.nodeCount(); node++) {
+        REQUIRE(straight.nodeCount[node] == float(graph.neighbours(node).size()));
+        REQUIRE(straight.nodeCount[node] < all.nodeCount[node]);
+    }
+    REQUIRE_THROWS_AS(VGAAngularGlobalBucketed::analyseGraph(graph, -1, 4, nullptr),
+                      genlib::RuntimeException);
+}
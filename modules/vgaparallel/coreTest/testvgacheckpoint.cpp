@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/vgaparallel/core/vgacheckpoint.hpp"
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+#include "modules/vgaparallel/core/vgasourcesweep.hpp"
+
+#include "salalib/genlib/comm.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+
+namespace {
+    class CancellingCommunicator : public Communicator {
+        size_t m_cancelAfter;
+
+      public:
+        CancellingCommunicator(size_t cancelAfter) : m_cancelAfter(cancelAfter) {}
+        void CommPostMessage(size_t m, size_t x) const override {
+            if (m == Communicator::CURRENT_RECORD && x >= m_cancelAfter) {
+                m_cancelled = true;
+            }
+        }
+    };
+
+    class TelemetryCommunicator : public Communicator, public AnalysisTelemetry::Provider {
+        mutable AnalysisTelemetry m_telemetry;
+
+      public:
+        void CommPostMessage(size_t m, size_t x) const override {
+            if (m == Communicator::NUM_RECORDS) {
+                m_telemetry.setNumRecords(x);
+            }
+        }
+        AnalysisTelemetry &getTelemetry() override { return m_telemetry; }
+    };
+} // namespace
+
+TEST_CASE("Checkpoint done ranges", "") {
+    VGACheckpoint checkpoint("test", 1, 10);
+    checkpoint.markDone(0);
+    checkpoint.markDone(1);
+    checkpoint.markDone(5);
+    checkpoint.markDone(9);
+    REQUIRE(checkpoint.getDoneCount() == 4);
+    auto ranges = checkpoint.getDoneRanges();
+    REQUIRE(ranges.size() == 3);
+    REQUIRE(ranges[0] == std::make_pair<size_t, size_t>(0, 2));
+    REQUIRE(ranges[1] == std::make_pair<size_t, size_t>(5, 6));
+    REQUIRE(ranges[2] == std::make_pair<size_t, size_t>(9, 10));
+}
+
+TEST_CASE("Checkpoint save and load", "") {
+    std::string filename = "testcheckpoint.ckpt";
+    {
+        VGACheckpoint checkpoint("visual-global r-1", 1234, 5);
+        checkpoint.markDone(1);
+        checkpoint.markDone(2);
+        auto &column = checkpoint.getColumn("Visual Mean Depth");
+        column[1] = 1.5f;
+        column[2] = 2.5f;
+        checkpoint.save(filename);
+    }
+    auto loaded = VGACheckpoint::load(filename);
+    VGACheckpoint::remove(filename);
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->matches("visual-global r-1", 1234, 5));
+    REQUIRE_FALSE(loaded->matches("visual-global r3", 1234, 5));
+    REQUIRE_FALSE(loaded->matches("visual-global r-1", 1235, 5));
+    REQUIRE(loaded->getDoneCount() == 2);
+    REQUIRE(loaded->isDone(1));
+    REQUIRE_FALSE(loaded->isDone(3));
+    REQUIRE(loaded->getColumns().size() == 1);
+    auto &column = loaded->getColumn("Visual Mean Depth");
+    REQUIRE(column[0] == -1.0f);
+    REQUIRE(column[1] == 1.5f);
+    REQUIRE(column[2] == 2.5f);
+
+    REQUIRE_FALSE(VGACheckpoint::load("nonexistent.ckpt").has_value());
+}
+
+TEST_CASE("Graph signature follows the connections", "") {
+    auto graphA = VGACSRGraph::fromAdjacency({1, 2, 3}, {{1}, {0, 2}, {1}});
+    auto graphB = VGACSRGraph::fromAdjacency({1, 2, 3}, {{1}, {0, 2}, {1}});
+    auto graphC = VGACSRGraph::fromAdjacency({1, 2, 3}, {{1, 2}, {0, 2}, {0, 1}});
+    REQUIRE(graphA.nodeCount() == 3);
+    REQUIRE(graphA.edgeCount() == 4);
+    REQUIRE(graphA.neighbours(1).size() == 2);
+    REQUIRE(graphA.getSignature() == graphB.getSignature());
+    REQUIRE(graphA.getSignature() != graphC.getSignature());
+}
+
+TEST_CASE("Cancelled sweep resumes from the checkpoint", "") {
+    std::string filename = "testsweep.ckpt";
+    size_t sourceCount = 100;
+    std::vector<int> timesRun(sourceCount, 0);
+    {
+        VGACheckpoint checkpoint("sweep", 1, sourceCount);
+        auto &column = checkpoint.getColumn("value");
+        VGASourceSweep sweep(checkpoint, filename);
+        sweep.setBlockSize(10);
+        CancellingCommunicator comm(30);
+        REQUIRE_THROWS_AS(sweep.run(&comm,
+                                    [&](size_t source, int) {
+                                        timesRun[source]++;
+                                        column[source] = float(source);
+                                    }),
+                          Communicator::CancelledException);
+    }
+    auto checkpoint = VGACheckpoint::load(filename);
+    REQUIRE(checkpoint.has_value());
+    REQUIRE(checkpoint->getDoneCount() == 30);
+
+    auto &column = checkpoint->getColumn("value");
+    VGASourceSweep sweep(*checkpoint, filename);
+    sweep.run(nullptr, [&](size_t source, int) {
+        timesRun[source]++;
+        column[source] = float(source);
+    });
+    VGACheckpoint::remove(filename);
+
+    REQUIRE(checkpoint->getDoneCount() == sourceCount);
+    for (size_t source = 0; source < sourceCount; source++) {
+        REQUIRE(timesRun[source] == 1);
+        REQUIRE(column[source] == float(source));
+    }
+}
+
+TEST_CASE("Sweep counts sources in the telemetry", "") {
+    size_t sourceCount = 100;
+    VGACheckpoint checkpoint("sweep", 1, sourceCount);
+    checkpoint.markDone(0);
+    VGASourceSweep sweep(checkpoint, "");
+    sweep.setBlockSize(10);
+    TelemetryCommunicator comm;
+    comm.getTelemetry().start();
+    sweep.run(&comm, [](size_t, int) {});
+
+    auto snapshot = comm.getTelemetry().snapshot();
+    REQUIRE(snapshot.numRecords == sourceCount);
+    REQUIRE(!snapshot.threadRecords.empty());
+    // the source already done is not counted again
+    uint64_t counted = 0;
+    for (uint64_t records : snapshot.threadRecords) {
+        counted += records;
+    }
+    REQUIRE(counted == sourceCount - 1);
+}
@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+#include "modules/vgaparallel/core/vgametricglobalradixheap.hpp"
+#include "modules/vgaparallel/core/vgametricglobalresumable.hpp"
+#include "modules/vgaparallel/core/vgasourcesweep.hpp"
+#include "modules/vgaparallel/core/vgavisualglobalbitparallel.hpp"
+#include "modules/vgaparallel/core/vgavisualglobalresumable.hpp"
+
+#include "modules/parallelcommon/coreTest/salalibparity.hpp"
+
+#include "salalib/pointmap.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <cstdio>
+#include <random>
+
+namespace {
+    // an open room where every cell sees the cells up to three steps away,
+    // with a few far connections that jump back and forth across the graph
+    VGACSRGraph makeRoom(int side) {
+        size_t nodeCount = static_cast<size_t>(side * side);
+        std::vector<std::vector<uint32_t>> adjacency(nodeCount);
+        std::vector<int> refs;
+        for (int x = 0; x < side; x++) {
+            for (int y = 0; y < side; y++) {
+                refs.push_back((x << 16) | y);
+                for (int dx = -3; dx <= 3; dx++) {
+                    for (int dy = -3; dy <= 3; dy++) {
+                        int nx = x + dx, ny = y + dy;
+                        if ((dx != 0 || dy != 0) && nx >= 0 && ny >= 0 && nx < side &&
+                            ny < side) {
+                            adjacency[static_cast<size_t>(x * side + y)].push_back(
+                                static_cast<uint32_t>(nx * side + ny));
+                        }
+                    }
+                }
+            }
+        }
+        std::mt19937 generator(7);
+        std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(nodeCount - 1));
+        for (int i = 0; i < side; i++) {
+            uint32_t from = pick(generator), to = pick(generator);
+            adjacency[from].push_back(to);
+            adjacency[to].push_back(from);
+        }
+        VGACSRGraph graph = VGACSRGraph::fromAdjacency(refs, adjacency);
+        for (int x = 0; x < side; x++) {
+            for (int y = 0; y < side; y++) {
+                graph.setPosition(static_cast<size_t>(x * side + y), x, y);
+            }
+        }
+        return graph;
+    }
+
+    // two corridors, 0-1-2-3 and 4-5, a cell apart, with 3 merged with 4
+    VGACSRGraph makeMergedCorridors() {
+        std::vector<std::vector<uint32_t>> adjacency = {{1}, {0, 2}, {1, 3}, {2}, {5}, {4}};
+        VGACSRGraph graph = VGACSRGraph::fromAdjacency({0, 1, 2, 3, 4, 5}, adjacency);
+        double xs[] = {0.0, 1.0, 2.0, 3.0, 10.0, 11.0};
+        for (size_t node = 0; node < graph.nodeCount(); node++) {
+            graph.setPosition(node, xs[node], 0.0);
+        }
+        graph.setMerge(3, 4);
+        return graph;
+    }
+} // namespace
+
+TEST_CASE("Delta encoded connections traverse like plain ones", "") {
+    VGACSRGraph plain = makeRoom(40);
+    VGACSRGraph encoded = makeRoom(40);
+    encoded.setStorage(VGACSRGraph::Storage::DELTA_VARINT);
+    REQUIRE(encoded.getStorage() == VGACSRGraph::Storage::DELTA_VARINT);
+    REQUIRE(encoded.edgeCount() == plain.edgeCount());
+    REQUIRE(encoded.getSignature() == plain.getSignature());
+    // mostly one byte per connection instead of four
+    REQUIRE(encoded.getConnectionBytes() * 2 < plain.getConnectionBytes());
+
+    for (size_t node = 0; node < plain.nodeCount(); node++) {
+        auto plainNeighbours = plain.neighbours(node);
+        auto encodedNeighbours = encoded.neighbours(node);
+        REQUIRE(encodedNeighbours.size() == plainNeighbours.size());
+        std::vector<uint32_t> plainTargets(plainNeighbours.begin(), plainNeighbours.end());
+        std::vector<uint32_t> encodedTargets;
+        for (uint32_t target : encodedNeighbours) {
+            encodedTargets.push_back(target);
+        }
+        REQUIRE(encodedTargets == plainTargets);
+    }
+
+    encoded.setStorage(VGACSRGraph::Storage::PLAIN);
+    REQUIRE(encoded.getConnectionBytes() == plain.getConnectionBytes());
+    REQUIRE(encoded.getSignature() == plain.getSignature());
+}
+
+TEST_CASE("Encoding while reading salalib's map matches encoding afterwards", "") {
+    auto data = salalibparity::readTestData("gallery_connected.graph");
+    PointMap &map = data.pointMaps.front();
+    VGACSRGraph plain = VGACSRGraph::fromPointMap(map);
+    VGACSRGraph encoded = VGACSRGraph::fromPointMap(map, VGACSRGraph::Storage::DELTA_VARINT);
+    REQUIRE(plain.nodeCount() == map.getFilledPointCount());
+    REQUIRE(encoded.getStorage() == VGACSRGraph::Storage::DELTA_VARINT);
+    REQUIRE(encoded.edgeCount() == plain.edgeCount());
+    REQUIRE(encoded.getSignature() == plain.getSignature());
+
+    plain.setStorage(VGACSRGraph::Storage::DELTA_VARINT);
+    REQUIRE(encoded.getConnectionBytes() == plain.getConnectionBytes());
+}
+
+TEST_CASE("Analyses give the same results on either storage", "") {
+    VGACSRGraph plain = makeRoom(24);
+    VGACSRGraph encoded = makeRoom(24);
+    encoded.setStorage(VGACSRGraph::Storage::DELTA_VARINT);
+
+    std::string key = VGAMetricGlobalResumable::getAnalysisKey(-1);
+    VGACheckpoint plainResult(key, plain.getSignature(), plain.nodeCount());
+    VGASourceSweep plainSweep(plainResult, "");
+    VGAMetricGlobalResumable::analyseGraph(plain, -1, plainSweep, nullptr);
+    VGACheckpoint encodedResult(key, encoded.getSignature(), encoded.nodeCount());
+    VGASourceSweep encodedSweep(encodedResult, "");
+    VGAMetricGlobalResumable::analyseGraph(encoded, -1, encodedSweep, nullptr);
+
+    REQUIRE(plainResult.getColumns().size() == encodedResult.getColumns().size());
+    for (size_t i = 0; i < plainResult.getColumns().size(); i++) {
+        REQUIRE(plainResult.getColumns()[i] == encodedResult.getColumns()[i]);
+    }
+}
+
+TEST_CASE("Delta encoded graph save and load", "") {
+    std::string filename = "testencodedgraph.vgagraph";
+    VGACSRGraph graph = makeRoom(16);
+    graph.setStorage(VGACSRGraph::Storage::DELTA_VARINT);
+    graph.setMapWidth(0.5);
+    graph.save(filename);
+    auto loaded = VGACSRGraph::load(filename);
+    std::remove(filename.c_str());
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->getStorage() == VGACSRGraph::Storage::DELTA_VARINT);
+    REQUIRE(loaded->getSignature() == graph.getSignature());
+    REQUIRE(loaded->getMapWidth() == 0.5);
+}
+
+TEST_CASE("Merged points are one place, as in salalib", "") {
+    // salalib goes on from the other of a merged pair at the same depth and
+    // does not count it: from 0 the depths are 0, 1, 2, 3 and then 4 for 5,
+    // from 4 they are 0, 1 for 2 and 5, 2 for 1 and 3 for 0
+    VGACSRGraph graph = makeMergedCorridors();
+    REQUIRE(graph.hasMerges());
+    REQUIRE(graph.getMerge(4) == 3);
+    REQUIRE(graph.getMerge(0) == VGACSRGraph::NO_MERGE);
+    REQUIRE(graph.edgeCount() == 8);
+
+    std::vector<int> radii = {-1};
+    VGACheckpoint visual(VGAVisualGlobalResumable::getAnalysisKey(radii), graph.getSignature(),
+                         graph.nodeCount());
+    VGASourceSweep visualSweep(visual, "");
+    VGAVisualGlobalResumable::analyseGraph(graph, radii, visualSweep, nullptr);
+    using VisualColumn = VGAVisualGlobalResumable::Column;
+    auto &nodeCount = visual.getColumn(VisualColumn::VISUAL_NODE_COUNT);
+    auto &meanDepth = visual.getColumn(VisualColumn::VISUAL_MEAN_DEPTH);
+    REQUIRE(nodeCount[0] == Catch::Approx(5.0));
+    REQUIRE(meanDepth[0] == Catch::Approx(10.0 / 4.0));
+    REQUIRE(nodeCount[4] == Catch::Approx(5.0));
+    REQUIRE(meanDepth[4] == Catch::Approx(7.0 / 4.0));
+
+    auto bitParallel = VGAVisualGlobalBitParallel::analyseGraph(graph, -1, nullptr);
+    for (size_t node = 0; node < graph.nodeCount(); node++) {
+        REQUIRE(bitParallel[node].nodeCount == nodeCount[node]);
+        REQUIRE(bitParallel[node].meanDepth == Catch::Approx(meanDepth[node]));
+    }
+
+    // 4 is reached at the distance of 3, so 5 is only a step further
+    auto metric = VGAMetricGlobalRadixHeap::analyseGraph(graph, -1, nullptr);
+    REQUIRE(metric.nodeCount[0] == Catch::Approx(5.0));
+    REQUIRE(metric.meanShortestPathDistance[0] == Catch::Approx(10.0 / 5.0));
+    REQUIRE(metric.meanStraightLineDistance[0] == Catch::Approx(17.0 / 5.0));
+    REQUIRE(metric.nodeCount[4] == Catch::Approx(5.0));
+    REQUIRE(metric.meanShortestPathDistance[4] == Catch::Approx(7.0 / 5.0));
+
+    std::string key = VGAMetricGlobalResumable::getAnalysisKey(-1);
+    VGACheckpoint resumable(key, graph.getSignature(), graph.nodeCount());
+    VGASourceSweep resumableSweep(resumable, "");
+    VGAMetricGlobalResumable::analyseGraph(graph, -1, resumableSweep, nullptr);
+    using MetricColumn = VGAMetricGlobalResumable::Column;
+    auto &resumableCount = resumable.getColumn(MetricColumn::METRIC_NODE_COUNT);
+    auto &resumableDistance =
+        resumable.getColumn(MetricColumn::METRIC_MEAN_SHORTEST_PATH_DISTANCE);
+    for (size_t node = 0; node < graph.nodeCount(); node++) {
+        REQUIRE(resumableCount[node] == metric.nodeCount[node]);
+        REQUIRE(resumableDistance[node] == Catch::Approx(metric.meanShortestPathDistance[node]));
+    }
+}
+
+TEST_CASE("Merges are kept in the graph file", "") {
+    std::string filename = "testmergedgraph.vgagraph";
+    VGACSRGraph graph = makeMergedCorridors();
+    graph.save(filename);
+    auto loaded = VGACSRGraph::load(filename);
+    std::remove(filename.c_str());
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->getMerge(3) == 4);
+    REQUIRE(loaded->getSignature() == graph.getSignature());
+    REQUIRE(loaded->getSignature() != makeRoom(2).getSignature());
+}
@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+#include "modules/vgaparallel/core/vgaglobalsampled.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <cmath>
+
+namespace {
+    // an open square room, where every cell sees its eight neighbours
+    VGACSRGraph makeGrid(int side) {
+        std::vector<std::vector<uint32_t>> adjacency(static_cast<size_t>(side * side));
+        std::vector<int> refs;
+        for (int x = 0; x < side; x++) {
+            for (int y = 0; y < side; y++) {
+                refs.push_back(x * side + y);
+                for (int dx = -1; dx <= 1; dx++) {
+                    for (int dy = -1; dy <= 1; dy++) {
+                        int nx = x + dx, ny = y + dy;
+                        if ((dx != 0 || dy != 0) && nx >= 0 && ny >= 0 && nx < side &&
+                            ny < side) {
+                            adjacency[static_cast<size_t>(x * side + y)].push_back(
+                                static_cast<uint32_t>(nx * side + ny));
+                        }
+                    }
+                }
+            }
+        }
+        VGACSRGraph graph = VGACSRGraph::fromAdjacency(refs, adjacency);
+        for (int x = 0; x < side; x++) {
+            for (int y = 0; y < side; y++) {
+                graph.setPosition(static_cast<size_t>(x * side + y), x, y);
+            }
+        }
+        return graph;
+    }
+
+    // visual depth on the grid is the larger of the two offsets
+    double exactMeanDepth(int side, int x, int y) {
+        double total = 0.0;
+        for (int ox = 0; ox < side; ox++) {
+            for (int oy = 0; oy < side; oy++) {
+                total += std::max(std::abs(ox - x), std::abs(oy - y));
+            }
+        }
+        return total / double(side * side - 1);
+    }
+} // namespace
+
+TEST_CASE("Sampling every point gives the exact mean depth", "") {
+    int side = 12;
+    VGACSRGraph graph = makeGrid(side);
+    VGAGlobalSampled::Settings settings;
+    settings.targetError = 0.0001;
+    auto result = VGAGlobalSampled::analyseGraph(graph, settings, nullptr);
+    REQUIRE(result.sampleCount == graph.nodeCount());
+    for (int x = 0; x < side; x++) {
+        for (int y = 0; y < side; y++) {
+            size_t node = static_cast<size_t>(x * side + y);
+            REQUIRE(result.meanDepth[node] == Catch::Approx(exactMeanDepth(side, x, y)));
+            REQUIRE(result.nodeCount[node] == Catch::Approx(side * side));
+            REQUIRE(result.meanDepthError[node] == Catch::Approx(0.0));
+        }
+    }
+}
+
+TEST_CASE("Sampled mean depth falls within its error", "") {
+    int side = 40;
+    VGACSRGraph graph = makeGrid(side);
+    VGAGlobalSampled::Settings settings;
+    settings.targetError = 0.05;
+    settings.sampling = GENERATE(VGAGlobalSampled::Sampling::STRATIFIED,
+                                 VGAGlobalSampled::Sampling::RANDOM);
+    settings.seed = 3;
+    auto result = VGAGlobalSampled::analyseGraph(graph, settings, nullptr);
+    REQUIRE(result.sampleCount < graph.nodeCount());
+
+    size_t within = 0;
+    for (int x = 0; x < side; x++) {
+        for (int y = 0; y < side; y++) {
+            size_t node = static_cast<size_t>(x * side + y);
+            double exact = exactMeanDepth(side, x, y);
+            REQUIRE(result.meanDepthError[node] > 0.0f);
+            if (std::abs(result.meanDepth[node] - exact) <= result.meanDepthError[node]) {
+                within++;
+            }
+            REQUIRE(std::abs(result.meanDepth[node] - exact) < 0.1 * exact);
+        }
+    }
+    // all points share the sample, so a random one that is off is off for
+    // many points together, while an evenly spread one is hardly off at all
+    if (settings.sampling == VGAGlobalSampled::Sampling::STRATIFIED) {
+        REQUIRE(double(within) / double(graph.nodeCount()) > 0.95);
+    }
+}
+
+TEST_CASE("Sampled metric and angular depths", "") {
+    int side = 10;
+    VGACSRGraph graph = makeGrid(side);
+    VGAGlobalSampled::Settings settings;
+    settings.targetError = 0.0001;
+    settings.measure = VGAGlobalSampled::Measure::METRIC;
+    auto metric = VGAGlobalSampled::analyseGraph(graph, settings, nullptr);
+    // from a corner the shortest path runs diagonally then straight
+    double total = 0.0;
+    for (int x = 0; x < side; x++) {
+        for (int y = 0; y < side; y++) {
+            total += std::abs(x - y) + std::sqrt(2.0) * std::min(x, y);
+        }
+    }
+    REQUIRE(metric.meanDepth[0] == Catch::Approx(total / double(side * side - 1)));
+
+    settings.measure = VGAGlobalSampled::Measure::ANGULAR;
+    auto angular = VGAGlobalSampled::analyseGraph(graph, settings, nullptr);
+    // from a corner every cell is reached with at most one 45 degree turn
+    REQUIRE(angular.meanDepth[0] > 0.0f);
+    REQUIRE(angular.meanDepth[0] < 0.5f);
+    REQUIRE(angular.nodeCount[0] == Catch::Approx(side * side));
+}
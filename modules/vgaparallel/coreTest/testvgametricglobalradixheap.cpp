@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgametricglobalradixheap.hpp"
+#include "modules/vgaparallel/core/vgametricglobalresumable.hpp"
+#include "modules/vgaparallel/core/vgaradixheap.hpp"
+#include "modules/vgaparallel/core/vgasourcesweep.hpp"
+
+#include "modules/parallelcommon/coreTest/salalibparity.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+#include "salalib/pointmap.hpp"
+#include "salalib/vgamodules/vgametricopenmp.hpp"
+
+#include "vgatestplan.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+    // a gallery of rooms off a corridor, each with a door and a few screens
+    VGACSRGraph makeGallery(int rooms, double spacing) {
+        std::vector<vgatestplan::Line> lines;
+        double roomWidth = 6.0, roomDepth = 5.0, corridor = 2.0;
+        double length = rooms * roomWidth;
+        lines.push_back({0.0, 0.0, length, 0.0});
+        lines.push_back({0.0, roomDepth * 2 + corridor, length, roomDepth * 2 + corridor});
+        lines.push_back({0.0, 0.0, 0.0, roomDepth * 2 + corridor});
+        lines.push_back({length, 0.0, length, roomDepth * 2 + corridor});
+        for (int side = 0; side < 2; side++) {
+            double wallY = side == 0 ? roomDepth : roomDepth + corridor;
+            double backY = side == 0 ? 0.0 : roomDepth * 2 + corridor;
+            for (int room = 0; room < rooms; room++) {
+                double left = room * roomWidth;
+                // a door in the middle of the wall to the corridor
+                lines.push_back({left, wallY, left + roomWidth * 0.4, wallY});
+                lines.push_back({left + roomWidth * 0.6, wallY, left + roomWidth, wallY});
+                if (room > 0) {
+                    lines.push_back({left, backY, left, wallY});
+                }
+                double screenY = (backY + wallY) * 0.5;
+                lines.push_back({left + 1.5, screenY - 0.8, left + 2.1, screenY + 0.6});
+                lines.push_back({left + 4.2, screenY + 0.5, left + 4.6, screenY - 0.7});
+            }
+        }
+        vgatestplan::Grid grid;
+        grid.spacing = spacing;
+        grid.cols = static_cast<int>(length / spacing);
+        grid.rows = static_cast<int>((roomDepth * 2 + corridor) / spacing);
+        grid.originX = spacing * 0.5;
+        grid.originY = spacing * 0.5;
+        grid.fillClear(lines);
+        return vgatestplan::makeGraph(grid, lines);
+    }
+
+    VGACheckpoint analyseWithPriorityQueue(const VGACSRGraph &graph, double radius) {
+        VGACheckpoint checkpoint(VGAMetricGlobalResumable::getAnalysisKey(radius),
+                                 graph.getSignature(), graph.nodeCount());
+        VGASourceSweep sweep(checkpoint, "");
+        VGAMetricGlobalResumable::analyseGraph(graph, radius, sweep, nullptr);
+        return checkpoint;
+    }
+} // namespace
+
+TEST_CASE("Radix heap pops in order", "") {
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<double> step(0.0, 2.0);
+    VGARadixHeap heap;
+    std::vector<double> popped;
+    double last = 0.0;
+    heap.push(0.0, 0);
+    for (uint32_t i = 1; i < 2000; i++) {
+        // searches push distances no lower than the last taken out
+        heap.push(last + step(generator), i);
+        heap.push(last + step(generator), i);
+        if (i % 3 == 0) {
+            last = heap.pop().first;
+            popped.push_back(last);
+        }
+    }
+    while (!heap.empty()) {
+        popped.push_back(heap.pop().first);
+    }
+    REQUIRE(popped.size() == 3999);
+    REQUIRE(std::is_sorted(popped.begin(), popped.end()));
+
+    // an empty heap has nothing on top and nothing to pop
+    REQUIRE(heap.top() == std::numeric_limits<double>::infinity());
+    REQUIRE_THROWS_AS(heap.pop(), genlib::RuntimeException);
+    heap.clear();
+    heap.push(0.5, 7);
+    REQUIRE(heap.top() == 0.5);
+}
+
+TEST_CASE("Radix heap metric matches the priority queue", "") {
+    VGACSRGraph graph = makeGallery(3, 0.5);
+    double radius = GENERATE(-1.0, 6.5);
+
+    VGACheckpoint expected = analyseWithPriorityQueue(graph, radius);
+    auto result = VGAMetricGlobalRadixHeap::analyseGraph(graph, radius, nullptr);
+    double mapWidth = graph.getMapWidth();
+    auto &shortestPath = expected.getColumn(getColumnWithRadius(
+        VGAMetricGlobalResumable::Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE, radius, mapWidth));
+    auto &straightLine = expected.getColumn(getColumnWithRadius(
+        VGAMetricGlobalResumable::Column::METRIC_MEAN_STRAIGHT_LINE_DISTANCE, radius, mapWidth));
+    auto &nodeCount = expected.getColumn(getColumnWithRadius(
+        VGAMetricGlobalResumable::Column::METRIC_NODE_COUNT, radius, mapWidth));
+    REQUIRE(result.nodeCount == nodeCount);
+    // equal distances may be taken out in another order, summing differently
+    for (size_t node = 0; node < graph.nodeCount(); node++) {
+        REQUIRE(result.meanShortestPathDistance[node] ==
+                Catch::Approx(shortestPath[node]).epsilon(1e-6));
+        REQUIRE(result.meanStraightLineDistance[node] ==
+                Catch::Approx(straightLine[node]).epsilon(1e-6));
+    }
+}
+
+TEST_CASE("Radix heap metric matches salalib's global metric", "") {
+    auto data = salalibparity::readTestData("gallery_connected.graph");
+    PointMap &map = data.pointMaps.front();
+    salalibparity::QuietCommunicator comm;
+    double radius = GENERATE(-1.0, 6.5, 150.0);
+
+    VGAMetricOpenMP(map, radius, false).run(&comm);
+    std::vector<std::string> columns;
+    for (auto &column : {VGAMetricOpenMP::Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE,
+                         VGAMetricOpenMP::Column::METRIC_MEAN_STRAIGHT_LINE_DISTANCE,
+                         VGAMetricOpenMP::Column::METRIC_NODE_COUNT}) {
+        columns.push_back(VGAMetricOpenMP::getColumnWithRadius(column, radius, map.getRegion()));
+        // the radius is written out the same way
+        REQUIRE(getColumnWithRadius(column, radius, map.getRegion().width()) == columns.back());
+    }
+    auto expected = salalibparity::getColumns(map.getAttributeTable(), columns);
+
+    VGAMetricGlobalRadixHeap(map, radius).run(&comm);
+    salalibparity::requireSameColumns(map.getAttributeTable(), columns, expected);
+}
+
+TEST_CASE("Radix heap metric benchmark", "[.][benchmark]") {
+    auto data = salalibparity::readTestData("gallery_connected.graph");
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(data.pointMaps.front());
+    BENCHMARK("Priority queue") { return analyseWithPriorityQueue(graph, -1).getDoneCount(); };
+    BENCHMARK("Radix heap") {
+        return VGAMetricGlobalRadixHeap::analyseGraph(graph, -1, nullptr).nodeCount.size();
+    };
+}
@@ -0,0 +1,213 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgapathtree.hpp"
+#include "modules/vgaparallel/core/vgapointtopointpath.hpp"
+
+#include "vgatestplan.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <random>
+
+namespace {
+    using PathType = VGAPointToPointPath::PathType;
+
+    // a row of rooms off a corridor, each with a door, and a closed room at
+    // the end that cannot be reached
+    VGACSRGraph makeRooms(int rooms) {
+        double roomWidth = 6.0, roomDepth = 5.0, corridor = 2.0;
+        double length = (rooms + 1) * roomWidth;
+        std::vector<vgatestplan::Line> lines = {
+            {0.0, 0.0, length, 0.0},
+            {0.0, roomDepth + corridor, length, roomDepth + corridor},
+            {0.0, 0.0, 0.0, roomDepth + corridor},
+            {length, 0.0, length, roomDepth + corridor},
+            {rooms * roomWidth, 0.0, rooms * roomWidth, roomDepth + corridor}};
+        for (int room = 0; room < rooms; room++) {
+            double left = room * roomWidth;
+            lines.push_back({left, roomDepth, left + roomWidth * 0.4, roomDepth});
+            lines.push_back({left + roomWidth * 0.6, roomDepth, left + roomWidth, roomDepth});
+            if (room > 0) {
+                lines.push_back({left, 0.0, left, roomDepth});
+            }
+            lines.push_back({left + 1.5, 1.5, left + 2.5, 3.0});
+        }
+        vgatestplan::Grid grid;
+        grid.spacing = 0.5;
+        grid.cols = static_cast<int>(length / grid.spacing);
+        grid.rows = static_cast<int>((roomDepth + corridor) / grid.spacing);
+        grid.originX = grid.spacing * 0.5;
+        grid.originY = grid.spacing * 0.5;
+        grid.fillClear(lines);
+        return vgatestplan::makeGraph(grid, lines);
+    }
+
+    // the cost to every node from one end, searched from that end only
+    std::vector<double> searchOneWay(const VGACSRGraph &graph, uint32_t from,
+                                     PathType pathType) {
+        std::vector<double> cost(graph.nodeCount(), std::numeric_limits<double>::infinity());
+        std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>,
+                            std::greater<std::pair<double, uint32_t>>>
+            queue;
+        cost[from] = 0.0;
+        queue.emplace(0.0, from);
+        while (!queue.empty()) {
+            auto [nodeCost, node] = queue.top();
+            queue.pop();
+            if (nodeCost > cost[node]) {
+                continue;
+            }
+            for (uint32_t connected : graph.neighbours(node)) {
+                double step = 1.0;
+                if (pathType == PathType::METRIC) {
+                    step = std::hypot(graph.getX(connected) - graph.getX(node),
+                                      graph.getY(connected) - graph.getY(node));
+                }
+                if (nodeCost + step < cost[connected]) {
+                    cost[connected] = nodeCost + step;
+                    queue.emplace(cost[connected], connected);
+                }
+            }
+        }
+        return cost;
+    }
+
+    bool isConnected(const VGACSRGraph &graph, uint32_t node, uint32_t other) {
+        for (uint32_t connected : graph.neighbours(node)) {
+            if (connected == other) {
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+TEST_CASE("Point-to-point paths are as short as searching from one end", "") {
+    VGACSRGraph graph = makeRooms(8);
+    std::mt19937 generator(4);
+    std::uniform_int_distribution<uint32_t> anyNode(0,
+                                                    static_cast<uint32_t>(graph.nodeCount() - 1));
+    for (auto pathType : {PathType::METRIC, PathType::VISUAL}) {
+        for (int pair = 0; pair < 40; pair++) {
+            uint32_t from = anyNode(generator), to = anyNode(generator);
+            auto expected = searchOneWay(graph, from, pathType)[to];
+            auto path = VGAPointToPointPath::findPath(graph, from, to, pathType);
+            if (!std::isfinite(expected)) {
+                REQUIRE(path.nodes.empty());
+                continue;
+            }
+            REQUIRE(path.nodes.front() == from);
+            REQUIRE(path.nodes.back() == to);
+            for (size_t step = 1; step < path.nodes.size(); step++) {
+                REQUIRE(isConnected(graph, path.nodes[step - 1], path.nodes[step]));
+            }
+            REQUIRE(path.costs.back() == Catch::Approx(expected));
+        }
+    }
+}
+
+TEST_CASE("Point-to-point angular paths", "") {
+    VGACSRGraph graph = makeRooms(3);
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<uint32_t> anyNode(0,
+                                                    static_cast<uint32_t>(graph.nodeCount() - 1));
+    for (int pair = 0; pair < 40; pair++) {
+        uint32_t from = anyNode(generator), to = anyNode(generator);
+        auto path = VGAPointToPointPath::findPath(graph, from, to, PathType::ANGULAR);
+        if (!std::isfinite(searchOneWay(graph, from, PathType::VISUAL)[to])) {
+            REQUIRE(path.nodes.empty());
+            continue;
+        }
+        REQUIRE(path.nodes.back() == to);
+        for (size_t step = 1; step < path.nodes.size(); step++) {
+            REQUIRE(isConnected(graph, path.nodes[step - 1], path.nodes[step]));
+        }
+        if (isConnected(graph, from, to)) {
+            // straight there
+            REQUIRE(path.costs.back() == 0.0);
+        } else {
+            // at least one turn, and never doubling back
+            REQUIRE(path.costs.back() > 0.0);
+            REQUIRE(path.costs.back() < 2.0 * static_cast<double>(path.nodes.size() - 2));
+        }
+    }
+}
+
+TEST_CASE("Point-to-point searches stay near the path", "") {
+    VGACSRGraph graph = makeRooms(20);
+    // from the middle of the first room to the one next to it
+    uint32_t from = 0, to = 0;
+    double best = std::numeric_limits<double>::infinity(), next = best;
+    for (uint32_t node = 0; node < graph.nodeCount(); node++) {
+        double x = graph.getX(node), y = graph.getY(node);
+        if (std::hypot(x - 3.0, y - 4.0) < best) {
+            best = std::hypot(x - 3.0, y - 4.0);
+            from = node;
+        }
+        if (std::hypot(x - 9.0, y - 4.0) < next) {
+            next = std::hypot(x - 9.0, y - 4.0);
+            to = node;
+        }
+    }
+    auto path = VGAPointToPointPath::findPath(graph, from, to, PathType::METRIC);
+    REQUIRE(path.costs.back() == Catch::Approx(searchOneWay(graph, from, PathType::METRIC)[to]));
+    REQUIRE(path.settledCount < graph.nodeCount() / 4);
+}
+
+TEST_CASE("Path trees carry on from where they stopped", "") {
+    VGACSRGraph graph = makeRooms(8);
+    std::mt19937 generator(9);
+    std::uniform_int_distribution<uint32_t> anyNode(0,
+                                                    static_cast<uint32_t>(graph.nodeCount() - 1));
+    for (auto pathType : {PathType::METRIC, PathType::VISUAL}) {
+        uint32_t from = anyNode(generator);
+        auto expected = searchOneWay(graph, from, pathType);
+        VGAPathTree tree(std::make_unique<VGAPointToPointPath::CSRGraphView>(graph, 0.0), from,
+                         pathType);
+        // no time at all still settles a few cells at a time
+        size_t settled = 0;
+        std::optional<VGAPathTree::Path> path;
+        uint32_t far = from, closed = from;
+        for (uint32_t node = 0; node < graph.nodeCount(); node++) {
+            if (!std::isfinite(expected[node])) {
+                closed = node;
+            } else if (expected[node] > expected[far]) {
+                far = node;
+            }
+        }
+        while (!(path = tree.findPath(far, std::chrono::microseconds(0)))) {
+            REQUIRE(tree.getSettledCount() > settled);
+            settled = tree.getSettledCount();
+        }
+        REQUIRE(path->costs.back() == Catch::Approx(expected[far]));
+
+        for (int query = 0; query < 40; query++) {
+            uint32_t to = anyNode(generator);
+            path = tree.findPath(to, std::chrono::seconds(10));
+            REQUIRE(path);
+            if (!std::isfinite(expected[to])) {
+                REQUIRE(path->nodes.empty());
+                continue;
+            }
+            REQUIRE(path->nodes.front() == from);
+            REQUIRE(path->nodes.back() == to);
+            for (size_t step = 1; step < path->nodes.size(); step++) {
+                REQUIRE(isConnected(graph, path->nodes[step - 1], path->nodes[step]));
+            }
+            REQUIRE(path->costs.back() == Catch::Approx(expected[to]));
+        }
+
+        // the closed room is only known to be out of reach once all else is
+        REQUIRE(closed != from);
+        path = tree.findPath(closed, std::chrono::seconds(10));
+        REQUIRE(path);
+        REQUIRE(path->nodes.empty());
+        REQUIRE(tree.isComplete());
+    }
+}
@@ -0,0 +1,128 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+#include "modules/vgaparallel/core/vgametricglobalresumable.hpp"
+#include "modules/vgaparallel/core/vgashard.hpp"
+#include "modules/vgaparallel/core/vgasourcesweep.hpp"
+#include "modules/vgaparallel/core/vgavisualglobalresumable.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    // a grid of cells with a wall across the middle, open at one end
+    VGACSRGraph makeRoomsWithWall(int side) {
+        auto isWall = [side](int x, int y) { return x == side / 2 && y < side - 2; };
+        std::vector<int> refs;
+        std::vector<std::pair<int, int>> cells;
+        for (int x = 0; x < side; x++) {
+            for (int y = 0; y < side; y++) {
+                if (!isWall(x, y)) {
+                    refs.push_back(x * side + y);
+                    cells.emplace_back(x, y);
+                }
+            }
+        }
+        std::vector<std::vector<uint32_t>> adjacency(cells.size());
+        for (size_t from = 0; from < cells.size(); from++) {
+            for (size_t to = 0; to < cells.size(); to++) {
+                int dx = cells[to].first - cells[from].first;
+                int dy = cells[to].second - cells[from].second;
+                if (from != to && std::abs(dx) <= 1 && std::abs(dy) <= 1) {
+                    adjacency[from].push_back(static_cast<uint32_t>(to));
+                }
+            }
+        }
+        VGACSRGraph graph = VGACSRGraph::fromAdjacency(refs, adjacency);
+        for (size_t node = 0; node < cells.size(); node++) {
+            graph.setPosition(node, cells[node].first, cells[node].second);
+        }
+        return graph;
+    }
+
+    bool sameBytes(const VGACheckpoint &a, const VGACheckpoint &b) {
+        if (a.getColumns().size() != b.getColumns().size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.getColumns().size(); i++) {
+            auto &columnA = a.getColumns()[i];
+            auto &columnB = b.getColumns()[i];
+            if (columnA.first != columnB.first || columnA.second.size() != columnB.second.size() ||
+                std::memcmp(columnA.second.data(), columnB.second.data(),
+                            columnA.second.size() * sizeof(float)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace
+
+TEST_CASE("Graph save and load", "") {
+    std::string filename = "testshardgraph.vgagraph";
+    VGACSRGraph graph = makeRoomsWithWall(8);
+    graph.save(filename);
+    auto loaded = VGACSRGraph::load(filename);
+    std::remove(filename.c_str());
+    REQUIRE(loaded.has_value());
+    REQUIRE(loaded->nodeCount() == graph.nodeCount());
+    REQUIRE(loaded->getSignature() == graph.getSignature());
+    REQUIRE(loaded->getX(5) == graph.getX(5));
+    REQUIRE_FALSE(VGACSRGraph::load("doesnotexist.vgagraph").has_value());
+}
+
+TEST_CASE("Merged shards are identical to a single run", "") {
+    std::string folder = "testshards";
+    std::filesystem::remove_all(folder);
+    VGACSRGraph graph = makeRoomsWithWall(12);
+
+    SECTION("Visual") {
+        std::vector<int> radii = VGAVisualGlobalResumable::sortRadii({-1, 3});
+        VGACheckpoint single(VGAVisualGlobalResumable::getAnalysisKey(radii),
+                             graph.getSignature(), graph.nodeCount());
+        VGASourceSweep sweep(single, "");
+        VGAVisualGlobalResumable::analyseGraph(graph, radii, sweep, nullptr);
+
+        auto manifests =
+            VGAShard::prepare(graph, VGAShard::Analysis::VISUAL_GLOBAL, {3, -1}, 3, folder);
+        REQUIRE(manifests.size() == 3);
+        REQUIRE(VGAShard::findManifests(folder) == manifests);
+        // shards may finish in any order
+        for (size_t i = manifests.size(); i > 0; i--) {
+            VGAShard::run(manifests[i - 1], nullptr);
+        }
+        VGACheckpoint merged = VGAShard::merge(manifests);
+        REQUIRE(merged.matches(single.getAnalysisKey(), graph.getSignature(), graph.nodeCount()));
+        REQUIRE(merged.getDoneCount() == graph.nodeCount());
+        REQUIRE(sameBytes(merged, single));
+    }
+
+    SECTION("Metric") {
+        VGACheckpoint single(VGAMetricGlobalResumable::getAnalysisKey(4.5), graph.getSignature(),
+                             graph.nodeCount());
+        VGASourceSweep sweep(single, "");
+        VGAMetricGlobalResumable::analyseGraph(graph, 4.5, sweep, nullptr);
+
+        auto manifests =
+            VGAShard::prepare(graph, VGAShard::Analysis::METRIC_GLOBAL, {4.5}, 4, folder);
+        for (auto &manifest : manifests) {
+            VGAShard::run(manifest, nullptr);
+        }
+        REQUIRE(sameBytes(VGAShard::merge(manifests), single));
+    }
+
+    SECTION("Missing shard") {
+        auto manifests =
+            VGAShard::prepare(graph, VGAShard::Analysis::VISUAL_GLOBAL, {-1}, 2, folder);
+        VGAShard::run(manifests[0], nullptr);
+        REQUIRE_THROWS_AS(VGAShard::merge(manifests), genlib::RuntimeException);
+        REQUIRE_THROWS_AS(VGAShard::merge({manifests[0]}), genlib::RuntimeException);
+    }
+
+    std::filesystem::remove_all(folder);
+}
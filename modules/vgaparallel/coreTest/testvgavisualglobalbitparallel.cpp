@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+#include "modules/vgaparallel/core/vgavisualglobalbitparallel.hpp"
+
+#include "modules/parallelcommon/coreTest/salalibparity.hpp"
+
+#include "salalib/pointmap.hpp"
+#include "salalib/vgamodules/vgavisualglobalopenmp.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <queue>
+#include <random>
+
+namespace {
+    // an undirected random graph, with enough nodes for several batches
+    VGACSRGraph makeRandomGraph(size_t nodeCount, size_t edgeCount, unsigned int seed) {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(nodeCount - 1));
+        std::vector<std::vector<uint32_t>> adjacency(nodeCount);
+        for (size_t edge = 0; edge < edgeCount; edge++) {
+            uint32_t from = pick(generator), to = pick(generator);
+            if (from != to) {
+                adjacency[from].push_back(to);
+                adjacency[to].push_back(from);
+            }
+        }
+        std::vector<int> refs(nodeCount);
+        for (size_t node = 0; node < nodeCount; node++) {
+            refs[node] = static_cast<int>(node);
+        }
+        return VGACSRGraph::fromAdjacency(refs, adjacency);
+    }
+
+    VGAVisualMeasures searchFrom(const VGACSRGraph &graph, uint32_t source, int radius) {
+        std::vector<int> depth(graph.nodeCount(), -1);
+        std::vector<int> distribution;
+        std::queue<uint32_t> queue;
+        depth[source] = 0;
+        queue.push(source);
+        while (!queue.empty()) {
+            uint32_t node = queue.front();
+            queue.pop();
+            if (static_cast<size_t>(depth[node]) >= distribution.size()) {
+                distribution.push_back(0);
+            }
+            distribution[static_cast<size_t>(depth[node])]++;
+            if (radius != -1 && depth[node] >= radius) {
+                continue;
+            }
+            for (uint32_t connected : graph.neighbours(node)) {
+                if (depth[connected] == -1) {
+                    depth[connected] = depth[node] + 1;
+                    queue.push(connected);
+                }
+            }
+        }
+        return VGAVisualMeasures::fromDistribution(distribution.data(), distribution.size());
+    }
+} // namespace
+
+TEST_CASE("Bit-parallel search matches one search per source", "") {
+    auto radius = GENERATE(-1, 2);
+    // sparse enough that some nodes are cut off from the rest
+    VGACSRGraph graph = makeRandomGraph(600, 1500, 42);
+    auto measures = VGAVisualGlobalBitParallel::analyseGraph(graph, radius, nullptr);
+    REQUIRE(measures.size() == graph.nodeCount());
+    for (uint32_t node = 0; node < graph.nodeCount(); node++) {
+        auto expected = searchFrom(graph, node, radius);
+        REQUIRE(measures[node].nodeCount == expected.nodeCount);
+        REQUIRE(measures[node].meanDepth == expected.meanDepth);
+        REQUIRE(measures[node].integHH == expected.integHH);
+        REQUIRE(measures[node].integPV == expected.integPV);
+        REQUIRE(measures[node].integTK == expected.integTK);
+        REQUIRE(measures[node].entropy == expected.entropy);
+        REQUIRE(measures[node].relEntropy == expected.relEntropy);
+    }
+}
+
+TEST_CASE("Bit-parallel search matches salalib's global visibility", "") {
+    auto data = salalibparity::readTestData("gallery_connected.graph");
+    PointMap &map = data.pointMaps.front();
+    salalibparity::QuietCommunicator comm;
+    int radius = GENERATE(-1, 3);
+
+    VGAVisualGlobalOpenMP(map, radius, false).run(&comm);
+    std::vector<std::string> columns;
+    for (auto &column : {VGAVisualGlobalColumn::VISUAL_ENTROPY,
+                         VGAVisualGlobalColumn::VISUAL_INTEGRATION_HH,
+                         VGAVisualGlobalColumn::VISUAL_INTEGRATION_PV,
+                         VGAVisualGlobalColumn::VISUAL_INTEGRATION_TK,
+                         VGAVisualGlobalColumn::VISUAL_MEAN_DEPTH,
+                         VGAVisualGlobalColumn::VISUAL_NODE_COUNT,
+                         VGAVisualGlobalColumn::VISUAL_REL_ENTROPY}) {
+        columns.push_back(getColumnWithRadius(column, radius));
+    }
+    auto expected = salalibparity::getColumns(map.getAttributeTable(), columns);
+
+    VGAVisualGlobalBitParallel(map, radius).run(&comm);
+    salalibparity::requireSameColumns(map.getAttributeTable(), columns, expected);
+}
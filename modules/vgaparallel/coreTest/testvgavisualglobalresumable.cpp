@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgacheckpoint.hpp"
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+#include "modules/vgaparallel/core/vgasourcesweep.hpp"
+#include "modules/vgaparallel/core/vgavisualglobalresumable.hpp"
+
+#include "modules/parallelcommon/coreTest/salalibparity.hpp"
+
+#include "salalib/pointmap.hpp"
+#include "salalib/vgamodules/vgavisualglobalopenmp.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <random>
+
+namespace {
+    // a grid where every cell sees the cells up to two steps away, with a
+    // few far connections
+    VGACSRGraph makeGrid(int side) {
+        size_t nodeCount = static_cast<size_t>(side * side);
+        std::vector<std::vector<uint32_t>> adjacency(nodeCount);
+        std::vector<int> refs;
+        for (int x = 0; x < side; x++) {
+            for (int y = 0; y < side; y++) {
+                refs.push_back((x << 16) | y);
+                for (int dx = -2; dx <= 2; dx++) {
+                    for (int dy = -2; dy <= 2; dy++) {
+                        int nx = x + dx, ny = y + dy;
+                        if ((dx != 0 || dy != 0) && nx >= 0 && ny >= 0 && nx < side &&
+                            ny < side) {
+                            adjacency[static_cast<size_t>(x * side + y)].push_back(
+                                static_cast<uint32_t>(nx * side + ny));
+                        }
+                    }
+                }
+            }
+        }
+        std::mt19937 generator(3);
+        std::uniform_int_distribution<uint32_t> pick(0, static_cast<uint32_t>(nodeCount - 1));
+        for (int i = 0; i < side / 2; i++) {
+            uint32_t from = pick(generator), to = pick(generator);
+            adjacency[from].push_back(to);
+            adjacency[to].push_back(from);
+        }
+        VGACSRGraph graph = VGACSRGraph::fromAdjacency(refs, adjacency);
+        graph.setMerge(0, nodeCount - 1);
+        return graph;
+    }
+
+    VGACheckpoint analyse(const VGACSRGraph &graph, const std::vector<int> &radii) {
+        auto sorted = VGAVisualGlobalResumable::sortRadii(radii);
+        VGACheckpoint checkpoint(VGAVisualGlobalResumable::getAnalysisKey(sorted),
+                                 graph.getSignature(), graph.nodeCount());
+        VGASourceSweep sweep(checkpoint, "");
+        VGAVisualGlobalResumable::analyseGraph(graph, sorted, sweep, nullptr);
+        return checkpoint;
+    }
+} // namespace
+
+TEST_CASE("Several radii in one pass match one pass per radius", "") {
+    VGACSRGraph graph = makeGrid(20);
+    std::vector<int> radii = {-1, 2, 5};
+    VGACheckpoint together = analyse(graph, radii);
+
+    for (int radius : radii) {
+        VGACheckpoint alone = analyse(graph, {radius});
+        REQUIRE(alone.getColumns().size() == 7);
+        for (auto &column : alone.getColumns()) {
+            REQUIRE(together.getColumn(column.first) == column.second);
+        }
+    }
+}
+
+TEST_CASE("Several radii in one pass match salalib's global visibility", "") {
+    auto data = salalibparity::readTestData("gallery_connected.graph");
+    PointMap &map = data.pointMaps.front();
+    salalibparity::QuietCommunicator comm;
+    std::vector<int> radii = {-1, 3};
+
+    std::vector<std::string> columns;
+    std::vector<std::vector<float>> expected;
+    for (int radius : radii) {
+        VGAVisualGlobalOpenMP(map, radius, false).run(&comm);
+        for (auto &column : {VGAVisualGlobalColumn::VISUAL_ENTROPY,
+                             VGAVisualGlobalColumn::VISUAL_INTEGRATION_HH,
+                             VGAVisualGlobalColumn::VISUAL_INTEGRATION_PV,
+                             VGAVisualGlobalColumn::VISUAL_INTEGRATION_TK,
+                             VGAVisualGlobalColumn::VISUAL_MEAN_DEPTH,
+                             VGAVisualGlobalColumn::VISUAL_NODE_COUNT,
+                             VGAVisualGlobalColumn::VISUAL_REL_ENTROPY}) {
+            columns.push_back(getColumnWithRadius(column, radius));
+            expected.push_back(salalibparity::getColumn(map.getAttributeTable(), columns.back()));
+        }
+    }
+
+    VGAVisualGlobalResumable(map, radii).run(&comm);
+    salalibparity::requireSameColumns(map.getAttributeTable(), columns, expected);
+}
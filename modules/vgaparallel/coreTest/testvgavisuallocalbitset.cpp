@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgablockedbitset.hpp"
+#include "modules/vgaparallel/core/vgavisuallocalbitset.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+namespace {
+    // nodes mostly see nodes with nearby indices, as cells of a map do
+    std::vector<std::set<uint32_t>> makeNeighbourhoods(size_t nodeCount, unsigned int seed) {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<int> offset(-300, 300);
+        std::uniform_int_distribution<uint32_t> any(0, static_cast<uint32_t>(nodeCount - 1));
+        std::vector<std::set<uint32_t>> hoods(nodeCount);
+        for (size_t node = 0; node < nodeCount; node++) {
+            for (int edge = 0; edge < 40; edge++) {
+                int other = static_cast<int>(node) + offset(generator);
+                uint32_t connected = edge % 10 == 0 ? any(generator) : static_cast<uint32_t>(
+                    std::clamp(other, 0, static_cast<int>(nodeCount) - 1));
+                if (connected != node) {
+                    hoods[node].insert(connected);
+                    hoods[connected].insert(static_cast<uint32_t>(node));
+                }
+            }
+        }
+        return hoods;
+    }
+} // namespace
+
+TEST_CASE("Blocked bitset intersections", "") {
+    std::vector<uint32_t> positions;
+    std::vector<VGABlockedBitset::Block> blocks;
+    std::vector<uint32_t> first = {1, 5, 255, 256, 700, 5000};
+    std::vector<uint32_t> second = {5, 255, 257, 700, 701, 9000};
+    size_t firstBlocks = VGABlockedBitset::append(first, positions, blocks);
+    size_t secondBlocks = VGABlockedBitset::append(second, positions, blocks);
+    REQUIRE(firstBlocks == 4);
+    REQUIRE(secondBlocks == 4);
+
+    VGABlockedBitset firstSet(positions.data(), blocks.data(), firstBlocks, first.size());
+    VGABlockedBitset secondSet(positions.data() + firstBlocks, blocks.data() + firstBlocks,
+                               secondBlocks, second.size());
+    REQUIRE(firstSet.intersectionCount(secondSet) == 3);
+
+    std::vector<size_t> members;
+    firstSet.forEach([&members](size_t index) { members.push_back(index); });
+    REQUIRE(members == std::vector<size_t>(first.begin(), first.end()));
+}
+
+TEST_CASE("Local visibility from blocked bitsets", "") {
+    size_t nodeCount = 3000;
+    auto hoods = makeNeighbourhoods(nodeCount, 7);
+    auto neighbours = [&hoods](size_t node, std::vector<uint32_t> &connected) {
+        connected.insert(connected.end(), hoods[node].begin(), hoods[node].end());
+    };
+    // a budget small enough to split the nodes in many tiles, and one
+    // large enough to take them all at once
+    size_t budget = GENERATE(size_t(50000), size_t(1) << 30);
+    auto result = VGAVisualLocalBitset::analyseNeighbourhoods(nodeCount, neighbours, budget,
+                                                              nullptr);
+
+    for (size_t node = 0; node < nodeCount; node++) {
+        const auto &hood = hoods[node];
+        size_t cluster = 0;
+        double control = 0.0;
+        std::set<uint32_t> reach;
+        for (uint32_t connected : hood) {
+            const auto &connectedHood = hoods[connected];
+            for (uint32_t other : connectedHood) {
+                cluster += hood.count(other);
+                reach.insert(other);
+            }
+            control += 1.0 / double(connectedHood.size());
+        }
+        if (hood.size() > 1) {
+            double k = double(hood.size());
+            REQUIRE(result.clusteringCoefficient[node] ==
+                    Catch::Approx(double(cluster) / (k * (k - 1.0))));
+            REQUIRE(result.control[node] == Catch::Approx(control));
+            REQUIRE(result.controllability[node] == Catch::Approx(k / double(reach.size())));
+        } else {
+            REQUIRE(result.clusteringCoefficient[node] == -1.0f);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// small plans of lines and cells, and their visibility graphs tested pair by
+// pair, for the tests of the analyses
+namespace vgatestplan {
+    struct Line {
+        double x1, y1, x2, y2;
+    };
+
+    struct Grid {
+        int cols = 0;
+        int rows = 0;
+        double spacing = 1.0;
+        // centre of the cell in the first column and row
+        double originX = 0.0;
+        double originY = 0.0;
+        // one flag per cell, column by column, in the order of the PixelRefs
+        std::vector<uint8_t> filled;
+
+        double getX(int x) const { return originX + x * spacing; }
+        double getY(int y) const { return originY + y * spacing; }
+
+        // fills the cells further than half a spacing from every line
+        void fillClear(const std::vector<Line> &lines) {
+            filled.clear();
+            for (int x = 0; x < cols; x++) {
+                for (int y = 0; y < rows; y++) {
+                    bool clear = true;
+                    for (auto &line : lines) {
+                        double ex = line.x2 - line.x1, ey = line.y2 - line.y1;
+                        double px = getX(x) - line.x1, py = getY(y) - line.y1;
+                        double t =
+                            std::clamp((px * ex + py * ey) / (ex * ex + ey * ey), 0.0, 1.0);
+                        clear = clear && std::hypot(px - t * ex, py - t * ey) > spacing * 0.5;
+                    }
+                    filled.push_back(clear);
+                }
+            }
+        }
+    };
+
+    // whether the line hides b from a, touching included
+    inline bool isBlocked(double ax, double ay, double bx, double by, const Line &line) {
+        auto side = [](double ox, double oy, double px, double py, double qx, double qy) {
+            return (px - ox) * (qy - oy) - (py - oy) * (qx - ox);
+        };
+        double s1 = side(ax, ay, bx, by, line.x1, line.y1);
+        double s2 = side(ax, ay, bx, by, line.x2, line.y2);
+        double s3 = side(line.x1, line.y1, line.x2, line.y2, ax, ay);
+        double s4 = side(line.x1, line.y1, line.x2, line.y2, bx, by);
+        return s1 * s2 <= 0.0 && s3 * s4 <= 0.0 &&
+               std::min(line.x1, line.x2) <= std::max(ax, bx) &&
+               std::max(line.x1, line.x2) >= std::min(ax, bx) &&
+               std::min(line.y1, line.y2) <= std::max(ay, by) &&
+               std::max(line.y1, line.y2) >= std::min(ay, by);
+    }
+
+    // every filled cell connected to the filled cells whose centres it sees,
+    // nodes in PixelRef order as in the attribute table
+    inline VGACSRGraph makeGraph(const Grid &grid, const std::vector<Line> &lines) {
+        std::vector<int> refs;
+        std::vector<std::pair<double, double>> positions;
+        for (int x = 0; x < grid.cols; x++) {
+            for (int y = 0; y < grid.rows; y++) {
+                if (grid.filled[static_cast<size_t>(x) * static_cast<size_t>(grid.rows) +
+                                static_cast<size_t>(y)] != 0) {
+                    refs.push_back((x << 16) | (y & 0xffff));
+                    positions.emplace_back(grid.getX(x), grid.getY(y));
+                }
+            }
+        }
+        std::vector<std::vector<uint32_t>> adjacency(refs.size());
+        for (uint32_t from = 0; from < refs.size(); from++) {
+            double fromX = positions[from].first, fromY = positions[from].second;
+            for (uint32_t to = from + 1; to < refs.size(); to++) {
+                double toX = positions[to].first, toY = positions[to].second;
+                bool visible = std::none_of(lines.begin(), lines.end(), [&](const Line &line) {
+                    return isBlocked(fromX, fromY, toX, toY, line);
+                });
+                if (visible) {
+                    adjacency[from].push_back(to);
+                    adjacency[to].push_back(from);
+                }
+            }
+        }
+        VGACSRGraph graph = VGACSRGraph::fromAdjacency(refs, adjacency);
+        for (size_t node = 0; node < positions.size(); node++) {
+            graph.setPosition(node, positions[node].first, positions[node].second);
+        }
+        return graph;
+    }
+} // namespace vgatestplan
@@ -4,17 +4,35 @@
 
 #include "vgaparallelmainwindow.hpp"
 
+#include "modules/vgaparallel/core/vgaangularglobalbucketed.hpp"
+#include "modules/vgaparallel/core/vgacheckpoint.hpp"
+#include "modules/vgaparallel/core/vgaglobalsampled.hpp"
+#include "modules/vgaparallel/core/vgametricglobalradixheap.hpp"
+#include "modules/vgaparallel/core/vgametricglobalresumable.hpp"
+#include "modules/vgaparallel/core/vgashardmerge.hpp"
+#include "modules/vgaparallel/core/vgavisualglobalbitparallel.hpp"
+#include "modules/vgaparallel/core/vgavisualglobalresumable.hpp"
+#include "modules/vgaparallel/core/vgavisuallocalbitset.hpp"
+
 #include "salalib/vgamodules/vgaangularopenmp.hpp"
 #include "salalib/vgamodules/vgametricopenmp.hpp"
 #include "salalib/vgamodules/vgavisualglobalopenmp.hpp"
 #include "salalib/vgamodules/vgavisuallocaladjmatrix.hpp"
 #include "salalib/vgamodules/vgavisuallocalopenmp.hpp"
 
+#include "vgashardedrun.hpp"
+
 #include "qtgui/mainwindowhelpers.hpp"
 
+#include <QDir>
+#include <QFileDialog>
 #include <QInputDialog>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QThread>
+
+#include <limits>
+#include <sstream>
 
 bool VGAParallelMainWindow::createMenus(MainWindow *mainWindow) {
     QMenu *toolsMenu = MainWindowHelpers::getOrAddRootMenu(mainWindow, tr("&Tools"));
@@ -26,6 +44,15 @@ bool VGAParallelMainWindow::createMenus(MainWindow *mainWindow) {
     connect(visualGlobalAct, &QAction::triggered, this,
             [this, mainWindow] { OnVGAParallel(mainWindow, AnalysisType::VISUAL_GLOBAL_OPENMP); });
     vgaParallelMenu->addAction(visualGlobalAct);
+    QAction *visualGlobalBitParallelAct =
+        new QAction(tr("Global Visibility (Bit-parallel)"), mainWindow);
+    visualGlobalBitParallelAct->setStatusTip(
+        tr("Global visibility analysis searching from many points at once, fastest on dense "
+           "graphs"));
+    connect(visualGlobalBitParallelAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::VISUAL_GLOBAL_BITPARALLEL);
+    });
+    vgaParallelMenu->addAction(visualGlobalBitParallelAct);
     QAction *visualLocalAct = new QAction(tr("Local Visibility"), mainWindow);
     connect(visualLocalAct, &QAction::triggered, this,
             [this, mainWindow] { OnVGAParallel(mainWindow, AnalysisType::VISUAL_LOCAL_OPENMP); });
@@ -36,14 +63,109 @@ bool VGAParallelMainWindow::createMenus(MainWindow *mainWindow) {
         OnVGAParallel(mainWindow, AnalysisType::VISUAL_LOCAL_ADJMATRIX);
     });
     vgaParallelMenu->addAction(visualLocalAdjMatrixAct);
+    QAction *visualLocalBitsetAct =
+        new QAction(tr("Local Visibility (Compressed Bitsets)"), mainWindow);
+    visualLocalBitsetAct->setStatusTip(
+        tr("Local visibility analysis of large maps within a set amount of memory"));
+    connect(visualLocalBitsetAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::VISUAL_LOCAL_BITSET);
+    });
+    vgaParallelMenu->addAction(visualLocalBitsetAct);
     QAction *metricAct = new QAction(tr("Global Metric"), mainWindow);
     connect(metricAct, &QAction::triggered, this,
             [this, mainWindow] { OnVGAParallel(mainWindow, AnalysisType::METRIC_OPENMP); });
     vgaParallelMenu->addAction(metricAct);
+    QAction *metricRadixHeapAct = new QAction(tr("Global Metric (Radix Heap)"), mainWindow);
+    metricRadixHeapAct->setStatusTip(
+        tr("Global metric analysis with searches suited to distances that only grow"));
+    connect(metricRadixHeapAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::METRIC_GLOBAL_RADIXHEAP);
+    });
+    vgaParallelMenu->addAction(metricRadixHeapAct);
     QAction *angularAct = new QAction(tr("Global Angular"), mainWindow);
     connect(angularAct, &QAction::triggered, this,
             [this, mainWindow] { OnVGAParallel(mainWindow, AnalysisType::ANGULAR_OPENMP); });
     vgaParallelMenu->addAction(angularAct);
+    QAction *angularBucketedAct = new QAction(tr("Global Angular (Bucketed)"), mainWindow);
+    angularBucketedAct->setStatusTip(
+        tr("Global angular analysis with turns rounded to angular bins, for large maps"));
+    connect(angularBucketedAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::ANGULAR_GLOBAL_BUCKETED);
+    });
+    vgaParallelMenu->addAction(angularBucketedAct);
+
+    vgaParallelMenu->addSeparator();
+    QAction *visualGlobalResumableAct =
+        new QAction(tr("Global Visibility (Resumable)"), mainWindow);
+    visualGlobalResumableAct->setStatusTip(
+        tr("Global visibility analysis that can be resumed after it is cancelled"));
+    connect(visualGlobalResumableAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::VISUAL_GLOBAL_RESUMABLE);
+    });
+    vgaParallelMenu->addAction(visualGlobalResumableAct);
+    QAction *metricResumableAct = new QAction(tr("Global Metric (Resumable)"), mainWindow);
+    metricResumableAct->setStatusTip(
+        tr("Global metric analysis that can be resumed after it is cancelled"));
+    connect(metricResumableAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::METRIC_GLOBAL_RESUMABLE);
+    });
+    vgaParallelMenu->addAction(metricResumableAct);
+
+    vgaParallelMenu->addSeparator();
+    QAction *visualShardedAct = new QAction(tr("Global Visibility (Sharded)"), mainWindow);
+    visualShardedAct->setStatusTip(
+        tr("Global visibility analysis split between separate processes or computers"));
+    connect(visualShardedAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::VISUAL_GLOBAL_SHARDED);
+    });
+    vgaParallelMenu->addAction(visualShardedAct);
+    QAction *metricShardedAct = new QAction(tr("Global Metric (Sharded)"), mainWindow);
+    metricShardedAct->setStatusTip(
+        tr("Global metric analysis split between separate processes or computers"));
+    connect(metricShardedAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::METRIC_GLOBAL_SHARDED);
+    });
+    vgaParallelMenu->addAction(metricShardedAct);
+    QAction *mergeShardsAct = new QAction(tr("Merge Shard Results..."), mainWindow);
+    mergeShardsAct->setStatusTip(
+        tr("Bring the results of shards run on other computers into the map"));
+    connect(mergeShardsAct, &QAction::triggered, this,
+            [this, mainWindow] { OnVGAParallel(mainWindow, AnalysisType::MERGE_SHARDS); });
+    vgaParallelMenu->addAction(mergeShardsAct);
+
+    vgaParallelMenu->addSeparator();
+    QAction *visualSampledAct = new QAction(tr("Global Visibility (Sampled)"), mainWindow);
+    visualSampledAct->setStatusTip(
+        tr("Estimate global visibility from a sample of points, with the error of each"));
+    connect(visualSampledAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::VISUAL_GLOBAL_SAMPLED);
+    });
+    vgaParallelMenu->addAction(visualSampledAct);
+    QAction *metricSampledAct = new QAction(tr("Global Metric (Sampled)"), mainWindow);
+    metricSampledAct->setStatusTip(
+        tr("Estimate global metric depth from a sample of points, with the error of each"));
+    connect(metricSampledAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::METRIC_SAMPLED);
+    });
+    vgaParallelMenu->addAction(metricSampledAct);
+    QAction *angularSampledAct = new QAction(tr("Global Angular (Sampled)"), mainWindow);
+    angularSampledAct->setStatusTip(
+        tr("Estimate global angular depth from a sample of points, with the error of each"));
+    connect(angularSampledAct, &QAction::triggered, this, [this, mainWindow] {
+        OnVGAParallel(mainWindow, AnalysisType::ANGULAR_SAMPLED);
+    });
+    vgaParallelMenu->addAction(angularSampledAct);
+
+    vgaParallelMenu->addSeparator();
+    QAction *compactGraphsAct = new QAction(tr("Compact Graph Storage"), mainWindow);
+    compactGraphsAct->setStatusTip(
+        tr("Delta encode the copy of the visibility graph that the analyses above build, so "
+           "that it takes less memory"));
+    compactGraphsAct->setCheckable(true);
+    compactGraphsAct->setChecked(m_compactGraphs);
+    connect(compactGraphsAct, &QAction::toggled, this,
+            [this](bool checked) { m_compactGraphs = checked; });
+    vgaParallelMenu->addAction(compactGraphsAct);
 
     return true;
 }
@@ -54,12 +176,6 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
     if (graphDoc == nullptr)
         return;
 
-    if (graphDoc->m_communicator) {
-        QMessageBox::warning(mainWindow, tr("Warning"),
-                             tr("Please wait, another process is running"), QMessageBox::Ok,
-                             QMessageBox::Ok);
-        return;
-    }
     if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::LATTICEMAP) {
         QMessageBox::warning(mainWindow, tr("Warning"),
                              tr("Please make sure the displayed map is a vga map"), QMessageBox::Ok,
@@ -67,7 +183,7 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
         return;
     }
 
-    graphDoc->m_communicator = new CMSCommunicator();
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
 
     switch (analysisType) {
     case AnalysisType::VISUAL_GLOBAL_OPENMP: {
@@ -76,28 +192,63 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
         QString radiusText = QInputDialog::getText(
             mainWindow, tr("Visibility radius"),
             tr("This is the standard global-visibility analysis, parallelised "
-               "with OpenMP.\nRadius can be from 1 to 99 or n"),
+               "with OpenMP.\nRadius can be from 1 to 99 or n, several radii separated by "
+               "commas are\ncalculated together in a single pass"),
+            QLineEdit::Normal, "n", &ok);
+        if (!ok)
+            return;
+        auto radii = ConvertForVisibilityRadii(mainWindow, radiusText.toStdString());
+        if (!radii)
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        auto radius = radii->front();
+        if (radii->size() == 1) {
+            comm->setAnalysis(std::unique_ptr<IAnalysis>(
+                new VGAVisualGlobalOpenMP(map.getInternalMap(), radius, false)));
+        } else {
+            // several radii are calculated together, from a single traversal
+            // of each point
+            auto analysis =
+                std::make_unique<VGAVisualGlobalResumable>(map.getInternalMap(), *radii);
+            analysis->setGraphStorage(getGraphStorage());
+            comm->setAnalysis(std::move(analysis));
+        }
+        comm->setPostAnalysisFunc(
+            [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+                map.overrideDisplayedAttribute(-2);
+                map.setDisplayedAttribute(getColumnWithRadius(
+                    VGAVisualGlobalResumable::Column::VISUAL_INTEGRATION_HH, radius));
+            });
+        break;
+    }
+    case AnalysisType::VISUAL_GLOBAL_BITPARALLEL: {
+        bool ok;
+        QString radiusText = QInputDialog::getText(
+            mainWindow, tr("Visibility radius"),
+            tr("This is the global-visibility analysis, searching from %1 points at a "
+               "time.\nRadius can be from 1 to 99 or n")
+                .arg(VGAVisualGlobalBitParallel::BATCH_SIZE),
             QLineEdit::Normal, "n", &ok);
         if (!ok)
             return;
         auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
-        auto radius = ConvertForVisibility(radiusText.toStdString());
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
-            new VGAVisualGlobalOpenMP(map.getInternalMap(), radius, false)));
-        graphDoc->m_communicator->setPostAnalysisFunc(
+        auto radius = static_cast<int>(ConvertForVisibility(radiusText.toStdString()));
+        auto analysis = std::make_unique<VGAVisualGlobalBitParallel>(map.getInternalMap(), radius);
+        analysis->setGraphStorage(getGraphStorage());
+        comm->setAnalysis(std::move(analysis));
+        comm->setPostAnalysisFunc(
             [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
                 map.overrideDisplayedAttribute(-2);
-                map.setDisplayedAttribute(VGAVisualGlobalOpenMP::getColumnWithRadius(
-                    VGAVisualGlobalOpenMP::Column::VISUAL_INTEGRATION_HH, radius));
+                map.setDisplayedAttribute(getColumnWithRadius(
+                    VGAVisualGlobalBitParallel::Column::VISUAL_INTEGRATION_HH, radius));
             });
         break;
     }
     case AnalysisType::VISUAL_LOCAL_OPENMP: {
         auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
-        graphDoc->m_communicator->setAnalysis(
+        comm->setAnalysis(
             std::unique_ptr<IAnalysis>(new VGAVisualLocalOpenMP(map.getInternalMap())));
-        graphDoc->m_communicator->setPostAnalysisFunc([&map](std::unique_ptr<IAnalysis> &analysis,
-                                                             AnalysisResult &) {
+        comm->setPostAnalysisFunc([&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
             map.overrideDisplayedAttribute(-2);
             map.setDisplayedAttribute(VGAVisualLocalOpenMP::Column::VISUAL_CLUSTERING_COEFFICIENT);
         });
@@ -105,14 +256,31 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
     }
     case AnalysisType::VISUAL_LOCAL_ADJMATRIX: {
         auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
-        graphDoc->m_communicator->setAnalysis(
+        comm->setAnalysis(
             std::unique_ptr<IAnalysis>(new VGAVisualLocalAdjMatrix(map.getInternalMap(), false)));
-        graphDoc->m_communicator->setPostAnalysisFunc(
-            [&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
-                map.overrideDisplayedAttribute(-2);
-                map.setDisplayedAttribute(
-                    VGAVisualLocalAdjMatrix::Column::VISUAL_CLUSTERING_COEFFICIENT);
-            });
+        comm->setPostAnalysisFunc([&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+            map.overrideDisplayedAttribute(-2);
+            map.setDisplayedAttribute(
+                VGAVisualLocalAdjMatrix::Column::VISUAL_CLUSTERING_COEFFICIENT);
+        });
+        break;
+    }
+    case AnalysisType::VISUAL_LOCAL_BITSET: {
+        bool ok;
+        int memoryBudget = QInputDialog::getInt(
+            mainWindow, tr("Memory budget"),
+            tr("This is the local-visibility analysis, keeping the visible sets of the points "
+               "as compressed bitsets.\nMemory to use for the visible sets, in MB"),
+            4096, 64, std::numeric_limits<int>::max(), 256, &ok);
+        if (!ok)
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        comm->setAnalysis(std::make_unique<VGAVisualLocalBitset>(
+            map.getInternalMap(), static_cast<size_t>(memoryBudget) * 1024 * 1024));
+        comm->setPostAnalysisFunc([&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+            map.overrideDisplayedAttribute(-2);
+            map.setDisplayedAttribute(VGAVisualLocalBitset::Column::VISUAL_CLUSTERING_COEFFICIENT);
+        });
         break;
     }
     case AnalysisType::METRIC_OPENMP: {
@@ -126,9 +294,9 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
             return;
         auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
         auto radius = ConvertForMetric(radiusText.toStdString());
-        graphDoc->m_communicator->setAnalysis(
+        comm->setAnalysis(
             std::unique_ptr<IAnalysis>(new VGAMetricOpenMP(map.getInternalMap(), radius, false)));
-        graphDoc->m_communicator->setPostAnalysisFunc(
+        comm->setPostAnalysisFunc(
             [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
                 map.overrideDisplayedAttribute(-2);
                 map.setDisplayedAttribute(VGAMetricOpenMP::getColumnWithRadius(
@@ -137,6 +305,29 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
             });
         break;
     }
+    case AnalysisType::METRIC_GLOBAL_RADIXHEAP: {
+        bool ok;
+        QString radiusText = QInputDialog::getText(
+            mainWindow, tr("Metric radius"),
+            tr("This is the global-metric analysis, searching with a radix heap.\nRadius can be "
+               "any positive number or n for unlimited radius"),
+            QLineEdit::Normal, "n", &ok);
+        if (!ok)
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        auto radius = ConvertForMetric(radiusText.toStdString());
+        auto analysis = std::make_unique<VGAMetricGlobalRadixHeap>(map.getInternalMap(), radius);
+        analysis->setGraphStorage(getGraphStorage());
+        comm->setAnalysis(std::move(analysis));
+        comm->setPostAnalysisFunc(
+            [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+                map.overrideDisplayedAttribute(-2);
+                map.setDisplayedAttribute(getColumnWithRadius(
+                    VGAMetricGlobalRadixHeap::Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE, radius,
+                    map.getInternalMap().getRegion().width()));
+            });
+        break;
+    }
     case AnalysisType::ANGULAR_OPENMP: {
 
         bool ok;
@@ -149,9 +340,9 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
             return;
         auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
         auto radius = ConvertForMetric(radiusText.toStdString());
-        graphDoc->m_communicator->setAnalysis(
+        comm->setAnalysis(
             std::unique_ptr<IAnalysis>(new VGAAngularOpenMP(map.getInternalMap(), radius, false)));
-        graphDoc->m_communicator->setPostAnalysisFunc(
+        comm->setPostAnalysisFunc(
             [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
                 map.overrideDisplayedAttribute(-2);
                 map.setDisplayedAttribute(VGAAngularOpenMP::getColumnWithRadius(
@@ -160,6 +351,216 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
             });
         break;
     }
+    case AnalysisType::ANGULAR_GLOBAL_BUCKETED: {
+        bool ok;
+        QString radiusText = QInputDialog::getText(
+            mainWindow, tr("Angular radius"),
+            tr("This is the global-angular analysis, with turns rounded to angular bins.\nRadius "
+               "can be any positive number or n for unlimited radius"),
+            QLineEdit::Normal, "n", &ok);
+        if (!ok)
+            return;
+        int bins = QInputDialog::getInt(
+            mainWindow, tr("Angular bins"),
+            tr("Number of bins around the circle that turns are rounded to.\nMore bins are "
+               "closer to the exact angles, fewer are faster"),
+            VGAAngularGlobalBucketed::DEFAULT_BINS, VGAAngularGlobalBucketed::MIN_BINS,
+            VGAAngularGlobalBucketed::MAX_BINS, 1, &ok);
+        if (!ok)
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        auto radius = ConvertForMetric(radiusText.toStdString());
+        auto analysis =
+            std::make_unique<VGAAngularGlobalBucketed>(map.getInternalMap(), radius, bins);
+        analysis->setGraphStorage(getGraphStorage());
+        comm->setAnalysis(std::move(analysis));
+        comm->setPostAnalysisFunc(
+            [&map, radius, bins](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+                map.overrideDisplayedAttribute(-2);
+                map.setDisplayedAttribute(VGAAngularGlobalBucketed::getColumnWithBinsAndRadius(
+                    VGAAngularGlobalBucketed::Column::ANGULAR_MEAN_DEPTH, bins, radius,
+                    map.getInternalMap().getRegion().width()));
+            });
+        break;
+    }
+    case AnalysisType::VISUAL_GLOBAL_RESUMABLE: {
+        bool ok;
+        QString radiusText = QInputDialog::getText(
+            mainWindow, tr("Visibility radius"),
+            tr("This is the global-visibility analysis, saving its progress so that it can be "
+               "resumed if cancelled.\nRadius can be from 1 to 99 or n, several radii "
+               "separated by commas are\ncalculated together in a single pass"),
+            QLineEdit::Normal, "n", &ok);
+        if (!ok)
+            return;
+        auto radii = ConvertForVisibilityRadii(mainWindow, radiusText.toStdString());
+        if (!radii)
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        auto radius = radii->front();
+        auto analysis = std::make_unique<VGAVisualGlobalResumable>(map.getInternalMap(), *radii);
+        analysis->setGraphStorage(getGraphStorage());
+        auto checkpointFile = getCheckpointFile(*graphDoc, analysis->getAnalysisKey());
+        offerToResume(mainWindow, checkpointFile, analysis->getAnalysisKey());
+        analysis->setCheckpointFile(checkpointFile);
+        comm->setAnalysis(std::move(analysis));
+        comm->setPostAnalysisFunc(
+            [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+                map.overrideDisplayedAttribute(-2);
+                map.setDisplayedAttribute(getColumnWithRadius(
+                    VGAVisualGlobalResumable::Column::VISUAL_INTEGRATION_HH, radius));
+            });
+        break;
+    }
+    case AnalysisType::METRIC_GLOBAL_RESUMABLE: {
+        bool ok;
+        QString radiusText = QInputDialog::getText(
+            mainWindow, tr("Metric radius"),
+            tr("This is the global-metric analysis, saving its progress so that it can be "
+               "resumed if cancelled.\nRadius can be any positive number or n for unlimited "
+               "radius"),
+            QLineEdit::Normal, "n", &ok);
+        if (!ok)
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        auto radius = ConvertForMetric(radiusText.toStdString());
+        auto analysis = std::make_unique<VGAMetricGlobalResumable>(map.getInternalMap(), radius);
+        analysis->setGraphStorage(getGraphStorage());
+        auto checkpointFile = getCheckpointFile(*graphDoc, analysis->getAnalysisKey());
+        offerToResume(mainWindow, checkpointFile, analysis->getAnalysisKey());
+        analysis->setCheckpointFile(checkpointFile);
+        comm->setAnalysis(std::move(analysis));
+        comm->setPostAnalysisFunc(
+            [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+                map.overrideDisplayedAttribute(-2);
+                map.setDisplayedAttribute(getColumnWithRadius(
+                    VGAMetricGlobalResumable::Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE, radius,
+                    map.getInternalMap().getRegion().width()));
+            });
+        break;
+    }
+    case AnalysisType::VISUAL_GLOBAL_SHARDED: {
+        bool ok;
+        QString radiusText = QInputDialog::getText(
+            mainWindow, tr("Visibility radius"),
+            tr("This is the global-visibility analysis, split into shards that run as "
+               "separate processes.\nRadius can be from 1 to 99 or n, several radii separated "
+               "by commas are\ncalculated together in a single pass"),
+            QLineEdit::Normal, "n", &ok);
+        if (!ok)
+            return;
+        auto radii = ConvertForVisibilityRadii(mainWindow, radiusText.toStdString());
+        if (!radii)
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        auto radius = radii->front();
+        if (!setUpShards(mainWindow, *graphDoc, *comm, VGAShard::Analysis::VISUAL_GLOBAL,
+                         std::vector<double>(radii->begin(), radii->end())))
+            return;
+        comm->setPostAnalysisFunc(
+            [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+                map.overrideDisplayedAttribute(-2);
+                map.setDisplayedAttribute(getColumnWithRadius(
+                    VGAVisualGlobalResumable::Column::VISUAL_INTEGRATION_HH, radius));
+            });
+        break;
+    }
+    case AnalysisType::METRIC_GLOBAL_SHARDED: {
+        bool ok;
+        QString radiusText = QInputDialog::getText(
+            mainWindow, tr("Metric radius"),
+            tr("This is the global-metric analysis, split into shards that run as separate "
+               "processes.\nRadius can be any positive number or n for unlimited radius"),
+            QLineEdit::Normal, "n", &ok);
+        if (!ok)
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        auto radius = ConvertForMetric(radiusText.toStdString());
+        if (!setUpShards(mainWindow, *graphDoc, *comm, VGAShard::Analysis::METRIC_GLOBAL,
+                         {radius}))
+            return;
+        comm->setPostAnalysisFunc(
+            [&map, radius](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+                map.overrideDisplayedAttribute(-2);
+                map.setDisplayedAttribute(getColumnWithRadius(
+                    VGAMetricGlobalResumable::Column::METRIC_MEAN_SHORTEST_PATH_DISTANCE, radius,
+                    map.getInternalMap().getRegion().width()));
+            });
+        break;
+    }
+    case AnalysisType::MERGE_SHARDS: {
+        QString folder =
+            QFileDialog::getExistingDirectory(mainWindow, tr("Folder of the shard results"));
+        if (folder.isEmpty())
+            return;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        comm->setAnalysis(
+            std::make_unique<VGAShardMerge>(map.getInternalMap(), folder.toStdString()));
+        comm->setPostAnalysisFunc(
+            [&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &result) {
+                if (!result.getAttributes().empty()) {
+                    map.overrideDisplayedAttribute(-2);
+                    map.setDisplayedAttribute(result.getAttributes().front());
+                }
+            });
+        break;
+    }
+    case AnalysisType::VISUAL_GLOBAL_SAMPLED:
+    case AnalysisType::METRIC_SAMPLED:
+    case AnalysisType::ANGULAR_SAMPLED: {
+        VGAGlobalSampled::Settings settings;
+        bool ok;
+        if (analysisType == AnalysisType::VISUAL_GLOBAL_SAMPLED) {
+            settings.measure = VGAGlobalSampled::Measure::VISUAL;
+            QString radiusText = QInputDialog::getText(
+                mainWindow, tr("Visibility radius"),
+                tr("This is the global-visibility analysis, estimated from a sample of "
+                   "points.\nRadius can be from 1 to 99 or n"),
+                QLineEdit::Normal, "n", &ok);
+            if (!ok)
+                return;
+            settings.radius = ConvertForVisibility(radiusText.toStdString());
+        } else {
+            settings.measure = analysisType == AnalysisType::METRIC_SAMPLED
+                                   ? VGAGlobalSampled::Measure::METRIC
+                                   : VGAGlobalSampled::Measure::ANGULAR;
+            QString radiusText = QInputDialog::getText(
+                mainWindow, tr("Radius"),
+                tr("This is the global analysis, estimated from a sample of points.\nRadius "
+                   "can be any positive number or n for unlimited radius"),
+                QLineEdit::Normal, "n", &ok);
+            if (!ok)
+                return;
+            settings.radius = ConvertForMetric(radiusText.toStdString());
+        }
+        double targetError = QInputDialog::getDouble(
+            mainWindow, tr("Target error"),
+            tr("Error of the estimated mean depth to aim for, in percent.\nThe sample grows "
+               "until most points are expected to be within it"),
+            5.0, 0.1, 50.0, 1, &ok);
+        if (!ok)
+            return;
+        settings.targetError = targetError / 100.0;
+        QStringList samplings = {tr("Stratified"), tr("Random")};
+        QString sampling = QInputDialog::getItem(mainWindow, tr("Sampling"),
+                                                 tr("How to pick the sample points"), samplings,
+                                                 0, false, &ok);
+        if (!ok)
+            return;
+        settings.sampling = sampling == samplings[0] ? VGAGlobalSampled::Sampling::STRATIFIED
+                                                     : VGAGlobalSampled::Sampling::RANDOM;
+        auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+        auto analysis = std::make_unique<VGAGlobalSampled>(map.getInternalMap(), settings);
+        analysis->setGraphStorage(getGraphStorage());
+        comm->setAnalysis(std::move(analysis));
+        comm->setPostAnalysisFunc(
+            [&map, settings](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &) {
+                map.overrideDisplayedAttribute(-2);
+                map.setDisplayedAttribute(VGAGlobalSampled::getMainColumn(
+                    settings, map.getInternalMap().getRegion().width()));
+            });
+        break;
+    }
     case AnalysisType::NONE: {
         QMessageBox::warning(mainWindow, tr("Warning"), tr("Please select an analysis type"),
                              QMessageBox::Ok, QMessageBox::Ok);
@@ -167,13 +568,96 @@ void VGAParallelMainWindow::OnVGAParallel(MainWindow *mainWindow,
     }
     }
 
-    graphDoc->m_communicator->SetFunction(CMSCommunicator::FROMCONNECTOR);
-    graphDoc->m_communicator->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
-    graphDoc->m_communicator->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH,
-                                                    QGraphDoc::NEW_DATA);
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
+
+    // the analysis only touches the displayed vga map, so it may run alongside
+    // analyses of other maps
+    graphDoc->submitJob(comm.release(), tr("Running parallel visibility graph analysis..."),
+                        graphDoc->getDisplayedLayer());
+}
+
+std::string VGAParallelMainWindow::getCheckpointFile(QGraphDoc &graphDoc,
+                                                     const std::string &analysisKey) const {
+    // checkpoints of saved graphs are kept next to them so that they can be
+    // picked up after the graph is reopened, others only last for the session
+    QString base = graphDoc.m_opened_name;
+    if (base.isEmpty()) {
+        base = QDir::temp().filePath(
+            QString("depthmapX-%1").arg(reinterpret_cast<quintptr>(&graphDoc), 0, 16));
+    }
+    QString mapName = QString::fromStdString(
+        graphDoc.m_meta_graph->getDisplayedLatticeMap().getInternalMap().getName());
+    size_t key = qHash(mapName + "/" + QString::fromStdString(analysisKey));
+    return (base + QString(".%1.ckpt").arg(key, 0, 16)).toStdString();
+}
+
+bool VGAParallelMainWindow::setUpShards(MainWindow *mainWindow, QGraphDoc &graphDoc,
+                                        CMSCommunicator &comm, VGAShard::Analysis analysis,
+                                        const std::vector<double> &radii) const {
+    bool ok;
+    int shardCount = QInputDialog::getInt(
+        mainWindow, tr("Number of shards"),
+        tr("Number of parts to split the analysis into. Each part runs as its own process"),
+        std::max(2, QThread::idealThreadCount() / 2), 1, 1024, 1, &ok);
+    if (!ok)
+        return false;
+    QStringList modes = {tr("Run the shards on this computer"),
+                         tr("Only write the shards to a folder, to run them elsewhere")};
+    QString mode = QInputDialog::getItem(mainWindow, tr("Sharded analysis"),
+                                         tr("Where to run the shards"), modes, 0, false, &ok);
+    if (!ok)
+        return false;
+    auto &map = graphDoc.m_meta_graph->getDisplayedLatticeMap();
+
+    if (mode == modes[0]) {
+        // a folder that belongs to the map and analysis, so that a cancelled
+        // run continues when started again
+        auto folder = getCheckpointFile(graphDoc, VGAShard::getAnalysisKey(analysis, radii));
+        auto shardedRun = std::make_unique<VGAShardedRun>(
+            map.getInternalMap(), analysis, radii, static_cast<size_t>(shardCount),
+            QString::fromStdString(folder + ".shards"));
+        shardedRun->setGraphStorage(getGraphStorage());
+        comm.setAnalysis(std::move(shardedRun));
+        return true;
+    }
+
+    QString folder =
+        QFileDialog::getExistingDirectory(mainWindow, tr("Folder to write the shards to"));
+    if (folder.isEmpty())
+        return false;
+    auto manifestFiles =
+        VGAShard::prepare(VGACSRGraph::fromPointMap(map.getInternalMap(), getGraphStorage()),
+                          analysis, radii, static_cast<size_t>(shardCount), folder.toStdString());
+    QMessageBox::information(
+        mainWindow, tr("Sharded analysis"),
+        tr("%1 shards were written to %2.\nRun \"vgashardworker <shard file>\" for each of the "
+           ".vgashard files, on any computer with a copy of the folder. Then copy the .result "
+           "files back and use \"Merge Shard Results...\" to bring them into the map.")
+            .arg(manifestFiles.size())
+            .arg(folder),
+        QMessageBox::Ok, QMessageBox::Ok);
+    return false;
+}
 
-    graphDoc->CreateWaitDialog(tr("Calculating shortest path..."));
-    graphDoc->m_thread.render(graphDoc);
+void VGAParallelMainWindow::offerToResume(MainWindow *mainWindow, const std::string &checkpointFile,
+                                          const std::string &analysisKey) const {
+    auto checkpoint = VGACheckpoint::load(checkpointFile);
+    if (!checkpoint.has_value() || checkpoint->getAnalysisKey() != analysisKey ||
+        checkpoint->getSourceCount() == 0) {
+        return;
+    }
+    int percent =
+        static_cast<int>(100 * checkpoint->getDoneCount() / checkpoint->getSourceCount());
+    if (QMessageBox::question(mainWindow, tr("Resume analysis"),
+                              tr("An interrupted run of this analysis was found (%1% complete).\n"
+                                 "Resume from where it was left?")
+                                  .arg(percent),
+                              QMessageBox::Yes | QMessageBox::No,
+                              QMessageBox::Yes) == QMessageBox::No) {
+        VGACheckpoint::remove(checkpointFile);
+    }
 }
 
 // Duplicating the radius converters here to keep the module self contained
@@ -194,6 +678,31 @@ double VGAParallelMainWindow::ConvertForVisibility(const std::string &radius) co
     return static_cast<double>(rad);
 }
 
+std::optional<std::vector<int>>
+VGAParallelMainWindow::ConvertForVisibilityRadii(QWidget *parent, const std::string &radii) const {
+    std::vector<int> converted;
+    std::stringstream stream(radii);
+    std::string radius;
+    try {
+        while (std::getline(stream, radius, ',')) {
+            radius.erase(0, radius.find_first_not_of(' '));
+            radius.erase(radius.find_last_not_of(' ') + 1);
+            converted.push_back(static_cast<int>(ConvertForVisibility(radius)));
+        }
+    } catch (const genlib::RuntimeException &e) {
+        QMessageBox::warning(parent, tr("Warning"), QString::fromStdString(e.what()),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return std::nullopt;
+    }
+    if (converted.empty()) {
+        QMessageBox::warning(parent, tr("Warning"),
+                             tr("Please give at least one radius for the visibility analysis"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return std::nullopt;
+    }
+    return converted;
+}
+
 double VGAParallelMainWindow::ConvertForMetric(const std::string &radius) const {
     if (radius == "n") {
         return -1.0;
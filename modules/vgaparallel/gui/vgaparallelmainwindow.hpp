@@ -4,20 +4,55 @@
 
 #pragma once
 
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+#include "modules/vgaparallel/core/vgashard.hpp"
+
 #include "qtgui/imainwindowmodule.hpp"
 
+#include <optional>
+#include <vector>
+
 class VGAParallelMainWindow : public IMainWindowModule {
   private:
     enum class AnalysisType {
         NONE,
         VISUAL_LOCAL_OPENMP,
         VISUAL_LOCAL_ADJMATRIX,
+        VISUAL_LOCAL_BITSET,
         VISUAL_GLOBAL_OPENMP,
+        VISUAL_GLOBAL_BITPARALLEL,
         METRIC_OPENMP,
-        ANGULAR_OPENMP
+        METRIC_GLOBAL_RADIXHEAP,
+        ANGULAR_OPENMP,
+        ANGULAR_GLOBAL_BUCKETED,
+        VISUAL_GLOBAL_RESUMABLE,
+        METRIC_GLOBAL_RESUMABLE,
+        VISUAL_GLOBAL_SAMPLED,
+        METRIC_SAMPLED,
+        ANGULAR_SAMPLED,
+        VISUAL_GLOBAL_SHARDED,
+        METRIC_GLOBAL_SHARDED,
+        MERGE_SHARDS
     };
+    // delta encoded graphs take less memory for a little more time
+    bool m_compactGraphs = false;
+    VGACSRGraph::Storage getGraphStorage() const {
+        return m_compactGraphs ? VGACSRGraph::Storage::DELTA_VARINT : VGACSRGraph::Storage::PLAIN;
+    }
+
     double ConvertForVisibility(const std::string &radius) const;
+    // a comma separated list of radii, in the order given. Invalid input is
+    // reported to the user and gives nothing
+    std::optional<std::vector<int>> ConvertForVisibilityRadii(QWidget *parent,
+                                                              const std::string &radii) const;
     double ConvertForMetric(const std::string &radius) const;
+    std::string getCheckpointFile(QGraphDoc &graphDoc, const std::string &analysisKey) const;
+    // asks for the number of shards and runs them here, or only writes them to
+    // a folder to be run elsewhere. Returns whether the analysis should be run
+    bool setUpShards(MainWindow *mainWindow, QGraphDoc &graphDoc, CMSCommunicator &comm,
+                     VGAShard::Analysis analysis, const std::vector<double> &radii) const;
+    void offerToResume(MainWindow *mainWindow, const std::string &checkpointFile,
+                       const std::string &analysisKey) const;
 
   private slots:
     void OnVGAParallel(MainWindow *mainWindow, VGAParallelMainWindow::AnalysisType analysisType);
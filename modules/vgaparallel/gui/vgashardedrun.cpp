@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "vgashardedrun.hpp"
+
+#include "modules/vgaparallel/core/vgashardmerge.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+
+#include "salalib/genlib/exceptions.hpp"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QProcess>
+#include <QThread>
+
+#include <memory>
+#include <numeric>
+
+QString VGAShardedRun::getWorkerProgram() {
+    QString program = QDir(QCoreApplication::applicationDirPath()).filePath("vgashardworker");
+    if (QFileInfo::exists(program) || QFileInfo::exists(program + ".exe")) {
+        return program;
+    }
+    return "vgashardworker";
+}
+
+AnalysisResult VGAShardedRun::run(Communicator *comm) {
+    AnalysisTelemetry *telemetry = AnalysisTelemetry::of(comm);
+    if (telemetry) {
+        telemetry->setPhase("building graph");
+    }
+    VGACSRGraph graph = VGACSRGraph::fromPointMap(m_map, m_graphStorage);
+    auto manifestFiles =
+        VGAShard::prepare(graph, m_analysis, m_radii, m_shardCount, m_folder.toStdString());
+
+    // the workers share the cores between them
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    int threadsPerWorker =
+        std::max(1, QThread::idealThreadCount() / static_cast<int>(manifestFiles.size()));
+    environment.insert("OMP_NUM_THREADS", QString::number(threadsPerWorker));
+
+    std::vector<std::unique_ptr<QProcess>> workers;
+    for (auto &manifestFile : manifestFiles) {
+        auto worker = std::make_unique<QProcess>();
+        worker->setProcessEnvironment(environment);
+        worker->start(getWorkerProgram(), {QString::fromStdString(manifestFile)});
+        if (!worker->waitForStarted()) {
+            for (auto &started : workers) {
+                started->kill();
+                started->waitForFinished();
+            }
+            throw genlib::RuntimeException("Unable to start the shard worker " +
+                                           getWorkerProgram().toStdString());
+        }
+        workers.push_back(std::move(worker));
+    }
+
+    if (telemetry) {
+        telemetry->setPhase("traversing");
+    }
+    if (comm) {
+        comm->CommPostMessage(Communicator::NUM_RECORDS, graph.nodeCount());
+    }
+    // sources done by each worker, as last reported on their output
+    std::vector<size_t> progress(workers.size(), 0);
+    bool running = true;
+    while (running) {
+        running = false;
+        for (size_t i = 0; i < workers.size(); i++) {
+            QProcess &worker = *workers[i];
+            if (worker.state() != QProcess::NotRunning) {
+                worker.waitForFinished(100);
+                running |= worker.state() != QProcess::NotRunning;
+            }
+            while (worker.canReadLine()) {
+                QStringList words = QString(worker.readLine()).split(' ');
+                if (words.size() == 3 && words[0] == "progress") {
+                    progress[i] = words[1].toULongLong();
+                }
+            }
+        }
+        if (comm) {
+            comm->CommPostMessage(Communicator::CURRENT_RECORD,
+                                  std::accumulate(progress.begin(), progress.end(), size_t(0)));
+            if (comm->IsCancelled()) {
+                // the shard results saved so far stay in the folder for the next run
+                for (auto &worker : workers) {
+                    worker->kill();
+                    worker->waitForFinished();
+                }
+                throw Communicator::CancelledException();
+            }
+        }
+    }
+    for (auto &worker : workers) {
+        if (worker->exitStatus() != QProcess::NormalExit || worker->exitCode() != 0) {
+            throw genlib::RuntimeException("A shard worker failed: " +
+                                           worker->readAllStandardError().trimmed().toStdString());
+        }
+    }
+
+    AnalysisResult result = VGAShardMerge(m_map, m_folder.toStdString()).run(comm);
+    QDir(m_folder).removeRecursively();
+    return result;
+}
@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "modules/vgaparallel/core/vgacsrgraph.hpp"
+#include "modules/vgaparallel/core/vgashard.hpp"
+
+#include "salalib/ianalysis.hpp"
+
+#include <QString>
+
+class PointMap;
+
+/**
+ * @brief Runs a sharded analysis with one worker process per shard
+ *
+ * The shards are written to the folder and run by the shard worker on this
+ * computer. Shard results already in the folder are picked up, so a
+ * cancelled run continues where the workers were stopped. Once all the
+ * workers finish the results are merged into the map.
+ */
+class VGAShardedRun : public IAnalysis {
+  private:
+    PointMap &m_map;
+    VGAShard::Analysis m_analysis;
+    std::vector<double> m_radii;
+    size_t m_shardCount;
+    QString m_folder;
+    VGACSRGraph::Storage m_graphStorage = VGACSRGraph::Storage::PLAIN;
+
+  public:
+    VGAShardedRun(PointMap &map, VGAShard::Analysis analysis, std::vector<double> radii,
+                  size_t shardCount, QString folder)
+        : m_map(map), m_analysis(analysis), m_radii(std::move(radii)), m_shardCount(shardCount),
+          m_folder(std::move(folder)) {}
+    std::string getAnalysisName() const override { return "Sharded Analysis"; }
+    // the shards are written in this storage, for the workers to load as is
+    void setGraphStorage(VGACSRGraph::Storage graphStorage) { m_graphStorage = graphStorage; }
+    AnalysisResult run(Communicator *comm) override;
+
+    // the worker next to the application, or the one on the path
+    static QString getWorkerProgram();
+};
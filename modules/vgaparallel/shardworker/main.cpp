@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "modules/vgaparallel/core/vgashard.hpp"
+
+#include "salalib/genlib/comm.hpp"
+
+#include <exception>
+#include <iostream>
+
+namespace {
+    // reports progress on stdout, one "progress <done> <total>" line per block
+    class ConsoleCommunicator : public Communicator {
+        mutable size_t m_numRecords = 0;
+
+      public:
+        void CommPostMessage(size_t m, size_t x) const override {
+            if (m == Communicator::NUM_RECORDS) {
+                m_numRecords = x;
+            } else if (m == Communicator::CURRENT_RECORD) {
+                std::cout << "progress " << x << " " << m_numRecords << std::endl;
+            }
+        }
+    };
+} // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <shard manifest>" << std::endl;
+        return 2;
+    }
+    try {
+        ConsoleCommunicator comm;
+        VGAShard::run(argv[1], &comm);
+    } catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    std::cout << "done" << std::endl;
+    return 0;
+}
@@ -4,6 +4,8 @@
 
 #include "vgapathsmainwindow.hpp"
 
+#include "modules/vgaparallel/core/vgapointtopointpath.hpp"
+
 #include "salalib/vgamodules/extractlinkdata.hpp"
 #include "salalib/vgamodules/vgaangularshortestpath.hpp"
 #include "salalib/vgamodules/vgaisovistzone.hpp"
@@ -12,6 +14,7 @@
 #include "salalib/vgamodules/vgavisualshortestpath.hpp"
 
 #include "qtgui/mainwindowhelpers.hpp"
+#include "qtgui/views/mapview.hpp"
 
 #include <QMenuBar>
 #include <QMessageBox>
@@ -40,6 +43,52 @@ bool VGAPathsMainWindow::createMenus(MainWindow *mainWindow) {
             [this, mainWindow] { OnShortestPath(mainWindow, PathType::ANGULAR); });
     shortestPathSubMenu->addAction(angularShortestPathAct);
 
+    shortestPathSubMenu->addSeparator();
+    QAction *visibilityPointToPointAct =
+        new QAction(tr("Visibility Shortest Path (Bidirectional)"), this);
+    visibilityPointToPointAct->setStatusTip(
+        tr("Shortest visual path between two selected points, searched from both ends"));
+    connect(visibilityPointToPointAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPointToPointPath(mainWindow, PathType::VISUAL); });
+    shortestPathSubMenu->addAction(visibilityPointToPointAct);
+
+    QAction *metricPointToPointAct = new QAction(tr("Metric Shortest Path (Bidirectional)"), this);
+    metricPointToPointAct->setStatusTip(
+        tr("Shortest metric path between two selected points, searched from both ends"));
+    connect(metricPointToPointAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPointToPointPath(mainWindow, PathType::METRIC); });
+    shortestPathSubMenu->addAction(metricPointToPointAct);
+
+    QAction *angularPointToPointAct =
+        new QAction(tr("Angular Shortest Path (Bidirectional)"), this);
+    angularPointToPointAct->setStatusTip(
+        tr("Shortest angular path between two selected points, searched from both ends"));
+    connect(angularPointToPointAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPointToPointPath(mainWindow, PathType::ANGULAR); });
+    shortestPathSubMenu->addAction(angularPointToPointAct);
+
+    shortestPathSubMenu->addSeparator();
+    QAction *visibilityPreviewAct = new QAction(tr("Visibility Path Preview"), this);
+    visibilityPreviewAct->setStatusTip(
+        tr("Click a point and follow the mouse with the shortest visual path from it"));
+    connect(visibilityPreviewAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPathPreview(mainWindow, PathType::VISUAL); });
+    shortestPathSubMenu->addAction(visibilityPreviewAct);
+
+    QAction *metricPreviewAct = new QAction(tr("Metric Path Preview"), this);
+    metricPreviewAct->setStatusTip(
+        tr("Click a point and follow the mouse with the shortest metric path from it"));
+    connect(metricPreviewAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPathPreview(mainWindow, PathType::METRIC); });
+    shortestPathSubMenu->addAction(metricPreviewAct);
+
+    QAction *angularPreviewAct = new QAction(tr("Angular Path Preview"), this);
+    angularPreviewAct->setStatusTip(
+        tr("Click a point and follow the mouse with the shortest angular path from it"));
+    connect(angularPreviewAct, &QAction::triggered, this,
+            [this, mainWindow] { OnPathPreview(mainWindow, PathType::ANGULAR); });
+    shortestPathSubMenu->addAction(angularPreviewAct);
+
     QAction *extractLinkDataAct = new QAction(tr("&Extract Link Data"), this);
     extractLinkDataAct->setStatusTip(
         tr("Extracts data from the links and adds them to the attribute table"));
@@ -55,12 +104,6 @@ void VGAPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pathTyp
     if (graphDoc == nullptr)
         return;
 
-    if (graphDoc->m_communicator) {
-        QMessageBox::warning(mainWindow, tr("Warning"),
-                             tr("Please wait, another process is running"), QMessageBox::Ok,
-                             QMessageBox::Ok);
-        return;
-    }
     if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::LATTICEMAP) {
         QMessageBox::warning(mainWindow, tr("Warning"),
                              tr("Please make sure the displayed map is a VGA map"), QMessageBox::Ok,
@@ -77,14 +120,13 @@ void VGAPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pathTyp
     const PixelRef &pixelFrom = *latticeMap.getSelSet().begin();
     const PixelRef &pixelTo = *std::next(latticeMap.getSelSet().begin());
 
-    graphDoc->m_communicator = new CMSCommunicator();
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
     switch (pathType) {
     case PathType::VISUAL: {
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+        comm->setAnalysis(std::unique_ptr<IAnalysis>(
             new VGAVisualShortestPath(latticeMap.getInternalMap(), pixelFrom, pixelTo)));
-        graphDoc->m_communicator->setPostAnalysisFunc([&latticeMap](
-                                                          std::unique_ptr<IAnalysis> &analysis,
-                                                          AnalysisResult &analysisResult) {
+        comm->setPostAnalysisFunc([&latticeMap](std::unique_ptr<IAnalysis> &analysis,
+                                                AnalysisResult &analysisResult) {
             auto vgaAnalysis = dynamic_cast<VGAVisualShortestPath *>(analysis.get());
             vgaAnalysis->copyResultToMap(analysisResult.getAttributes(),
                                          analysisResult.getAttributeData(),
@@ -97,11 +139,10 @@ void VGAPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pathTyp
     case PathType::METRIC: {
         std::set<PixelRef> pixelsFrom;
         pixelsFrom.insert(pixelFrom);
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+        comm->setAnalysis(std::unique_ptr<IAnalysis>(
             new VGAMetricShortestPath(latticeMap.getInternalMap(), pixelsFrom, pixelTo)));
-        graphDoc->m_communicator->setPostAnalysisFunc([&latticeMap](
-                                                          std::unique_ptr<IAnalysis> &analysis,
-                                                          AnalysisResult &analysisResult) {
+        comm->setPostAnalysisFunc([&latticeMap](std::unique_ptr<IAnalysis> &analysis,
+                                                AnalysisResult &analysisResult) {
             auto vgaAnalysis = dynamic_cast<VGAMetricShortestPath *>(analysis.get());
             vgaAnalysis->copyResultToMap(analysisResult.getAttributes(),
                                          analysisResult.getAttributeData(),
@@ -112,11 +153,10 @@ void VGAPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pathTyp
         break;
     }
     case PathType::ANGULAR: {
-        graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+        comm->setAnalysis(std::unique_ptr<IAnalysis>(
             new VGAAngularShortestPath(latticeMap.getInternalMap(), pixelFrom, pixelTo)));
-        graphDoc->m_communicator->setPostAnalysisFunc([&latticeMap](
-                                                          std::unique_ptr<IAnalysis> &analysis,
-                                                          AnalysisResult &analysisResult) {
+        comm->setPostAnalysisFunc([&latticeMap](std::unique_ptr<IAnalysis> &analysis,
+                                                AnalysisResult &analysisResult) {
             auto vgaAnalysis = dynamic_cast<VGAAngularShortestPath *>(analysis.get());
             vgaAnalysis->copyResultToMap(analysisResult.getAttributes(),
                                          analysisResult.getAttributeData(),
@@ -127,26 +167,88 @@ void VGAPathsMainWindow::OnShortestPath(MainWindow *mainWindow, PathType pathTyp
         break;
     }
     }
-    graphDoc->m_communicator->SetFunction(CMSCommunicator::FROMCONNECTOR);
-    graphDoc->m_communicator->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
-    graphDoc->m_communicator->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS,
-                                                    QGraphDoc::NEW_DATA);
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS, QGraphDoc::NEW_DATA);
 
-    graphDoc->CreateWaitDialog(tr("Calculating shortest path..."));
-    graphDoc->m_thread.render(graphDoc);
+    graphDoc->submitJob(comm.release(), tr("Calculating shortest path..."),
+                        graphDoc->getDisplayedLayer());
 }
 
-void VGAPathsMainWindow::OnExtractLinkData(MainWindow *mainWindow) {
+void VGAPathsMainWindow::OnPointToPointPath(MainWindow *mainWindow, PathType pathType) {
     QGraphDoc *graphDoc = mainWindow->activeMapDoc();
     if (graphDoc == nullptr)
         return;
 
-    if (graphDoc->m_communicator) {
+    if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::LATTICEMAP) {
         QMessageBox::warning(mainWindow, tr("Warning"),
-                             tr("Please wait, another process is running"), QMessageBox::Ok,
+                             tr("Please make sure the displayed map is a VGA map"), QMessageBox::Ok,
                              QMessageBox::Ok);
         return;
     }
+    LatticeMapDM &latticeMap = graphDoc->m_meta_graph->getDisplayedLatticeMap();
+    if (latticeMap.getSelSet().size() != 2) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please select two cells to create a path between"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+    const PixelRef &pixelFrom = *latticeMap.getSelSet().begin();
+    const PixelRef &pixelTo = *std::next(latticeMap.getSelSet().begin());
+
+    VGAPointToPointPath::PathType pointToPointType = VGAPointToPointPath::PathType::VISUAL;
+    if (pathType == PathType::METRIC) {
+        pointToPointType = VGAPointToPointPath::PathType::METRIC;
+    } else if (pathType == PathType::ANGULAR) {
+        pointToPointType = VGAPointToPointPath::PathType::ANGULAR;
+    }
+
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    comm->setAnalysis(std::make_unique<VGAPointToPointPath>(
+        latticeMap.getInternalMap(), pixelFrom, pixelTo, pointToPointType));
+    comm->setPostAnalysisFunc(
+        [&latticeMap](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &analysisResult) {
+            latticeMap.overrideDisplayedAttribute(-2);
+            latticeMap.setDisplayedAttribute(analysisResult.getAttributes()[0]);
+        });
+
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS, QGraphDoc::NEW_DATA);
+
+    graphDoc->submitJob(comm.release(), tr("Calculating shortest path..."),
+                        graphDoc->getDisplayedLayer());
+}
+
+void VGAPathsMainWindow::OnPathPreview(MainWindow *mainWindow, PathType pathType) {
+    MapView *mapView = mainWindow->activeMapView();
+    if (mapView == nullptr)
+        return;
+
+    if (mapView->getGraphDoc()->m_meta_graph->getDisplayedMapType() != ShapeMap::LATTICEMAP) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Please make sure the displayed map is a VGA map"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+    MapView::PathPreviewType previewType = MapView::PathPreviewType::METRIC;
+    if (pathType == PathType::VISUAL) {
+        previewType = MapView::PathPreviewType::VISUAL;
+    } else if (pathType == PathType::ANGULAR) {
+        previewType = MapView::PathPreviewType::ANGULAR;
+    }
+    if (!mapView->OnModePathPreview(previewType)) {
+        QMessageBox::warning(mainWindow, tr("Warning"),
+                             tr("Path previews are only shown in the GL map view"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+    }
+}
+
+void VGAPathsMainWindow::OnExtractLinkData(MainWindow *mainWindow) {
+    QGraphDoc *graphDoc = mainWindow->activeMapDoc();
+    if (graphDoc == nullptr)
+        return;
+
     if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::LATTICEMAP) {
         QMessageBox::warning(mainWindow, tr("Warning"),
                              tr("Please make sure the displayed map is a VGA map"), QMessageBox::Ok,
@@ -154,16 +256,16 @@ void VGAPathsMainWindow::OnExtractLinkData(MainWindow *mainWindow) {
         return;
     }
 
-    graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    comm->setAnalysis(std::unique_ptr<IAnalysis>(
         new ExtractLinkData(graphDoc->m_meta_graph->getDisplayedLatticeMap().getInternalMap())));
 
-    graphDoc->m_communicator->SetFunction(CMSCommunicator::FROMCONNECTOR);
-    graphDoc->m_communicator->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
-    graphDoc->m_communicator->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS,
-                                                    QGraphDoc::NEW_DATA);
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS, QGraphDoc::NEW_DATA);
 
-    graphDoc->CreateWaitDialog(tr("Extracting link data.."));
-    graphDoc->m_thread.render(graphDoc);
+    graphDoc->submitJob(comm.release(), tr("Extracting link data.."),
+                        graphDoc->getDisplayedLayer());
 }
 
 void VGAPathsMainWindow::OnMakeIsovistZones(MainWindow *mainWindow) {
@@ -171,12 +273,6 @@ void VGAPathsMainWindow::OnMakeIsovistZones(MainWindow *mainWindow) {
     if (graphDoc == nullptr)
         return;
 
-    if (graphDoc->m_communicator) {
-        QMessageBox::warning(mainWindow, tr("Warning"),
-                             tr("Please wait, another process is running"), QMessageBox::Ok,
-                             QMessageBox::Ok);
-        return;
-    }
     if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::LATTICEMAP) {
         QMessageBox::warning(mainWindow, tr("Warning"),
                              tr("Please make sure the displayed map is a VGA map"), QMessageBox::Ok,
@@ -188,22 +284,22 @@ void VGAPathsMainWindow::OnMakeIsovistZones(MainWindow *mainWindow) {
     float restrictDistance = -1;
 
     auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
-    graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
+    comm->setAnalysis(std::unique_ptr<IAnalysis>(
         new VGAIsovistZone(map.getInternalMap(), originPointSets, restrictDistance)));
 
-    graphDoc->m_communicator->setPostAnalysisFunc(
+    comm->setPostAnalysisFunc(
         [&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &result) {
             map.overrideDisplayedAttribute(-2);
             map.setDisplayedAttribute(result.getAttributes()[0]);
         });
 
-    graphDoc->m_communicator->SetFunction(CMSCommunicator::FROMCONNECTOR);
-    graphDoc->m_communicator->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
-    graphDoc->m_communicator->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS,
-                                                    QGraphDoc::NEW_DATA);
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS, QGraphDoc::NEW_DATA);
 
-    graphDoc->CreateWaitDialog(tr("Making isovist zones.."));
-    graphDoc->m_thread.render(graphDoc);
+    graphDoc->submitJob(comm.release(), tr("Making isovist zones.."),
+                        graphDoc->getDisplayedLayer());
 }
 
 void VGAPathsMainWindow::OnMetricShortestPathsToMany(MainWindow *mainWindow) {
@@ -211,12 +307,6 @@ void VGAPathsMainWindow::OnMetricShortestPathsToMany(MainWindow *mainWindow) {
     if (graphDoc == nullptr)
         return;
 
-    if (graphDoc->m_communicator) {
-        QMessageBox::warning(mainWindow, tr("Warning"),
-                             tr("Please wait, another process is running"), QMessageBox::Ok,
-                             QMessageBox::Ok);
-        return;
-    }
     if (graphDoc->m_meta_graph->getDisplayedMapType() != ShapeMap::LATTICEMAP) {
         QMessageBox::warning(mainWindow, tr("Warning"),
                              tr("Please make sure the displayed map is a VGA map"), QMessageBox::Ok,
@@ -224,23 +314,23 @@ void VGAPathsMainWindow::OnMetricShortestPathsToMany(MainWindow *mainWindow) {
         return;
     }
 
+    std::unique_ptr<CMSCommunicator> comm(new CMSCommunicator());
     std::set<PixelRef> pixelsFrom;
     std::set<PixelRef> pixelsTo;
     auto &map = graphDoc->m_meta_graph->getDisplayedLatticeMap();
-    graphDoc->m_communicator->setAnalysis(std::unique_ptr<IAnalysis>(
+    comm->setAnalysis(std::unique_ptr<IAnalysis>(
         new VGAMetricShortestPathToMany(map.getInternalMap(), pixelsFrom, pixelsTo)));
 
-    graphDoc->m_communicator->setPostAnalysisFunc(
+    comm->setPostAnalysisFunc(
         [&map](std::unique_ptr<IAnalysis> &analysis, AnalysisResult &result) {
             map.overrideDisplayedAttribute(-2);
             map.setDisplayedAttribute(result.getAttributes()[0]);
         });
 
-    graphDoc->m_communicator->SetFunction(CMSCommunicator::FROMCONNECTOR);
-    graphDoc->m_communicator->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
-    graphDoc->m_communicator->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS,
-                                                    QGraphDoc::NEW_DATA);
+    comm->SetFunction(CMSCommunicator::FROMCONNECTOR);
+    comm->setSuccessUpdateFlags(QGraphDoc::NEW_DATA);
+    comm->setSuccessRedrawFlags(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS, QGraphDoc::NEW_DATA);
 
-    graphDoc->CreateWaitDialog(tr("Making isovist zones.."));
-    graphDoc->m_thread.render(graphDoc);
+    graphDoc->submitJob(comm.release(), tr("Making isovist zones.."),
+                        graphDoc->getDisplayedLayer());
 }
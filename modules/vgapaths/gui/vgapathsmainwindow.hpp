@@ -13,6 +13,8 @@ class VGAPathsMainWindow : public IMainWindowModule {
 
   private slots:
     void OnShortestPath(MainWindow *mainWindow, PathType pathType);
+    void OnPointToPointPath(MainWindow *mainWindow, PathType pathType);
+    void OnPathPreview(MainWindow *mainWindow, PathType pathType);
     void OnExtractLinkData(MainWindow *mainWindow);
     void OnMakeIsovistZones(MainWindow *mainWindow);
     void OnMetricShortestPathsToMany(MainWindow *mainWindow);
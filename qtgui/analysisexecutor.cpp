@@ -0,0 +1,178 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "analysisexecutor.hpp"
+
+#include "modules/parallelcommon/core/parallelsearch.hpp"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+    // the worker index of the calling thread, -1 outside the executor
+    thread_local int tl_workerIdx = -1;
+    thread_local const std::atomic<int> *tl_budget = nullptr;
+} // namespace
+
+AnalysisExecutor::AnalysisExecutor(size_t maxThreads)
+    : m_maxThreads(maxThreads == 0 ? defaultMaxThreads() : maxThreads) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    spawnWorkers(m_maxThreads);
+}
+
+AnalysisExecutor::~AnalysisExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto &worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+AnalysisExecutor &AnalysisExecutor::instance() {
+    static AnalysisExecutor executor;
+    return executor;
+}
+
+int AnalysisExecutor::currentBudget() {
+    return tl_budget == nullptr ? 1 : std::max(1, tl_budget->load(std::memory_order_relaxed));
+}
+
+size_t AnalysisExecutor::defaultMaxThreads() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void AnalysisExecutor::setMaxThreads(size_t maxThreads) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxThreads = maxThreads == 0 ? defaultMaxThreads() : maxThreads;
+        // workers are never removed, lowering the cap only stops them from
+        // picking up new tasks
+        if (m_maxThreads > m_workers.size()) {
+            spawnWorkers(m_maxThreads - m_workers.size());
+        }
+        rebalance();
+    }
+    m_wake.notify_all();
+}
+
+size_t AnalysisExecutor::maxThreads() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxThreads;
+}
+
+size_t AnalysisExecutor::runningTasks() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running;
+}
+
+size_t AnalysisExecutor::pendingTasks() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending;
+}
+
+std::future<void> AnalysisExecutor::submit(Task task) {
+    std::packaged_task<void()> packagedTask(std::move(task));
+    std::future<void> result = packagedTask.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // tasks submitted from a worker stay local, others are dealt out
+        size_t workerIdx = tl_workerIdx >= 0 ? static_cast<size_t>(tl_workerIdx)
+                                             : m_nextWorker++ % m_workers.size();
+        m_workers[workerIdx]->tasks.push_back(std::move(packagedTask));
+        ++m_pending;
+    }
+    m_wake.notify_all();
+    return result;
+}
+
+void AnalysisExecutor::spawnWorkers(size_t count) {
+    // expects m_mutex to be held
+    for (size_t i = 0; i < count; ++i) {
+        size_t workerIdx = m_workers.size();
+        m_workers.push_back(std::make_unique<Worker>());
+        m_workers.back()->thread = std::thread([this, workerIdx]() { workerLoop(workerIdx); });
+    }
+}
+
+bool AnalysisExecutor::takeTask(size_t workerIdx, std::packaged_task<void()> &task) {
+    // expects m_mutex to be held. Own tasks are taken first and in order,
+    // then the oldest task of the next busy worker is stolen
+    for (size_t offset = 0; offset < m_workers.size(); ++offset) {
+        Worker &worker = *m_workers[(workerIdx + offset) % m_workers.size()];
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void AnalysisExecutor::rebalance() {
+    // expects m_mutex to be held. The threads are split evenly between the
+    // running tasks, the first ones taking what does not divide
+    if (m_running == 0) {
+        return;
+    }
+    size_t share = std::max<size_t>(1, m_maxThreads / m_running);
+    size_t extra = m_maxThreads > m_running ? m_maxThreads % m_running : 0;
+    for (auto &worker : m_workers) {
+        if (worker->budget.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        size_t budget = share + (extra > 0 ? 1 : 0);
+        extra -= extra > 0 ? 1 : 0;
+        worker->budget.store(static_cast<int>(budget), std::memory_order_relaxed);
+    }
+}
+
+void AnalysisExecutor::workerLoop(size_t workerIdx) {
+    tl_workerIdx = static_cast<int>(workerIdx);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Worker &self = *m_workers[workerIdx];
+    tl_budget = &self.budget;
+    // the kernels run by this worker follow its budget
+    setThreadBudget(&self.budget);
+    while (true) {
+        m_wake.wait(lock, [this]() {
+            return (m_stopping && m_pending == 0) ||
+                   (m_pending > 0 && m_running < m_maxThreads);
+        });
+        if (m_pending == 0) {
+            return;
+        }
+        std::packaged_task<void()> task;
+        if (!takeTask(workerIdx, task)) {
+            continue;
+        }
+        --m_pending;
+        ++m_running;
+        self.budget.store(1, std::memory_order_relaxed);
+        rebalance();
+        // the team size is the whole cap so that the per-thread state of the
+        // kernels covers any budget they are given while they run
+        int maxThreads = static_cast<int>(m_maxThreads);
+        lock.unlock();
+
+#ifdef _OPENMP
+        omp_set_num_threads(maxThreads);
+#else
+        (void)maxThreads;
+#endif
+        task();
+
+        lock.lock();
+        --m_running;
+        self.budget.store(0, std::memory_order_relaxed);
+        // the others take over the threads of this task
+        rebalance();
+        m_wake.notify_all();
+    }
+}
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Process-wide pool that runs the analyses of all open documents
+ *
+ * Every worker keeps its own queue of tasks and idle workers steal from the
+ * queues of the others. At most maxThreads() tasks run at once and the
+ * threads are shared evenly between them. The shares are worked out again
+ * whenever a task starts or finishes, and the parallel kernels read theirs
+ * through getThreadBudget() as they go, so a long analysis gives threads
+ * up to one started beside it rather than holding on to all of them.
+ */
+class AnalysisExecutor {
+  public:
+    using Task = std::function<void()>;
+
+  private:
+    struct Worker {
+        std::deque<std::packaged_task<void()>> tasks;
+        std::thread thread;
+        // the threads the task running on this worker may use, 0 when idle
+        std::atomic<int> budget{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    // guards the workers and their queues. Analyses are coarse tasks so a
+    // single lock is not contended
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    size_t m_maxThreads;
+    size_t m_nextWorker = 0;
+    size_t m_pending = 0;
+    size_t m_running = 0;
+    bool m_stopping = false;
+
+    void spawnWorkers(size_t count);
+    void workerLoop(size_t workerIdx);
+    bool takeTask(size_t workerIdx, std::packaged_task<void()> &task);
+    void rebalance();
+
+  public:
+    explicit AnalysisExecutor(size_t maxThreads = 0);
+    ~AnalysisExecutor();
+    AnalysisExecutor(const AnalysisExecutor &) = delete;
+    AnalysisExecutor &operator=(const AnalysisExecutor &) = delete;
+
+    static AnalysisExecutor &instance();
+
+    // the number of threads available to a task running on the calling
+    // thread, 1 if the caller is not an executor worker
+    static int currentBudget();
+
+    static size_t defaultMaxThreads();
+
+    // 0 resets to the number of hardware threads
+    void setMaxThreads(size_t maxThreads);
+    size_t maxThreads() const;
+    size_t runningTasks() const;
+    size_t pendingTasks() const;
+
+    std::future<void> submit(Task task);
+};
@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <utility>
+
+/**
+ * @brief The analyses queued on a document
+ *
+ * Jobs run one at a time, in the order they were queued. Only the job at the
+ * front of the queue is ever running, so a job sees the document exactly as
+ * the jobs before it left it. Everything here happens on the GUI thread.
+ */
+template <typename Payload> class AnalysisJobQueue {
+  public:
+    enum class State { QUEUED, RUNNING, CANCELLING };
+    enum class CancelResult {
+        // there is no such job, it may have finished already
+        NOT_FOUND,
+        // the job had not started and has been taken out of the queue
+        REMOVED,
+        // the job is running, it is taken out when it has stopped
+        STOPPING
+    };
+
+    struct Job {
+        size_t id;
+        State state = State::QUEUED;
+        Payload payload;
+    };
+
+  private:
+    std::deque<Job> m_jobs;
+    size_t m_nextId = 1;
+
+  public:
+    size_t push(Payload payload) {
+        m_jobs.push_back({m_nextId, State::QUEUED, std::move(payload)});
+        return m_nextId++;
+    }
+
+    // marks the job at the front as running and returns it, if nothing is
+    // running yet
+    Job *startNext() {
+        if (m_jobs.empty() || m_jobs.front().state != State::QUEUED) {
+            return nullptr;
+        }
+        m_jobs.front().state = State::RUNNING;
+        return &m_jobs.front();
+    }
+
+    Job *running() {
+        if (m_jobs.empty() || m_jobs.front().state == State::QUEUED) {
+            return nullptr;
+        }
+        return &m_jobs.front();
+    }
+    const Job *running() const {
+        if (m_jobs.empty() || m_jobs.front().state == State::QUEUED) {
+            return nullptr;
+        }
+        return &m_jobs.front();
+    }
+
+    // takes out the running job once it has stopped, or once it turned out
+    // it could not run after all
+    void finishRunning() {
+        if (running() != nullptr) {
+            m_jobs.pop_front();
+        }
+    }
+
+    CancelResult cancel(size_t jobId) {
+        auto it = std::find_if(m_jobs.begin(), m_jobs.end(),
+                               [jobId](const Job &job) { return job.id == jobId; });
+        if (it == m_jobs.end()) {
+            return CancelResult::NOT_FOUND;
+        }
+        if (it->state == State::QUEUED) {
+            m_jobs.erase(it);
+            return CancelResult::REMOVED;
+        }
+        it->state = State::CANCELLING;
+        return CancelResult::STOPPING;
+    }
+
+    const Job *find(size_t jobId) const {
+        auto it = std::find_if(m_jobs.begin(), m_jobs.end(),
+                               [jobId](const Job &job) { return job.id == jobId; });
+        return it == m_jobs.end() ? nullptr : &*it;
+    }
+
+    bool empty() const { return m_jobs.empty(); }
+    size_t size() const { return m_jobs.size(); }
+    typename std::deque<Job>::const_iterator begin() const { return m_jobs.begin(); }
+    typename std::deque<Job>::const_iterator end() const { return m_jobs.end(); }
+};
@@ -17,8 +17,22 @@ GeneralPage::GeneralPage(Settings &settings, QWidget *parent) : SettingsPage(set
     connect(simpleModeCheckBox, &QCheckBox::stateChanged,
             [=]() { m_simpleVersion = !m_simpleVersion; });
 
+    QLabel *analysisThreadsLabel = new QLabel(tr("Analysis threads"));
+    QSpinBox *analysisThreadsSpinBox = new QSpinBox();
+    analysisThreadsSpinBox->setRange(0, 1024);
+    analysisThreadsSpinBox->setSpecialValueText(tr("All cores"));
+    analysisThreadsSpinBox->setToolTip(
+        tr("Maximum number of threads shared by the analyses of all open graphs"));
+    analysisThreadsSpinBox->setValue(m_analysisThreads);
+    connect(analysisThreadsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            [=](int value) { m_analysisThreads = value; });
+    QHBoxLayout *analysisThreadsLayout = new QHBoxLayout;
+    analysisThreadsLayout->addWidget(analysisThreadsLabel);
+    analysisThreadsLayout->addWidget(analysisThreadsSpinBox);
+
     QVBoxLayout *configLayout = new QVBoxLayout;
     configLayout->addWidget(simpleModeCheckBox);
+    configLayout->addLayout(analysisThreadsLayout);
     configGroup->setLayout(configLayout);
 
     QVBoxLayout *mainLayout = new QVBoxLayout;
@@ -12,13 +12,16 @@
 class GeneralPage : public SettingsPage {
   private:
     bool m_simpleVersion = false;
+    int m_analysisThreads = 0;
     void readSettings(Settings &settings) {
         m_simpleVersion = settings.readSetting(SettingTag::simpleVersion, true).toBool();
+        m_analysisThreads = settings.readSetting(SettingTag::analysisThreads, 0).toInt();
     }
 
   public:
     GeneralPage(Settings &settings, QWidget *parent = 0);
     virtual void writeSettings(Settings &settings) override {
         settings.writeSetting(SettingTag::simpleVersion, m_simpleVersion);
+        settings.writeSetting(SettingTag::analysisThreads, m_analysisThreads);
     }
 };
@@ -38,10 +38,14 @@
 #include "salalib/linkutils.hpp"
 #include "salalib/salaprogram.hpp"
 
+#include <QDialogButtonBox>
 #include <QFile>
+#include <QLabel>
+#include <QListWidget>
 #include <QMessageBox>
 #include <QMetaType>
 #include <QString>
+#include <QVBoxLayout>
 #include <QtCore/QFile>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMessageBox>
@@ -61,18 +65,11 @@ QGraphDoc::QGraphDoc(const QString &author, const QString &organisation) {
     }
     m_communicator = NULL;
 
-    m_make_algorithm = 0;  // algorithm to make graph
-    m_make_maxdist = -1.0; // maximum distance you can see (set to -1.0 for infinite)
-
     m_meta_graph = new MetaGraphDM;
 
     modifiedFlag = false;
 
     modify_prog = false;
-    m_num_steps = 0;
-    m_record = 0;
-    m_step = 0;
-    m_num_records = 0;
 
     std::string date = ViewHelpers::getCurrentDate();
     QString version = QString(TITLE_BASE);
@@ -85,7 +82,7 @@ QGraphDoc::QGraphDoc(const QString &author, const QString &organisation) {
             &QGraphDoc::exceptionThrownInRenderThread);
     connect(&m_thread, &RenderThread::showWarningMessage, this,
             &QGraphDoc::messageFromRenderThread);
-    connect(&m_thread, &RenderThread::closeWaitDialog, this, &QGraphDoc::DestroyWaitDialog);
+    connect(&m_thread, &RenderThread::finished, this, &QGraphDoc::jobThreadFinished);
 }
 void QGraphDoc::exceptionThrownInRenderThread(int type, std::string message) {
     if (type == sala::LatticeMapExceptionType::NO_ISOVIST_ANALYSIS) {
@@ -105,6 +102,12 @@ void QGraphDoc::messageFromRenderThread(QString title, QString message) {
 bool QGraphDoc::SetRedrawFlag(int viewtype, int flag, int reason,
                               QWidget *originator) // (almost) thread safe
 {
+    if (flag >= REDRAW_GRAPH && (reason == NEW_DATA || reason == NEW_LINESET ||
+                                 reason == NEW_TABLE || reason == NEW_FILE ||
+                                 reason == DELETED_TABLE)) {
+        // the segments or their connections may have changed
+        m_routeIndices.clear();
+    }
 
     if (viewtype == VIEW_ALL && flag != REDRAW_DONE) {
         ((MainWindow *)m_mainFrame)->updateGLWindows(true, flag == REDRAW_TOTAL);
@@ -167,6 +170,9 @@ void QGraphDoc::UpdateMainframestatus() {
 }
 
 void QGraphDoc::SetUpdateFlag(int type, bool modified) {
+    if (type == NEW_FILE || type == NEW_TABLE || type == DELETED_TABLE) {
+        m_routeIndices.clear();
+    }
     switch (type) {
     case NEW_FILE:
         QApplication::postEvent(
@@ -332,6 +338,14 @@ void QGraphDoc::OnLayerNew() {
 }
 
 void QGraphDoc::OnLayerDelete() {
+    if (hasJobs()) {
+        // queued jobs refer to maps by index
+        QMessageBox::warning(this, tr("Warning"),
+                             tr("Please wait for the queued analyses to finish or cancel them "
+                                "before deleting a map"),
+                             QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
     // Delete the currently displayed map
     if (QMessageBox::Yes == QMessageBox::question(this, tr("Notice"),
                                                   tr("Are you sure you want to delete this "
@@ -355,6 +369,8 @@ void QGraphDoc::CreateWaitDialog(const QString &description, QWidget *pr) {
     m_waitdlg->setCancelButtonText(tr("&Cancel"));
     m_waitdlg->setWindowTitle(description);
     m_waitdlg->setWindowFlags(Qt::WindowStaysOnTopHint | Qt::Dialog);
+    // the dialog stays up while there are jobs in the queue
+    m_waitdlg->setAutoClose(false);
     m_waitdlg->show();
     Tid_progress = startTimer(50);
     m_timer.start();
@@ -373,6 +389,13 @@ void QGraphDoc::cancel_wait() {
         } else {
             m_communicator->Cancel();
         }
+        if (auto *job = m_jobs.running()) {
+            m_jobs.cancel(job->id);
+        }
+        // cancelling only stops the current job, keep showing the rest
+        if (m_jobs.size() > 1) {
+            m_waitdlg->show();
+        }
         // Don't cancel --- cancel should be handled by the thread!
     }
 }
@@ -385,12 +408,32 @@ void QGraphDoc::timerEvent(QTimerEvent *event) {
             return;
         }
 
-        QString lstr = QString("Step %1 of %2").arg(m_step).arg(m_num_steps);
-        m_waitdlg->setValue(m_record);
+        if (m_communicator == nullptr) {
+            return;
+        }
+        auto progress = m_communicator->getTelemetry().snapshot();
+        int numRecords = int(progress.numRecords);
+        int record = int(std::min(progress.currentRecord, progress.numRecords));
+        if (m_waitdlg->maximum() != numRecords) {
+            m_waitdlg->setRange(0, numRecords);
+        }
+        m_waitdlg->setValue(record);
 
-        double percent = (100.0 * double(m_record)) / double(m_num_records);
+        // remember when the records last moved, to tell a stuck analysis
+        // from a slow one
+        if (progress.currentRecord != m_progressRecord) {
+            m_progressRecord = progress.currentRecord;
+            m_progressTime = m_timer.elapsed();
+        }
+
+        QString lstr = QString("Step %1 of %2").arg(progress.currentStep).arg(progress.numSteps);
+        if (!progress.phase.empty()) {
+            lstr += QString(" (%1)").arg(QString::fromStdString(progress.phase));
+        }
+
+        double percent = (100.0 * double(record)) / double(numRecords);
         QString str;
-        int timeleft = 1 + int((100.0 / percent - 1.0) * double(m_timer.elapsed() / 1000));
+        int timeleft = 1 + int((100.0 / percent - 1.0) * progress.elapsedSeconds);
         if (percent > 0.5) {
             if (timeleft >= 3600) {
                 str = QString(" : Estimated %1 hours %2 minutes remaining")
@@ -405,30 +448,184 @@ void QGraphDoc::timerEvent(QTimerEvent *event) {
             }
         }
         lstr += str;
+        if (progress.currentRecord > 0) {
+            lstr += QString("\n%1 records/s").arg(progress.getRecordsPerSecond(), 0, 'f', 1);
+            if (progress.threadRecords.size() > 1) {
+                lstr += QString(" on %1 threads, busiest at %2x the average")
+                            .arg(progress.threadRecords.size())
+                            .arg(progress.getThreadImbalance(), 0, 'f', 2);
+            }
+        }
+        qint64 stalled = (m_timer.elapsed() - m_progressTime) / 1000;
+        if (stalled >= 10) {
+            lstr += QString("\nNo progress for %1 seconds").arg(stalled);
+        }
+        if (m_jobs.size() > 1) {
+            lstr += QString("\n%1 more job(s) in the queue").arg(m_jobs.size() - 1);
+        }
         m_waitdlg->setLabelText(lstr);
     }
 }
 
-void QGraphDoc::ProcPostMessage(int m, int x) {
-    switch (m) {
-    case Communicator::NUM_STEPS:
-        m_num_steps = x;
-        break;
-    case Communicator::NUM_RECORDS:
-        if (!modify_prog)
-            m_waitdlg->setRange(0, x);
-        m_record = 0;
-        m_num_records = x;
+AnalysisJob::Layer QGraphDoc::getDisplayedLayer() const {
+    AnalysisJob::Layer layer;
+    int viewClass = m_meta_graph->getViewClass();
+    if (viewClass & MetaGraphDM::DX_VIEWVGA) {
+        layer.viewClass = MetaGraphDM::DX_VIEWVGA;
+        layer.ref = static_cast<int>(m_meta_graph->getDisplayedLatticeMapRef());
+    } else if (viewClass & MetaGraphDM::DX_VIEWAXIAL) {
+        layer.viewClass = MetaGraphDM::DX_VIEWAXIAL;
+        layer.ref = static_cast<int>(m_meta_graph->getDisplayedShapeGraphRef());
+    } else if (viewClass & MetaGraphDM::DX_VIEWDATA) {
+        layer.viewClass = MetaGraphDM::DX_VIEWDATA;
+        layer.ref = static_cast<int>(m_meta_graph->getDisplayedDataMapRef());
+    }
+    return layer;
+}
+
+void QGraphDoc::focusLayer(const AnalysisJob::Layer &layer) {
+    if (layer.ref == -1 || getDisplayedLayer() == layer) {
+        return;
+    }
+    switch (layer.viewClass) {
+    case MetaGraphDM::DX_VIEWVGA:
+        m_meta_graph->setDisplayedLatticeMapRef(layer.ref);
+        m_meta_graph->setViewClass(MetaGraphDM::DX_SHOWVGATOP);
         break;
-    case Communicator::CURRENT_STEP:
-        m_step = x;
+    case MetaGraphDM::DX_VIEWAXIAL:
+        m_meta_graph->setDisplayedShapeGraphRef(layer.ref);
+        m_meta_graph->setViewClass(MetaGraphDM::DX_SHOWAXIALTOP);
         break;
-    case Communicator::CURRENT_RECORD:
-        m_record = x;
-        if (m_record > m_num_records)
-            m_record = m_num_records;
+    case MetaGraphDM::DX_VIEWDATA:
+        m_meta_graph->setDisplayedDataMapRef(layer.ref);
+        m_meta_graph->setViewClass(MetaGraphDM::DX_SHOWSHAPETOP);
         break;
     }
+    SetRemenuFlag(VIEW_ALL, true);
+    QApplication::postEvent(
+        (QObject *)m_mainFrame,
+        new QmyEvent((enum QEvent::Type)FOCUSGRAPH, (void *)this, CONTROLS_CHANGEATTRIBUTE));
+}
+
+size_t QGraphDoc::submitJob(CMSCommunicator *comm, const QString &description,
+                            std::optional<AnalysisJob::Layer> layer) {
+    // legacy functions read the analysis options when they run, so take a
+    // copy of them now in case they are changed for the next job
+    comm->setOptions(((MainWindow *)m_mainFrame)->m_options);
+    comm->parent_doc = this;
+
+    AnalysisJob job;
+    job.description = description;
+    job.communicator.reset(comm);
+    job.onDisplayedMap = !layer.has_value();
+    job.layer = layer.has_value() ? *layer : getDisplayedLayer();
+
+    bool wasIdle = m_jobs.empty();
+    size_t jobId = m_jobs.push(std::move(job));
+    if (wasIdle) {
+        CreateWaitDialog(description);
+        startNextJob();
+    }
+    return jobId;
+}
+
+void QGraphDoc::startNextJob() {
+    while (auto *job = m_jobs.startNext()) {
+        AnalysisJob &analysisJob = job->payload;
+        CMSCommunicator &comm = *analysisJob.communicator;
+        if (analysisJob.onDisplayedMap) {
+            focusLayer(analysisJob.layer);
+        }
+        if (comm.GetSelection().has_value()) {
+            m_meta_graph->setSelSet(*comm.GetSelection());
+            SetRedrawFlag(VIEW_ALL, REDRAW_POINTS, NEW_SELECTION);
+        }
+        QString reason = comm.preAnalysis();
+        if (!reason.isEmpty()) {
+            QMessageBox::warning(this, tr("Warning"),
+                                 tr("%1 could not run: %2").arg(analysisJob.description, reason),
+                                 QMessageBox::Ok, QMessageBox::Ok);
+            m_jobs.finishRunning();
+            continue;
+        }
+        m_communicator = &comm;
+        m_progressRecord = 0;
+        m_progressTime = m_timer.elapsed();
+        if (m_waitdlg) {
+            m_waitdlg->setWindowTitle(analysisJob.description);
+        }
+        m_thread.render(this, &comm);
+        return;
+    }
+    DestroyWaitDialog();
+}
+
+void QGraphDoc::jobThreadFinished() {
+    // finished() is emitted at the very end of the task, make sure it has
+    // returned before the thread is handed the next job
+    m_thread.wait();
+    auto *job = m_jobs.running();
+    if (job == nullptr) {
+        return;
+    }
+    // whatever the analysis changes in the document beyond its own results
+    // is done here, on the GUI thread, before the next job starts
+    job->payload.communicator->finishAnalysis(*this);
+    m_communicator = nullptr;
+    m_jobs.finishRunning();
+    startNextJob();
+}
+
+bool QGraphDoc::cancelJob(size_t jobId) {
+    auto *job = m_jobs.find(jobId);
+    if (job != nullptr && job->state != AnalysisJobQueue<AnalysisJob>::State::QUEUED) {
+        // running jobs stop at their next cancellation check
+        job->payload.communicator->Cancel();
+    }
+    return m_jobs.cancel(jobId) != AnalysisJobQueue<AnalysisJob>::CancelResult::NOT_FOUND;
+}
+
+void QGraphDoc::OnToolsAnalysisQueue() {
+    if (m_jobs.empty()) {
+        QMessageBox::information(this, tr("Analysis queue"), tr("No analyses are queued"),
+                                 QMessageBox::Ok, QMessageBox::Ok);
+        return;
+    }
+    QDialog dlg(this);
+    dlg.setWindowTitle(tr("Analysis queue"));
+    QVBoxLayout *layout = new QVBoxLayout(&dlg);
+    layout->addWidget(new QLabel(tr("Select an analysis to cancel:"), &dlg));
+    QListWidget *list = new QListWidget(&dlg);
+    for (auto &job : m_jobs) {
+        QString state;
+        switch (job.state) {
+        case AnalysisJobQueue<AnalysisJob>::State::QUEUED:
+            state = tr("queued");
+            break;
+        case AnalysisJobQueue<AnalysisJob>::State::RUNNING:
+            state = tr("running");
+            break;
+        case AnalysisJobQueue<AnalysisJob>::State::CANCELLING:
+            state = tr("cancelling");
+            break;
+        }
+        QListWidgetItem *item =
+            new QListWidgetItem(QString("[%1] %2").arg(state, job.payload.description), list);
+        item->setData(Qt::UserRole, QVariant::fromValue<qulonglong>(job.id));
+    }
+    list->setCurrentRow(0);
+    layout->addWidget(list);
+    QDialogButtonBox *buttons =
+        new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dlg);
+    connect(buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    layout->addWidget(buttons);
+    if (dlg.exec() != QDialog::Accepted || list->currentItem() == nullptr) {
+        return;
+    }
+    // the job may have finished while the list was shown, in which case
+    // there is nothing left to cancel
+    cancelJob(list->currentItem()->data(Qt::UserRole).toULongLong());
 }
 
 void QGraphDoc::OnVGALinksFileImport() {
@@ -492,10 +689,6 @@ void QGraphDoc::OnVGALinksFileImport() {
 }
 
 void QGraphDoc::OnGenerateIsovistsFromFile() {
-    if (m_communicator) {
-        return; // Locked
-    }
-
     QString template_string;
     template_string += "Text files (*.txt *.csv)\n";
     template_string += "All files (*.*)";
@@ -522,11 +715,10 @@ void QGraphDoc::OnGenerateIsovistsFromFile() {
     } else {
         // communicator and wait dialog to prevent draw while this operation is in
         // progress and also because the isovist generation requires both
-        m_communicator = new CMSCommunicator;
-        m_communicator->SetInfile2(qPrintable(infile));
-        CreateWaitDialog(tr("Generating isovists..."));
-        m_communicator->SetFunction(CMSCommunicator::MAKEISOVISTSFROMFILE);
-        m_thread.render(this);
+        CMSCommunicator *comm = new CMSCommunicator;
+        comm->SetInfile2(qPrintable(infile));
+        comm->SetFunction(CMSCommunicator::MAKEISOVISTSFROMFILE);
+        submitJob(comm, tr("Generating isovists..."));
     }
 }
 
@@ -583,37 +775,38 @@ void QGraphDoc::OnFileImport() {
         bool ok = true;
 
         if (ok) {
-            m_communicator = new CMSCommunicator;
+            CMSCommunicator *comm = new CMSCommunicator;
+            QString description;
             if (ext != tr("RT1") && ext != tr("NTF") &&
                 ext != tr("GML")) { // ntf, gml & rt1 use filesets (all others use
                                     // standard file at a time)
-                m_communicator->SetInfile(qPrintable(infiles[0]));
+                comm->SetInfile(qPrintable(infiles[0]));
             }
             if (ext != tr("MIF")) {
-                CreateWaitDialog(tr("Importing file..."));
-                m_communicator->SetFunction(CMSCommunicator::IMPORT);
+                description = tr("Importing file...");
+                comm->SetFunction(CMSCommunicator::IMPORT);
                 if (ext == tr("CAT")) {
-                    m_communicator->SetOption(MetaGraphDM::DX_CAT | graph_option);
+                    comm->SetOption(MetaGraphDM::DX_CAT | graph_option);
                 } else if (ext == tr("DXF")) {
-                    m_communicator->SetOption(MetaGraphDM::DX_DXF | graph_option);
+                    comm->SetOption(MetaGraphDM::DX_DXF | graph_option);
                 } else if (ext == tr("NTF")) {
-                    m_communicator->SetOption(MetaGraphDM::DX_NTF | graph_option);
-                    m_communicator->SetFileSet(infiles);
+                    comm->SetOption(MetaGraphDM::DX_NTF | graph_option);
+                    comm->SetFileSet(infiles);
                 } else if (ext == tr("GML")) {
-                    m_communicator->SetOption(MetaGraphDM::DX_GML | graph_option);
-                    m_communicator->SetFileSet(infiles);
+                    comm->SetOption(MetaGraphDM::DX_GML | graph_option);
+                    comm->SetFileSet(infiles);
                 } else if (ext == tr("RT1")) {
-                    m_communicator->SetOption(MetaGraphDM::DX_RT1 | graph_option);
-                    m_communicator->SetFileSet(infiles);
+                    comm->SetOption(MetaGraphDM::DX_RT1 | graph_option);
+                    comm->SetFileSet(infiles);
                 }
             } else {
                 int thedot = infiles[0].lastIndexOf('.');
                 QString infile2 = infiles[0].left(thedot + 1) + tr("mid");
-                m_communicator->SetInfile2(qPrintable(infile2));
-                CreateWaitDialog(tr("Importing file..."));
-                m_communicator->SetFunction(CMSCommunicator::IMPORTMIF);
+                comm->SetInfile2(qPrintable(infile2));
+                description = tr("Importing file...");
+                comm->SetFunction(CMSCommunicator::IMPORTMIF);
             }
-            m_thread.render(this);
+            submitJob(comm, description);
         }
     } else if (ext == tr("TXT") || ext == tr("CSV")) {
         std::ifstream file(infiles[0].toLatin1());
@@ -1289,11 +1482,6 @@ void QGraphDoc::OnFillPoints(const Point2f &p,
                                             // semifilled steps for part filled)
 {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Notice"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
     if (~state & MetaGraphDM::DX_LINEDATA) {
         QMessageBox::warning(this, tr("Notice"),
                              tr("Sorry, line drawing data must be loaded before "
@@ -1314,24 +1502,23 @@ void QGraphDoc::OnFillPoints(const Point2f &p,
         return;
     }
 
-    m_communicator = new CMSCommunicator();
-    m_communicator->SetSeedPoint(p);
-    m_communicator->SetOption(fill_type); // AV TV
-    CreateWaitDialog(tr("Generating grid points..."));
-    m_communicator->SetFunction(CMSCommunicator::MAKEPOINTS);
+    CMSCommunicator *comm = new CMSCommunicator();
+    comm->SetSeedPoint(p);
+    comm->SetOption(fill_type); // AV TV
+    comm->SetFunction(CMSCommunicator::MAKEPOINTS);
+    // the points may have been made into a graph by an earlier job
+    comm->setPreAnalysisFunc([this]() {
+        return m_meta_graph->viewingProcessed()
+                   ? tr("the points have already been made into a graph")
+                   : QString();
+    });
 
-    m_thread.render(this);
+    submitJob(comm, tr("Generating grid points..."));
 }
 
 // convert any shape layer to any other (certain rules apply)
 
 void QGraphDoc::OnLayerConvert() {
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Notice"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
-
     CMakeLayerDlg dlg;
 
     dlg.m_mapin = MAKELAYER_DATA; // mapin is a data map (assume)
@@ -1361,58 +1548,51 @@ void QGraphDoc::OnLayerConvert() {
     }
 
     if (dlg.m_mapout != 0 && QDialog::Accepted == dlg.exec()) {
-        m_communicator = new CMSCommunicator();
-        m_communicator->SetString(dlg.m_layer_name);
-        m_communicator->SetOption(dlg.m_keeporiginal ? 1 : 0,
-                                  0); // <- option 0 used for retain original flag
-        m_communicator->SetOption(dlg.m_push_values ? 1 : 0,
-                                  1); // <- option 1 used for push values flag
+        CMSCommunicator *comm = new CMSCommunicator();
+        QString description;
+        comm->SetString(dlg.m_layer_name);
+        comm->SetOption(dlg.m_keeporiginal ? 1 : 0, 0); // <- option 0 used for retain original flag
+        comm->SetOption(dlg.m_push_values ? 1 : 0, 1);  // <- option 1 used for push values flag
         //
         if (dlg.m_mapout == MAKELAYER_DRAWING) {
             // this one new: data or graph (any sort) -> drawing
-            m_communicator->SetOption(
+            comm->SetOption(
                 dlg.m_mapin == MAKELAYER_DATA ? 0 : 1,
                 1); // <- option 1 in this case signifies base as graph or data
             // (option 1 overidden, as data cannot be pushed to a drawing layer)
-            CreateWaitDialog(tr("Constructing segment map..."));
-            m_communicator->SetFunction(CMSCommunicator::MAKEDRAWING);
+            description = tr("Constructing segment map...");
+            comm->SetFunction(CMSCommunicator::MAKEDRAWING);
         }
         if (dlg.m_mapout == MAKELAYER_DATA) {
             // this one new: graph (any sort) -> data
-            CreateWaitDialog(tr("Constructing segment map..."));
-            m_communicator->SetFunction(CMSCommunicator::MAKEGATESMAP);
+            description = tr("Constructing segment map...");
+            comm->SetFunction(CMSCommunicator::MAKEGATESMAP);
         } else if (dlg.m_mapout == MAKELAYER_CONVEX) {
             // this one new: data -> convex map
-            CreateWaitDialog(tr("Constructing convex map..."));
-            m_communicator->SetFunction(CMSCommunicator::MAKECONVEXMAP);
+            description = tr("Constructing convex map...");
+            comm->SetFunction(CMSCommunicator::MAKECONVEXMAP);
         } else if (dlg.m_mapout == MAKELAYER_AXIAL) {
             // this one originally data -> axial map
-            CreateWaitDialog(tr("Constructing axial map..."));
-            m_communicator->SetFunction(CMSCommunicator::MAKEUSERMAPSHAPE);
+            description = tr("Constructing axial map...");
+            comm->SetFunction(CMSCommunicator::MAKEUSERMAPSHAPE);
         } else if (dlg.m_mapout == MAKELAYER_SEGMENT) {
             if (dlg.m_mapin == MAKELAYER_AXIAL) {
                 // this one originally axial -> segment map
                 // use option 2 to specify percentage removal
-                m_communicator->SetOption(dlg.m_remove_stubs ? dlg.m_percentage : 0, 2);
-                CreateWaitDialog(tr("Constructing segment map..."));
-                m_communicator->SetFunction(CMSCommunicator::MAKESEGMENTMAP);
+                comm->SetOption(dlg.m_remove_stubs ? dlg.m_percentage : 0, 2);
+                description = tr("Constructing segment map...");
+                comm->SetFunction(CMSCommunicator::MAKESEGMENTMAP);
             } else {
                 // this one originally data -> segment map
-                CreateWaitDialog(tr("Constructing segment map..."));
-                m_communicator->SetFunction(CMSCommunicator::MAKEUSERSEGMAPSHAPE);
+                description = tr("Constructing segment map...");
+                comm->SetFunction(CMSCommunicator::MAKEUSERSEGMAPSHAPE);
             }
         }
-        m_thread.render(this);
+        submitJob(comm, description);
     }
 }
 
 void QGraphDoc::OnLayerConvertDrawing() {
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Notice"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
-
     CMakeLayerDlg dlg;
 
     dlg.m_mapin = MAKELAYER_DRAWING; // mapin is a drawing map
@@ -1420,42 +1600,37 @@ void QGraphDoc::OnLayerConvertDrawing() {
     dlg.m_origin = QString(tr("Drawing Layers: All Displayed"));
 
     if (QDialog::Accepted == dlg.exec()) {
-        m_communicator = new CMSCommunicator();
-        m_communicator->SetString(dlg.m_layer_name);
-        m_communicator->SetOption(dlg.m_keeporiginal ? 1 : 0,
-                                  0);     // <- option 0 used for retain original flag
-        m_communicator->SetOption(-1, 1); // this is used to distinguish between 0
-                                          // or 1 used when converting data layer
+        CMSCommunicator *comm = new CMSCommunicator();
+        QString description;
+        comm->SetString(dlg.m_layer_name);
+        comm->SetOption(dlg.m_keeporiginal ? 1 : 0, 0); // <- option 0 used for retain original flag
+        comm->SetOption(-1, 1); // this is used to distinguish between 0
+                                // or 1 used when converting data layer
         //
         if (dlg.m_mapout == MAKELAYER_DATA) {
             // this one originally drawing -> data map
-            CreateWaitDialog(tr("Constructing data map..."));
-            m_communicator->SetFunction(CMSCommunicator::MAKEGATESMAP);
+            description = tr("Constructing data map...");
+            comm->SetFunction(CMSCommunicator::MAKEGATESMAP);
         } else if (dlg.m_mapout == MAKELAYER_AXIAL) {
             // this one originally drawing -> axial map
-            CreateWaitDialog(tr("Constructing axial map..."));
-            m_communicator->SetFunction(CMSCommunicator::MAKEUSERMAP);
+            description = tr("Constructing axial map...");
+            comm->SetFunction(CMSCommunicator::MAKEUSERMAP);
         } else if (dlg.m_mapout == MAKELAYER_CONVEX) {
             // this one new: drawing -> convex map
-            CreateWaitDialog(tr("Constructing convex map..."));
-            m_communicator->SetFunction(CMSCommunicator::MAKECONVEXMAP);
+            description = tr("Constructing convex map...");
+            comm->SetFunction(CMSCommunicator::MAKECONVEXMAP);
         } else if (dlg.m_mapout == MAKELAYER_SEGMENT) {
             // this one originally drawing -> seg map
-            CreateWaitDialog(tr("Constructing segment map..."));
-            m_communicator->SetFunction(CMSCommunicator::MAKEUSERSEGMAP);
+            description = tr("Constructing segment map...");
+            comm->SetFunction(CMSCommunicator::MAKEUSERSEGMAP);
         }
-        m_thread.render(this);
+        submitJob(comm, description);
     }
 }
 
 // arbitrary isovist
 void QGraphDoc::OnMakeIsovist(const Point2f &seed, double angle) {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Notice"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
     if (~state & MetaGraphDM::DX_LINEDATA) {
         QMessageBox::warning(this, tr("Notice"),
                              tr("Sorry, line drawing data must be loaded before an "
@@ -1464,21 +1639,20 @@ void QGraphDoc::OnMakeIsovist(const Point2f &seed, double angle) {
         return;
     }
 
-    m_communicator = new CMSCommunicator();
-    m_communicator->SetSeedPoint(seed);
-    m_communicator->SetSeedAngle(angle);
+    CMSCommunicator *comm = new CMSCommunicator();
+    comm->SetSeedPoint(seed);
+    comm->SetSeedAngle(angle);
 
     if (angle >= 0) {
         CIsovistPathDlg dlg;
         if (dlg.exec() == QDialog::Accepted) {
-            m_communicator->SetSeedFoV(dlg.fov_angle);
+            comm->SetSeedFoV(dlg.fov_angle);
         }
     }
 
-    CreateWaitDialog(tr("Constructing BSP tree to calculate isovist..."));
-    m_communicator->SetFunction(CMSCommunicator::MAKEISOVIST);
+    comm->SetFunction(CMSCommunicator::MAKEISOVIST);
 
-    m_thread.render(this);
+    submitJob(comm, tr("Constructing BSP tree to calculate isovist..."));
 }
 
 void QGraphDoc::OnToolsIsovistpath() {
@@ -1490,11 +1664,10 @@ void QGraphDoc::OnToolsIsovistpath() {
             CIsovistPathDlg dlg;
             if (dlg.exec() == QDialog::Accepted) {
                 double angle = dlg.fov_angle;
-                m_communicator = new CMSCommunicator();
-                m_communicator->SetSeedAngle(angle);
-                CreateWaitDialog(tr("Constructing BSP tree to calculate isovists..."));
-                m_communicator->SetFunction(CMSCommunicator::MAKEISOVISTPATH);
-                m_thread.render(this);
+                CMSCommunicator *comm = new CMSCommunicator();
+                comm->SetSeedAngle(angle);
+                comm->SetFunction(CMSCommunicator::MAKEISOVISTPATH);
+                submitJob(comm, tr("Constructing BSP tree to calculate isovists..."));
             }
         } else {
             // an explanation of what you need to do as it isn't obvious!
@@ -1512,11 +1685,6 @@ void QGraphDoc::OnToolsIsovistpath() {
 // all line map
 void QGraphDoc::OnToolsAxialMap(const Point2f &seed) {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Notice"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
     if (~state & MetaGraphDM::DX_LINEDATA) {
         QMessageBox::warning(this, tr("Notice"),
                              tr("Sorry, line drawing data must be loaded before an "
@@ -1536,21 +1704,15 @@ void QGraphDoc::OnToolsAxialMap(const Point2f &seed) {
     }
 
     // This is easy too... too easy... hmm... crossed-fingers, here goes:
-    m_communicator = new CMSCommunicator();
-    m_communicator->SetSeedPoint(seed);
-    CreateWaitDialog(tr("Constructing all line axial map..."));
-    m_communicator->SetFunction(CMSCommunicator::MAKEALLLINEMAP);
-    m_thread.render(this);
+    CMSCommunicator *comm = new CMSCommunicator();
+    comm->SetSeedPoint(seed);
+    comm->SetFunction(CMSCommunicator::MAKEALLLINEMAP);
+    submitJob(comm, tr("Constructing all line axial map..."));
 }
 
 // fewest line map
 void QGraphDoc::OnToolsMakeFewestLineMap() {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
     if (~state & MetaGraphDM::DX_SHAPEGRAPHS) {
         QMessageBox::warning(this, tr("Warning"),
                              tr("Sorry, all line map must exist in order to "
@@ -1581,73 +1743,55 @@ void QGraphDoc::OnToolsMakeFewestLineMap() {
     }
 
     // This is easy too... too easy... hmm... crossed-fingers, here goes:
-    m_communicator = new CMSCommunicator();
-    CreateWaitDialog(tr("Constructing fewest line axial map..."));
-    m_communicator->SetFunction(CMSCommunicator::MAKEFEWESTLINEMAP);
-    m_communicator->SetOption(replace);
-    m_thread.render(this);
+    CMSCommunicator *comm = new CMSCommunicator();
+    comm->SetFunction(CMSCommunicator::MAKEFEWESTLINEMAP);
+    comm->SetOption(replace);
+    submitJob(comm, tr("Constructing fewest line axial map..."));
 }
 
 void QGraphDoc::OnToolsRunAxa() {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
 
     CAxialAnalysisOptionsDlg dlg(m_meta_graph);
 
     if (QDialog::Accepted == dlg.exec()) {
-        m_communicator = new CMSCommunicator();
-        CreateWaitDialog(tr("Performing axial line analysis..."));
-        m_communicator->SetFunction(CMSCommunicator::AXIALANALYSIS);
-        m_thread.render(this);
+        CMSCommunicator *comm = new CMSCommunicator();
+        comm->SetFunction(CMSCommunicator::AXIALANALYSIS);
+        submitJob(comm, tr("Performing axial line analysis..."));
     }
 }
 
 void QGraphDoc::OnToolsRunSeg() {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
 
     CSegmentAnalysisDlg dlg(m_meta_graph);
 
     if (QDialog::Accepted == dlg.exec()) {
-        m_communicator = new CMSCommunicator();
-        CreateWaitDialog(tr("Performing segment line analysis..."));
-        m_communicator->SetFunction(dlg.m_analysis_type == 1
-                                        ? CMSCommunicator::SEGMENTANALYSISANGULAR
-                                        : CMSCommunicator::SEGMENTANALYSISTULIP);
-        m_thread.render(this);
+        CMSCommunicator *comm = new CMSCommunicator();
+        comm->SetFunction(dlg.m_analysis_type == 1 ? CMSCommunicator::SEGMENTANALYSISANGULAR
+                                                   : CMSCommunicator::SEGMENTANALYSISTULIP);
+        submitJob(comm, tr("Performing segment line analysis..."));
     }
 }
 
 void QGraphDoc::OnToolsTopomet() {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
 
     CTopoMetDlg dlg;
 
     if (QDialog::Accepted == dlg.exec()) {
-        m_communicator = new CMSCommunicator();
+        CMSCommunicator *comm = new CMSCommunicator();
+        QString description;
         ((MainWindow *)m_mainFrame)->m_options.outputType = dlg.m_analysisType;
         ((MainWindow *)m_mainFrame)->m_options.radius = dlg.m_dradius;
         ((MainWindow *)m_mainFrame)->m_options.selOnly = dlg.m_selected_only;
         if (dlg.isAnalysisTopological()) {
-            CreateWaitDialog(tr("Performing topological analysis..."));
+            description = tr("Performing topological analysis...");
         } else {
-            CreateWaitDialog(tr("Performing metric analysis..."));
+            description = tr("Performing metric analysis...");
         }
-        m_communicator->SetFunction(CMSCommunicator::TOPOMETANALYSIS);
-        m_thread.render(this);
+        comm->SetFunction(CMSCommunicator::TOPOMETANALYSIS);
+        submitJob(comm, description);
     }
 }
 
@@ -1656,11 +1800,6 @@ void QGraphDoc::OnToolsTopomet() {
 // New agent functionality:
 
 void QGraphDoc::OnToolsAgentRun() {
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
 
     CAgentAnalysisDlg dlg;
     dlg.m_timesteps = 5000;
@@ -1694,17 +1833,6 @@ void QGraphDoc::OnToolsAgentRun() {
     std::vector<Point2f> releasePoints;
     std::optional<size_t> randomReleaseLocationSeed = 0;
 
-    std::optional<AgentAnalysis::TrailRecordOptions> recordTrails =
-        dlg.m_record_trails
-            ? std::make_optional(AgentAnalysis::TrailRecordOptions{
-                  dlg.m_trail_count == 0
-                      ? std::nullopt
-                      : std::make_optional(static_cast<size_t>(dlg.m_trail_count)),
-                  std::ref(
-                      m_meta_graph->createNewShapeMap(sala::ImportType::DATAMAP, "Agent trails")
-                          .getInternalMap())})
-            : std::nullopt;
-
     if (dlg.m_release_location == 1) {
         randomReleaseLocationSeed = std::nullopt;
         std::set<int> selected = m_meta_graph->getDisplayedLatticeMap().getSelSet();
@@ -1714,23 +1842,39 @@ void QGraphDoc::OnToolsAgentRun() {
         }
     }
 
-    // then go:
-    std::unique_ptr<IAnalysis> analysis(new AgentAnalysis(
-        m_meta_graph->getDisplayedLatticeMap().getInternalMap(), dlg.m_timesteps,
-        dlg.m_release_rate, dlg.m_frames, dlg.m_fov, dlg.m_steps, agentAlgorithm,
-        randomReleaseLocationSeed, releasePoints,
-        dlg.m_gatelayer == -1 ? std::nullopt
-                              : std::make_optional(std::ref(
-                                    m_meta_graph->getDataMaps()[dlg.m_gatelayer].getInternalMap())),
-        recordTrails));
-
-    m_communicator = new CMSCommunicator();
+    CMSCommunicator *comm = new CMSCommunicator();
 
-    m_communicator->setAnalysis(std::move(analysis));
-    CreateWaitDialog(tr("Performing agent analysis..."));
-    m_communicator->SetFunction(CMSCommunicator::AGENTANALYSIS);
-
-    m_thread.render(this);
+    // the trails map is only made once the job starts, as adding a map
+    // while an earlier job runs would move the maps it works on
+    comm->setPreAnalysisFunc([this, comm, agentAlgorithm, randomReleaseLocationSeed, releasePoints,
+                              timesteps = dlg.m_timesteps, releaseRate = dlg.m_release_rate,
+                              frames = dlg.m_frames, fov = dlg.m_fov, steps = dlg.m_steps,
+                              recordTrails = dlg.m_record_trails, trailCount = dlg.m_trail_count,
+                              gateLayer = dlg.m_gatelayer]() {
+        if (!m_meta_graph->viewingProcessedPoints()) {
+            return tr("the visibility graph it was to run on is no longer there");
+        }
+        std::optional<AgentAnalysis::TrailRecordOptions> trailOptions =
+            recordTrails
+                ? std::make_optional(AgentAnalysis::TrailRecordOptions{
+                      trailCount == 0 ? std::nullopt
+                                      : std::make_optional(static_cast<size_t>(trailCount)),
+                      std::ref(m_meta_graph
+                                   ->createNewShapeMap(sala::ImportType::DATAMAP, "Agent trails")
+                                   .getInternalMap())})
+                : std::nullopt;
+        comm->setAnalysis(std::unique_ptr<IAnalysis>(new AgentAnalysis(
+            m_meta_graph->getDisplayedLatticeMap().getInternalMap(), timesteps, releaseRate,
+            frames, fov, steps, agentAlgorithm, randomReleaseLocationSeed, releasePoints,
+            gateLayer == -1 ? std::nullopt
+                            : std::make_optional(std::ref(
+                                  m_meta_graph->getDataMaps()[gateLayer].getInternalMap())),
+            trailOptions)));
+        return QString();
+    });
+    comm->SetFunction(CMSCommunicator::AGENTANALYSIS);
+
+    submitJob(comm, tr("Performing agent analysis..."));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1783,11 +1927,6 @@ void QGraphDoc::OnEditClear() {
 
 void QGraphDoc::OnToolsMakeGraph() {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
     if (!m_meta_graph->viewingUnprocessedPoints()) {
         QMessageBox::warning(this, tr("Warning"),
                              tr("Sorry, you need an unprocessed set of points to "
@@ -1801,31 +1940,24 @@ void QGraphDoc::OnToolsMakeGraph() {
     if (dlg.exec() != QDialog::Accepted) {
         return;
     }
-    if (dlg.m_boundarygraph) {
-        m_make_algorithm = 1;
-    } else {
-        m_make_algorithm = 0;
-    }
-    if (dlg.m_restrict_visibility) {
-        m_make_maxdist = dlg.m_maxdist;
-    } else {
-        m_make_maxdist = -1.0;
-    }
 
-    m_communicator = new CMSCommunicator();
-    CreateWaitDialog(tr("Constructing graph..."));
-    m_communicator->SetFunction(CMSCommunicator::MAKEGRAPH);
+    CMSCommunicator *comm = new CMSCommunicator();
+    comm->SetFunction(CMSCommunicator::MAKEGRAPH);
+    // option 0 is the algorithm, 1 for a boundary graph
+    comm->SetOption(dlg.m_boundarygraph ? 1 : 0);
+    comm->SetMaxDist(dlg.m_restrict_visibility ? dlg.m_maxdist : -1.0);
+    // the points may have been made into a graph by an earlier job
+    comm->setPreAnalysisFunc([this]() {
+        return m_meta_graph->viewingUnprocessedPoints()
+                   ? QString()
+                   : tr("the points have already been made into a graph");
+    });
 
-    m_thread.render(this);
+    submitJob(comm, tr("Constructing graph..."));
 }
 
 void QGraphDoc::OnToolsUnmakeGraph() {
     int state = m_meta_graph->getState();
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Notice"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
     if (~state & MetaGraphDM::DX_LATTICEMAPS) {
         QMessageBox::warning(this, tr("Notice"), tr("Please make grid before filling"),
                              QMessageBox::Ok, QMessageBox::Ok);
@@ -1846,21 +1978,17 @@ void QGraphDoc::OnToolsUnmakeGraph() {
             QMessageBox::question(this, tr("Notice"), tr("Would you also like to clear the links?"),
                                   QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
     }
-    bool ok = m_meta_graph->unmakeGraph(removeLinks);
-    if (ok) {
-        SetUpdateFlag(QGraphDoc::NEW_DATA);
-    }
-    SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
+
+    CMSCommunicator *comm = new CMSCommunicator();
+    comm->SetFunction(CMSCommunicator::UNMAKEGRAPH);
+    // option 0 is whether the links are cleared as well
+    comm->SetOption(removeLinks ? 1 : 0);
+    submitJob(comm, tr("Removing graph..."));
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
 void QGraphDoc::OnToolsRun() {
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another task is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
 
     // This is easy!
     COptionsDlg dlg;
@@ -1883,94 +2011,63 @@ void QGraphDoc::OnToolsRun() {
     }
 
     // This is easy too... too easy... hmm... crossed-fingers, here goes:
-    m_communicator = new CMSCommunicator();
-    CreateWaitDialog(tr("Analysing graph..."));
-    m_communicator->SetFunction(CMSCommunicator::ANALYSEGRAPH);
+    CMSCommunicator *comm = new CMSCommunicator();
+    comm->SetFunction(CMSCommunicator::ANALYSEGRAPH);
 
-    m_thread.render(this);
+    submitJob(comm, tr("Analysing graph..."));
 }
 
-void QGraphDoc::OnToolsPD() {
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another process is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
+void QGraphDoc::submitPointDepth(int function, std::function<bool()> canRun,
+                                 const QString &description) {
+    if (!canRun() || !m_meta_graph->isSelected()) {
         return;
     }
+    CMSCommunicator *comm = new CMSCommunicator();
+    comm->SetFunction(function);
+    // the depth is from the selection as it is now, not as it is when the
+    // job gets to run
+    auto &selection = m_meta_graph->getSelSet();
+    comm->SetSelection(std::vector<int>(selection.begin(), selection.end()));
+    comm->setPreAnalysisFunc([this, canRun]() {
+        return canRun() && m_meta_graph->isSelected()
+                   ? QString()
+                   : tr("the map or the selection it was to start from has changed");
+    });
+    submitJob(comm, description);
+}
 
-    if (m_meta_graph->viewingProcessed()) {
-        if (m_meta_graph->isSelected()) {
-
-            // This is easy too... too easy... hmm... crossed-fingers, here goes:
-            m_communicator = new CMSCommunicator();
-            CreateWaitDialog(tr("Calculating step depth..."));
-            m_communicator->SetFunction(CMSCommunicator::POINTDEPTH);
-
-            m_thread.render(this);
-        }
-    }
+void QGraphDoc::OnToolsPD() {
+    submitPointDepth(
+        CMSCommunicator::POINTDEPTH, [this]() { return m_meta_graph->viewingProcessed(); },
+        tr("Calculating step depth..."));
 }
 
 void QGraphDoc::OnToolsMPD() {
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another process is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
-
-    if (m_meta_graph->viewingProcessedPoints() ||
-        (m_meta_graph->viewingProcessedLines() &&
-         m_meta_graph->getDisplayedShapeGraph().getInternalMap().isSegmentMap())) {
-        if (m_meta_graph->isSelected()) {
-
-            // This is easy too... too easy... hmm... crossed-fingers, here goes:
-            m_communicator = new CMSCommunicator();
-            CreateWaitDialog(tr("Calculating metric depth..."));
-            m_communicator->SetFunction(CMSCommunicator::METRICPOINTDEPTH);
-
-            m_thread.render(this);
-        }
-    }
+    submitPointDepth(
+        CMSCommunicator::METRICPOINTDEPTH,
+        [this]() {
+            return m_meta_graph->viewingProcessedPoints() ||
+                   (m_meta_graph->viewingProcessedLines() &&
+                    m_meta_graph->getDisplayedShapeGraph().getInternalMap().isSegmentMap());
+        },
+        tr("Calculating metric depth..."));
 }
 
 void QGraphDoc::OnToolsAPD() {
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another process is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
-
-    if (m_meta_graph->viewingProcessedPoints()) {
-        if (m_meta_graph->isSelected()) {
-
-            // This is easy too... too easy... hmm... crossed-fingers, here goes:
-            m_communicator = new CMSCommunicator();
-            CreateWaitDialog(tr("Calculating angular depth..."));
-            m_communicator->SetFunction(CMSCommunicator::ANGULARPOINTDEPTH);
-
-            m_thread.render(this);
-        }
-    }
+    submitPointDepth(
+        CMSCommunicator::ANGULARPOINTDEPTH,
+        [this]() { return m_meta_graph->viewingProcessedPoints(); },
+        tr("Calculating angular depth..."));
 }
 
 void QGraphDoc::OnToolsTPD() {
-    if (m_communicator) {
-        QMessageBox::warning(this, tr("Warning"), tr("Please wait, another process is running"),
-                             QMessageBox::Ok, QMessageBox::Ok);
-        return;
-    }
-
-    if (m_meta_graph->viewingProcessedLines() &&
-        m_meta_graph->getDisplayedShapeGraph().getInternalMap().isSegmentMap()) {
-        if (m_meta_graph->isSelected()) {
-
-            // This is easy too... too easy... hmm... crossed-fingers, here goes:
-            m_communicator = new CMSCommunicator();
-            CreateWaitDialog(tr("Calculating topological depth..."));
-            m_communicator->SetFunction(CMSCommunicator::TOPOLOGICALPOINTDEPTH);
-
-            m_thread.render(this);
-        }
-    }
+    submitPointDepth(
+        CMSCommunicator::TOPOLOGICALPOINTDEPTH,
+        [this]() {
+            return m_meta_graph->viewingProcessedLines() &&
+                   m_meta_graph->getDisplayedShapeGraph().getInternalMap().isSegmentMap();
+        },
+        tr("Calculating topological depth..."));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -2273,17 +2370,18 @@ void QGraphDoc::OnPushToLayer() {
         dlg.m_origin_layer = QString(origin_layer.c_str());
         dlg.m_origin_attribute = QString(origin_attribute.c_str());
         if (QDialog::Accepted == dlg.exec()) {
-            m_communicator = new CMSCommunicator; // dummy value to prevent draw while
-                                                  // this operation is in progress
             // now have to separate vga and axial layers again:
             int sel = dlg.m_layer_selection;
             std::pair<int, int> dest = genlib::getMapAtIndex(names, sel)->first;
-            //         CWaitCursor c;
-            m_meta_graph->pushValuesToLayer(dest.first, dest.second, dlg.m_function,
-                                            dlg.m_count_intersections);
-            delete m_communicator;
-            m_communicator = NULL;
-            SetUpdateFlag(NEW_TABLE);
+            CMSCommunicator *comm = new CMSCommunicator();
+            comm->SetFunction(CMSCommunicator::PUSHVALUES);
+            // options 0 and 1 are the layer pushed to, 2 the function and 3
+            // whether the intersections are counted
+            comm->SetOption(dest.first, 0);
+            comm->SetOption(dest.second, 1);
+            comm->SetOption(dlg.m_function, 2);
+            comm->SetOption(dlg.m_count_intersections ? 1 : 0, 3);
+            submitJob(comm, tr("Pushing values..."));
         }
     }
 }
@@ -5,6 +5,12 @@
 #pragma once
 
 #include "dminterface/metagraphdm.hpp"
+#include "dminterface/options.hpp"
+
+#include "analysisjobqueue.hpp"
+
+#include "modules/analysistelemetry/core/analysistelemetry.hpp"
+#include "modules/segmentshortestpaths/core/segmentrouteindex.hpp"
 
 #include "salalib/genlib/comm.hpp"
 #include "salalib/ianalysis.hpp"
@@ -14,15 +20,23 @@
 #include <QMutex>
 #include <QProgressDialog>
 #include <QSize>
-#include <QThread>
 #include <QWaitCondition>
 
+#include <functional>
+#include <future>
+#include <optional>
 #include <math.h>
 
 QT_BEGIN_NAMESPACE
 
+class QGraphDoc; // forward declaration required by
+                 // CMSCommunicator::run(QGraphDoc *)
+class CMSCommunicator;
+
 //! [0]
-class RenderThread : public QThread {
+// Runs one analysis of a document. Despite the name it no longer owns a
+// thread, the analysis is submitted to the shared AnalysisExecutor
+class RenderThread : public QObject {
     Q_OBJECT
 
   public:
@@ -31,28 +45,26 @@ class RenderThread : public QThread {
 
     void *m_parent;
     bool simple_version;
-    void render(void *param);
+    void render(void *param, CMSCommunicator *comm);
+    CMSCommunicator *getCommunicator() const { return m_comm; }
+    // blocks until the last analysis handed to render() has finished
+    void wait();
 
   signals:
     void renderedImage(const QImage &image, double scaleFactor);
     void runtimeExceptionThrown(int type, std::string message);
     void showWarningMessage(QString title, QString message);
-    void closeWaitDialog();
+    void finished();
 
   protected:
-    void run() override;
+    void run();
 
   private:
-    bool restart;
-    bool abort;
-    QMutex mutex;
-    QWaitCondition condition;
+    CMSCommunicator *m_comm = nullptr;
+    std::future<void> m_done;
 };
 
-class QGraphDoc; // forward declaration required by
-                 // CMSCommunicator::run(QGraphDoc *)
-
-class CMSCommunicator : public Communicator {
+class CMSCommunicator : public Communicator, public AnalysisTelemetry::Provider {
   public:
     enum {
         IMPORT,
@@ -83,6 +95,8 @@ class CMSCommunicator : public Communicator {
         SEGMENTANALYSISANGULAR,
         TOPOMETANALYSIS,
         AGENTANALYSIS,
+        UNMAKEGRAPH,
+        PUSHVALUES,
         FROMCONNECTOR
     };
 
@@ -114,6 +128,11 @@ class CMSCommunicator : public Communicator {
     double GetSeedAngle() const { return m_seed_angle; }
     void SetSeedFoV(const double fov) { m_seed_fov = fov; }
     double GetSeedFoV() const { return m_seed_fov; }
+    void SetMaxDist(const double maxdist) { m_maxdist = maxdist; }
+    double GetMaxDist() const { return m_maxdist; }
+    // the selection the job was queued with, put back before it starts
+    void SetSelection(std::vector<int> selection) { m_selection = std::move(selection); }
+    const std::optional<std::vector<int>> &GetSelection() const { return m_selection; }
     //
 
     void SetString(const QString &str) { m_string = str; }
@@ -124,6 +143,10 @@ class CMSCommunicator : public Communicator {
             m_fileset.push_back(strings[i].toStdString());
         }
     }
+    // the analysis options are copied when the job is queued, so that a job
+    // runs with the options it was set up with even if others are chosen later
+    void setOptions(const Options &options) { m_dm_options = options; }
+    const Options &getOptions() const { return m_dm_options; }
     void setAnalysis(std::unique_ptr<IAnalysis> &&analysis) { m_analysis = std::move(analysis); }
     std::unique_ptr<IAnalysis> &getAnalysis() { return m_analysis; }
 
@@ -141,7 +164,21 @@ class CMSCommunicator : public Communicator {
         m_successRedrawReason = reason;
     }
 
-    void runAnalysis(QGraphDoc &graphDoc);
+    // run on the GUI thread just before the job starts, as the jobs before
+    // it may have changed the document since it was queued. Returns why the
+    // job can not run, or an empty string if it can
+    void setPreAnalysisFunc(std::function<QString()> func) { m_preAnalysisFunc = func; }
+    QString preAnalysis() const { return m_preAnalysisFunc ? m_preAnalysisFunc() : QString(); }
+
+    // runs the analysis on the executor, the results are applied to the
+    // document by finishAnalysis on the GUI thread
+    void runAnalysis();
+    void finishAnalysis(QGraphDoc &graphDoc);
+
+    // progress is kept here rather than in the document, so that it can be
+    // reported from any thread without locking
+    AnalysisTelemetry &getTelemetry() override { return m_telemetry; }
+    const AnalysisTelemetry &getTelemetry() const { return m_telemetry; }
 
     void logError(const std::string &message) const override { std::cerr << message << std::endl; }
     void logWarning(const std::string &message) const override {
@@ -155,16 +192,42 @@ class CMSCommunicator : public Communicator {
     Point2f m_seed_point;
     double m_seed_angle;
     double m_seed_fov;
+    double m_maxdist = -1.0;
+    std::optional<std::vector<int>> m_selection;
+    std::function<QString()> m_preAnalysisFunc;
     // CImportedModule m_module;
     QString m_string; // for a generic string
+    Options m_dm_options;
     std::unique_ptr<IAnalysis> m_analysis;
     std::function<void(std::unique_ptr<IAnalysis> &analysis, AnalysisResult &result)>
         m_postAnalysisFunc;
+    std::optional<AnalysisResult> m_analysisResult;
     int m_successUpdateFlagType;
     bool m_successUpdateFlagModified = true;
     int m_successRedrawFlagViewType;
     bool m_successRedrawFlag;
     int m_successRedrawReason;
+    mutable AnalysisTelemetry m_telemetry;
+};
+
+// What a job queued on a document needs, besides its place in the queue
+struct AnalysisJob {
+    // The map a job works on, identified the same way the layer tree does
+    // (MetaGraphDM::DX_VIEWVGA, DX_VIEWAXIAL or DX_VIEWDATA and the map index)
+    struct Layer {
+        int viewClass = 0;
+        int ref = -1;
+        bool operator==(const Layer &other) const {
+            return viewClass == other.viewClass && ref == other.ref;
+        }
+    };
+
+    QString description;
+    std::unique_ptr<CMSCommunicator> communicator;
+    Layer layer;
+    // legacy functions work on whatever map is displayed, so the map that
+    // was displayed when they were queued is brought back before they start
+    bool onDisplayedMap = true;
 };
 
 struct QFilePath {
@@ -199,14 +262,21 @@ class QGraphDoc : public QWidget {
 
     std::recursive_mutex mLock;
 
+    AnalysisJobQueue<AnalysisJob> m_jobs;
+    RenderThread m_thread;
+
+    void startNextJob();
+    void jobThreadFinished();
+    void focusLayer(const AnalysisJob::Layer &layer);
+    void submitPointDepth(int function, std::function<bool()> canRun, const QString &description);
+
   public:
     QGraphDoc(const QString &author, const QString &organisation);
     CMSCommunicator *m_communicator;
 
-    int m_make_algorithm;  // algorithm to make graph
-    double m_make_maxdist; // maximum distance you can see (set to -1.0 for infinite)
-
     MetaGraphDM *m_meta_graph;
+    // made by the indexed segment shortest paths, cleared when a map is edited
+    SegmentRouteIndexCache m_routeIndices;
 
     QString m_base_title;
     QString m_opened_name;
@@ -281,18 +351,15 @@ class QGraphDoc : public QWidget {
     // Paths for the March 05 evolved agents
     // (loaded from file using the test button)
     std::vector<std::vector<Point2f>> m_evolved_paths;
-    RenderThread m_thread;
 
-    QProgressDialog *m_waitdlg;
+    QProgressDialog *m_waitdlg = nullptr;
     QString m_base_description;
     bool modify_prog;
     int Tid_progress;
-    int m_num_steps;
-    int m_record;
-    int m_step;
-    int m_num_records;
     QElapsedTimer m_timer;
-    void ProcPostMessage(int m, int x);
+    // last record count seen in the wait dialog, and when it changed
+    uint64_t m_progressRecord = 0;
+    qint64 m_progressTime = 0;
     void UpdateMainframestatus();
 
     std::unique_lock<std::recursive_mutex> getLock() {
@@ -311,6 +378,15 @@ class QGraphDoc : public QWidget {
     const AttributeTableHandle &
     getAttributeTableHandle(int type = -1, std::optional<size_t> layer = std::nullopt) const;
 
+    // Queues a job on this document and takes ownership of the communicator.
+    // Jobs given a layer work on that map only, whatever is displayed when
+    // they start
+    size_t submitJob(CMSCommunicator *comm, const QString &description,
+                     std::optional<AnalysisJob::Layer> layer = std::nullopt);
+    bool cancelJob(size_t jobId);
+    bool hasJobs() const { return !m_jobs.empty(); }
+    AnalysisJob::Layer getDisplayedLayer() const;
+
   public slots:
     void cancel_wait();
 
@@ -379,6 +455,7 @@ class QGraphDoc : public QWidget {
     void OnConvertMapShapes();
     void OnToolsLineLoadUnlinks();
     void OnLatticeMapExportConnectionsAsCSV();
+    void OnToolsAnalysisQueue();
 
   protected:
     virtual void timerEvent(QTimerEvent *event);
@@ -4,6 +4,7 @@
 
 #include "mainwindow.hpp"
 
+#include "analysisexecutor.hpp"
 #include "consts.hpp"
 #include "dialogs/AboutDlg.hpp"
 #include "dialogs/ColourScaleDlg.hpp"
@@ -494,6 +495,13 @@ void MainWindow::OnToolsTopomet() {
     }
 }
 
+void MainWindow::OnToolsAnalysisQueue() {
+    QGraphDoc *m_p = activeMapDoc();
+    if (m_p) {
+        m_p->OnToolsAnalysisQueue();
+    }
+}
+
 void MainWindow::OnToolsTPD() {
     QGraphDoc *m_p = activeMapDoc();
     if (m_p) {
@@ -1916,6 +1924,8 @@ void MainWindow::readSettings() {
     m_background = settings->readSetting(SettingTag::backgroundColour, qRgb(0, 0, 0)).toInt();
     m_simpleVersion = settings->readSetting(SettingTag::simpleVersion, true).toBool();
     m_defaultMapWindowIsLegacy = settings->readSetting(SettingTag::legacyMapWindow, false).toBool();
+    AnalysisExecutor::instance().setMaxThreads(
+        settings->readSetting(SettingTag::analysisThreads, 0).toUInt());
     if (settings->readSetting(SettingTag::mwMaximised, true).toBool()) {
         setWindowState(Qt::WindowMaximized);
     } else {
@@ -2208,7 +2218,7 @@ void MainWindow::updateAgentToolsSubMenu() {
         loadAgentProgramAct->setEnabled(0);
         return;
     }
-    if (m_p->m_meta_graph && m_p->m_meta_graph->viewingProcessedPoints() && !m_p->m_communicator)
+    if (m_p->m_meta_graph && m_p->m_meta_graph->viewingProcessedPoints())
         runAgentAnalysisAct->setEnabled(true);
     else
         runAgentAnalysisAct->setEnabled(0);
@@ -2279,7 +2289,7 @@ void MainWindow::updateAxialSubMenu() {
     }
     int state = m_p->m_meta_graph->getState();
     // non-segment maps only
-    if (state & MetaGraphDM::DX_SHAPEGRAPHS && !m_p->m_communicator &&
+    if (state & MetaGraphDM::DX_SHAPEGRAPHS &&
         !m_p->m_meta_graph->getDisplayedShapeGraph().isSegmentMap())
         runGraphAnaysisAct->setEnabled(true);
     else
@@ -2291,7 +2301,7 @@ void MainWindow::updateAxialSubMenu() {
         stepDepthAct->setEnabled(0);
 
     state = m_p->m_meta_graph->getState();
-    if (state & MetaGraphDM::DX_SHAPEGRAPHS && !m_p->m_communicator &&
+    if (state & MetaGraphDM::DX_SHAPEGRAPHS &&
         m_p->m_meta_graph->getDisplayedShapeGraph().isAllLineMap())
         reduceToFewestLineMapAct->setEnabled(true);
     else
@@ -2370,14 +2380,12 @@ void MainWindow::updateMapMenu() {
     else
         deleteAct->setEnabled(0);
 
-    if (!m_p->m_communicator &&
-        (m_p->m_meta_graph->viewingProcessedLines() || m_p->m_meta_graph->viewingProcessedShapes()))
+    if (m_p->m_meta_graph->viewingProcessedLines() || m_p->m_meta_graph->viewingProcessedShapes())
         convertActiveMapAct->setEnabled(true);
     else
         convertActiveMapAct->setEnabled(0);
 
-    if (!m_p->m_communicator &&
-        (m_p->m_meta_graph->getState() & MetaGraphDM::DX_LINEDATA) == MetaGraphDM::DX_LINEDATA)
+    if ((m_p->m_meta_graph->getState() & MetaGraphDM::DX_LINEDATA) == MetaGraphDM::DX_LINEDATA)
         convertDrawingMapAct->setEnabled(true);
     else
         convertDrawingMapAct->setEnabled(0);
@@ -2942,6 +2950,10 @@ void MainWindow::createActions() {
     optionsAct = new QAction(tr("Options..."), this);
     connect(optionsAct, SIGNAL(triggered()), this, SLOT(OnToolsOptions()));
 
+    analysisQueueAct = new QAction(tr("Analysis &Queue..."), this);
+    analysisQueueAct->setStatusTip(tr("Show the queued analyses and cancel one of them"));
+    connect(analysisQueueAct, SIGNAL(triggered()), this, SLOT(OnToolsAnalysisQueue()));
+
     // View Menu Actions
     showGridAct = new QAction(tr("Show &Grid"), this);
     showGridAct->setStatusTip(tr("Display grid"));
@@ -3433,6 +3445,7 @@ void MainWindow::createMenus() {
     segmentStepDepthSubMenu->addAction(segmentMetricStepAct);
 
     toolsMenu->addSeparator();
+    toolsMenu->addAction(analysisQueueAct);
     toolsMenu->addAction(optionsAct);
 
     viewMenu = menuBar()->addMenu(tr("&View"));
@@ -151,6 +151,7 @@ class MainWindow : public QMainWindow {
     void OnToolsMPD();
     void OnToolsPointConvShapeMap();
     void OnToolsOptions();
+    void OnToolsAnalysisQueue();
     void OnViewCentreView();
     void OnViewShowGrid();
     void OnViewSummary();
@@ -373,6 +374,7 @@ class MainWindow : public QMainWindow {
     QAction *topologicalStepAct;
     QAction *segmentMetricStepAct;
     QAction *optionsAct;
+    QAction *analysisQueueAct;
 
     // View Menu Actions
     QAction *showGridAct;
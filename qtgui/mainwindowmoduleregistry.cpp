@@ -5,12 +5,20 @@
 
 #include "mainwindowmoduleregistry.hpp"
 
+#include "modules/axialparallel/gui/axialparallelmainwindow.hpp"
+#include "modules/isovistparallel/gui/isovistparallelmainwindow.hpp"
+#include "modules/odmatrix/gui/odmatrixmainwindow.hpp"
+#include "modules/segmentparallel/gui/segmentparallelmainwindow.hpp"
 #include "modules/segmentshortestpaths/gui/segmentpathsmainwindow.hpp"
 #include "modules/vgaparallel/gui/vgaparallelmainwindow.hpp"
 #include "modules/vgapaths/gui/vgapathsmainwindow.hpp"
 
 void MainWindowModuleRegistry::populateModules() {
     // Register any main window modules here
+    REGISTER_MAIN_WINDOW_MODULE(AxialParallelMainWindow);
+    REGISTER_MAIN_WINDOW_MODULE(IsovistParallelMainWindow);
+    REGISTER_MAIN_WINDOW_MODULE(ODMatrixMainWindow);
+    REGISTER_MAIN_WINDOW_MODULE(SegmentParallelMainWindow);
     REGISTER_MAIN_WINDOW_MODULE(SegmentPathsMainWindow);
     REGISTER_MAIN_WINDOW_MODULE(VGAParallelMainWindow);
     REGISTER_MAIN_WINDOW_MODULE(VGAPathsMainWindow);
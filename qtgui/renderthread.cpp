@@ -2,13 +2,18 @@
 //
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include "analysisexecutor.hpp"
 #include "mainwindow.hpp"
 
+#include "modules/isovistparallel/core/isovistbatch.hpp"
+
 #include "salalib/entityparsing.hpp"
 
 #include <QEvent>
 #include <QtGui>
 
+#include <algorithm>
+
 CMSCommunicator::CMSCommunicator() {
     m_function = -1;
 
@@ -19,58 +24,91 @@ CMSCommunicator::CMSCommunicator() {
 CMSCommunicator::~CMSCommunicator() {}
 
 inline void CMSCommunicator::CommPostMessage(size_t m, size_t x) const {
-    QGraphDoc *pDoc = (QGraphDoc *)parent_doc;
-    pDoc->ProcPostMessage(m, x);
+    // called from the analysis threads, the document polls the telemetry
+    switch (m) {
+    case Communicator::NUM_STEPS:
+        m_telemetry.setNumSteps(x);
+        break;
+    case Communicator::CURRENT_STEP:
+        m_telemetry.setCurrentStep(x);
+        break;
+    case Communicator::NUM_RECORDS:
+        m_telemetry.setNumRecords(x);
+        break;
+    case Communicator::CURRENT_RECORD:
+        m_telemetry.setCurrentRecord(x);
+        break;
+    }
+}
+
+void CMSCommunicator::runAnalysis() {
+    try {
+        m_analysisResult = m_analysis->run(this);
+    } catch (Communicator::CancelledException &) {
+        // analyses that can be resumed have saved their progress by now
+    }
 }
 
-void CMSCommunicator::runAnalysis(QGraphDoc &graphDoc) {
-    auto analysisResult = m_analysis->run(this);
-    if (analysisResult.completed) {
-        m_postAnalysisFunc(m_analysis, analysisResult);
-        graphDoc.SetUpdateFlag(m_successUpdateFlagType, m_successUpdateFlagModified);
-        graphDoc.SetRedrawFlag(m_successRedrawFlagViewType, m_successRedrawFlag,
-                               m_successRedrawReason);
+void CMSCommunicator::finishAnalysis(QGraphDoc &graphDoc) {
+    if (!m_analysisResult.has_value() || !m_analysisResult->completed) {
+        return;
+    }
+    if (m_postAnalysisFunc) {
+        m_postAnalysisFunc(m_analysis, *m_analysisResult);
     }
+    graphDoc.SetUpdateFlag(m_successUpdateFlagType, m_successUpdateFlagModified);
+    graphDoc.SetRedrawFlag(m_successRedrawFlagViewType, m_successRedrawFlag,
+                           m_successRedrawReason);
 }
 
 //! [0]
-RenderThread::RenderThread(QObject *parent) : QThread(parent) { abort = false; }
+RenderThread::RenderThread(QObject *parent) : QObject(parent) {}
 //! [0]
 
 //! [1]
-RenderThread::~RenderThread() {
-    mutex.lock();
-    abort = true;
-    condition.wakeOne();
-    mutex.unlock();
+RenderThread::~RenderThread() { wait(); }
 
-    wait();
+void RenderThread::wait() {
+    if (m_done.valid()) {
+        m_done.wait();
+    }
 }
 //! [1]
 
 //! [2]
-void RenderThread::render(void *Praram) {
+void RenderThread::render(void *Praram, CMSCommunicator *comm) {
     m_parent = Praram;
-
-    if (!isRunning()) {
-        start(NormalPriority);
-    } else {
-        restart = true;
-        condition.wakeOne();
-    }
+    m_comm = comm;
+
+    // finished() is delivered to the document through its event loop
+    m_done = AnalysisExecutor::instance().submit([this]() {
+        // nobody reads the result of the task, so an error is reported here
+        // and the document moves on to its next job
+        try {
+            run();
+        } catch (const std::exception &e) {
+            emit showWarningMessage(tr("Warning"),
+                                    tr("The analysis stopped with an error: %1").arg(e.what()));
+        } catch (...) {
+            emit showWarningMessage(tr("Warning"), tr("The analysis stopped with an error"));
+        }
+        emit finished();
+    });
 }
 //! [2]
 
 //! [3]
 void RenderThread::run() {
     QGraphDoc *pDoc = (QGraphDoc *)m_parent;
-    CMSCommunicator *comm = pDoc->m_communicator;
-    comm->parent_doc = m_parent;
+    CMSCommunicator *comm = m_comm;
     MainWindow *pMain = (MainWindow *)pDoc->m_mainFrame;
 
     if (comm) {
+        comm->parent_doc = m_parent;
+        comm->getTelemetry().start();
         // move simple setting to comm
         comm->simple_version = pMain->m_simpleVersion;
+        const Options &jobOptions = comm->getOptions();
 
         int ok;
         switch (comm->GetFunction()) {
@@ -137,7 +175,7 @@ void RenderThread::run() {
             break;
 
         case CMSCommunicator::MAKEGRAPH:
-            ok = pDoc->m_meta_graph->makeGraph(comm, pDoc->m_make_algorithm, pDoc->m_make_maxdist);
+            ok = pDoc->m_meta_graph->makeGraph(comm, comm->GetOption(), comm->GetMaxDist());
             if (ok) {
                 pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
             }
@@ -146,9 +184,8 @@ void RenderThread::run() {
 
         case CMSCommunicator::ANALYSEGRAPH:
             ok = pDoc->m_meta_graph->analyseGraph(
-                comm, pMain->m_options.pointDepthSelection, pMain->m_options.outputType,
-                pMain->m_options.local, pMain->m_options.gatesOnly, pMain->m_options.global,
-                pMain->m_options.radius, comm->simple_version);
+                comm, jobOptions.pointDepthSelection, jobOptions.outputType, jobOptions.local,
+                jobOptions.gatesOnly, jobOptions.global, jobOptions.radius, comm->simple_version);
             pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
             pDoc->SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
             break;
@@ -180,15 +217,51 @@ void RenderThread::run() {
 
             try {
                 auto isovists = EntityParsing::parseIsovists(comm->GetInfile2(), ',');
-                comm->CommPostMessage(Communicator::NUM_STEPS, isovists.size());
-                int isovistIdx = 1;
+                std::vector<IsovistBatch::Definition> definitions;
+                definitions.reserve(isovists.size());
                 for (IsovistDefinition &isovist : isovists) {
-                    comm->CommPostMessage(Communicator::CURRENT_STEP, isovistIdx);
-                    pDoc->m_meta_graph->makeIsovist(comm, isovist.getLocation(),
-                                                    isovist.getLeftAngle(), isovist.getRightAngle(),
-                                                    comm->simple_version);
-                    isovistIdx++;
+                    definitions.push_back({isovist.getLocation().x, isovist.getLocation().y,
+                                           isovist.getLeftAngle(), isovist.getRightAngle()});
+                }
+
+                // the drawing is indexed once for all the isovists
+                std::vector<IsovistCaster::Line> lines;
+                for (const SimpleLine &line : pDoc->m_meta_graph->getVisibleDrawingLines()) {
+                    lines.push_back({line.start().x, line.start().y, line.end().x, line.end().y});
+                }
+                Region4f region = pDoc->m_meta_graph->getBoundingBox();
+                IsovistCaster caster(std::move(lines), region.bottomLeft.x, region.bottomLeft.y,
+                                     region.topRight.x, region.topRight.y);
+
+                // added to the isovists made before, if any
+                auto &dataMaps = pDoc->m_meta_graph->getDataMaps();
+                auto existing =
+                    std::find_if(dataMaps.begin(), dataMaps.end(),
+                                 [](ShapeMapDM &map) { return map.getName() == "Isovists"; });
+                size_t mapRef = static_cast<size_t>(std::distance(dataMaps.begin(), existing));
+                if (existing == dataMaps.end()) {
+                    mapRef = static_cast<size_t>(pDoc->m_meta_graph->addShapeMap("Isovists"));
+                    pDoc->m_meta_graph->getDataMaps()[mapRef].init(0, region);
+                }
+                pDoc->m_meta_graph->setDisplayedDataMapRef(mapRef);
+                ShapeMapDM &isovistMap = pDoc->m_meta_graph->getDataMaps()[mapRef];
+                bool simpleVersion = comm->simple_version;
+                try {
+                    IsovistBatch::makeIsovists(
+                        caster, definitions,
+                        [&](size_t, IsovistBatch::Isovist &isovist) {
+                            if (!isovist.polygon.empty()) {
+                                IsovistBatch::appendToMap(isovistMap.getInternalMap(), isovist,
+                                                          simpleVersion);
+                            }
+                        },
+                        comm);
+                } catch (Communicator::CancelledException &) {
+                    // the isovists of the batches done are kept
                 }
+                isovistMap.invalidateDisplayedAttribute();
+                isovistMap.setDisplayedAttribute(-1);
+                pDoc->m_meta_graph->setViewClass(MetaGraphDM::DX_SHOWSHAPETOP);
 
                 pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
                 // Tell the sidebar about the new map:
@@ -395,9 +468,8 @@ void RenderThread::run() {
 
         case CMSCommunicator::AXIALANALYSIS:
             ok = pDoc->m_meta_graph->analyseAxial(
-                comm, pMain->m_options.radiusSet, pMain->m_options.weightedMeasureCol,
-                pMain->m_options.choice, pMain->m_options.fulloutput, pMain->m_options.local,
-                false);
+                comm, jobOptions.radiusSet, jobOptions.weightedMeasureCol, jobOptions.choice,
+                jobOptions.fulloutput, jobOptions.local, false);
             if (ok) {
                 pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
             }
@@ -406,10 +478,9 @@ void RenderThread::run() {
 
         case CMSCommunicator::SEGMENTANALYSISTULIP:
             ok = pDoc->m_meta_graph->analyseSegmentsTulip(
-                comm, pMain->m_options.radiusSet, pMain->m_options.selOnly,
-                pMain->m_options.tulipBins, pMain->m_options.weightedMeasureCol,
-                pMain->m_options.radiusType, pMain->m_options.choice,
-                pMain->m_options.weightedMeasureCol2, pMain->m_options.routeweightCol, true, false);
+                comm, jobOptions.radiusSet, jobOptions.selOnly, jobOptions.tulipBins,
+                jobOptions.weightedMeasureCol, jobOptions.radiusType, jobOptions.choice,
+                jobOptions.weightedMeasureCol2, jobOptions.routeweightCol, true, false);
             if (ok) {
                 pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
             }
@@ -417,7 +488,7 @@ void RenderThread::run() {
             break;
 
         case CMSCommunicator::SEGMENTANALYSISANGULAR:
-            ok = pDoc->m_meta_graph->analyseSegmentsAngular(comm, pMain->m_options.radiusSet);
+            ok = pDoc->m_meta_graph->analyseSegmentsAngular(comm, jobOptions.radiusSet);
             if (ok) {
                 pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
             }
@@ -425,9 +496,8 @@ void RenderThread::run() {
             break;
 
         case CMSCommunicator::TOPOMETANALYSIS:
-            ok = pDoc->m_meta_graph->analyseTopoMet(comm, pMain->m_options.outputType,
-                                                    pMain->m_options.radius,
-                                                    pMain->m_options.selOnly);
+            ok = pDoc->m_meta_graph->analyseTopoMet(comm, jobOptions.outputType,
+                                                    jobOptions.radius, jobOptions.selOnly);
             if (ok) {
                 pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
             }
@@ -504,16 +574,24 @@ void RenderThread::run() {
                 emit runtimeExceptionThrown(e.getErrorType(), e.what());
             }
         } break;
+        case CMSCommunicator::UNMAKEGRAPH:
+            if (pDoc->m_meta_graph->unmakeGraph(comm->GetOption(0) == 1)) {
+                pDoc->SetUpdateFlag(QGraphDoc::NEW_DATA);
+            }
+            break;
+        case CMSCommunicator::PUSHVALUES:
+            pDoc->m_meta_graph->pushValuesToLayer(comm->GetOption(0), comm->GetOption(1),
+                                                  comm->GetOption(2), comm->GetOption(3) == 1);
+            pDoc->SetUpdateFlag(QGraphDoc::NEW_TABLE);
+            break;
         case CMSCommunicator::FROMCONNECTOR: {
-            comm->runAnalysis(*pDoc);
+            comm->runAnalysis();
             break;
         }
         }
 
-        emit closeWaitDialog();
-        msleep(100);
-        delete pDoc->m_communicator; // Ensure we delete *the* communicator
-        pDoc->m_communicator = NULL;
+        // the communicator is owned by the job, which the document removes
+        // once this thread has finished
         // REDRAW_TOTAL to REDRAW_GRAPH // recenterView after fill // TV
         pDoc->SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_GRAPH, QGraphDoc::NEW_DATA);
     }
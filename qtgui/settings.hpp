@@ -25,6 +25,7 @@ namespace SettingTag {
     const QString depthmapViewSize = "depthmapViewSize";
     const QString legacyMapWindow = "legacyMapWindow";
     const QString highlightOnHover = "highlightOnHover";
+    const QString analysisThreads = "analysisThreads";
 } // namespace SettingTag
 
 /**
@@ -870,6 +870,7 @@ void QDepthmapView::mouseReleaseEvent(QMouseEvent *e) {
                 if (m_pDoc.m_meta_graph->getSelCount() == 1) {
                     auto &map = m_pDoc.m_meta_graph->getDisplayedShapeGraph();
                     ok = map.linkShapes(LogicalUnits(point));
+                    m_pDoc.m_routeIndices.clear();
                     auto conn_col = map.getAttributeTable().getColumnIndex("Connectivity");
                     if (map.getDisplayedAttribute() == static_cast<int>(conn_col)) {
                         map.invalidateDisplayedAttribute();
@@ -906,6 +907,7 @@ void QDepthmapView::mouseReleaseEvent(QMouseEvent *e) {
                     auto &map = m_pDoc.m_meta_graph->getDisplayedShapeGraph();
 
                     ok = map.unlinkShapes(LogicalUnits(point));
+                    m_pDoc.m_routeIndices.clear();
 
                     auto conn_col = map.getAttributeTable().getColumnIndex("Connectivity");
                     if (map.getDisplayedAttribute() == static_cast<int>(conn_col)) {
@@ -7,8 +7,16 @@
 #include "mainwindow.hpp"
 #include "views/depthmapview/depthmapview.hpp"
 
+#include "salalib/genlib/exceptions.hpp"
+
 #include <QCoreApplication>
+#include <QMessageBox>
 #include <QMouseEvent>
+#include <QTimer>
+
+// how long the path preview may search on each move of the mouse, before
+// giving the rest of the search to the event loop
+static const std::chrono::microseconds PATH_PREVIEW_BUDGET(10000);
 
 static QRgb colorMerge(QRgb color, QRgb mergecolor) {
     return (color & 0x006f6f6f) | (mergecolor & 0x00a0a0a0);
@@ -68,6 +76,7 @@ GLView::~GLView() {
     m_visibleShapeGraph.cleanup();
     m_visibleDataMap.cleanup();
     m_hoveredShapes.cleanup();
+    m_pathPreview.cleanup();
     doneCurrent();
     m_settings.writeSetting(SettingTag::depthmapViewSize, size());
 }
@@ -90,6 +99,7 @@ void GLView::initializeGL() {
     m_visibleDataMap.initializeGL(m_core);
     m_hoveredShapes.initializeGL(m_core);
     m_hoveredPixels.initializeGL(m_core);
+    m_pathPreview.initializeGL(m_core);
 
     if (m_pDoc.m_meta_graph->getViewClass() & MetaGraphDM::DX_VIEWVGA) {
         m_visibleLatticeMap.loadGLObjectsRequiringGLContext(
@@ -140,6 +150,10 @@ void GLView::paintGL() {
         m_hoveredPixels.updateGL(m_core);
         m_hoverStoreInvalid = false;
     }
+    if (m_pathPreviewInvalid) {
+        m_pathPreview.updateGL(m_core);
+        m_pathPreviewInvalid = false;
+    }
 
     m_axes.paintGL(m_mProj, m_mView, m_mModel);
 
@@ -177,6 +191,11 @@ void GLView::paintGL() {
         m_hoveredSecondaryShapes.paintGL(m_mProj, m_mView, m_mModel);
         glLineWidth(1);
     }
+    if (m_mouseMode == MOUSE_MODE_PATH_PREVIEW) {
+        glLineWidth(5);
+        m_pathPreview.paintGL(m_mProj, m_mView, m_mModel);
+        glLineWidth(1);
+    }
 
     float pos[] = {
         float(std::min(m_mouseDragRect.bottomRight().x(), m_mouseDragRect.topLeft().x())),
@@ -342,6 +361,10 @@ void GLView::mouseReleaseEvent(QMouseEvent *event) {
             m_pDoc.OnToolsPD();
             break;
         }
+        case MOUSE_MODE_PATH_PREVIEW: {
+            setPathPreviewOrigin(worldPoint);
+            break;
+        }
         case MOUSE_MODE_JOIN: {
             selected = m_pDoc.m_meta_graph->setCurSel(r, false);
             int selectedCount = m_pDoc.m_meta_graph->getSelCount();
@@ -389,6 +412,7 @@ void GLView::mouseReleaseEvent(QMouseEvent *event) {
                         m_pDoc.modifiedFlag = true;
                         auto &map = m_pDoc.m_meta_graph->getDisplayedShapeGraph();
                         map.linkShapesFromRefs(axRef1, axRef2);
+                        m_pDoc.m_routeIndices.clear();
 
                         auto conn_col = map.getAttributeTable().getColumnIndex("Connectivity");
                         if (map.getDisplayedAttribute() == static_cast<int>(conn_col)) {
@@ -444,6 +468,7 @@ void GLView::mouseReleaseEvent(QMouseEvent *event) {
                         m_pDoc.modifiedFlag = true;
                         auto &map = m_pDoc.m_meta_graph->getDisplayedShapeGraph();
                         map.unlinkShapesFromRefs(axRef1, axRef2);
+                        m_pDoc.m_routeIndices.clear();
                         auto conn_col = map.getAttributeTable().getColumnIndex("Connectivity");
                         if (map.getDisplayedAttribute() == static_cast<int>(conn_col)) {
                             map.invalidateDisplayedAttribute();
@@ -460,8 +485,11 @@ void GLView::mouseReleaseEvent(QMouseEvent *event) {
         }
         }
 
-        m_pDoc.SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS,
-                             QGraphDoc::NEW_SELECTION);
+        // the path preview draws itself, without loading the map again
+        if (m_mouseMode != MOUSE_MODE_PATH_PREVIEW) {
+            m_pDoc.SetRedrawFlag(QGraphDoc::VIEW_ALL, QGraphDoc::REDRAW_POINTS,
+                                 QGraphDoc::NEW_SELECTION);
+        }
     }
     m_mouseDragRect.setWidth(0);
     m_mouseDragRect.setHeight(0);
@@ -526,6 +554,10 @@ void GLView::mouseMoveEvent(QMouseEvent *event) {
         }
         update();
     }
+    if (m_mouseMode == MOUSE_MODE_PATH_PREVIEW && (m_vgaPathTree || m_segmentPathTree)) {
+        m_pathPreviewTarget = worldPoint;
+        updatePathPreview();
+    }
     m_mouseLastPos = event->pos();
     m_pDoc.m_position = worldPoint;
     m_pDoc.UpdateMainframestatus();
@@ -799,6 +831,121 @@ void GLView::highlightHoveredShapes(const ShapeMapDM &map, const Region4f &regio
     }
 }
 
+void GLView::setPathPreviewOrigin(const Point2f &point) {
+    clearPathPreview();
+    if (m_pDoc.m_meta_graph->getDisplayedMapType() == ShapeMap::LATTICEMAP) {
+        auto &map = m_pDoc.m_meta_graph->getDisplayedLatticeMap();
+        PixelRef pixel = map.pixelate(point, true);
+        if (!map.includes(pixel) || !map.getPoint(pixel).filled()) {
+            return;
+        }
+        VGAPathTree::PathType pathType = VGAPathTree::PathType::METRIC;
+        if (m_pathPreviewType == PathPreviewType::VISUAL) {
+            pathType = VGAPathTree::PathType::VISUAL;
+        } else if (m_pathPreviewType == PathPreviewType::ANGULAR) {
+            pathType = VGAPathTree::PathType::ANGULAR;
+        }
+        auto graph = std::make_unique<VGAPointToPointPath::PointMapView>(map.getInternalMap());
+        m_vgaPathGraph = graph.get();
+        uint32_t origin = graph->nodeOf(pixel);
+        m_vgaPathTree = std::make_unique<VGAPathTree>(std::move(graph), origin, pathType);
+    } else if (m_pDoc.m_meta_graph->getDisplayedMapType() == ShapeMap::SEGMENTMAP) {
+        auto &map = m_pDoc.m_meta_graph->getDisplayedShapeGraph();
+        auto shapes = map.getShapesInRegion(Region4f(point, point));
+        if (shapes.empty()) {
+            return;
+        }
+        SegmentPathTree::CostType costType = SegmentPathTree::CostType::METRIC;
+        if (m_pathPreviewType == PathPreviewType::TOPOLOGICAL) {
+            costType = SegmentPathTree::CostType::TOPOLOGICAL;
+        } else if (m_pathPreviewType == PathPreviewType::ANGULAR) {
+            costType = SegmentPathTree::CostType::ANGULAR;
+        }
+        try {
+            m_segmentPathTree = SegmentPathTree::fromMap(map.getInternalMap(), costType,
+                                                         static_cast<int>(shapes.begin()->first));
+        } catch (genlib::RuntimeException &e) {
+            QMessageBox::warning(this, tr("Warning"), QString(e.what()), QMessageBox::Ok,
+                                 QMessageBox::Ok);
+        }
+    }
+}
+
+void GLView::updatePathPreview() {
+    m_pathPreviewPending = false;
+    if (m_pDoc.m_communicator) {
+        // the map may be changing under the search
+        return;
+    }
+    std::optional<std::vector<SimpleLine>> lines;
+    uint32_t target = std::numeric_limits<uint32_t>::max();
+    if (m_vgaPathTree) {
+        auto &map = m_pDoc.m_meta_graph->getDisplayedLatticeMap();
+        PixelRef pixel = map.pixelate(m_pathPreviewTarget, true);
+        if (!map.includes(pixel) || !map.getPoint(pixel).filled()) {
+            return;
+        }
+        target = m_vgaPathGraph->nodeOf(pixel);
+        if (target == m_pathPreviewShown) {
+            return;
+        }
+        if (auto path = m_vgaPathTree->findPath(target, PATH_PREVIEW_BUDGET)) {
+            lines.emplace();
+            for (size_t step = 1; step < path->nodes.size(); step++) {
+                lines->push_back(
+                    SimpleLine(map.depixelate(m_vgaPathGraph->pixelOf(path->nodes[step - 1])),
+                               map.depixelate(m_vgaPathGraph->pixelOf(path->nodes[step]))));
+            }
+        }
+    } else if (m_segmentPathTree) {
+        auto &map = m_pDoc.m_meta_graph->getDisplayedShapeGraph();
+        auto shapes = map.getShapesInRegion(Region4f(m_pathPreviewTarget, m_pathPreviewTarget));
+        if (shapes.empty()) {
+            return;
+        }
+        target = m_segmentPathTree->findSegment(static_cast<int>(shapes.begin()->first));
+        if (target == m_pathPreviewShown || target == SegmentRouteIndex::NO_SEGMENT) {
+            return;
+        }
+        if (auto route = m_segmentPathTree->findRoute(target, PATH_PREVIEW_BUDGET)) {
+            lines.emplace();
+            auto &allShapes = map.getAllShapes();
+            for (uint32_t segment : route->segments) {
+                lines->push_back(
+                    SimpleLine(allShapes.at(m_segmentPathTree->getRef(segment)).getLine()));
+            }
+        }
+    } else {
+        return;
+    }
+
+    if (!lines) {
+        // out of time, carry on once the events waiting have been seen to
+        m_pathPreviewPending = true;
+        QTimer::singleShot(0, this, [this] {
+            if (m_pathPreviewPending) {
+                updatePathPreview();
+            }
+        });
+        return;
+    }
+    m_pathPreviewShown = target;
+    m_pathPreview.loadLineData(*lines, qRgb(0, 255, 255));
+    m_pathPreviewInvalid = true;
+    update();
+}
+
+void GLView::clearPathPreview() {
+    m_vgaPathTree.reset();
+    m_vgaPathGraph = nullptr;
+    m_segmentPathTree.reset();
+    m_pathPreviewShown = std::numeric_limits<uint32_t>::max();
+    m_pathPreviewPending = false;
+    m_pathPreview.loadLineData(std::vector<SimpleLine>(), qRgb(0, 255, 255));
+    m_pathPreviewInvalid = true;
+    update();
+}
+
 void GLView::zoomBy(float dzf, int mouseX, int mouseY) {
     float pzf = m_zoomFactor;
     m_zoomFactor = m_zoomFactor * dzf;
@@ -867,6 +1014,7 @@ void GLView::OnViewZoomToRegion(Region4f region) {
 }
 
 void GLView::resetView() {
+    clearPathPreview();
     m_visibleLatticeMap.showLinks(false);
     m_visibleShapeGraph.showLinks(false);
     m_pDoc.m_meta_graph->clearSel();
@@ -951,6 +1099,18 @@ void GLView::OnEditPolygonTool() {
     m_mouseMode = MOUSE_MODE_POLYGON_TOOL;
 }
 
+bool GLView::OnModePathPreview(PathPreviewType pathType) {
+    auto mapType = m_pDoc.m_meta_graph->getDisplayedMapType();
+    if (!(mapType == ShapeMap::LATTICEMAP && pathType != PathPreviewType::TOPOLOGICAL) &&
+        !(mapType == ShapeMap::SEGMENTMAP && pathType != PathPreviewType::VISUAL)) {
+        return false;
+    }
+    resetView();
+    m_pathPreviewType = pathType;
+    m_mouseMode = MOUSE_MODE_PATH_PREVIEW;
+    return true;
+}
+
 void GLView::OnEditSelect() {
     resetView();
     m_mouseMode = MOUSE_MODE_SELECT;
@@ -14,6 +14,9 @@
 #include "graphdoc.hpp"
 #include "views/mapview.hpp"
 
+#include "modules/segmentshortestpaths/core/segmentpathtree.hpp"
+#include "modules/vgaparallel/core/vgapathtree.hpp"
+
 #include <QMatrix4x4>
 #include <QOpenGLFunctions>
 #include <QOpenGLWidget>
@@ -30,6 +33,8 @@ class GLView : public MapView, protected QOpenGLFunctions {
     QSize minimumSizeHint() const override;
     QSize sizeHint() const override;
     void notifyDatasetChanged() {
+        // the map the path preview was searching may have gone
+        clearPathPreview();
         m_datasetChanged = true;
         update();
     }
@@ -56,6 +61,7 @@ class GLView : public MapView, protected QOpenGLFunctions {
     virtual void OnEditCopy() override;
     virtual void OnEditSave() override;
     virtual void OnViewZoomToRegion(Region4f region) override;
+    virtual bool OnModePathPreview(PathPreviewType pathType) override;
 
   protected:
     void initializeGL() override;
@@ -95,6 +101,18 @@ class GLView : public MapView, protected QOpenGLFunctions {
     GLLinesUniform m_hoveredPixels;
     PixelRef m_lastHoverPixel = -1;
 
+    // the searches from the origin are kept while the mouse moves, and only
+    // the lines of the path are loaded again
+    PathPreviewType m_pathPreviewType = PathPreviewType::METRIC;
+    std::unique_ptr<VGAPathTree> m_vgaPathTree;
+    const VGAPointToPointPath::PointMapView *m_vgaPathGraph = nullptr;
+    std::unique_ptr<SegmentPathTree> m_segmentPathTree;
+    Point2f m_pathPreviewTarget;
+    uint32_t m_pathPreviewShown = std::numeric_limits<uint32_t>::max();
+    bool m_pathPreviewPending = false;
+    bool m_pathPreviewInvalid = false;
+    GLLinesUniform m_pathPreview;
+
     QPoint m_mouseLastPos;
     float m_eyePosX;
     float m_eyePosY;
@@ -123,6 +141,10 @@ class GLView : public MapView, protected QOpenGLFunctions {
     void highlightHoveredPixels(const LatticeMapDM &map, const std::set<PixelRef> &refs);
     void highlightHoveredShapes(const ShapeMapDM &map, const Region4f &region);
 
+    void setPathPreviewOrigin(const Point2f &point);
+    void updatePathPreview();
+    void clearPathPreview();
+
     void loadAxes();
     void loadDrawingGLObjects();
 
@@ -142,6 +164,7 @@ class GLView : public MapView, protected QOpenGLFunctions {
         MOUSE_MODE_LINE_TOOL = 0x0008,
         MOUSE_MODE_POLYGON_TOOL = 0x0010,
         MOUSE_MODE_POINT_STEP_DEPTH = 0x5000,
+        MOUSE_MODE_PATH_PREVIEW = 0x6000,
         MOUSE_MODE_JOIN = 0x20001,
         MOUSE_MODE_UNJOIN = 0x20002,
         MOUSE_MODE_SECOND_POINT = 0x00400,
@@ -18,6 +18,8 @@ class MapView : public QOpenGLWidget {
     QString m_currentFile;
 
   public:
+    enum class PathPreviewType { VISUAL, METRIC, ANGULAR, TOPOLOGICAL };
+
     MapView(QGraphDoc &pDoc, Settings &settings, QWidget *parent = Q_NULLPTR);
 
     virtual void OnModeJoin() = 0;
@@ -40,6 +42,9 @@ class MapView : public QOpenGLWidget {
     virtual void OnEditCopy() = 0;
     virtual void OnEditSave() = 0;
     virtual void OnViewZoomToRegion(Region4f region) = 0;
+    // click an origin and follow the mouse with the shortest path from it,
+    // false if the view cannot show the path
+    virtual bool OnModePathPreview(PathPreviewType) { return false; }
 
     QGraphDoc *getGraphDoc() { return &m_pDoc; }
     void setCurrentFile(const QString &fileName) { m_currentFile = fileName; }
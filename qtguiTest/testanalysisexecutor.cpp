@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "qtgui/analysisexecutor.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Test executor runs all tasks") {
+    AnalysisExecutor executor(4);
+    std::atomic<int> counter(0);
+    std::vector<std::future<void>> results;
+    for (int i = 0; i < 100; ++i) {
+        results.push_back(executor.submit([&counter]() { counter++; }));
+    }
+    for (auto &result : results) {
+        result.wait();
+    }
+    REQUIRE(counter == 100);
+    REQUIRE(executor.pendingTasks() == 0);
+}
+
+TEST_CASE("Test executor caps concurrency") {
+    AnalysisExecutor executor(2);
+    std::atomic<int> running(0);
+    std::atomic<int> maxRunning(0);
+    std::vector<std::future<void>> results;
+    for (int i = 0; i < 8; ++i) {
+        results.push_back(executor.submit([&running, &maxRunning]() {
+            int now = ++running;
+            int prev = maxRunning;
+            while (now > prev && !maxRunning.compare_exchange_weak(prev, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            running--;
+        }));
+    }
+    for (auto &result : results) {
+        result.wait();
+    }
+    REQUIRE(maxRunning <= 2);
+}
+
+TEST_CASE("Test executor thread budget") {
+    SECTION("A task on its own gets all threads") {
+        AnalysisExecutor executor(4);
+        int budget = 0;
+        executor.submit([&budget]() { budget = AnalysisExecutor::currentBudget(); }).wait();
+        REQUIRE(budget == 4);
+    }
+    SECTION("Outside the executor the budget is a single thread") {
+        REQUIRE(AnalysisExecutor::currentBudget() == 1);
+    }
+}
+
+TEST_CASE("Test executor rebalances budgets") {
+    AnalysisExecutor executor(4);
+    // waits up to a second for a condition set by the other task
+    auto waitFor = [](const auto &condition) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        return condition();
+    };
+    std::atomic<bool> secondStarted(false), secondChecked(false);
+    int alone = 0, shared = 0, secondBudget = 0;
+    bool regained = false;
+    auto first = executor.submit([&]() {
+        alone = AnalysisExecutor::currentBudget();
+        waitFor([&]() { return secondStarted.load(); });
+        shared = AnalysisExecutor::currentBudget();
+        secondChecked = true;
+        regained = waitFor([]() { return AnalysisExecutor::currentBudget() == 4; });
+    });
+    waitFor([&]() { return alone != 0; });
+    auto second = executor.submit([&]() {
+        secondBudget = AnalysisExecutor::currentBudget();
+        secondStarted = true;
+        waitFor([&]() { return secondChecked.load(); });
+    });
+    second.wait();
+    first.wait();
+    REQUIRE(alone == 4);
+    REQUIRE(secondBudget == 2);
+    REQUIRE(shared == 2);
+    REQUIRE(regained);
+}
+
+TEST_CASE("Test executor raising the cap") {
+    AnalysisExecutor executor(1);
+    executor.setMaxThreads(3);
+    REQUIRE(executor.maxThreads() == 3);
+    int budget = 0;
+    executor.submit([&budget]() { budget = AnalysisExecutor::currentBudget(); }).wait();
+    REQUIRE(budget == 3);
+}
+
+TEST_CASE("Test executor propagates exceptions") {
+    AnalysisExecutor executor(2);
+    auto result = executor.submit([]() { throw std::runtime_error("failed"); });
+    REQUIRE_THROWS_AS(result.get(), std::runtime_error);
+    // the worker survives
+    bool ran = false;
+    executor.submit([&ran]() { ran = true; }).wait();
+    REQUIRE(ran);
+}
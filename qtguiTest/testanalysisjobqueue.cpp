@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: 2024 Petros Koutsolampros
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "qtgui/analysisjobqueue.hpp"
+
+#include "catch_amalgamated.hpp"
+
+#include <string>
+#include <vector>
+
+using JobQueue = AnalysisJobQueue<std::string>;
+
+TEST_CASE("Test job queue runs jobs one at a time in order") {
+    JobQueue queue;
+    size_t first = queue.push("first");
+    size_t second = queue.push("second");
+    size_t third = queue.push("third");
+    REQUIRE(first < second);
+    REQUIRE(second < third);
+
+    std::vector<std::string> order;
+    while (auto *job = queue.startNext()) {
+        REQUIRE(job->state == JobQueue::State::RUNNING);
+        // nothing else starts while a job runs
+        REQUIRE(queue.startNext() == nullptr);
+        order.push_back(job->payload);
+        queue.finishRunning();
+    }
+    REQUIRE(order == std::vector<std::string>{"first", "second", "third"});
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Test job queue keeps jobs queued behind a running one") {
+    JobQueue queue;
+    queue.push("first");
+    auto *running = queue.startNext();
+    REQUIRE(running != nullptr);
+    size_t second = queue.push("second");
+    REQUIRE(queue.running() == running);
+    REQUIRE(queue.find(second)->state == JobQueue::State::QUEUED);
+    REQUIRE(queue.startNext() == nullptr);
+
+    queue.finishRunning();
+    REQUIRE(queue.running() == nullptr);
+    auto *next = queue.startNext();
+    REQUIRE(next != nullptr);
+    REQUIRE(next->id == second);
+}
+
+TEST_CASE("Test job queue cancelling") {
+    JobQueue queue;
+    size_t first = queue.push("first");
+    size_t second = queue.push("second");
+    size_t third = queue.push("third");
+    queue.startNext();
+
+    SECTION("A queued job is taken out straight away") {
+        REQUIRE(queue.cancel(second) == JobQueue::CancelResult::REMOVED);
+        REQUIRE(queue.find(second) == nullptr);
+        REQUIRE(queue.size() == 2);
+        queue.finishRunning();
+        REQUIRE(queue.startNext()->id == third);
+    }
+
+    SECTION("A running job stays until it has stopped") {
+        REQUIRE(queue.cancel(first) == JobQueue::CancelResult::STOPPING);
+        REQUIRE(queue.running()->id == first);
+        REQUIRE(queue.running()->state == JobQueue::State::CANCELLING);
+        // cancelling again changes nothing
+        REQUIRE(queue.cancel(first) == JobQueue::CancelResult::STOPPING);
+        // the jobs behind it still wait for it
+        REQUIRE(queue.startNext() == nullptr);
+        queue.finishRunning();
+        REQUIRE(queue.startNext()->id == second);
+    }
+
+    SECTION("A finished job can not be cancelled") {
+        queue.finishRunning();
+        REQUIRE(queue.cancel(first) == JobQueue::CancelResult::NOT_FOUND);
+        REQUIRE(queue.size() == 2);
+    }
+}
+
+TEST_CASE("Test job queue ids are not reused") {
+    JobQueue queue;
+    size_t first = queue.push("first");
+    queue.startNext();
+    queue.finishRunning();
+    size_t second = queue.push("second");
+    REQUIRE(second != first);
+    REQUIRE(queue.find(first) == nullptr);
+    REQUIRE(queue.find(second)->payload == "second");
+}